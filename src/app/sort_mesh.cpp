@@ -1,3 +1,4 @@
+#include <wtlib/classification_certificate.hpp>
 #include <wtlib/ptq_impl/mesh_vertex_info.hpp>
 #include <wtlib/ptq_impl/vertex_classification.hpp>
 #include <wtlib/wavelet_mesh_operations.hpp>
@@ -94,7 +95,9 @@ int main(int argc, char** argv)
     ("input-mesh,i", po::value<std::string>(), "Set file path of input mesh.\n\n"
                                                "Without this option, program will read input mesh from standard input.\n\n")
     ("output-mesh,o", po::value<std::string>(), "Set file path of output sorted mesh.\n\n"
-                                                "Without this option, program will print output mesh to standard output.\n\n");
+                                                "Without this option, program will print output mesh to standard output.\n\n")
+    ("certificate,C", po::value<std::string>(), "Set file path of the certificate of the sorted mesh.\n\n"
+                                                "The wavelet transform programs given this certificate skip the vertex classification of the sorted mesh.\n\n");
 
   po::variables_map vm;
   po::parsed_options parsed = po::command_line_parser(argc, argv).options(desc).allow_unregistered().run();
@@ -113,6 +116,7 @@ int main(int argc, char** argv)
   int num_levels = 0;
   std::string mesh_in;
   std::string mesh_out;
+  std::string certificate_out;
 
   // Parse command line options
   if (vm.count("help"))
@@ -141,6 +145,11 @@ int main(int argc, char** argv)
     mesh_out = vm["output-mesh"].as<std::string>();
   }
 
+  if (vm.count("certificate"))
+  {
+    certificate_out = vm["certificate"].as<std::string>();
+  }
+
 
   // Validate mesh.
   Mesh mesh;
@@ -216,5 +225,29 @@ int main(int argc, char** argv)
     mesh_out_file.close();
   }
 
+  // The vertices of the sorted mesh are in the classified order, so the
+  // certificate only holds the bands.
+  if (!certificate_out.empty())
+  {
+    wtlib::Classification_certificate certificate;
+    certificate.connectivity_hash = wtlib::connectivity_hash(
+                                      mesh,
+                                      [&mesh_ops](Vertex_const_handle v)
+                                      {
+                                        return mesh_ops.get_vertex_id(v);
+                                      });
+    for (int level = 0; level <= num_levels; ++level)
+    {
+      certificate.level_sizes.push_back(bands[level + 1] - bands[0]);
+    }
+
+    std::ofstream certificate_file(certificate_out);
+    if (!(certificate_file << certificate))
+    {
+      std::cerr << "Fail to write certificate to " << certificate_out << "\n";
+      return 1;
+    }
+  }
+
   return 0;
 }
\ No newline at end of file
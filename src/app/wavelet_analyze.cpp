@@ -6,36 +6,52 @@
 
 #include <chrono>
 #include <fstream>
+#include <stdexcept>
+#include <string>
 
 namespace po = boost::program_options;
 
 using Vertex_const_handle = typename Mesh::Vertex_const_handle;
 using Vertex_handle = typename Mesh::Vertex_handle;
 using Vector3 = typename Mesh::Traits::Vector_3;
+using Coefficients = wtlib::Wavelet_coefficients<Vector3>;
 
-void dump_coefs(const std::vector<std::vector<Vector3>>& coefs,
+void dump_coefs(const Coefficients& coefs,
                 std::ostream& out)
 {
-  for (int i = 0; i < coefs.size(); ++i)
+  for (int b = 0; b < coefs.num_bands(); ++b)
   {
-    const std::vector<Vector3>& band_coefs = coefs[i];
-    for (int j = 0; j < band_coefs.size(); ++j)
+    Coefficients::Const_band band_coefs = coefs.band(b);
+    for (int i = 0; i < band_coefs.size(); ++i)
     {
-      const Vector3& c = band_coefs[j];
-      out << c.x() << " " << c.y() << " " << c.z() <<'\n';
+      out << band_coefs.x()[i] << " " << band_coefs.y()[i] << " " << band_coefs.z()[i] <<'\n';
     }
     out << "\n";
   }
 }
 
+// Read the certificate of an earlier classification, an absent or malformed
+// file gives an empty certificate.
+wtlib::Classification_certificate load_certificate(const std::string& path)
+{
+  wtlib::Classification_certificate certificate;
+  std::ifstream in(path);
+  if (in && !(in >> certificate))
+  {
+    std::cerr << "[WARNING] Ignore the malformed certificate " << path << ".\n";
+    certificate = {};
+  }
+  return certificate;
+}
+
 int main(int argc, char** argv)
 {
   po::options_description descriptions(R"(A program computes the Loop or Butterfly forward wavelet transform on a triangle mesh.
 
 Usage:
-    wtl_wavelet_analyze -m <scheme> -l <level> 
+    wtl_wavelet_analyze -m <scheme> -l <level|auto> [-j <threads>] 
                         [--input-mesh <args>] [--output-mesh <args>]
-                        [--output-coefs <args>]
+                        [--output-coefs <args>] [--certificate <args>]
 
 These are accepted options)");
   descriptions.add_options()
@@ -43,13 +59,19 @@ These are accepted options)");
     ("method,m", po::value<std::string>(), "Select a wavelet transform scheme:\n"
                                            "\t - Butterfly\n"
                                            "\t - Loop")
-    ("level,l", po::value<int>(), "Set the number of wavelet transform levels.")
+    ("level,l", po::value<std::string>(), "Set the number of wavelet transform levels, "
+                                          "auto transforms as many levels as the input mesh has.")
+    ("threads,j", po::value<int>()->default_value(1), "Set the number of threads used by the lifting steps, "
+                                                      "0 selects the number of hardware threads.")
     ("input-mesh,i", po::value<std::string>(), "Set the file path for the input mesh. "
                                                "Without this option, the program will read input mesh from standard input.")
     ("output-mesh,o", po::value<std::string>(), "Set the file path for the coarse output mesh. "
                                                 "Without this option, program will output mesh to standard output.")
     ("output-coefs,c", po::value<std::string>(), "Set the file path for the output wavelet coefficients. "
-                                                 "Without this option, program will output wavelet coefficients to standard output.");
+                                                 "Without this option, program will output wavelet coefficients to standard output.")
+    ("certificate,C", po::value<std::string>(), "Set the file path for the certificate of the subdivision connectivity. "
+                                                "A certificate matching the input mesh skips the vertex classification, "
+                                                "otherwise the certificate of this classification is written to the file.");
 
 
   po::variables_map vm;
@@ -75,10 +97,13 @@ These are accepted options)");
   }
 
   int num_levels = 0;
+  bool auto_levels = false;
+  int num_threads = 1;
   std::string mesh_out;
   std::string coefs_out;
   std::string mesh_in;
   std::string method;
+  std::string certificate_path;
 
   // Parse command line options
   if (vm.count("help"))
@@ -108,11 +133,32 @@ These are accepted options)");
 
   if (vm.count("level"))
   {
-    num_levels = vm["level"].as<int>();
-    if (num_levels < 0)
+    std::string level = vm["level"].as<std::string>();
+    if (level == "auto")
     {
-      std::cerr << "The set number of levels (" << num_levels << ") should be a non-negative integer.\n";
-      return 1;
+      auto_levels = true;
+    }
+    else
+    {
+      try
+      {
+        std::size_t size = 0;
+        num_levels = std::stoi(level, &size);
+        if (size != level.size())
+        {
+          throw std::invalid_argument(level);
+        }
+      }
+      catch (std::exception&)
+      {
+        std::cerr << "The set number of levels (" << level << ") should be a non-negative integer or auto.\n";
+        return 1;
+      }
+      if (num_levels < 0)
+      {
+        std::cerr << "The set number of levels (" << num_levels << ") should be a non-negative integer.\n";
+        return 1;
+      }
     }
   }
   else
@@ -121,6 +167,13 @@ These are accepted options)");
     return 1;
   }
 
+  num_threads = vm["threads"].as<int>();
+  if (num_threads < 0)
+  {
+    std::cerr << "The set number of threads (" << num_threads << ") should be a non-negative integer.\n";
+    return 1;
+  }
+
   if (vm.count("input-mesh"))
   {
     mesh_in = vm["input-mesh"].as<std::string>();
@@ -136,6 +189,16 @@ These are accepted options)");
     coefs_out = vm["output-coefs"].as<std::string>();
   }
 
+  if (vm.count("certificate"))
+  {
+    certificate_path = vm["certificate"].as<std::string>();
+    if (auto_levels)
+    {
+      std::cerr << "[WARNING] The certificate is not used with the automatic number of levels.\n";
+      certificate_path.clear();
+    }
+  }
+
   // Load mesh
   Mesh mesh;
 
@@ -167,11 +230,31 @@ These are accepted options)");
     }
   }
 
-  std::vector<std::vector<Vector3>> coefs;
+  Coefficients coefs;
 
-  if (method == "Butterfly")
+  // Without a certificate file, the empty certificate is replaced and dropped.
+  wtlib::Classification_certificate certificate;
+  if (!certificate_path.empty())
+  {
+    certificate = load_certificate(certificate_path);
+  }
+  const wtlib::Classification_certificate loaded_certificate {certificate};
+
+  if (auto_levels)
+  {
+    num_levels = method == "Butterfly" ?
+                 wtlib::butterfly_analyze_max_levels(mesh, coefs, 0, num_threads) :
+                 wtlib::loop_analyze_max_levels(mesh, coefs, 0, num_threads);
+    if (num_levels == 0)
+    {
+      std::cerr << "[ERROR] The input mesh does not have subdivision connectivity.\n";
+      return 1;
+    }
+    std::cerr << "[INFO] Computed " << num_levels << " levels of wavelet transform.\n";
+  }
+  else if (method == "Butterfly")
   {
-    if (!wtlib::butterfly_analyze(mesh, coefs, num_levels))
+    if (!wtlib::butterfly_analyze(mesh, coefs, num_levels, certificate, num_threads))
     {
       std::cerr << "[ERROR] The input mesh does not have " << num_levels 
                 << " levels of subdivision connectivity.\n";
@@ -180,7 +263,7 @@ These are accepted options)");
   }
   else
   {
-    if (!wtlib::loop_analyze(mesh, coefs, num_levels))
+    if (!wtlib::loop_analyze(mesh, coefs, num_levels, certificate, num_threads))
     {
       std::cerr << "[ERROR] The input mesh does not have " << num_levels 
                 << " levels of subdivision connectivity.\n";
@@ -188,6 +271,16 @@ These are accepted options)");
     }
   }
 
+  if (!certificate_path.empty() && certificate != loaded_certificate)
+  {
+    std::ofstream certificate_file(certificate_path);
+    if (!(certificate_file << certificate))
+    {
+      std::cerr << "[ERROR] Fail to write certificate to " << certificate_path << ".\n";
+      return 1;
+    }
+  }
+
   if (mesh_out.empty())
   {
     std::cout << mesh;
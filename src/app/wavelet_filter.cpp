@@ -1,19 +1,39 @@
 #include <wtlib/butterfly_wavelet_transform.hpp>
 #include <wtlib/loop_wavelet_transform.hpp>
 #include <wtlib/mesh_types.hpp>
+#include <wtlib/transform_plan.hpp>
 
 #include <boost/program_options.hpp>
 #include <boost/exception/diagnostic_information.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <fstream>
+#include <numeric>
 
 namespace po = boost::program_options;
 
 using Vertex_handle = typename Mesh::Vertex_handle;
-using Vector3 = typename Mesh::Traits::Vector_3;
+using Kernel = typename Mesh::Traits;
+using Point3 = typename Kernel::Point_3;
+using Vector3 = typename Kernel::Vector_3;
+using Coefficients = wtlib::Wavelet_coefficients<Vector3>;
 
-void apply_hard_thresholding(std::vector<std::vector<Vector3>>& coefs, double threshold)
+double squared_length(const Coefficients& coefs, int i)
+{
+  return coefs.x()[i] * coefs.x()[i] +
+         coefs.y()[i] * coefs.y()[i] +
+         coefs.z()[i] * coefs.z()[i];
+}
+
+void set_zero(Coefficients& coefs, int i)
+{
+  coefs.x()[i] = 0.0;
+  coefs.y()[i] = 0.0;
+  coefs.z()[i] = 0.0;
+}
+
+void apply_hard_thresholding(Coefficients& coefs, double threshold)
 {
   if (threshold < 0)
   {
@@ -21,57 +41,43 @@ void apply_hard_thresholding(std::vector<std::vector<Vector3>>& coefs, double th
     return;
   }
 
-  int total = 0;
+  int total = coefs.size();
 
   int i = 0;
-  for (std::vector<Vector3>& band_coefs : coefs)
+  for (int j = 0; j < total; ++j)
   {
-    total += band_coefs.size();
-    for (Vector3& v : band_coefs)
+    if (squared_length(coefs, j) < threshold * threshold)
     {
-      if (v.squared_length() < threshold * threshold)
-      {
-        v = Vector3(0.0, 0.0, 0.0);
-        ++i;
-      }
+      set_zero(coefs, j);
+      ++i;
     }
   }
   std::cerr << i << " out of " << total << " coefficients are set to zero\n";
 }
 
-void apply_lowpass_filter(std::vector<std::vector<Vector3>>& coefs, int level)
+void apply_lowpass_filter(Coefficients& coefs, int level)
 {
-  for (int l = 0; l < coefs.size(); ++l)
+  // The bands are stored in order, so the bands above the level are a suffix
+  // of the coordinate arrays.
+  if (level >= coefs.num_bands())
   {
-    if (l + 1 <= level) {
-      continue;
-    }
-    std::vector<Vector3>& band_coefs = coefs[l];
-    for (Vector3& v : band_coefs)
-    {
-      v = Vector3(0.0, 0.0, 0.0);
-    }
+    return;
+  }
+  for (int i = coefs.band_offset(std::max(level, 0)); i < coefs.size(); ++i)
+  {
+    set_zero(coefs, i);
   }
 }
 
-void apply_compressing(std::vector<std::vector<Vector3>>& coefs, double compression)
+void apply_compressing(Coefficients& coefs, double compression)
 {
-  std::vector<std::pair<int, int>> indexes;
-  for (int b = 0; b < coefs.size(); ++b)
-  {
-    for (int i = 0; i < coefs[b].size(); ++i)
-    {
-      indexes.emplace_back(std::pair<int, int>{b, i});
-    }
-  }
+  std::vector<int> indexes(coefs.size());
+  std::iota(indexes.begin(), indexes.end(), 0);
 
   // Sort coefs based on their L2 norm
-  auto compare = [&coefs](const std::pair<int, int>& lhs,
-                          const std::pair<int, int>& rhs)
+  auto compare = [&coefs](int lhs, int rhs)
                           {
-                            const Vector3& lv = coefs[lhs.first][lhs.second];
-                            const Vector3& rv = coefs[rhs.first][rhs.second];
-                            return lv.squared_length() > rv.squared_length();
+                            return squared_length(coefs, lhs) > squared_length(coefs, rhs);
                           };
   std::sort(indexes.begin(), indexes.end(), compare);
 
@@ -85,20 +91,34 @@ void apply_compressing(std::vector<std::vector<Vector3>>& coefs, double compress
   // Drop the smaller coefficients
   for (int i = desired_length; i < indexes.size(); ++i)
   {
-    std::pair<int, int> index = indexes[i];
-    coefs[index.first][index.second] = Vector3 {0.0, 0.0, 0.0};
+    set_zero(coefs, indexes[i]);
   }
 
   std::cerr << "Dropped " << indexes.size() - desired_length << " out of " << indexes.size() << " coefficients\n";
 }
 
+// Read the certificate of an earlier classification, an absent or malformed
+// file gives an empty certificate.
+wtlib::Classification_certificate load_certificate(const std::string& path)
+{
+  wtlib::Classification_certificate certificate;
+  std::ifstream in(path);
+  if (in && !(in >> certificate))
+  {
+    std::cerr << "[WARNING] Ignore the malformed certificate " << path << "\n";
+    certificate = {};
+  }
+  return certificate;
+}
+
 int main(int argc, char** argv)
 {
   po::options_description descriptions(R"(A program performs the Loop or Butterfly wavelet filtering on a triangle mesh.
 
 Usage:
-    wtl_wavelet_analyze -m <scheme> -l <level> 
+    wtl_wavelet_analyze -m <scheme> -l <level> [-j <threads>] [-k]
                         [--input-mesh <args>] [--output-mesh <args>]
+                        [--certificate <args>]
                         (-t <args> | -L | -c <args>)
 
 These are accepted options)");
@@ -108,10 +128,17 @@ These are accepted options)");
                                            "\t - Butterfly\n"
                                            "\t - Loop.")
     ("level,l", po::value<int>(), "Set the number of wavelet transform levels.")
+    ("threads,j", po::value<int>()->default_value(1), "Set the number of threads used by the lifting steps, "
+                                                      "0 selects the number of hardware threads.")
+    ("keep-topology,k", "Keep the connectivity of the input mesh and only transform its vertex positions, "
+                        "instead of coarsening and refining the mesh.")
     ("input-mesh,i", po::value<std::string>(), "Set the file path for the input mesh. "
                                                "Without this option, program will read input mesh from standard input.")
     ("output-mesh,o", po::value<std::string>(), "Set the file path for the output mesh. "
                                                 "Without this option, program will output the mesh to standard output.")
+    ("certificate,C", po::value<std::string>(), "Set the file path for the certificate of the subdivision connectivity. "
+                                                "A certificate matching the input mesh skips the vertex classification, "
+                                                "otherwise the certificate of this classification is written to the file.")
     ("threshold,t", po::value<double>(), "Enable hard-thresholding on filtering the wavelet coefficients. "
                                          "Any wavelet coefficients whose L2 norms are less than the given threshold will be set to zero.")
     ("lowpass-filter,L", po::value<int>(), "Enable lowpass on filtering the wavelet coefficients. Wavelet coefficients above the given level will be set to zero. ")
@@ -147,12 +174,15 @@ These are accepted options)");
 
   
   int num_levels = 0;
+  int num_threads = 1;
   std::string mesh_out;
   std::string mesh_in;
   std::string method;
   double threshold = 0.0;
   double compress = 100;
   int lowpass_level = -1;
+  bool keep_topology = false;
+  std::string certificate_path;
 
   // Parse command line options
   if (vm.count("help"))
@@ -195,6 +225,15 @@ These are accepted options)");
     return 1;
   }
 
+  num_threads = vm["threads"].as<int>();
+  if (num_threads < 0)
+  {
+    std::cerr << "The set number of threads (" << num_threads << ") should be a non-negative integer.\n";
+    return 1;
+  }
+
+  keep_topology = vm.count("keep-topology") && num_levels > 0;
+
   if (vm.count("input-mesh"))
   {
     mesh_in = vm["input-mesh"].as<std::string>();
@@ -226,6 +265,11 @@ These are accepted options)");
     lowpass_level = vm["lowpass-filter"].as<int>();
   }
 
+  if (vm.count("certificate"))
+  {
+    certificate_path = vm["certificate"].as<std::string>();
+  }
+
 
 
   // Load mesh.
@@ -251,7 +295,21 @@ These are accepted options)");
     mesh_in_file.close();
   }
 
-  std::vector<std::vector<Vector3>> coefs;
+  Coefficients coefs;
+
+  // The plans record the lifting stencils of the levels, so that the
+  // transforms of the keep-topology mode leave the mesh connectivity intact.
+  wtlib::Loop_transform_plan<Kernel> loop_plan;
+  wtlib::Butterfly_transform_plan<Kernel> butterfly_plan;
+  std::vector<Point3> coarse_points;
+
+  // Without a certificate file, the empty certificate is replaced and dropped.
+  wtlib::Classification_certificate certificate;
+  if (!certificate_path.empty())
+  {
+    certificate = load_certificate(certificate_path);
+  }
+  const wtlib::Classification_certificate loaded_certificate {certificate};
 
   if (method == "Butterfly")
   {
@@ -261,7 +319,10 @@ These are accepted options)");
       return 1;
     }
   
-    if (!wtlib::butterfly_analyze(mesh, coefs, num_levels))
+    if (keep_topology ?
+        !(butterfly_plan.build(mesh, num_levels, certificate) &&
+          butterfly_plan.analyze(mesh, coarse_points, coefs)) :
+        !wtlib::butterfly_analyze(mesh, coefs, num_levels, certificate, num_threads))
     {
       std::cerr << "[ERROR] The input mesh does not have " << num_levels 
                 << " levels of subdivision connectivity\n";
@@ -270,7 +331,10 @@ These are accepted options)");
   }
   else
   {
-    if (!wtlib::loop_analyze(mesh, coefs, num_levels))
+    if (keep_topology ?
+        !(loop_plan.build(mesh, num_levels, certificate) &&
+          loop_plan.analyze(mesh, coarse_points, coefs)) :
+        !wtlib::loop_analyze(mesh, coefs, num_levels, certificate, num_threads))
     {
       std::cerr << "[ERROR] The input mesh does not have " << num_levels 
                 << " levels of subdivision connectivity\n";
@@ -278,6 +342,16 @@ These are accepted options)");
     }
   }
 
+  if (!certificate_path.empty() && certificate != loaded_certificate)
+  {
+    std::ofstream certificate_file(certificate_path);
+    if (!(certificate_file << certificate))
+    {
+      std::cerr << "[ERROR] Fail to write certificate to " << certificate_path << '\n';
+      return 1;
+    }
+  }
+
   std::function<void()> perform_lowpass = std::bind(&apply_lowpass_filter, std::ref(coefs), lowpass_level);
   std::function<void()> perform_compress = std::bind(&apply_compressing, std::ref(coefs), compress);
   std::function<void()> perform_threshold = std::bind(&apply_hard_thresholding, std::ref(coefs), threshold);
@@ -302,13 +376,24 @@ These are accepted options)");
     f();
   }
 
-  if (method == "Butterfly")
+  if (keep_topology)
+  {
+    if (method == "Butterfly" ?
+        !butterfly_plan.synthesize(mesh, coarse_points, coefs) :
+        !loop_plan.synthesize(mesh, coarse_points, coefs))
+    {
+      std::cerr << "[ERROR] The filtered coefficients do not match the "
+                   "transform plan of the input mesh\n";
+      return 1;
+    }
+  }
+  else if (method == "Butterfly")
   {
-    wtlib::butterfly_synthesize(mesh, coefs, num_levels);
+    wtlib::butterfly_synthesize(mesh, coefs, num_levels, num_threads);
   }
   else
   {
-    wtlib::loop_synthesize(mesh, coefs, num_levels);
+    wtlib::loop_synthesize(mesh, coefs, num_levels, num_threads);
   }
 
   // Output mesh
@@ -11,26 +11,25 @@ namespace po = boost::program_options;
 using Vertex_const_handle = typename Mesh::Vertex_const_handle;
 using Vertex_handle = typename Mesh::Vertex_handle;
 using Vector3 = typename Mesh::Traits::Vector_3;
+using Coefficients = wtlib::Wavelet_coefficients<Vector3>;
 using Get_mesh_size = std::function<int(Mesh&, int)>;
 
-void load_coefs(std::vector<std::vector<Vector3>>& coefs,
+void load_coefs(Coefficients& coefs,
                 std::istream& in)
 {
   std::istringstream coef_scanner;
   std::string coef_buffer;
-  int band_idx = 0;
-  coefs.emplace_back(std::vector<Vector3>{});
+  coefs.add_band();
 
-  double x;
-  double y;
-  double z;
+  Coefficients::FT x;
+  Coefficients::FT y;
+  Coefficients::FT z;
 
   while (std::getline(in, coef_buffer))
   {
     if (coef_buffer.empty())
     {
-      ++band_idx;
-      coefs.push_back(std::vector<Vector3>{});
+      coefs.add_band();
     }
     else
     {
@@ -42,56 +41,47 @@ void load_coefs(std::vector<std::vector<Vector3>>& coefs,
 
       coef_scanner.clear();
 
-      Vector3 c {x, y, z};
-      coefs[band_idx].emplace_back(c);
+      coefs.push_back(Vector3 {x, y, z});
     }
   }
 
-  while (coefs.back().empty())
-  {
-    coefs.pop_back();
-  }
+  coefs.pop_empty_bands();
 }
 
-void coefficients_padding(std::vector<std::vector<Vector3>>& coefs,
-                          Mesh& mesh,
-                          int num_levels)
+std::vector<int> get_band_sizes(Mesh& mesh, int num_levels)
 {
-  if (coefs.size() != num_levels)
-  {
-    coefs.resize(num_levels);
-  }
-
   // int act as a placeholder for Mesh_ops since it is not used
   Get_mesh_size get_mesh_size = wtlib::ptq_impl::PTQ_subdivision_modifier<Mesh, int>::ptq_mesh_size;
 
-  for (int i = 0; i < coefs.size(); ++i)
+  std::vector<int> band_sizes;
+  for (int i = 0; i < num_levels; ++i)
   {
-    int expect_size = get_mesh_size(mesh, i + 1) - get_mesh_size(mesh, i);
-    if (coefs[i].size() != expect_size)
-    {
-      // Feeding zero coefficients
-      coefs[i].resize(expect_size, Vector3 {0.0, 0.0, 0.0});
-    }
+    band_sizes.push_back(get_mesh_size(mesh, i + 1) - get_mesh_size(mesh, i));
   }
+  return band_sizes;
 }
 
-bool coefs_precheck(const std::vector<std::vector<Vector3>>& coefs,
+void coefficients_padding(Coefficients& coefs,
+                          Mesh& mesh,
+                          int num_levels)
+{
+  // Feeding zero coefficients
+  coefs.resize_bands(get_band_sizes(mesh, num_levels));
+}
+
+bool coefs_precheck(const Coefficients& coefs,
                     Mesh& mesh,
                     int num_levels)
 {
-  if (coefs.size() != num_levels)
+  if (coefs.num_bands() != num_levels)
   {
     return false;
   }
 
-  // int act as a placeholder for Mesh_ops since it is not used
-  Get_mesh_size get_mesh_size = wtlib::ptq_impl::PTQ_subdivision_modifier<Mesh, int>::ptq_mesh_size;
-
-  for (int i = 0; i < coefs.size(); ++i)
+  std::vector<int> band_sizes {get_band_sizes(mesh, num_levels)};
+  for (int i = 0; i < coefs.num_bands(); ++i)
   {
-    int expect_size = get_mesh_size(mesh, i + 1) - get_mesh_size(mesh, i);
-    if (coefs[i].size() != expect_size)
+    if (coefs.band_size(i) != band_sizes[i])
     {
       std::cerr << "Invalid coefficients size in level " << i + 1 << '\n';
       return false;
@@ -105,7 +95,7 @@ int main(int argc, char** argv)
   po::options_description descriptions(R"(A program computes the Loop or Butterfly inverse wavelet transform on a triangle mesh.
 
 Usage:
-    wtl_wavelet_synthesize -m <scheme> -l <level> [-A]
+    wtl_wavelet_synthesize -m <scheme> -l <level> [-j <threads>] [-A]
                         [--input-mesh <args>] [--output-mesh <args>]
                         [--output-coefs <args>]
 
@@ -116,6 +106,8 @@ These are accepted options)");
                                            "\t - Butterfly\n"
                                            "\t - Loop.")
     ("level,l", po::value<int>(), "Set the number of wavelet transform levels.")
+    ("threads,j", po::value<int>()->default_value(1), "Set the number of threads used by the lifting steps, "
+                                                      "0 selects the number of hardware threads.")
     ("input-mesh,i", po::value<std::string>(), "Set the file path for the input mesh. "
                                                "Without this option, program will read input mesh from standard input.")
     ("output-mesh,o", po::value<std::string>(), "Set the file path for the refined output mesh. "
@@ -150,6 +142,7 @@ These are accepted options)");
   }
 
   int num_levels = 0;
+  int num_threads = 1;
   std::string mesh_out;
   std::string coefs_in;
   std::string mesh_in;
@@ -202,6 +195,13 @@ These are accepted options)");
     return 1;
   }
 
+  num_threads = vm["threads"].as<int>();
+  if (num_threads < 0)
+  {
+    std::cerr << "The set number of threads (" << num_threads << ") should be a non-negative integer.\n";
+    return 1;
+  }
+
   if (vm.count("input-mesh"))
   {
     mesh_in = vm["input-mesh"].as<std::string>();
@@ -248,7 +248,7 @@ These are accepted options)");
     }
   }
 
-  std::vector<std::vector<Vector3>> coefs;
+  Coefficients coefs;
 
   if (coefs_in.empty())
   {
@@ -279,11 +279,11 @@ These are accepted options)");
 
   if (method == "Butterfly")
   {
-    wtlib::butterfly_synthesize(mesh, coefs, num_levels);
+    wtlib::butterfly_synthesize(mesh, coefs, num_levels, num_threads);
   }
   else
   {
-    wtlib::loop_synthesize(mesh, coefs, num_levels);
+    wtlib::loop_synthesize(mesh, coefs, num_levels, num_threads);
   }
 
 
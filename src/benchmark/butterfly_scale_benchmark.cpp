@@ -0,0 +1,226 @@
+/**
+ * @file     butterfly_scale_benchmark.cpp
+ * @brief    Compares the Butterfly vertex scales kept in a map keyed by
+ *           vertex handle with the scales kept in a vector indexed by vertex
+ *           id (Butterfly_lift_operations::update_scale).
+ *
+ * Usage:
+ *     wtt_butterfly_scale_benchmark [mesh] [levels] [repeats]
+ *
+ * Without a mesh, both sorted_subdivision_meshes/torusknot-3.off and
+ * sorted_subdivision_meshes/bunny.off are timed.
+ */
+
+#include <wtlib/butterfly_wavelet_transform.hpp>
+#include <wtlib/mesh_types.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#if defined (WTLIB_USE_UNORDERED_MAP)
+#include <unordered_map>
+#else
+#include <map>
+#endif  // if defined WTLIB_USE_UNORDERED_MAP
+
+#ifndef BENCHMARK_DATA_DIR
+#define BENCHMARK_DATA_DIR "."
+#endif
+
+using FT = typename Mesh::Traits::FT;
+using Vertex_handle = typename Mesh::Vertex_handle;
+using Mesh_info = wtlib::ptq_impl::Mesh_info<Mesh>;
+using Mesh_ops = wtlib::ptq_impl::Mesh_info_operations<Mesh>;
+using Classify = wtlib::ptq_impl::PTQ_classify_vertices<Mesh, Mesh_ops>;
+using Modifier = wtlib::ptq_impl::PTQ_subdivision_modifier<Mesh, Mesh_ops>;
+using Butterfly = wtlib::ptq_impl::Butterfly_analysis_operations<Mesh,
+                                                                 Mesh_ops>;
+
+// The scales in a map keyed by vertex handle, updated by the same scatter
+// loop as the serial Butterfly_lift_operations::update_scale.
+class Map_scales
+{
+public:
+  void init(const Mesh_ops& m_ops, Vertex_handle* head, Vertex_handle* end)
+  {
+    scales_.clear();
+    for (Vertex_handle* p = head; p != end; ++p)
+    {
+      scales_.insert({*p, 1.0});
+    }
+  }
+
+  void update(Mesh& mesh, const Mesh_ops& m_ops,
+              Vertex_handle* edges_start, Vertex_handle* edges_end)
+  {
+    for (Vertex_handle* p = edges_start; p != edges_end; ++p)
+    {
+      Vertex_handle e = *p;
+      FT se = scales_.at(e);
+      Modifier::Halfedge_pair hps {
+        Modifier::get_halfedges_to_old_vertices(e, m_ops)};
+      scales_[hps.first->vertex()] += 0.5 * se;
+      scales_[hps.second->vertex()] += 0.5 * se;
+      scales_[Butterfly::get_vertex_B(hps.first)] += 0.125 * se;
+      scales_[Butterfly::get_vertex_B(hps.second)] += 0.125 * se;
+      scales_[Butterfly::get_vertex_C0(hps.first)] -= 0.0625 * se;
+      scales_[Butterfly::get_vertex_C1(hps.first)] -= 0.0625 * se;
+      scales_[Butterfly::get_vertex_C0(hps.second)] -= 0.0625 * se;
+      scales_[Butterfly::get_vertex_C1(hps.second)] -= 0.0625 * se;
+    }
+  }
+
+  FT get(Vertex_handle v, const Mesh_ops& m_ops) const
+  {
+    return scales_.at(v);
+  }
+
+private:
+#if defined (WTLIB_USE_UNORDERED_MAP)
+  std::unordered_map<Vertex_handle, FT> scales_;
+#else
+  std::map<Vertex_handle, FT> scales_;
+#endif
+};
+
+// The scales in a vector indexed by vertex id.
+class Dense_scales
+{
+public:
+  void init(const Mesh_ops& m_ops, Vertex_handle* head, Vertex_handle* end)
+  {
+    butterfly_.init_scale(m_ops, head, end, end);
+  }
+
+  void update(Mesh& mesh, const Mesh_ops& m_ops,
+              Vertex_handle* edges_start, Vertex_handle* edges_end)
+  {
+    butterfly_.update_scale(mesh, m_ops, edges_start, edges_end);
+  }
+
+  FT get(Vertex_handle v, const Mesh_ops& m_ops) const
+  {
+    return butterfly_.get_vertex_scale(v, m_ops);
+  }
+
+private:
+  Butterfly butterfly_;
+};
+
+// Update the scales of a fresh, classified copy of the mesh over num_levels
+// levels, and return the best total time of the updates in milliseconds.
+// The scales of the coarsest vertices of the last run are kept in coarsest.
+template <class Scales>
+double time_scales(const Mesh& mesh, int num_levels, int repeats,
+                   std::vector<FT>& coarsest)
+{
+  double best = 0.0;
+  for (int i = 0; i < repeats; ++i)
+  {
+    Mesh m {mesh};
+    Mesh_info mesh_info;
+    Mesh_ops mesh_ops {&mesh_info};
+    std::vector<Vertex_handle> vertices;
+    std::vector<Vertex_handle*> bands;
+    if (!Classify::classify(m, mesh_ops, num_levels, vertices, bands, true))
+    {
+      return -1.0;
+    }
+
+    Scales scales;
+    scales.init(mesh_ops, bands[0], bands[num_levels + 1]);
+    double ms = 0.0;
+    for (int level = num_levels; level > 0; --level)
+    {
+      auto start = std::chrono::steady_clock::now();
+      scales.update(m, mesh_ops, bands[level], bands[level + 1]);
+      auto end = std::chrono::steady_clock::now();
+      ms += std::chrono::duration<double, std::milli>(end - start).count();
+      Modifier::coarsen(m, mesh_ops, level);
+    }
+    best = (i == 0) ? ms : std::min(best, ms);
+
+    coarsest.clear();
+    for (Vertex_handle* p = bands[0]; p != bands[1]; ++p)
+    {
+      coarsest.push_back(scales.get(*p, mesh_ops));
+    }
+  }
+  return best;
+}
+
+int run(const std::string& mesh_in, int num_levels, int repeats)
+{
+  Mesh mesh;
+  std::ifstream mesh_in_file(mesh_in);
+  if (!(mesh_in_file) || !(mesh_in_file >> mesh))
+  {
+    std::cerr << "[ERROR] Fail to read mesh from " << mesh_in << ".\n";
+    return 1;
+  }
+  if (!mesh.is_closed())
+  {
+    std::cerr << "[ERROR] The Butterfly transform needs a closed mesh.\n";
+    return 1;
+  }
+  std::cout << mesh_in << ": " << mesh.size_of_vertices() << " vertices, "
+            << num_levels << " levels, best of " << repeats << "\n";
+
+  std::vector<FT> map_coarsest;
+  std::vector<FT> dense_coarsest;
+  double map_ms = time_scales<Map_scales>(mesh, num_levels, repeats,
+                                          map_coarsest);
+  double dense_ms = time_scales<Dense_scales>(mesh, num_levels, repeats,
+                                              dense_coarsest);
+  if (map_ms < 0.0 || dense_ms < 0.0)
+  {
+    std::cout << "The mesh does not have enough levels of subdivision "
+                 "connectivity.\n";
+    return 1;
+  }
+  if (map_coarsest != dense_coarsest)
+  {
+    std::cerr << "[ERROR] The dense scales differ from the map scales.\n";
+    return 1;
+  }
+  std::cout << "Butterfly scales:\n"
+            << "  map by handle:  " << map_ms << " ms\n"
+            << "  vector by id:   " << dense_ms << " ms\n"
+            << "  speedup:        " << map_ms / dense_ms << "\n";
+  return 0;
+}
+
+int main(int argc, char** argv)
+{
+  std::vector<std::string> meshes;
+  if (argc > 1)
+  {
+    meshes.push_back(argv[1]);
+  }
+  else
+  {
+    meshes.push_back(std::string(BENCHMARK_DATA_DIR) +
+                     "sorted_subdivision_meshes/torusknot-3.off");
+    meshes.push_back(std::string(BENCHMARK_DATA_DIR) +
+                     "sorted_subdivision_meshes/bunny.off");
+  }
+  int num_levels = (argc > 2) ? std::stoi(argv[2]) : 3;
+  int repeats = (argc > 3) ? std::stoi(argv[3]) : 5;
+  if (num_levels < 1 || repeats < 1)
+  {
+    std::cerr << "The number of levels and repeats should be positive.\n";
+    return 1;
+  }
+
+  for (const std::string& mesh_in : meshes)
+  {
+    if (run(mesh_in, num_levels, repeats) != 0)
+    {
+      return 1;
+    }
+  }
+  return 0;
+}
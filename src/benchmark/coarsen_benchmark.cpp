@@ -0,0 +1,110 @@
+/**
+ * @file     coarsen_benchmark.cpp
+ * @brief    Compares the coarsening of a Compact_mesh by joining facets and
+ *           vertices per element (PTQ_subdivision_modifier::coarsen_by_joins)
+ *           with the one-pass rebuild of the coarse connectivity
+ *           (PTQ_subdivision_modifier::coarsen_by_rebuild).
+ *
+ * Usage:
+ *     wtt_coarsen_benchmark [mesh] [levels] [repeats]
+ */
+
+#include <wtlib/compact_mesh.hpp>
+#include <wtlib/loop_wavelet_transform.hpp>
+#include <wtlib/mesh_types.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef BENCHMARK_DATA_DIR
+#define BENCHMARK_DATA_DIR "."
+#endif
+
+using Compact_mesh = wtlib::Compact_mesh<MeshKernel>;
+using Compact_vertex_handle = typename Compact_mesh::Vertex_handle;
+using Compact_mesh_info = wtlib::ptq_impl::Mesh_info<Compact_mesh>;
+using Compact_mesh_ops = wtlib::ptq_impl::Mesh_info_operations<Compact_mesh>;
+using Classify = wtlib::ptq_impl::PTQ_classify_vertices<Compact_mesh,
+                                                        Compact_mesh_ops>;
+using Modifier = wtlib::ptq_impl::PTQ_subdivision_modifier<Compact_mesh,
+                                                           Compact_mesh_ops>;
+
+// Coarsen a fresh, classified copy of the mesh by num_levels levels, and
+// return the best time of the coarsening in milliseconds.
+template <class Coarsen>
+double time_coarsen(const Mesh& mesh, int num_levels, int repeats,
+                    Coarsen coarsen)
+{
+  double best = 0.0;
+  for (int i = 0; i < repeats; ++i)
+  {
+    Compact_mesh m;
+    if (!wtlib::polyhedron_to_compact_mesh(mesh, m))
+    {
+      return -1.0;
+    }
+    Compact_mesh_info mesh_info;
+    Compact_mesh_ops mesh_ops {&mesh_info};
+    std::vector<Compact_vertex_handle> vertices;
+    std::vector<Compact_vertex_handle*> bands;
+    if (!Classify::classify(m, mesh_ops, num_levels, vertices, bands, true))
+    {
+      return -1.0;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int level = num_levels; level > 0; --level)
+    {
+      coarsen(m, mesh_ops, level);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    best = (i == 0) ? ms : std::min(best, ms);
+  }
+  return best;
+}
+
+int main(int argc, char** argv)
+{
+  std::string mesh_in = (argc > 1) ? argv[1] :
+    std::string(BENCHMARK_DATA_DIR) +
+    "subdivided_meshes/dragon_500_2000_8000_32000.off";
+  int num_levels = (argc > 2) ? std::stoi(argv[2]) : 3;
+  int repeats = (argc > 3) ? std::stoi(argv[3]) : 5;
+  if (num_levels < 1 || repeats < 1)
+  {
+    std::cerr << "The number of levels and repeats should be positive.\n";
+    return 1;
+  }
+
+  Mesh mesh;
+  std::ifstream mesh_in_file(mesh_in);
+  if (!(mesh_in_file) || !(mesh_in_file >> mesh))
+  {
+    std::cerr << "[ERROR] Fail to read mesh from " << mesh_in << ".\n";
+    return 1;
+  }
+  std::cout << mesh_in << ": " << mesh.size_of_vertices() << " vertices, "
+            << num_levels << " levels, best of " << repeats << "\n";
+
+  double joins_ms = time_coarsen(mesh, num_levels, repeats,
+                                 &Modifier::coarsen_by_joins);
+  double rebuild_ms = time_coarsen(mesh, num_levels, repeats,
+                                   &Modifier::coarsen_by_rebuild);
+  if (joins_ms < 0.0 || rebuild_ms < 0.0)
+  {
+    std::cout << "The mesh does not have enough levels of subdivision "
+                 "connectivity.\n";
+    return 1;
+  }
+  std::cout << "Coarsen:\n"
+            << "  join per element: " << joins_ms << " ms\n"
+            << "  one-pass rebuild: " << rebuild_ms << " ms\n"
+            << "  speedup:          " << joins_ms / rebuild_ms << "\n";
+
+  return 0;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file     loop_weight_benchmark.cpp
+ * @brief    Compares the Loop lifting weights solved per edge
+ *           (Loop_math::get_weight) with the weights looked up by valences
+ *           (Loop_math::get_cached_weight), over the valence tuples of the
+ *           inner edges of a mesh.
+ *
+ * Usage:
+ *     wtt_loop_weight_benchmark [mesh] [repeats]
+ */
+
+#include <wtlib/mesh_types.hpp>
+#include <wtlib/ptq_impl/loop_math_utils.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef BENCHMARK_DATA_DIR
+#define BENCHMARK_DATA_DIR "."
+#endif
+
+using FT = typename Mesh::Traits::FT;
+using Math = wtlib::ptq_impl::Loop_math<FT>;
+using Valences = std::array<int, 4>;
+
+// Compute the weights of all tuples, and return the best time in
+// milliseconds. The sum of the weights keeps the work from being optimized
+// away.
+template <class Get_weight>
+double time_weights(const std::vector<Valences>& tuples, int repeats,
+                    FT& sum, Get_weight get_weight)
+{
+  double best = 0.0;
+  for (int i = 0; i < repeats; ++i)
+  {
+    sum = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (const Valences& n : tuples)
+    {
+      sum += get_weight(n[0], n[1], n[2], n[3]).sum();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    best = (i == 0) ? ms : std::min(best, ms);
+  }
+  return best;
+}
+
+int main(int argc, char** argv)
+{
+  std::string mesh_in = (argc > 1) ? argv[1] :
+    std::string(BENCHMARK_DATA_DIR) + "sorted_subdivision_meshes/bunny.off";
+  int repeats = (argc > 2) ? std::stoi(argv[2]) : 5;
+  if (repeats < 1)
+  {
+    std::cerr << "The number of repeats should be positive.\n";
+    return 1;
+  }
+
+  Mesh mesh;
+  std::ifstream mesh_in_file(mesh_in);
+  if (!(mesh_in_file) || !(mesh_in_file >> mesh))
+  {
+    std::cerr << "[ERROR] Fail to read mesh from " << mesh_in << ".\n";
+    return 1;
+  }
+
+  // The valences of the two ends and the two opposite vertices of every
+  // inner edge, as read by the Loop lifting of an edge vertex.
+  std::vector<Valences> tuples;
+  for (auto e = mesh.edges_begin(); e != mesh.edges_end(); ++e)
+  {
+    if (e->is_border_edge())
+    {
+      continue;
+    }
+    tuples.push_back({static_cast<int>(e->vertex()->degree()),
+                      static_cast<int>(e->opposite()->vertex()->degree()),
+                      static_cast<int>(e->next()->vertex()->degree()),
+                      static_cast<int>(e->opposite()->next()->vertex()->degree())});
+  }
+  std::cout << mesh_in << ": " << tuples.size() << " inner edges, best of "
+            << repeats << "\n";
+
+  FT solved_sum;
+  FT cached_sum;
+  double solved_ms = time_weights(tuples, repeats, solved_sum,
+                                  &Math::get_weight);
+  double cached_ms = time_weights(tuples, repeats, cached_sum,
+                                  &Math::get_cached_weight);
+  if (solved_sum != cached_sum)
+  {
+    std::cerr << "[ERROR] The cached weights differ from the solved ones.\n";
+    return 1;
+  }
+  std::cout << "Loop weights:\n"
+            << "  solved per edge:      " << solved_ms << " ms\n"
+            << "  looked up by valence: " << cached_ms << " ms\n"
+            << "  speedup:              " << solved_ms / cached_ms << "\n";
+
+  return 0;
+}
@@ -0,0 +1,146 @@
+/**
+ * @file     mesh_ops_benchmark.cpp
+ * @brief    Compares the forward wavelet transforms using mesh operations
+ *           built from std::function objects (Wavelet_mesh_operations) with
+ *           the default mesh operations (ptq_impl::Mesh_info_operations).
+ *
+ * Usage:
+ *     wtt_mesh_ops_benchmark [mesh] [levels] [repeats]
+ */
+
+#include <wtlib/butterfly_wavelet_transform.hpp>
+#include <wtlib/loop_wavelet_transform.hpp>
+#include <wtlib/mesh_types.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef BENCHMARK_DATA_DIR
+#define BENCHMARK_DATA_DIR "."
+#endif
+
+using Vertex_const_handle = typename Mesh::Vertex_const_handle;
+using Vertex_handle = typename Mesh::Vertex_handle;
+using Vector3 = typename Mesh::Traits::Vector_3;
+
+using Mesh_info = wtlib::ptq_impl::Mesh_info<Mesh>;
+using Function_mesh_ops = wtlib::Wavelet_mesh_operations<
+                                  Mesh,
+                                  std::function<int(Vertex_const_handle)>,
+                                  std::function<void(Vertex_handle, int)>,
+                                  std::function<int(Vertex_const_handle)>,
+                                  std::function<void(Vertex_handle, int)>,
+                                  std::function<int(Vertex_const_handle)>,
+                                  std::function<void(Vertex_handle, int)>,
+                                  std::function<bool(Vertex_const_handle)>,
+                                  std::function<void(Vertex_handle, bool)>>;
+
+Function_mesh_ops make_function_mesh_ops(Mesh_info* mesh_info)
+{
+  using namespace std::placeholders;
+  return {std::bind(&Mesh_info::get_vertex_id, mesh_info, _1),
+          std::bind(&Mesh_info::set_vertex_id, mesh_info, _1, _2),
+          std::bind(&Mesh_info::get_vertex_level, mesh_info, _1),
+          std::bind(&Mesh_info::set_vertex_level, mesh_info, _1, _2),
+          std::bind(&Mesh_info::get_vertex_type, mesh_info, _1),
+          std::bind(&Mesh_info::set_vertex_type, mesh_info, _1, _2),
+          std::bind(&Mesh_info::get_vertex_border, mesh_info, _1),
+          std::bind(&Mesh_info::set_vertex_border, mesh_info, _1, _2)};
+}
+
+// Run the transform on a fresh copy of the mesh, and return the best time in
+// milliseconds.
+template <class Transform>
+double time_transform(const Mesh& mesh, int repeats, Transform transform)
+{
+  double best = 0.0;
+  for (int i = 0; i < repeats; ++i)
+  {
+    Mesh m {mesh};
+    std::vector<std::vector<Vector3>> coefs;
+    auto start = std::chrono::steady_clock::now();
+    if (!transform(m, coefs))
+    {
+      return -1.0;
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    best = (i == 0) ? ms : std::min(best, ms);
+  }
+  return best;
+}
+
+void report(const std::string& name, double function_ms, double static_ms)
+{
+  if (function_ms < 0.0 || static_ms < 0.0)
+  {
+    std::cout << name << ": the mesh does not have enough levels of "
+                         "subdivision connectivity.\n";
+    return;
+  }
+  std::cout << name << ":\n"
+            << "  std::function mesh ops: " << function_ms << " ms\n"
+            << "  static mesh ops:        " << static_ms << " ms\n"
+            << "  speedup:                " << function_ms / static_ms << "\n";
+}
+
+int main(int argc, char** argv)
+{
+  std::string mesh_in = (argc > 1) ? argv[1] :
+    std::string(BENCHMARK_DATA_DIR) + "sorted_subdivision_meshes/bunny.off";
+  int num_levels = (argc > 2) ? std::stoi(argv[2]) : 3;
+  int repeats = (argc > 3) ? std::stoi(argv[3]) : 5;
+  if (num_levels < 1 || repeats < 1)
+  {
+    std::cerr << "The number of levels and repeats should be positive.\n";
+    return 1;
+  }
+
+  Mesh mesh;
+  std::ifstream mesh_in_file(mesh_in);
+  if (!(mesh_in_file) || !(mesh_in_file >> mesh))
+  {
+    std::cerr << "[ERROR] Fail to read mesh from " << mesh_in << ".\n";
+    return 1;
+  }
+  std::cout << mesh_in << ": " << mesh.size_of_vertices() << " vertices, "
+            << num_levels << " levels, best of " << repeats << "\n";
+
+  report("Loop analysis",
+         time_transform(mesh, repeats,
+           [&](Mesh& m, std::vector<std::vector<Vector3>>& coefs)
+           {
+             Mesh_info mesh_info;
+             Function_mesh_ops mesh_ops {make_function_mesh_ops(&mesh_info)};
+             return wtlib::loop_analyze(m, mesh_ops, coefs, num_levels);
+           }),
+         time_transform(mesh, repeats,
+           [&](Mesh& m, std::vector<std::vector<Vector3>>& coefs)
+           {
+             return wtlib::loop_analyze(m, coefs, num_levels);
+           }));
+
+  if (mesh.is_closed())
+  {
+    report("Butterfly analysis",
+           time_transform(mesh, repeats,
+             [&](Mesh& m, std::vector<std::vector<Vector3>>& coefs)
+             {
+               Mesh_info mesh_info;
+               Function_mesh_ops mesh_ops {make_function_mesh_ops(&mesh_info)};
+               return wtlib::butterfly_analyze(m, mesh_ops, coefs, num_levels);
+             }),
+           time_transform(mesh, repeats,
+             [&](Mesh& m, std::vector<std::vector<Vector3>>& coefs)
+             {
+               return wtlib::butterfly_analyze(m, coefs, num_levels);
+             }));
+  }
+
+  return 0;
+}
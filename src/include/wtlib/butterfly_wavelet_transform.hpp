@@ -6,338 +6,327 @@
  * @brief    Defines the Butterfly wavelet transforms.
  */
 
+#include <wtlib/classification_certificate.hpp>
+#include <wtlib/mesh_components.hpp>
 #include <wtlib/ptq_impl/butterfly_wavelet_operations.hpp>
 #include <wtlib/ptq_impl/mesh_vertex_info.hpp>
 #include <wtlib/ptq_impl/subdivision_modifier.hpp>
 #include <wtlib/ptq_impl/vertex_classification.hpp>
+#include <wtlib/wavelet_coefficients.hpp>
 #include <wtlib/wavelet_mesh_operations.hpp>
 #include <wtlib/wavelet_operations.hpp>
 
 namespace wtlib
 {
 /**
- * @brief    The Butterfly forward wavelet transform.
- *
- * @tparam   Mesh       Type of mesh
- * @param    mesh       The input mesh 
- * @param    coefs      The wavelet coefficients, where an inner vector is the
- *                      wavelet coefficients at a resolution.
- * @param    num_levels The number of transform levels.
- *
- * @return true         
- * @return false        FWT fails because the input mesh does not have enough
- *                      levels of subdivision connectivity.
+ * @brief    The Butterfly forward wavelet transform of num_levels levels, or
+ *           of as many levels as the mesh has up to num_levels if max_levels
+ *           is true, which does not use a certificate. Returns the number of
+ *           transform levels, 0 on failure.
  */
-template<class Mesh>
-bool butterfly_analyze(Mesh& mesh,
-                       std::vector<std::vector<typename Mesh::Traits::Vector_3>>& coefs,
-                       int num_levels)
+template<class Mesh, class Mesh_ops, class Coefs>
+int butterfly_analyze_levels_with_ops(Mesh& mesh,
+                                      const Mesh_ops& mesh_ops,
+                                      Coefs& coefs,
+                                      int num_levels,
+                                      int num_threads,
+                                      Classification_certificate* certificate,
+                                      bool max_levels)
 {
   using Vertex_handle = typename Mesh::Vertex_handle;
-  using Vertex_const_handle = typename Mesh::Vertex_const_handle;
-  using Get_vertex_id = std::function<int(Vertex_const_handle)>;
-  using Set_vertex_id = std::function<void(Vertex_handle, int)>;
-  using Get_vertex_level = std::function<int(Vertex_const_handle)>;
-  using Set_vertex_level = std::function<void(Vertex_handle, int)>;
-  using Get_vertex_type = std::function<int(Vertex_const_handle)>;
-  using Set_vertex_type = std::function<void(Vertex_handle, int)>;
-  using Get_vertex_border = std::function<bool(Vertex_const_handle)>;
-  using Set_vertex_border = std::function<void(Vertex_handle, bool)>;
-  using Mesh_info = ptq_impl::Mesh_info<Mesh>;
-  using Mesh_ops = Wavelet_mesh_operations<
-                                        Mesh,
-                                        Get_vertex_id,
-                                        Set_vertex_id,
-                                        Get_vertex_level,
-                                        Set_vertex_level,
-                                        Get_vertex_type,
-                                        Set_vertex_type,
-                                        Get_vertex_border,
-                                        Set_vertex_border
-                                      >;
-
-
-  using Get_num_types = std::function<int(Mesh&, const Mesh_ops&)>;
-  using Classify_vertices = std::function<int(Mesh&,
-                                              const Mesh_ops&,
-                                              int,
-                                              std::vector<Vertex_handle>&,
-                                              std::vector<Vertex_handle*>&)>;
-  using Cleanup = std::function<void(Mesh&, const Mesh_ops&)>;
-  using Lift = std::function<void(Mesh&,
-                                  const Mesh_ops&,
-                                  Vertex_handle**,
-                                  Vertex_handle**)>;
-  using Coarsen = std::function<void(Mesh&, const Mesh_ops&, int)>;
-  using Initialize = std::function<void(Mesh&, const Mesh_ops&)>;
-
-
-
-  using Analysis_ops = Wavelet_analysis_ops<Mesh,
-                                            Mesh_ops,
-                                            Get_num_types,
-                                            Classify_vertices,
-                                            Initialize,
-                                            Cleanup,
-                                            Lift,
-                                            Coarsen>;
-
-  using Analyze = Wavelet_analyze<Mesh_ops, Analysis_ops>;
-
   using Butterfly = ptq_impl::Butterfly_analysis_operations<Mesh, Mesh_ops>;
   using PTQ_classify = ptq_impl::PTQ_classify_vertices<Mesh, Mesh_ops>;
   using PTQ_modifier = ptq_impl::PTQ_subdivision_modifier<Mesh, Mesh_ops>;
 
-  using std::placeholders::_1;
-  using std::placeholders::_2;
-  using std::placeholders::_3;
-  using std::placeholders::_4;
-
   assert(!mesh.empty() && mesh.is_pure_triangle() && mesh.is_closed());
+  assert(!(certificate && max_levels));
 
-  // PTQ classify and coarsen functors
-  PTQ_classify classify;
-  Get_num_types get_num_types = &PTQ_classify::get_num_types;
-  Coarsen coarsen = &PTQ_modifier::coarsen;
-
-  // Butterfly specific operations functors
+  // Butterfly specific operations functors, the lambdas are called directly
+  // instead of through std::function.
   Butterfly butterfly;
-  Initialize initialize = std::bind(&Butterfly::initialize, &butterfly, _1, _2);
-  Cleanup cleanup = std::bind(&Butterfly::cleanup, &butterfly, _1, _2);
-  Lift lift = std::bind(&Butterfly::lift, &butterfly, _1, _2, _3, _4);
-
-  // Setup mesh_ops
-  // Hold mesh vertex info
-  Mesh_info mesh_info;
-  // Mesh operations functors
-  Get_vertex_id get_vertex_id = std::bind(&Mesh_info::get_vertex_id, &mesh_info,  _1);
-  Set_vertex_id set_vertex_id = std::bind(&Mesh_info::set_vertex_id, &mesh_info,  _1, _2);
-  Get_vertex_type get_vertex_type = std::bind(&Mesh_info::get_vertex_type, &mesh_info,  _1);
-  Set_vertex_type set_vertex_type = std::bind(&Mesh_info::set_vertex_type, &mesh_info,  _1, _2);
-  Get_vertex_border get_vertex_border = std::bind(&Mesh_info::get_vertex_border, &mesh_info,  _1);
-  Set_vertex_border set_vertex_border = std::bind(&Mesh_info::set_vertex_border, &mesh_info,  _1, _2);
-  Get_vertex_level get_vertex_level = std::bind(&Mesh_info::get_vertex_level, &mesh_info,  _1);
-  Set_vertex_level set_vertex_level = std::bind(&Mesh_info::set_vertex_level, &mesh_info,  _1, _2);
-
-  Mesh_ops mesh_ops {get_vertex_id,
-                     set_vertex_id,
-                     get_vertex_level,
-                     set_vertex_level,
-                     get_vertex_type,
-                     set_vertex_type,
-                     get_vertex_border,
-                     set_vertex_border};
+  num_threads = ptq_impl::get_num_threads(num_threads);
+  auto initialize = [&butterfly](Mesh& m, const Mesh_ops& m_ops)
+                    {
+                      butterfly.initialize(m, m_ops);
+                    };
+  auto cleanup = [&butterfly](Mesh& m, const Mesh_ops& m_ops)
+                 {
+                   butterfly.cleanup(m, m_ops);
+                 };
+  auto lift = [&butterfly, num_threads](Mesh& m,
+                                        const Mesh_ops& m_ops,
+                                        Vertex_handle** first_band,
+                                        Vertex_handle** last_band)
+              {
+                butterfly.lift(m, m_ops, first_band, last_band, num_threads);
+              };
+  auto classify = [certificate, max_levels, num_threads](Mesh& m,
+                                                         const Mesh_ops& m_ops,
+                                                         int n,
+                                                         std::vector<Vertex_handle>& vertices,
+                                                         std::vector<Vertex_handle*>& bands)
+                  {
+                    if (max_levels)
+                    {
+                      return PTQ_classify::classify_max_levels(m, m_ops, n, vertices, bands, true, num_threads) > 0;
+                    }
+                    return certificate ?
+                      PTQ_classify::classify(m, m_ops, n, vertices, bands, *certificate, num_threads) :
+                      PTQ_classify::classify(m, m_ops, n, vertices, bands, true, num_threads);
+                  };
 
   // Create analysis operations.
-  Analysis_ops analysis {get_num_types,
-                         classify,
-                         initialize,
-                         cleanup,
-                         lift,
-                         coarsen};
-
-  Analyze analyze {mesh_ops, analysis};
-
-  return analyze(mesh, coefs, num_levels);
+  auto analysis = make_wavelet_analysis_ops<Mesh, Mesh_ops>(
+                    &PTQ_classify::get_num_types,
+                    classify,
+                    initialize,
+                    cleanup,
+                    lift,
+                    &PTQ_modifier::coarsen);
+
+  Wavelet_analyze<Mesh_ops, decltype(analysis)> analyze {mesh_ops, analysis};
+
+  if (max_levels)
+  {
+    return analyze.analyze_max_levels(mesh, coefs, num_levels);
+  }
+  return analyze(mesh, coefs, num_levels) ? num_levels : 0;
 }
 
+/**
+ * @brief    The Butterfly forward wavelet transform with the given mesh
+ *           operations, where coefs is a std::vector<std::vector<Vector_3>>
+ *           or a Wavelet_coefficients<Vector_3>. Mesh operations whose
+ *           accessors are plain member functions are inlined into the lifting
+ *           steps. A non-null certificate is used to skip the vertex
+ *           classification and is updated otherwise.
+ */
+template<class Mesh, class Mesh_ops, class Coefs>
+bool butterfly_analyze_with_ops(Mesh& mesh,
+                                const Mesh_ops& mesh_ops,
+                                Coefs& coefs,
+                                int num_levels,
+                                int num_threads,
+                                Classification_certificate* certificate = nullptr)
+{
+  return butterfly_analyze_levels_with_ops(mesh,
+                                           mesh_ops,
+                                           coefs,
+                                           num_levels,
+                                           num_threads,
+                                           certificate,
+                                           false) > 0;
+}
 
 /**
- * @brief    Overloaded butterfly_analyze, which allows user to pass in custom mesh_ops.
- *
+ * @brief    The Butterfly inverse wavelet transform with the given mesh
+ *           operations, where coefs is a std::vector<std::vector<Vector_3>>,
+ *           whose used bands are erased, or a const
+ *           Wavelet_coefficients<Vector_3>.
  */
-template<class Mesh, class Mesh_ops>
-bool butterfly_analyze(Mesh& mesh,
-                       const Mesh_ops& mesh_ops,
-                       std::vector<std::vector<typename Mesh::Traits::Vector_3>>& coefs,
-                       int num_levels)
+template<class Mesh, class Mesh_ops, class Coefs>
+void butterfly_synthesize_with_ops(Mesh& mesh,
+                                   const Mesh_ops& mesh_ops,
+                                   Coefs& coefs,
+                                   int num_levels,
+                                   int num_threads)
 {
   using Vertex_handle = typename Mesh::Vertex_handle;
-  using Get_num_types = std::function<int(Mesh&, const Mesh_ops&)>;
-  using Classify_vertices = std::function<int(Mesh&,
-                                              const Mesh_ops&,
-                                              int,
-                                              std::vector<Vertex_handle>&,
-                                              std::vector<Vertex_handle*>&)>;
-  using Cleanup = std::function<void(Mesh&, const Mesh_ops&)>;
-  using Lift = std::function<void(Mesh&,
-                                  const Mesh_ops&,
-                                  Vertex_handle**,
-                                  Vertex_handle**)>;
-  using Coarsen = std::function<void(Mesh&, const Mesh_ops&, int)>;
-  using Initialize = std::function<void(Mesh&, const Mesh_ops&)>;
-
-  using Analysis_ops = Wavelet_analysis_ops<Mesh,
-                                            Mesh_ops,
-                                            Get_num_types,
-                                            Classify_vertices,
-                                            Initialize,
-                                            Cleanup,
-                                            Lift,
-                                            Coarsen>;
-
-  using Analyze = Wavelet_analyze<Mesh_ops, Analysis_ops>;
-
-  using Butterfly = ptq_impl::Butterfly_analysis_operations<Mesh, Mesh_ops>;
+  using Butterfly = ptq_impl::Butterfly_synthesis_operations<Mesh, Mesh_ops>;
   using PTQ_classify = ptq_impl::PTQ_classify_vertices<Mesh, Mesh_ops>;
   using PTQ_modifier = ptq_impl::PTQ_subdivision_modifier<Mesh, Mesh_ops>;
 
-  using std::placeholders::_1;
-  using std::placeholders::_2;
-  using std::placeholders::_3;
-  using std::placeholders::_4;
-
   assert(!mesh.empty() && mesh.is_pure_triangle() && mesh.is_closed());
 
-  // PTQ classify and coarsen functors
-  PTQ_classify classify;
-  Get_num_types get_num_types = &PTQ_classify::get_num_types;
-  Coarsen coarsen = &PTQ_modifier::coarsen;
-
   // Butterfly specific operations functors
   Butterfly butterfly;
-  Initialize initialize = std::bind(&Butterfly::initialize, &butterfly, _1, _2);
-  Cleanup cleanup = std::bind(&Butterfly::cleanup, &butterfly, _1, _2);
-  Lift lift = std::bind(&Butterfly::lift, &butterfly, _1, _2, _3, _4);
+  num_threads = ptq_impl::get_num_threads(num_threads);
+  auto initialize = [&butterfly](Mesh& m, const Mesh_ops& m_ops, int level)
+                    {
+                      // The synthesis refines the mesh level times.
+                      PTQ_modifier::reserve(m, level);
+                      butterfly.initialize(m, m_ops, level);
+                    };
+  auto cleanup = [&butterfly](Mesh& m, const Mesh_ops& m_ops)
+                 {
+                   butterfly.cleanup(m, m_ops);
+                 };
+  auto lift = [&butterfly, num_threads](Mesh& m,
+                                        const Mesh_ops& m_ops,
+                                        Vertex_handle** first_band,
+                                        Vertex_handle** last_band)
+              {
+                butterfly.lift(m, m_ops, first_band, last_band, num_threads);
+              };
+
+  // Create synthesis operations.
+  auto synthesis = make_wavelet_synthesis_ops<Mesh, Mesh_ops>(
+                     &PTQ_classify::get_num_types,
+                     &PTQ_modifier::get_mesh_size,
+                     initialize,
+                     cleanup,
+                     &PTQ_modifier::refine,
+                     lift);
+
+  Wavelet_synthesize<Mesh_ops, decltype(synthesis)> synthesize {mesh_ops,
+                                                                synthesis};
 
-  // Create analysis operations.
-  Analysis_ops analysis {get_num_types,
-                         classify,
-                         initialize,
-                         cleanup,
-                         lift,
-                         coarsen};
+  synthesize(mesh, coefs, num_levels);
+}
 
-  Analyze analyze {mesh_ops, analysis};
+/**
+ * @brief    Overloaded butterfly_analyze, which allows user to pass in custom
+ *           mesh_ops (e.g., Wavelet_mesh_operations).
+ */
+template<class Mesh, class Mesh_ops>
+bool butterfly_analyze(Mesh& mesh,
+                       const Mesh_ops& mesh_ops,
+                       std::vector<std::vector<typename Mesh::Traits::Vector_3>>& coefs,
+                       int num_levels,
+                       int num_threads = 1)
+{
+  return butterfly_analyze_with_ops(mesh, mesh_ops, coefs, num_levels, num_threads);
+}
 
-  return analyze(mesh, coefs, num_levels);
+/**
+ * @brief    Overloaded butterfly_analyze with custom mesh_ops, writing the
+ *           coefficients to a contiguous buffer.
+ */
+template<class Mesh, class Mesh_ops>
+bool butterfly_analyze(Mesh& mesh,
+                       const Mesh_ops& mesh_ops,
+                       Wavelet_coefficients<typename Mesh::Traits::Vector_3>& coefs,
+                       int num_levels,
+                       int num_threads = 1)
+{
+  return butterfly_analyze_with_ops(mesh, mesh_ops, coefs, num_levels, num_threads);
 }
 
 /**
- * @brief    The Butterfly inverse wavelet transform.
+ * @brief    The Butterfly forward wavelet transform.
  *
  * @tparam   Mesh       Type of mesh
  * @param    mesh       The input mesh 
- * @param    coefs      The wavelet coefficients, where an inner vector should
- *                      be the wavelet coefficients at a resolution, and the
- *                      number should match the number of introduced vertices.
+ * @param    coefs      The wavelet coefficients, where an inner vector is the
+ *                      wavelet coefficients at a resolution.
  * @param    num_levels The number of transform levels.
+ * @param    num_threads The number of threads used by the lifting steps, a
+ *                      value less than 1 uses all hardware threads.
  *
+ * @return true         
+ * @return false        FWT fails because the input mesh does not have enough
+ *                      levels of subdivision connectivity.
  */
 template<class Mesh>
-void butterfly_synthesize(Mesh& mesh,
-                          std::vector<std::vector<typename Mesh::Traits::Vector_3>>& coefs,
-                          int num_levels)
+bool butterfly_analyze(Mesh& mesh,
+                       std::vector<std::vector<typename Mesh::Traits::Vector_3>>& coefs,
+                       int num_levels,
+                       int num_threads = 1)
 {
-  using Vertex_handle = typename Mesh::Vertex_handle;
-  using Vertex_const_handle = typename Mesh::Vertex_const_handle;
-
-
-  using Get_vertex_id = std::function<int(Vertex_const_handle)>;
-  using Set_vertex_id = std::function<void(Vertex_handle, int)>;
-  using Get_vertex_level = std::function<int(Vertex_const_handle)>;
-  using Set_vertex_level = std::function<void(Vertex_handle, int)>;
-  using Get_vertex_type = std::function<int(Vertex_const_handle)>;
-  using Set_vertex_type = std::function<void(Vertex_handle, int)>;
-  using Get_vertex_border = std::function<bool(Vertex_const_handle)>;
-  using Set_vertex_border = std::function<void(Vertex_handle, bool)>;
-  using Mesh_info = ptq_impl::Mesh_info<Mesh>;
-  using Mesh_ops = Wavelet_mesh_operations<
-                                        Mesh,
-                                        Get_vertex_id,
-                                        Set_vertex_id,
-                                        Get_vertex_level,
-                                        Set_vertex_level,
-                                        Get_vertex_type,
-                                        Set_vertex_type,
-                                        Get_vertex_border,
-                                        Set_vertex_border
-                                      >;
-
-
-  using Get_num_types = std::function<int(Mesh&, const Mesh_ops&)>;
-  using Get_mesh_size = std::function<int(Mesh&, const Mesh_ops&, int)>;
-
-  using Cleanup = std::function<void(Mesh&, const Mesh_ops&)>;
-  using Lift = std::function<void(Mesh&,
-                                  const Mesh_ops&,
-                                  Vertex_handle**,
-                                  Vertex_handle**)>;
-  using Refine = std::function<void(Mesh&, 
-                                    const Mesh_ops&,
-                                    int,
-                                    std::vector<Vertex_handle>&,
-                                    std::vector<Vertex_handle*>&)>;
-  using Initialize = std::function<void(Mesh&, const Mesh_ops&, int)>;
-
-
-
-  using Synthesis_ops = Wavelet_synthesis_ops<Mesh,
-                                              Mesh_ops,
-                                              Get_num_types,
-                                              Get_mesh_size,
-                                              Initialize,
-                                              Cleanup,
-                                              Refine,
-                                              Lift>;
-
-  using Synthesize = Wavelet_synthesize<Mesh_ops, Synthesis_ops>;
+  // Hold mesh vertex info
+  ptq_impl::Mesh_info<Mesh> mesh_info;
+  ptq_impl::Mesh_info_operations<Mesh> mesh_ops {&mesh_info};
 
-  using Butterfly = ptq_impl::Butterfly_synthesis_operations<Mesh, Mesh_ops>;
-  using PTQ_classify = ptq_impl::PTQ_classify_vertices<Mesh, Mesh_ops>;
-  using PTQ_modifier = ptq_impl::PTQ_subdivision_modifier<Mesh, Mesh_ops>;
+  return butterfly_analyze_with_ops(mesh, mesh_ops, coefs, num_levels, num_threads);
+}
 
-  using std::placeholders::_1;
-  using std::placeholders::_2;
-  using std::placeholders::_3;
-  using std::placeholders::_4;
+/**
+ * @brief    Overloaded butterfly_analyze writing the coefficients to a
+ *           contiguous buffer, whose band b holds the inner vector coefs[b] of
+ *           the overload above.
+ */
+template<class Mesh>
+bool butterfly_analyze(Mesh& mesh,
+                       Wavelet_coefficients<typename Mesh::Traits::Vector_3>& coefs,
+                       int num_levels,
+                       int num_threads = 1)
+{
+  // Hold mesh vertex info
+  ptq_impl::Mesh_info<Mesh> mesh_info;
+  ptq_impl::Mesh_info_operations<Mesh> mesh_ops {&mesh_info};
 
-  assert(!mesh.empty() && mesh.is_pure_triangle() && mesh.is_closed());
+  return butterfly_analyze_with_ops(mesh, mesh_ops, coefs, num_levels, num_threads);
+}
 
-  // PTQ refine and get_mesh_size functors
-  Get_num_types get_num_types = &PTQ_classify::get_num_types;
-  Get_mesh_size get_mesh_size = &PTQ_modifier::get_mesh_size;
-  Refine refine = &PTQ_modifier::refine;
+/**
+ * @brief    Overloaded butterfly_analyze with a certificate of the subdivision
+ *           connectivity. If the certificate was produced for the same mesh
+ *           connectivity and number of levels, the vertices are not
+ *           classified again; otherwise it is replaced by the certificate of
+ *           this classification, which can be saved for later transforms.
+ */
+template<class Mesh>
+bool butterfly_analyze(Mesh& mesh,
+                       Wavelet_coefficients<typename Mesh::Traits::Vector_3>& coefs,
+                       int num_levels,
+                       Classification_certificate& certificate,
+                       int num_threads = 1)
+{
+  // Hold mesh vertex info
+  ptq_impl::Mesh_info<Mesh> mesh_info;
+  ptq_impl::Mesh_info_operations<Mesh> mesh_ops {&mesh_info};
 
-  // Butterfly specific operations functors
-  Butterfly butterfly;
-  Initialize initialize = std::bind(&Butterfly::initialize, &butterfly, _1, _2, _3);
-  Cleanup cleanup = std::bind(&Butterfly::cleanup, &butterfly, _1, _2);
-  Lift lift = std::bind(&Butterfly::lift, &butterfly, _1, _2, _3, _4);
+  return butterfly_analyze_with_ops(mesh, mesh_ops, coefs, num_levels,
+                                    num_threads, &certificate);
+}
 
-  // Setup mesh_ops
+/**
+ * @brief    The Butterfly forward wavelet transform of as many levels as the
+ *           mesh has, found in the same pass as the vertex classification.
+ *
+ * @param    max_levels The maximum number of transform levels, a value less
+ *                      than 1 sets no limit.
+ *
+ * @return   The number of transform levels, 0 if the input mesh does not have
+ *           subdivision connectivity.
+ */
+template<class Mesh>
+int butterfly_analyze_max_levels(Mesh& mesh,
+                                 Wavelet_coefficients<typename Mesh::Traits::Vector_3>& coefs,
+                                 int max_levels = 0,
+                                 int num_threads = 1)
+{
   // Hold mesh vertex info
-  Mesh_info mesh_info;
-  // Mesh operations functors
-  Get_vertex_id get_vertex_id = std::bind(&Mesh_info::get_vertex_id, &mesh_info,  _1);
-  Set_vertex_id set_vertex_id = std::bind(&Mesh_info::set_vertex_id, &mesh_info,  _1, _2);
-  Get_vertex_type get_vertex_type = std::bind(&Mesh_info::get_vertex_type, &mesh_info,  _1);
-  Set_vertex_type set_vertex_type = std::bind(&Mesh_info::set_vertex_type, &mesh_info,  _1, _2);
-  Get_vertex_border get_vertex_border = std::bind(&Mesh_info::get_vertex_border, &mesh_info,  _1);
-  Set_vertex_border set_vertex_border = std::bind(&Mesh_info::set_vertex_border, &mesh_info,  _1, _2);
-  Get_vertex_level get_vertex_level = std::bind(&Mesh_info::get_vertex_level, &mesh_info,  _1);
-  Set_vertex_level set_vertex_level = std::bind(&Mesh_info::set_vertex_level, &mesh_info,  _1, _2);
-
-  Mesh_ops mesh_ops {get_vertex_id,
-                     set_vertex_id,
-                     get_vertex_level,
-                     set_vertex_level,
-                     get_vertex_type,
-                     set_vertex_type,
-                     get_vertex_border,
-                     set_vertex_border};
+  ptq_impl::Mesh_info<Mesh> mesh_info;
+  ptq_impl::Mesh_info_operations<Mesh> mesh_ops {&mesh_info};
 
-  // Create analysis operations.
-  Synthesis_ops synthesis {get_num_types,
-                           get_mesh_size,
-                           initialize,
-                           cleanup,
-                           refine,
-                           lift};
-
-  Synthesize synthesize {mesh_ops, synthesis};
+  return butterfly_analyze_levels_with_ops(mesh, mesh_ops, coefs, max_levels,
+                                           num_threads, nullptr, true);
+}
 
-  synthesize(mesh, coefs, num_levels);
+/**
+ * @brief    The Butterfly forward wavelet transform of every connected
+ *           component of the mesh, see analyze_components. Each closed
+ *           component is transformed by as many levels as it has, so the
+ *           components may have different numbers of levels, and the open
+ *           components are left unchanged.
+ *
+ * @param    coefs      The coefficients and number of levels of every
+ *                      component.
+ * @param    max_levels The maximum number of transform levels, a value less
+ *                      than 1 sets no limit.
+ *
+ * @return   The largest number of transform levels of a component, 0 if no
+ *           component has subdivision connectivity.
+ */
+template<class Mesh>
+int butterfly_analyze_components(Mesh& mesh,
+  std::vector<Component_coefficients<typename Mesh::Traits::Vector_3>>& coefs,
+  int max_levels = 0,
+  int num_threads = 1)
+{
+  return analyze_components(mesh, coefs, num_threads,
+                 [max_levels](Mesh& m,
+                              Wavelet_coefficients<typename Mesh::Traits::Vector_3>& c,
+                              int n)
+                 {
+                   if (!m.is_closed())
+                   {
+                     // The Butterfly transform needs a closed component.
+                     return 0;
+                   }
+                   return butterfly_analyze_max_levels(m, c, max_levels, n);
+                 });
 }
 
 /**
@@ -348,70 +337,89 @@ template<class Mesh, class Mesh_ops>
 void butterfly_synthesize(Mesh& mesh,
                           const Mesh_ops& mesh_ops,
                           std::vector<std::vector<typename Mesh::Traits::Vector_3>>& coefs,
-                          int num_levels)
+                          int num_levels,
+                          int num_threads = 1)
 {
-  using Vertex_handle = typename Mesh::Vertex_handle;
-  using Get_num_types = std::function<int(Mesh&, const Mesh_ops&)>;
-  using Get_mesh_size = std::function<int(Mesh&, const Mesh_ops&, int)>;
-  using Cleanup = std::function<void(Mesh&, const Mesh_ops&)>;
-  using Lift = std::function<void(Mesh&,
-                                  const Mesh_ops&,
-                                  Vertex_handle**,
-                                  Vertex_handle**)>;
-  using Refine = std::function<void(Mesh&, 
-                                    const Mesh_ops&,
-                                    int,
-                                    std::vector<Vertex_handle>&,
-                                    std::vector<Vertex_handle*>&)>;
-  using Initialize = std::function<void(Mesh&, const Mesh_ops&, int)>;
-
-
-
-  using Synthesis_ops = Wavelet_synthesis_ops<Mesh,
-                                              Mesh_ops,
-                                              Get_num_types,
-                                              Get_mesh_size,
-                                              Initialize,
-                                              Cleanup,
-                                              Refine,
-                                              Lift>;
-
-  using Synthesize = Wavelet_synthesize<Mesh_ops, Synthesis_ops>;
-
-  using Butterfly = ptq_impl::Butterfly_synthesis_operations<Mesh, Mesh_ops>;
-  using PTQ_classify = ptq_impl::PTQ_classify_vertices<Mesh, Mesh_ops>;
-  using PTQ_modifier = ptq_impl::PTQ_subdivision_modifier<Mesh, Mesh_ops>;
-
-  using std::placeholders::_1;
-  using std::placeholders::_2;
-  using std::placeholders::_3;
-  using std::placeholders::_4;
+  butterfly_synthesize_with_ops(mesh, mesh_ops, coefs, num_levels, num_threads);
+}
 
-  assert(!mesh.empty() && mesh.is_pure_triangle() && mesh.is_closed());
+/**
+ * @brief    Overloaded butterfly_synthesize with custom mesh_ops, reading the
+ *           coefficients from a contiguous buffer.
+ */
+template<class Mesh, class Mesh_ops>
+void butterfly_synthesize(Mesh& mesh,
+                          const Mesh_ops& mesh_ops,
+                          const Wavelet_coefficients<typename Mesh::Traits::Vector_3>& coefs,
+                          int num_levels,
+                          int num_threads = 1)
+{
+  butterfly_synthesize_with_ops(mesh, mesh_ops, coefs, num_levels, num_threads);
+}
 
-  // PTQ refine and get_mesh_size functors
-  Get_num_types get_num_types = &PTQ_classify::get_num_types;
-  Get_mesh_size get_mesh_size = &PTQ_modifier::get_mesh_size;
-  Refine refine = &PTQ_modifier::refine;
+/**
+ * @brief    The Butterfly inverse wavelet transform.
+ *
+ * @tparam   Mesh       Type of mesh
+ * @param    mesh       The input mesh 
+ * @param    coefs      The wavelet coefficients, where an inner vector should
+ *                      be the wavelet coefficients at a resolution, and the
+ *                      number should match the number of introduced vertices.
+ *                      The used inner vectors are erased.
+ * @param    num_levels The number of transform levels.
+ * @param    num_threads The number of threads used by the lifting steps, a
+ *                      value less than 1 uses all hardware threads.
+ *
+ */
+template<class Mesh>
+void butterfly_synthesize(Mesh& mesh,
+                          std::vector<std::vector<typename Mesh::Traits::Vector_3>>& coefs,
+                          int num_levels,
+                          int num_threads = 1)
+{
+  // Hold mesh vertex info
+  ptq_impl::Mesh_info<Mesh> mesh_info;
+  ptq_impl::Mesh_info_operations<Mesh> mesh_ops {&mesh_info};
 
-  // Butterfly specific operations functors
-  Butterfly butterfly;
-  Initialize initialize = std::bind(&Butterfly::initialize, &butterfly, _1, _2, _3);
-  Cleanup cleanup = std::bind(&Butterfly::cleanup, &butterfly, _1, _2);
-  Lift lift = std::bind(&Butterfly::lift, &butterfly, _1, _2, _3, _4);
+  butterfly_synthesize_with_ops(mesh, mesh_ops, coefs, num_levels, num_threads);
+}
 
-  // Create analysis operations.
-  Synthesis_ops synthesis {get_num_types,
-                           get_mesh_size,
-                           initialize,
-                           cleanup,
-                           refine,
-                           lift};
+/**
+ * @brief    Overloaded butterfly_synthesize reading the coefficients from a
+ *           contiguous buffer, which is left unchanged.
+ */
+template<class Mesh>
+void butterfly_synthesize(Mesh& mesh,
+                          const Wavelet_coefficients<typename Mesh::Traits::Vector_3>& coefs,
+                          int num_levels,
+                          int num_threads = 1)
+{
+  // Hold mesh vertex info
+  ptq_impl::Mesh_info<Mesh> mesh_info;
+  ptq_impl::Mesh_info_operations<Mesh> mesh_ops {&mesh_info};
 
-  Synthesize synthesize {mesh_ops, synthesis};
+  butterfly_synthesize_with_ops(mesh, mesh_ops, coefs, num_levels, num_threads);
+}
 
-  synthesize(mesh, coefs, num_levels);
+/**
+ * @brief    The Butterfly inverse wavelet transform of every connected
+ *           component of the coarse mesh, with the coefficients of
+ *           butterfly_analyze_components.
+ */
+template<class Mesh>
+void butterfly_synthesize_components(Mesh& mesh,
+  const std::vector<Component_coefficients<typename Mesh::Traits::Vector_3>>& coefs,
+  int num_threads = 1)
+{
+  synthesize_components(mesh, coefs, num_threads,
+                 [](Mesh& m,
+                    const Wavelet_coefficients<typename Mesh::Traits::Vector_3>& c,
+                    int num_levels,
+                    int n)
+                 {
+                   butterfly_synthesize(m, c, num_levels, n);
+                 });
 }
 }  // namespace wtlib
 
-#endif
\ No newline at end of file
+#endif
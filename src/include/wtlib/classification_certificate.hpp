@@ -0,0 +1,177 @@
+#ifndef WTLIB_CLASSIFICATION_CERTIFICATE_HPP
+#define WTLIB_CLASSIFICATION_CERTIFICATE_HPP
+
+/**
+ * @file     classification_certificate.hpp
+ * @brief    Defines a certificate of the subdivision connectivity of a mesh,
+ *           which lets a later transform of the same mesh skip the vertex
+ *           classification.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace wtlib
+{
+/**
+ * @brief    The result of classifying the vertices of a mesh, i.e., the band
+ *           permutation of its vertices.
+ *
+ * The sorted vertex i is the vertex vertex_order[i] in the memory order of the
+ * mesh (the identity if vertex_order is empty), and the vertices of level l
+ * are the sorted vertices [level_sizes[l - 1], level_sizes[l]), where the base
+ * level holds the first level_sizes[0] vertices. The levels, types and parents
+ * of the vertices follow from the bands and the connectivity.
+ *
+ * The connectivity hash identifies the mesh the certificate belongs to, see
+ * connectivity_hash.
+ */
+struct Classification_certificate
+{
+  std::uint64_t connectivity_hash = 0;
+  std::vector<int> level_sizes;
+  std::vector<int> vertex_order;
+
+  int num_levels() const
+  {
+    return level_sizes.empty() ? 0 : static_cast<int>(level_sizes.size()) - 1;
+  }
+
+  bool empty() const
+  {
+    return level_sizes.empty();
+  }
+};
+
+inline bool operator==(const Classification_certificate& lhs,
+                       const Classification_certificate& rhs)
+{
+  return lhs.connectivity_hash == rhs.connectivity_hash &&
+         lhs.level_sizes == rhs.level_sizes &&
+         lhs.vertex_order == rhs.vertex_order;
+}
+
+inline bool operator!=(const Classification_certificate& lhs,
+                       const Classification_certificate& rhs)
+{
+  return !(lhs == rhs);
+}
+
+/**
+ * @brief      Hash the connectivity of a triangle mesh (64-bit FNV-1a).
+ *
+ *             Every facet is hashed as its vertex ids starting from the
+ *             smallest one, so the hash does not depend on which halfedge a
+ *             facet starts with, but it does depend on the order of the
+ *             vertices and facets in memory.
+ *
+ * @param[in]  mesh           The mesh
+ * @param[in]  get_vertex_id  Maps a vertex handle to its index in the memory
+ *                            order of the mesh.
+ */
+template <class Mesh, class Get_vertex_id>
+std::uint64_t connectivity_hash(const Mesh& mesh, Get_vertex_id get_vertex_id)
+{
+  std::uint64_t hash = 14695981039346656037ull;
+  auto combine = [&hash](std::uint64_t value)
+                 {
+                   for (int i = 0; i < 8; ++i)
+                   {
+                     hash ^= (value >> (8 * i)) & 0xff;
+                     hash *= 1099511628211ull;
+                   }
+                 };
+
+  combine(mesh.size_of_vertices());
+  combine(mesh.size_of_facets());
+  for (auto f = mesh.facets_begin(); f != mesh.facets_end(); ++f)
+  {
+    auto h = f->facet_begin();
+    int ids[3] = {get_vertex_id(h->vertex()),
+                  get_vertex_id(h->next()->vertex()),
+                  get_vertex_id(h->next()->next()->vertex())};
+    int first = std::min_element(ids, ids + 3) - ids;
+    for (int k = 0; k < 3; ++k)
+    {
+      combine(static_cast<std::uint32_t>(ids[(first + k) % 3]));
+    }
+  }
+  return hash;
+}
+
+/**
+ * @brief      Write a certificate as text, which is read back by operator>>.
+ */
+inline std::ostream& operator<<(std::ostream& out,
+                                const Classification_certificate& certificate)
+{
+  out << "WTC 1\n";
+  out << certificate.connectivity_hash << ' ' << certificate.num_levels() << '\n';
+  for (std::size_t l = 0; l < certificate.level_sizes.size(); ++l)
+  {
+    out << certificate.level_sizes[l]
+        << (l + 1 < certificate.level_sizes.size() ? ' ' : '\n');
+  }
+  out << certificate.vertex_order.size() << '\n';
+  for (std::size_t i = 0; i < certificate.vertex_order.size(); ++i)
+  {
+    out << certificate.vertex_order[i] << '\n';
+  }
+  return out;
+}
+
+/**
+ * @brief      Read a certificate written by operator<<, the failbit of the
+ *             stream is set if it is malformed.
+ */
+inline std::istream& operator>>(std::istream& in,
+                                Classification_certificate& certificate)
+{
+  std::string magic;
+  int version = 0;
+  int num_levels = -1;
+  std::uint64_t hash = 0;
+  if (!(in >> magic >> version >> hash >> num_levels) ||
+      magic != "WTC" || version != 1 || num_levels < 0)
+  {
+    in.setstate(std::ios::failbit);
+    return in;
+  }
+
+  std::vector<int> level_sizes(num_levels + 1);
+  for (int& size : level_sizes)
+  {
+    in >> size;
+  }
+  std::size_t num_vertices = 0;
+  in >> num_vertices;
+  if (!in ||
+      !std::is_sorted(level_sizes.begin(), level_sizes.end()) ||
+      (num_vertices != 0 &&
+       num_vertices != static_cast<std::size_t>(level_sizes.back())))
+  {
+    in.setstate(std::ios::failbit);
+    return in;
+  }
+  std::vector<int> vertex_order(num_vertices);
+  for (int& v : vertex_order)
+  {
+    in >> v;
+  }
+  if (!in)
+  {
+    return in;
+  }
+
+  certificate.connectivity_hash = hash;
+  certificate.level_sizes = std::move(level_sizes);
+  certificate.vertex_order = std::move(vertex_order);
+  return in;
+}
+}  // namespace wtlib
+#endif
@@ -0,0 +1,1784 @@
+#ifndef WTLIB_COMPACT_MESH_HPP
+#define WTLIB_COMPACT_MESH_HPP
+
+/**
+ * @file     compact_mesh.hpp
+ * @brief    Defines an index-based halfedge mesh stored in flat arrays.
+ *
+ * Compact_mesh keeps connectivity in plain integer arrays (next, prev, target
+ * vertex and facet per halfedge, one halfedge per vertex and facet) and the
+ * vertex positions in one contiguous array. It provides the subset of the
+ * CGAL::Polyhedron_3 interface used by the PTQ wavelet transforms (handles,
+ * iterators, circulators, split/join Euler operations), so loop_analyze,
+ * loop_synthesize, butterfly_analyze and butterfly_synthesize can be
+ * instantiated with it directly.
+ *
+ * Elements removed by join_facet/join_vertex are only marked as removed so
+ * that all outstanding handles stay valid during a transform; call
+ * collect_garbage() to compact the arrays afterwards.
+ *
+ * The halfedges of an edge are stored next to each other, so the opposite of
+ * halfedge h is always h ^ 1.
+ */
+
+#include <wtlib/ptq_impl/counting_sort.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <CGAL/Modifier_base.h>
+#include <CGAL/Polyhedron_incremental_builder_3.h>
+
+#if defined (WTLIB_USE_UNORDERED_MAP)
+#include <unordered_map>
+#else
+#include <map>
+#endif
+
+namespace wtlib
+{
+template <class Kernel>
+class Compact_mesh;
+
+namespace compact_mesh_impl
+{
+template <class M> class Vertex_handle;
+template <class M> class Halfedge_handle;
+template <class M> class Facet_handle;
+template <class M> class Halfedge_around_vertex_circulator;
+template <class M> class Halfedge_around_facet_circulator;
+
+// Reference to T, const qualified if the mesh M is const qualified.
+template <class M, class T>
+using Ref = std::conditional_t<std::is_const<M>::value, const T&, T&>;
+
+/**
+ * @brief      The object returned by Vertex_handle::operator->. It exposes the
+ *             same members as the vertex of a Polyhedron_3 (and the custom
+ *             vertex fields of MeshVertex in mesh_types.hpp).
+ */
+template <class M>
+class Vertex_accessor
+{
+public:
+  using Mesh = std::remove_const_t<M>;
+  using Vertex_info = typename Mesh::Vertex_info;
+  using Parents = decltype(Vertex_info::parents);
+
+  Vertex_accessor(M* m, int v)
+    : id(m->info(v).id),
+      type(m->info(v).type),
+      level(m->info(v).level),
+      border(m->info(v).border),
+      parents(m->info(v).parents),
+      m_(m),
+      v_(v)
+  {}
+
+  Vertex_accessor* operator->() { return this; }
+
+  Ref<M, typename Mesh::Point_3> point() const { return m_->point(v_); }
+
+  Halfedge_handle<M> halfedge() const
+  {
+    return Halfedge_handle<M>(m_, m_->vertex_halfedge(v_));
+  }
+
+  Halfedge_around_vertex_circulator<M> vertex_begin() const
+  {
+    return Halfedge_around_vertex_circulator<M>(halfedge());
+  }
+
+  std::size_t degree() const { return m_->vertex_degree(v_); }
+
+  std::size_t vertex_degree() const { return m_->vertex_degree(v_); }
+
+  Ref<M, int> id;
+  Ref<M, int> type;
+  Ref<M, int> level;
+  Ref<M, bool> border;
+  Ref<M, Parents> parents;
+
+private:
+  M* m_;
+  int v_;
+};  // class Vertex_accessor
+
+/**
+ * @brief      The object returned by Halfedge_handle::operator->.
+ */
+template <class M>
+class Halfedge_accessor
+{
+public:
+  Halfedge_accessor(M* m, int h): m_(m), h_(h) {}
+
+  Halfedge_accessor* operator->() { return this; }
+
+  Halfedge_handle<M> next() const
+  {
+    return Halfedge_handle<M>(m_, m_->next(h_));
+  }
+
+  Halfedge_handle<M> prev() const
+  {
+    return Halfedge_handle<M>(m_, m_->prev(h_));
+  }
+
+  Halfedge_handle<M> opposite() const
+  {
+    return Halfedge_handle<M>(m_, m_->opposite(h_));
+  }
+
+  Vertex_handle<M> vertex() const
+  {
+    return Vertex_handle<M>(m_, m_->target(h_));
+  }
+
+  Facet_handle<M> facet() const
+  {
+    return Facet_handle<M>(m_, m_->face(h_));
+  }
+
+  Facet_handle<M> face() const { return facet(); }
+
+  bool is_border() const { return m_->is_border(h_); }
+
+  bool is_border_edge() const
+  {
+    return m_->is_border(h_) || m_->is_border(m_->opposite(h_));
+  }
+
+  Halfedge_around_vertex_circulator<M> vertex_begin() const
+  {
+    return Halfedge_around_vertex_circulator<M>(Halfedge_handle<M>(m_, h_));
+  }
+
+  Halfedge_around_facet_circulator<M> facet_begin() const
+  {
+    return Halfedge_around_facet_circulator<M>(Halfedge_handle<M>(m_, h_));
+  }
+
+  std::size_t vertex_degree() const
+  {
+    return m_->vertex_degree(m_->target(h_));
+  }
+
+  std::size_t facet_degree() const { return m_->loop_size(h_); }
+
+private:
+  M* m_;
+  int h_;
+};  // class Halfedge_accessor
+
+/**
+ * @brief      The object returned by Facet_handle::operator->.
+ */
+template <class M>
+class Facet_accessor
+{
+public:
+  Facet_accessor(M* m, int f): m_(m), f_(f) {}
+
+  Facet_accessor* operator->() { return this; }
+
+  Halfedge_handle<M> halfedge() const
+  {
+    return Halfedge_handle<M>(m_, m_->facet_halfedge(f_));
+  }
+
+  Halfedge_around_facet_circulator<M> facet_begin() const
+  {
+    return Halfedge_around_facet_circulator<M>(halfedge());
+  }
+
+  std::size_t facet_degree() const { return m_->facet_degree(f_); }
+
+  std::size_t size() const { return m_->facet_degree(f_); }
+
+  bool is_triangle() const { return m_->facet_degree(f_) == 3; }
+
+  template <class H>
+  void set_halfedge(const H& h) const
+  {
+    m_->set_facet_halfedge(f_, h.index());
+  }
+
+private:
+  M* m_;
+  int f_;
+};  // class Facet_accessor
+
+/**
+ * @brief      Common part of the vertex/halfedge/facet handles: a mesh pointer
+ *             and an element index. A handle doubles as the iterator over its
+ *             element type, skipping removed elements.
+ */
+template <class M, class Derived>
+class Handle_base
+{
+public:
+  using Mesh = std::remove_const_t<M>;
+
+  Handle_base(): m_(nullptr), i_(-1) {}
+  Handle_base(M* m, int i): m_(m), i_(i) {}
+
+  int index() const { return i_; }
+  M* mesh() const { return m_; }
+
+  friend bool operator==(const Derived& lhs, const Derived& rhs)
+  {
+    return lhs.index() == rhs.index();
+  }
+
+  friend bool operator!=(const Derived& lhs, const Derived& rhs)
+  {
+    return lhs.index() != rhs.index();
+  }
+
+  friend bool operator<(const Derived& lhs, const Derived& rhs)
+  {
+    return lhs.index() < rhs.index();
+  }
+
+protected:
+  M* m_;
+  int i_;
+};  // class Handle_base
+
+template <class M>
+class Vertex_handle: public Handle_base<M, Vertex_handle<M>>
+{
+public:
+  using Base = Handle_base<M, Vertex_handle<M>>;
+  using Mesh = typename Base::Mesh;
+
+  Vertex_handle() = default;
+  Vertex_handle(M* m, int v): Base(m, v) {}
+
+  // Conversion from a mutable handle to a const handle.
+  template <class N,
+            class = std::enable_if_t<std::is_const<M>::value &&
+                                     std::is_same<N, Mesh>::value>>
+  Vertex_handle(const Vertex_handle<N>& v): Base(v.mesh(), v.index()) {}
+
+  Vertex_accessor<M> operator->() const
+  {
+    return Vertex_accessor<M>(this->m_, this->i_);
+  }
+
+  Vertex_handle& operator++()
+  {
+    this->i_ = this->m_->next_vertex_slot(this->i_);
+    return *this;
+  }
+
+  Vertex_handle operator++(int)
+  {
+    Vertex_handle tmp {*this};
+    ++(*this);
+    return tmp;
+  }
+};  // class Vertex_handle
+
+template <class M>
+class Halfedge_handle: public Handle_base<M, Halfedge_handle<M>>
+{
+public:
+  using Base = Handle_base<M, Halfedge_handle<M>>;
+  using Mesh = typename Base::Mesh;
+
+  Halfedge_handle() = default;
+  Halfedge_handle(M* m, int h): Base(m, h) {}
+
+  template <class N,
+            class = std::enable_if_t<std::is_const<M>::value &&
+                                     std::is_same<N, Mesh>::value>>
+  Halfedge_handle(const Halfedge_handle<N>& h): Base(h.mesh(), h.index()) {}
+
+  Halfedge_accessor<M> operator->() const
+  {
+    return Halfedge_accessor<M>(this->m_, this->i_);
+  }
+
+  Halfedge_handle& operator++()
+  {
+    this->i_ = this->m_->next_halfedge_slot(this->i_);
+    return *this;
+  }
+
+  Halfedge_handle operator++(int)
+  {
+    Halfedge_handle tmp {*this};
+    ++(*this);
+    return tmp;
+  }
+};  // class Halfedge_handle
+
+template <class M>
+class Facet_handle: public Handle_base<M, Facet_handle<M>>
+{
+public:
+  using Base = Handle_base<M, Facet_handle<M>>;
+  using Mesh = typename Base::Mesh;
+
+  Facet_handle() = default;
+  Facet_handle(M* m, int f): Base(m, f) {}
+
+  template <class N,
+            class = std::enable_if_t<std::is_const<M>::value &&
+                                     std::is_same<N, Mesh>::value>>
+  Facet_handle(const Facet_handle<N>& f): Base(f.mesh(), f.index()) {}
+
+  Facet_accessor<M> operator->() const
+  {
+    return Facet_accessor<M>(this->m_, this->i_);
+  }
+
+  Facet_handle& operator++()
+  {
+    this->i_ = this->m_->next_facet_slot(this->i_);
+    return *this;
+  }
+
+  Facet_handle operator++(int)
+  {
+    Facet_handle tmp {*this};
+    ++(*this);
+    return tmp;
+  }
+};  // class Facet_handle
+
+/**
+ * @brief      Iterates over one halfedge of every edge.
+ */
+template <class M>
+class Edge_iterator: public Halfedge_handle<M>
+{
+public:
+  Edge_iterator() = default;
+  Edge_iterator(M* m, int h): Halfedge_handle<M>(m, h) {}
+
+  Edge_iterator& operator++()
+  {
+    this->i_ = this->m_->next_edge_slot(this->i_);
+    return *this;
+  }
+
+  Edge_iterator operator++(int)
+  {
+    Edge_iterator tmp {*this};
+    ++(*this);
+    return tmp;
+  }
+};  // class Edge_iterator
+
+/**
+ * @brief      Circulates clockwise over the halfedges pointing to a vertex,
+ *             the same order as Polyhedron_3.
+ */
+template <class M>
+class Halfedge_around_vertex_circulator: public Halfedge_handle<M>
+{
+public:
+  Halfedge_around_vertex_circulator() = default;
+  Halfedge_around_vertex_circulator(const Halfedge_handle<M>& h)
+    : Halfedge_handle<M>(h)
+  {}
+
+  Halfedge_around_vertex_circulator& operator++()
+  {
+    this->i_ = this->m_->opposite(this->m_->next(this->i_));
+    return *this;
+  }
+
+  Halfedge_around_vertex_circulator operator++(int)
+  {
+    Halfedge_around_vertex_circulator tmp {*this};
+    ++(*this);
+    return tmp;
+  }
+
+  Halfedge_around_vertex_circulator& operator--()
+  {
+    this->i_ = this->m_->prev(this->m_->opposite(this->i_));
+    return *this;
+  }
+
+  Halfedge_around_vertex_circulator operator--(int)
+  {
+    Halfedge_around_vertex_circulator tmp {*this};
+    --(*this);
+    return tmp;
+  }
+};  // class Halfedge_around_vertex_circulator
+
+/**
+ * @brief      Circulates over the halfedges of a facet.
+ */
+template <class M>
+class Halfedge_around_facet_circulator: public Halfedge_handle<M>
+{
+public:
+  Halfedge_around_facet_circulator() = default;
+  Halfedge_around_facet_circulator(const Halfedge_handle<M>& h)
+    : Halfedge_handle<M>(h)
+  {}
+
+  Halfedge_around_facet_circulator& operator++()
+  {
+    this->i_ = this->m_->next(this->i_);
+    return *this;
+  }
+
+  Halfedge_around_facet_circulator operator++(int)
+  {
+    Halfedge_around_facet_circulator tmp {*this};
+    ++(*this);
+    return tmp;
+  }
+
+  Halfedge_around_facet_circulator& operator--()
+  {
+    this->i_ = this->m_->prev(this->i_);
+    return *this;
+  }
+
+  Halfedge_around_facet_circulator operator--(int)
+  {
+    Halfedge_around_facet_circulator tmp {*this};
+    --(*this);
+    return tmp;
+  }
+};  // class Halfedge_around_facet_circulator
+
+}  // namespace compact_mesh_impl
+
+template <class Kernel>
+class Compact_mesh
+{
+public:
+  using Traits = Kernel;
+  using Point_3 = typename Traits::Point_3;
+  using Point = Point_3;
+  using size_type = std::size_t;
+
+  // The mesh is its own halfedge data structure, the low-level Euler
+  // operations (e.g., join_vertex) are members of the mesh.
+  using HDS = Compact_mesh;
+
+  using Vertex_handle = compact_mesh_impl::Vertex_handle<Compact_mesh>;
+  using Vertex_const_handle = compact_mesh_impl::Vertex_handle<const Compact_mesh>;
+  using Halfedge_handle = compact_mesh_impl::Halfedge_handle<Compact_mesh>;
+  using Halfedge_const_handle = compact_mesh_impl::Halfedge_handle<const Compact_mesh>;
+  using Facet_handle = compact_mesh_impl::Facet_handle<Compact_mesh>;
+  using Facet_const_handle = compact_mesh_impl::Facet_handle<const Compact_mesh>;
+  using Face_handle = Facet_handle;
+  using Face_const_handle = Facet_const_handle;
+
+  using Vertex_iterator = Vertex_handle;
+  using Vertex_const_iterator = Vertex_const_handle;
+  using Halfedge_iterator = Halfedge_handle;
+  using Halfedge_const_iterator = Halfedge_const_handle;
+  using Facet_iterator = Facet_handle;
+  using Facet_const_iterator = Facet_const_handle;
+  using Edge_iterator = compact_mesh_impl::Edge_iterator<Compact_mesh>;
+  using Edge_const_iterator = compact_mesh_impl::Edge_iterator<const Compact_mesh>;
+
+  using Halfedge_around_vertex_circulator =
+          compact_mesh_impl::Halfedge_around_vertex_circulator<Compact_mesh>;
+  using Halfedge_around_vertex_const_circulator =
+          compact_mesh_impl::Halfedge_around_vertex_circulator<const Compact_mesh>;
+  using Halfedge_around_facet_circulator =
+          compact_mesh_impl::Halfedge_around_facet_circulator<Compact_mesh>;
+  using Halfedge_around_facet_const_circulator =
+          compact_mesh_impl::Halfedge_around_facet_circulator<const Compact_mesh>;
+
+  /**
+   * @brief      Per vertex attributes, the same fields as MeshVertex in
+   *             mesh_types.hpp, so Mesh_info works with WTLIB_USE_CUSTOM_MESH.
+   */
+  struct Vertex_info
+  {
+    int id = 0;
+    int type = 0;
+    int level = 0;
+    bool border = false;
+    std::pair<Vertex_handle, Vertex_handle> parents;
+  };
+
+  Compact_mesh() = default;
+
+  Compact_mesh(const Compact_mesh& other);
+
+  Compact_mesh(Compact_mesh&& other);
+
+  Compact_mesh& operator=(const Compact_mesh& other);
+
+  Compact_mesh& operator=(Compact_mesh&& other);
+
+  /**
+   * @brief      Build the mesh from a point array and a list of facets given
+   *             as counterclockwise vertex indices.
+   *
+   * @param[in]  points  The vertex positions
+   * @param[in]  facets  The facets
+   *
+   * @return     False if the facets do not describe an oriented 2-manifold.
+   */
+  bool build(const std::vector<Point_3>& points,
+             const std::vector<std::vector<int>>& facets);
+
+  /**
+   * @brief      Build the mesh from a point array and a flat list of
+   *             triangles, three counterclockwise vertex indices each. The
+   *             result is the same as build, but the halfedges of an edge are
+   *             paired by sorting instead of hashing, which is several times
+   *             faster on large meshes.
+   *
+   * @param[in]  points     The vertex positions
+   * @param[in]  triangles  The triangles
+   *
+   * @return     False if the triangles do not describe an oriented
+   *             2-manifold.
+   */
+  bool build_triangles(const std::vector<Point_3>& points,
+                       const std::vector<int>& triangles);
+
+  /**
+   * @brief      Replace the connectivity by a flat list of triangles over the
+   *             vertex slots of the mesh, e.g., to coarsen the mesh in one
+   *             pass. The vertices left out of every triangle are removed, the
+   *             others keep their slots, points and infos, so their handles
+   *             stay valid. Every halfedge and facet handle is invalidated.
+   *
+   * @param[in]  triangles  The triangles, three counterclockwise vertex slots
+   *                        each
+   *
+   * @return     False if the triangles do not describe an oriented
+   *             2-manifold of the vertices of the mesh.
+   */
+  bool rebuild_triangles(const std::vector<int>& triangles);
+
+  void clear();
+
+  void reserve(size_type v, size_type h, size_type f);
+
+  /**
+   * @brief      Compact all arrays by dropping removed elements. Every handle
+   *             and index obtained before this call is invalidated.
+   */
+  void collect_garbage();
+
+  // Element counts, not counting removed elements.
+  size_type size_of_vertices() const { return points_.size() - removed_vertices_; }
+  size_type size_of_halfedges() const { return hnext_.size() - 2 * removed_edges_; }
+  size_type size_of_facets() const { return fhalfedge_.size() - removed_facets_; }
+  bool empty() const { return size_of_halfedges() == 0; }
+
+  bool is_pure_triangle() const;
+
+  bool is_closed() const;
+
+  /**
+   * @brief      The border of a Compact_mesh is never normalized, border
+   *             halfedges are found by a linear scan instead.
+   */
+  bool normalized_border_is_valid() const { return false; }
+
+  Halfedge_iterator border_halfedges_begin() { return halfedges_end(); }
+
+  Vertex_iterator vertices_begin() { return Vertex_iterator(this, next_vertex_slot(-1)); }
+  Vertex_iterator vertices_end() { return Vertex_iterator(this, num_vertex_slots()); }
+  Vertex_const_iterator vertices_begin() const { return Vertex_const_iterator(this, next_vertex_slot(-1)); }
+  Vertex_const_iterator vertices_end() const { return Vertex_const_iterator(this, num_vertex_slots()); }
+
+  Halfedge_iterator halfedges_begin() { return Halfedge_iterator(this, next_halfedge_slot(-1)); }
+  Halfedge_iterator halfedges_end() { return Halfedge_iterator(this, num_halfedge_slots()); }
+  Halfedge_const_iterator halfedges_begin() const { return Halfedge_const_iterator(this, next_halfedge_slot(-1)); }
+  Halfedge_const_iterator halfedges_end() const { return Halfedge_const_iterator(this, num_halfedge_slots()); }
+
+  Edge_iterator edges_begin() { return Edge_iterator(this, next_edge_slot(-2)); }
+  Edge_iterator edges_end() { return Edge_iterator(this, num_halfedge_slots()); }
+  Edge_const_iterator edges_begin() const { return Edge_const_iterator(this, next_edge_slot(-2)); }
+  Edge_const_iterator edges_end() const { return Edge_const_iterator(this, num_halfedge_slots()); }
+
+  Facet_iterator facets_begin() { return Facet_iterator(this, next_facet_slot(-1)); }
+  Facet_iterator facets_end() { return Facet_iterator(this, num_facet_slots()); }
+  Facet_const_iterator facets_begin() const { return Facet_const_iterator(this, next_facet_slot(-1)); }
+  Facet_const_iterator facets_end() const { return Facet_const_iterator(this, num_facet_slots()); }
+
+  /**
+   * @brief      Split the vertex incident to h and g, same as
+   *             Polyhedron_3::split_vertex. The halfedges from h->next() to g
+   *             are moved to a new vertex, which is connected to the old one
+   *             by a new edge.
+   *
+   * @return     The new halfedge pointing to the old vertex.
+   */
+  Halfedge_handle split_vertex(Halfedge_handle h, Halfedge_handle g);
+
+  /**
+   * @brief      Split the facet incident to h and g by a diagonal from
+   *             h->vertex() to g->vertex(), same as Polyhedron_3::split_facet.
+   *
+   * @return     The new diagonal, i.e., h->next() after the split.
+   */
+  Halfedge_handle split_facet(Halfedge_handle h, Halfedge_handle g);
+
+  /**
+   * @brief      Join the two facets incident to h, the facet of
+   *             h->opposite() is removed. Same as Polyhedron_3::join_facet.
+   *
+   * @return     The predecessor of h in the joined facet.
+   */
+  Halfedge_handle join_facet(Halfedge_handle h);
+
+  /**
+   * @brief      Join the two vertices incident to h, the vertex
+   *             h->opposite()->vertex() is removed. Same as the join_vertex of
+   *             CGAL::HalfedgeDS_decorator, i.e., without the border check of
+   *             Polyhedron_3::join_vertex.
+   *
+   * @return     The predecessor of h around the remaining vertex.
+   */
+  Halfedge_handle join_vertex(Halfedge_handle h);
+
+  // Index level access to the arrays. Halfedge 2k and 2k + 1 form edge k.
+  int num_vertex_slots() const { return static_cast<int>(points_.size()); }
+  int num_halfedge_slots() const { return static_cast<int>(hnext_.size()); }
+  int num_facet_slots() const { return static_cast<int>(fhalfedge_.size()); }
+
+  bool is_removed_vertex(int v) const { return vremoved_[v]; }
+  bool is_removed_halfedge(int h) const { return eremoved_[h >> 1]; }
+  bool is_removed_facet(int f) const { return fremoved_[f]; }
+
+  int next(int h) const { return hnext_[h]; }
+  int prev(int h) const { return hprev_[h]; }
+  int opposite(int h) const { return h ^ 1; }
+  int target(int h) const { return hvertex_[h]; }
+  int source(int h) const { return hvertex_[h ^ 1]; }
+  int face(int h) const { return hface_[h]; }
+  bool is_border(int h) const { return hface_[h] < 0; }
+  int vertex_halfedge(int v) const { return vhalfedge_[v]; }
+  int facet_halfedge(int f) const { return fhalfedge_[f]; }
+  void set_facet_halfedge(int f, int h) { fhalfedge_[f] = h; }
+
+  Point_3& point(int v) { return points_[v]; }
+  const Point_3& point(int v) const { return points_[v]; }
+  Vertex_info& info(int v) { return vinfo_[v]; }
+  const Vertex_info& info(int v) const { return vinfo_[v]; }
+
+  // The contiguous point array, indexed by vertex slot.
+  std::vector<Point_3>& points() { return points_; }
+  const std::vector<Point_3>& points() const { return points_; }
+
+  int vertex_degree(int v) const;
+  int facet_degree(int f) const { return loop_size(fhalfedge_[f]); }
+  int loop_size(int h) const;
+
+  // Used by the iterators to skip removed elements.
+  int next_vertex_slot(int v) const;
+  int next_halfedge_slot(int h) const;
+  int next_edge_slot(int h) const;
+  int next_facet_slot(int f) const;
+
+private:
+  int new_edge();
+  int new_vertex(int copy_from);
+  int new_facet();
+  void link(int h, int n) { hnext_[h] = n; hprev_[n] = h; }
+  void set_face_in_face_loop(int h, int f);
+  void set_vertex_in_vertex_loop(int h, int v);
+  bool link_triangles(const std::vector<int>& triangles);
+  bool link_border_and_check();
+  void rebind_handles();
+
+  std::vector<Point_3> points_;
+  std::vector<Vertex_info> vinfo_;
+  std::vector<int> vhalfedge_;
+  std::vector<char> vremoved_;
+
+  std::vector<int> hnext_;
+  std::vector<int> hprev_;
+  std::vector<int> hvertex_;
+  std::vector<int> hface_;
+  std::vector<char> eremoved_;
+
+  std::vector<int> fhalfedge_;
+  std::vector<char> fremoved_;
+
+  size_type removed_vertices_ = 0;
+  size_type removed_edges_ = 0;
+  size_type removed_facets_ = 0;
+};  // class Compact_mesh
+
+template <class Kernel>
+Compact_mesh<Kernel>::Compact_mesh(const Compact_mesh& other)
+  : points_(other.points_), vinfo_(other.vinfo_),
+    vhalfedge_(other.vhalfedge_), vremoved_(other.vremoved_),
+    hnext_(other.hnext_), hprev_(other.hprev_), hvertex_(other.hvertex_),
+    hface_(other.hface_), eremoved_(other.eremoved_),
+    fhalfedge_(other.fhalfedge_), fremoved_(other.fremoved_),
+    removed_vertices_(other.removed_vertices_),
+    removed_edges_(other.removed_edges_),
+    removed_facets_(other.removed_facets_)
+{
+  rebind_handles();
+}
+
+template <class Kernel>
+Compact_mesh<Kernel>::Compact_mesh(Compact_mesh&& other)
+  : points_(std::move(other.points_)), vinfo_(std::move(other.vinfo_)),
+    vhalfedge_(std::move(other.vhalfedge_)),
+    vremoved_(std::move(other.vremoved_)),
+    hnext_(std::move(other.hnext_)), hprev_(std::move(other.hprev_)),
+    hvertex_(std::move(other.hvertex_)), hface_(std::move(other.hface_)),
+    eremoved_(std::move(other.eremoved_)),
+    fhalfedge_(std::move(other.fhalfedge_)),
+    fremoved_(std::move(other.fremoved_)),
+    removed_vertices_(other.removed_vertices_),
+    removed_edges_(other.removed_edges_),
+    removed_facets_(other.removed_facets_)
+{
+  rebind_handles();
+  other.clear();
+}
+
+template <class Kernel>
+Compact_mesh<Kernel>& Compact_mesh<Kernel>::operator=(const Compact_mesh& other)
+{
+  if (this != &other)
+  {
+    Compact_mesh tmp {other};
+    *this = std::move(tmp);
+  }
+  return *this;
+}
+
+template <class Kernel>
+Compact_mesh<Kernel>& Compact_mesh<Kernel>::operator=(Compact_mesh&& other)
+{
+  if (this != &other)
+  {
+    points_ = std::move(other.points_);
+    vinfo_ = std::move(other.vinfo_);
+    vhalfedge_ = std::move(other.vhalfedge_);
+    vremoved_ = std::move(other.vremoved_);
+    hnext_ = std::move(other.hnext_);
+    hprev_ = std::move(other.hprev_);
+    hvertex_ = std::move(other.hvertex_);
+    hface_ = std::move(other.hface_);
+    eremoved_ = std::move(other.eremoved_);
+    fhalfedge_ = std::move(other.fhalfedge_);
+    fremoved_ = std::move(other.fremoved_);
+    removed_vertices_ = other.removed_vertices_;
+    removed_edges_ = other.removed_edges_;
+    removed_facets_ = other.removed_facets_;
+    rebind_handles();
+    other.clear();
+  }
+  return *this;
+}
+
+template <class Kernel>
+void Compact_mesh<Kernel>::rebind_handles()
+{
+  // Parents are stored as handles, which carry the mesh pointer.
+  for (Vertex_info& info : vinfo_)
+  {
+    if (info.parents.first != Vertex_handle {})
+    {
+      info.parents.first = Vertex_handle(this, info.parents.first.index());
+    }
+    if (info.parents.second != Vertex_handle {})
+    {
+      info.parents.second = Vertex_handle(this, info.parents.second.index());
+    }
+  }
+}
+
+template <class Kernel>
+void Compact_mesh<Kernel>::clear()
+{
+  points_.clear();
+  vinfo_.clear();
+  vhalfedge_.clear();
+  vremoved_.clear();
+  hnext_.clear();
+  hprev_.clear();
+  hvertex_.clear();
+  hface_.clear();
+  eremoved_.clear();
+  fhalfedge_.clear();
+  fremoved_.clear();
+  removed_vertices_ = 0;
+  removed_edges_ = 0;
+  removed_facets_ = 0;
+}
+
+template <class Kernel>
+void Compact_mesh<Kernel>::reserve(size_type v, size_type h, size_type f)
+{
+  points_.reserve(v);
+  vinfo_.reserve(v);
+  vhalfedge_.reserve(v);
+  vremoved_.reserve(v);
+  hnext_.reserve(h);
+  hprev_.reserve(h);
+  hvertex_.reserve(h);
+  hface_.reserve(h);
+  eremoved_.reserve(h / 2);
+  fhalfedge_.reserve(f);
+  fremoved_.reserve(f);
+}
+
+template <class Kernel>
+bool Compact_mesh<Kernel>::build(const std::vector<Point_3>& points,
+                                 const std::vector<std::vector<int>>& facets)
+{
+  clear();
+  int num_vertices = static_cast<int>(points.size());
+  size_type num_corners = 0;
+  for (const std::vector<int>& f : facets)
+  {
+    num_corners += f.size();
+  }
+  reserve(points.size(), 2 * num_corners, facets.size());
+
+  points_ = points;
+  vinfo_.resize(points.size());
+  vhalfedge_.assign(points.size(), -1);
+  vremoved_.assign(points.size(), 0);
+
+  // Directed edge (source, target) to the halfedge index.
+  auto key = [](int s, int t) -> std::uint64_t
+             {
+               return (static_cast<std::uint64_t>(s) << 32) |
+                      static_cast<std::uint32_t>(t);
+             };
+  std::unordered_map<std::uint64_t, int> halfedges;
+  halfedges.reserve(2 * num_corners);
+
+  std::vector<int> loop;
+  for (const std::vector<int>& f : facets)
+  {
+    int k = static_cast<int>(f.size());
+    if (k < 3)
+    {
+      clear();
+      return false;
+    }
+    int fid = new_facet();
+    loop.clear();
+    for (int i = 0; i < k; ++i)
+    {
+      int s = f[i];
+      int t = f[(i + 1) % k];
+      if (s < 0 || s >= num_vertices || t < 0 || t >= num_vertices || s == t ||
+          halfedges.count(key(s, t)))
+      {
+        clear();
+        return false;
+      }
+      int h;
+      auto oppo = halfedges.find(key(t, s));
+      if (oppo == halfedges.end())
+      {
+        h = new_edge();
+        hvertex_[h] = t;
+        hvertex_[h ^ 1] = s;
+      }
+      else
+      {
+        h = oppo->second ^ 1;
+      }
+      halfedges.emplace(key(s, t), h);
+      hface_[h] = fid;
+      vhalfedge_[t] = h;
+      loop.push_back(h);
+    }
+    for (int i = 0; i < k; ++i)
+    {
+      link(loop[i], loop[(i + 1) % k]);
+    }
+    fhalfedge_[fid] = loop.front();
+  }
+
+  return link_border_and_check();
+}
+
+template <class Kernel>
+bool Compact_mesh<Kernel>::build_triangles(const std::vector<Point_3>& points,
+                                           const std::vector<int>& triangles)
+{
+  clear();
+  int num_vertices = static_cast<int>(points.size());
+  int num_corners = static_cast<int>(triangles.size());
+  if (num_corners % 3 != 0)
+  {
+    return false;
+  }
+  auto next = [](int c) { return c % 3 == 2 ? c - 2 : c + 1; };
+  for (int c = 0; c < num_corners; ++c)
+  {
+    int s = triangles[c];
+    int t = triangles[next(c)];
+    if (s < 0 || s >= num_vertices || t < 0 || t >= num_vertices || s == t)
+    {
+      return false;
+    }
+  }
+
+  points_ = points;
+  vinfo_.resize(points.size());
+  vhalfedge_.assign(points.size(), -1);
+  vremoved_.assign(points.size(), 0);
+
+  return link_triangles(triangles);
+}
+
+template <class Kernel>
+bool Compact_mesh<Kernel>::rebuild_triangles(const std::vector<int>& triangles)
+{
+  int num_vertices = num_vertex_slots();
+  int num_corners = static_cast<int>(triangles.size());
+  if (num_corners % 3 != 0)
+  {
+    return false;
+  }
+  auto next = [](int c) { return c % 3 == 2 ? c - 2 : c + 1; };
+  for (int c = 0; c < num_corners; ++c)
+  {
+    int s = triangles[c];
+    int t = triangles[next(c)];
+    if (s < 0 || s >= num_vertices || t < 0 || t >= num_vertices || s == t ||
+        vremoved_[s])
+    {
+      return false;
+    }
+  }
+
+  vhalfedge_.assign(num_vertices, -1);
+  if (!link_triangles(triangles))
+  {
+    return false;
+  }
+
+  // The vertices left without a halfedge are removed, the others keep their
+  // slots.
+  removed_vertices_ = 0;
+  for (int v = 0; v < num_vertices; ++v)
+  {
+    vremoved_[v] = vhalfedge_[v] < 0;
+    removed_vertices_ += vremoved_[v];
+  }
+  return true;
+}
+
+template <class Kernel>
+bool Compact_mesh<Kernel>::link_triangles(const std::vector<int>& triangles)
+{
+  int num_vertices = num_vertex_slots();
+  int num_corners = static_cast<int>(triangles.size());
+  auto next = [](int c) { return c % 3 == 2 ? c - 2 : c + 1; };
+
+  // Sort the corners, i.e. the halfedges from a corner to the next one, by
+  // their end vertices, so the two halfedges of an edge become neighbors.
+  auto low = [&](int c) { return std::min(triangles[c], triangles[next(c)]); };
+  auto high = [&](int c) { return std::max(triangles[c], triangles[next(c)]); };
+  std::vector<int> order(num_corners);
+  ptq_impl::counting_sort_pairs(num_corners, num_vertices, low, high,
+                                order.data());
+
+  // An edge has one halfedge on each side at most, in opposite directions.
+  std::vector<int> partner(num_corners, -1);
+  for (int k = 0; k < num_corners;)
+  {
+    int c = order[k];
+    int j = k + 1;
+    while (j < num_corners && low(order[j]) == low(c) && high(order[j]) == high(c))
+    {
+      ++j;
+    }
+    if (j - k > 2 || (j - k == 2 && triangles[c] == triangles[order[k + 1]]))
+    {
+      clear();
+      return false;
+    }
+    if (j - k == 2)
+    {
+      partner[c] = order[k + 1];
+      partner[order[k + 1]] = c;
+    }
+    k = j;
+  }
+
+  // Number the edges in the order of their first corner, as build does.
+  int num_edges = 0;
+  for (int c = 0; c < num_corners; ++c)
+  {
+    num_edges += partner[c] < c;
+  }
+  hnext_.assign(2 * num_edges, -1);
+  hprev_.assign(2 * num_edges, -1);
+  hvertex_.assign(2 * num_edges, -1);
+  hface_.assign(2 * num_edges, -1);
+  eremoved_.assign(num_edges, 0);
+  fhalfedge_.assign(num_corners / 3, -1);
+  fremoved_.assign(num_corners / 3, 0);
+  removed_edges_ = 0;
+  removed_facets_ = 0;
+
+  std::vector<int> halfedges(num_corners, -1);
+  for (int c = 0, e = 0; c < num_corners; ++c)
+  {
+    int h = halfedges[c];
+    if (h < 0)
+    {
+      h = 2 * e++;
+      hvertex_[h] = triangles[next(c)];
+      hvertex_[h ^ 1] = triangles[c];
+      halfedges[c] = h;
+      if (partner[c] >= 0)
+      {
+        halfedges[partner[c]] = h ^ 1;
+      }
+    }
+    hface_[h] = c / 3;
+    vhalfedge_[triangles[next(c)]] = h;
+  }
+  for (int f = 0; f < num_corners / 3; ++f)
+  {
+    const int* loop = &halfedges[3 * f];
+    link(loop[0], loop[1]);
+    link(loop[1], loop[2]);
+    link(loop[2], loop[0]);
+    fhalfedge_[f] = loop[0];
+  }
+
+  return link_border_and_check();
+}
+
+template <class Kernel>
+bool Compact_mesh<Kernel>::link_border_and_check()
+{
+  int num_vertices = num_vertex_slots();
+
+  // Link the border halfedges, every vertex can start at most one border
+  // halfedge in a 2-manifold.
+  std::vector<int> border_out(num_vertices, -1);
+  for (int h = 0; h < num_halfedge_slots(); ++h)
+  {
+    if (is_border(h))
+    {
+      if (border_out[source(h)] >= 0)
+      {
+        clear();
+        return false;
+      }
+      border_out[source(h)] = h;
+    }
+  }
+  for (int h = 0; h < num_halfedge_slots(); ++h)
+  {
+    if (is_border(h))
+    {
+      link(h, border_out[target(h)]);
+    }
+  }
+
+  // Every vertex must be a single fan of facets.
+  std::vector<int> valence(num_vertices, 0);
+  for (int h = 0; h < num_halfedge_slots(); ++h)
+  {
+    ++valence[target(h)];
+  }
+  for (int v = 0; v < num_vertices; ++v)
+  {
+    if (vhalfedge_[v] >= 0 && vertex_degree(v) != valence[v])
+    {
+      clear();
+      return false;
+    }
+  }
+  return true;
+}
+
+template <class Kernel>
+void Compact_mesh<Kernel>::collect_garbage()
+{
+  std::vector<int> vmap(points_.size(), -1);
+  std::vector<int> hmap(hnext_.size(), -1);
+  std::vector<int> fmap(fhalfedge_.size(), -1);
+
+  int nv = 0;
+  for (int v = 0; v < num_vertex_slots(); ++v)
+  {
+    if (!vremoved_[v])
+    {
+      vmap[v] = nv++;
+    }
+  }
+  int nh = 0;
+  for (int h = 0; h < num_halfedge_slots(); ++h)
+  {
+    if (!eremoved_[h >> 1])
+    {
+      hmap[h] = nh++;
+    }
+  }
+  int nf = 0;
+  for (int f = 0; f < num_facet_slots(); ++f)
+  {
+    if (!fremoved_[f])
+    {
+      fmap[f] = nf++;
+    }
+  }
+
+  for (int v = 0; v < num_vertex_slots(); ++v)
+  {
+    if (vmap[v] >= 0)
+    {
+      Vertex_info info = vinfo_[v];
+      if (info.parents.first != Vertex_handle {})
+      {
+        info.parents.first = Vertex_handle(this, vmap[info.parents.first.index()]);
+      }
+      if (info.parents.second != Vertex_handle {})
+      {
+        info.parents.second = Vertex_handle(this, vmap[info.parents.second.index()]);
+      }
+      points_[vmap[v]] = points_[v];
+      vinfo_[vmap[v]] = info;
+      vhalfedge_[vmap[v]] = vhalfedge_[v] < 0 ? -1 : hmap[vhalfedge_[v]];
+    }
+  }
+  for (int h = 0; h < num_halfedge_slots(); ++h)
+  {
+    if (hmap[h] >= 0)
+    {
+      hnext_[hmap[h]] = hmap[hnext_[h]];
+      hprev_[hmap[h]] = hmap[hprev_[h]];
+      hvertex_[hmap[h]] = vmap[hvertex_[h]];
+      hface_[hmap[h]] = hface_[h] < 0 ? -1 : fmap[hface_[h]];
+    }
+  }
+  for (int f = 0; f < num_facet_slots(); ++f)
+  {
+    if (fmap[f] >= 0)
+    {
+      fhalfedge_[fmap[f]] = hmap[fhalfedge_[f]];
+    }
+  }
+
+  points_.resize(nv);
+  vinfo_.resize(nv);
+  vhalfedge_.resize(nv);
+  vremoved_.assign(nv, 0);
+  hnext_.resize(nh);
+  hprev_.resize(nh);
+  hvertex_.resize(nh);
+  hface_.resize(nh);
+  eremoved_.assign(nh / 2, 0);
+  fhalfedge_.resize(nf);
+  fremoved_.assign(nf, 0);
+  removed_vertices_ = 0;
+  removed_edges_ = 0;
+  removed_facets_ = 0;
+}
+
+template <class Kernel>
+bool Compact_mesh<Kernel>::is_pure_triangle() const
+{
+  for (int f = next_facet_slot(-1); f < num_facet_slots(); f = next_facet_slot(f))
+  {
+    if (facet_degree(f) != 3)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <class Kernel>
+bool Compact_mesh<Kernel>::is_closed() const
+{
+  for (int h = next_halfedge_slot(-1); h < num_halfedge_slots(); h = next_halfedge_slot(h))
+  {
+    if (is_border(h))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <class Kernel>
+int Compact_mesh<Kernel>::vertex_degree(int v) const
+{
+  int h = vhalfedge_[v];
+  if (h < 0)
+  {
+    return 0;
+  }
+  int count = 0;
+  int hcir = h;
+  do
+  {
+    ++count;
+    hcir = opposite(hnext_[hcir]);
+  }
+  while (hcir != h);
+  return count;
+}
+
+template <class Kernel>
+int Compact_mesh<Kernel>::loop_size(int h) const
+{
+  int count = 0;
+  int hcir = h;
+  do
+  {
+    ++count;
+    hcir = hnext_[hcir];
+  }
+  while (hcir != h);
+  return count;
+}
+
+template <class Kernel>
+int Compact_mesh<Kernel>::next_vertex_slot(int v) const
+{
+  do
+  {
+    ++v;
+  }
+  while (v < num_vertex_slots() && vremoved_[v]);
+  return v;
+}
+
+template <class Kernel>
+int Compact_mesh<Kernel>::next_halfedge_slot(int h) const
+{
+  do
+  {
+    ++h;
+  }
+  while (h < num_halfedge_slots() && eremoved_[h >> 1]);
+  return h;
+}
+
+template <class Kernel>
+int Compact_mesh<Kernel>::next_edge_slot(int h) const
+{
+  do
+  {
+    h += 2;
+  }
+  while (h < num_halfedge_slots() && eremoved_[h >> 1]);
+  return h;
+}
+
+template <class Kernel>
+int Compact_mesh<Kernel>::next_facet_slot(int f) const
+{
+  do
+  {
+    ++f;
+  }
+  while (f < num_facet_slots() && fremoved_[f]);
+  return f;
+}
+
+template <class Kernel>
+int Compact_mesh<Kernel>::new_edge()
+{
+  int h = num_halfedge_slots();
+  hnext_.resize(h + 2, -1);
+  hprev_.resize(h + 2, -1);
+  hvertex_.resize(h + 2, -1);
+  hface_.resize(h + 2, -1);
+  eremoved_.push_back(0);
+  return h;
+}
+
+template <class Kernel>
+int Compact_mesh<Kernel>::new_vertex(int copy_from)
+{
+  int v = num_vertex_slots();
+  // Same as Polyhedron_3, the new vertex is a copy of the split one.
+  points_.push_back(points_[copy_from]);
+  vinfo_.push_back(vinfo_[copy_from]);
+  vhalfedge_.push_back(-1);
+  vremoved_.push_back(0);
+  return v;
+}
+
+template <class Kernel>
+int Compact_mesh<Kernel>::new_facet()
+{
+  int f = num_facet_slots();
+  fhalfedge_.push_back(-1);
+  fremoved_.push_back(0);
+  return f;
+}
+
+template <class Kernel>
+void Compact_mesh<Kernel>::set_face_in_face_loop(int h, int f)
+{
+  int hcir = h;
+  do
+  {
+    hface_[hcir] = f;
+    hcir = hnext_[hcir];
+  }
+  while (hcir != h);
+}
+
+template <class Kernel>
+void Compact_mesh<Kernel>::set_vertex_in_vertex_loop(int h, int v)
+{
+  int hcir = h;
+  do
+  {
+    hvertex_[hcir] = v;
+    hcir = opposite(hnext_[hcir]);
+  }
+  while (hcir != h);
+}
+
+template <class Kernel>
+typename Compact_mesh<Kernel>::Halfedge_handle
+Compact_mesh<Kernel>::split_vertex(Halfedge_handle hh, Halfedge_handle gh)
+{
+  int h = hh.index();
+  int g = gh.index();
+  assert(h != g);
+  assert(target(h) == target(g));
+
+  int v = target(h);
+  int hnew = new_edge();
+  int gnew = hnew ^ 1;
+  int vnew = new_vertex(v);
+
+  // hnew points to the old vertex and follows g, gnew points to the new
+  // vertex and follows h.
+  link(hnew, hnext_[g]);
+  link(g, hnew);
+  hface_[hnew] = hface_[g];
+  link(gnew, hnext_[h]);
+  link(h, gnew);
+  hface_[gnew] = hface_[h];
+
+  hvertex_[hnew] = v;
+  set_vertex_in_vertex_loop(gnew, vnew);
+  vhalfedge_[v] = hnew;
+  vhalfedge_[vnew] = gnew;
+  return Halfedge_handle(this, hnew);
+}
+
+template <class Kernel>
+typename Compact_mesh<Kernel>::Halfedge_handle
+Compact_mesh<Kernel>::split_facet(Halfedge_handle hh, Halfedge_handle gh)
+{
+  int h = hh.index();
+  int g = gh.index();
+  assert(h != g);
+  assert(face(h) == face(g));
+  assert(hnext_[h] != g && hnext_[g] != h);
+
+  int hnew = new_edge();
+  int gnew = hnew ^ 1;
+  int fnew = new_facet();
+
+  hvertex_[hnew] = target(g);
+  hvertex_[gnew] = target(h);
+  link(hnew, hnext_[g]);
+  link(g, gnew);
+  link(gnew, hnext_[h]);
+  link(h, hnew);
+
+  hface_[hnew] = hface_[h];
+  set_face_in_face_loop(gnew, fnew);
+  fhalfedge_[hface_[hnew]] = hnew;
+  fhalfedge_[fnew] = gnew;
+  return Halfedge_handle(this, hnew);
+}
+
+template <class Kernel>
+typename Compact_mesh<Kernel>::Halfedge_handle
+Compact_mesh<Kernel>::join_facet(Halfedge_handle hh)
+{
+  int h = hh.index();
+  int g = opposite(h);
+  int hprev = hprev_[h];
+  int gprev = hprev_[g];
+  int removed_facet = hface_[g];
+
+  link(hprev, hnext_[g]);
+  link(gprev, hnext_[h]);
+
+  eremoved_[h >> 1] = 1;
+  ++removed_edges_;
+  if (removed_facet >= 0)
+  {
+    fremoved_[removed_facet] = 1;
+    ++removed_facets_;
+  }
+
+  set_face_in_face_loop(hprev, hface_[h]);
+  vhalfedge_[target(hprev)] = hprev;
+  vhalfedge_[target(gprev)] = gprev;
+  if (hface_[hprev] >= 0)
+  {
+    fhalfedge_[hface_[hprev]] = hprev;
+  }
+  return Halfedge_handle(this, hprev);
+}
+
+template <class Kernel>
+typename Compact_mesh<Kernel>::Halfedge_handle
+Compact_mesh<Kernel>::join_vertex(Halfedge_handle hh)
+{
+  int h = hh.index();
+  int g = opposite(h);
+  int v = target(h);
+  int removed_vertex = target(g);
+  int hprev = hprev_[g];
+  int gprev = hprev_[h];
+
+  link(hprev, hnext_[g]);
+  link(gprev, hnext_[h]);
+
+  eremoved_[h >> 1] = 1;
+  ++removed_edges_;
+  vremoved_[removed_vertex] = 1;
+  ++removed_vertices_;
+
+  set_vertex_in_vertex_loop(gprev, v);
+  vhalfedge_[v] = hprev;
+  if (hface_[hprev] >= 0)
+  {
+    fhalfedge_[hface_[hprev]] = hprev;
+  }
+  if (hface_[gprev] >= 0)
+  {
+    fhalfedge_[hface_[gprev]] = gprev;
+  }
+  return Halfedge_handle(this, hprev);
+}
+
+/**
+ * @brief      Read a Compact_mesh from an OFF stream. Sets the failbit of the
+ *             stream if the input is not an oriented 2-manifold.
+ */
+template <class Kernel>
+std::istream& operator>>(std::istream& is, Compact_mesh<Kernel>& mesh)
+{
+  using Point_3 = typename Kernel::Point_3;
+
+  // Next line with content, comments are skipped.
+  std::string line;
+  auto next_line = [&is, &line]() -> bool
+                   {
+                     while (std::getline(is, line))
+                     {
+                       std::string::size_type c = line.find('#');
+                       if (c != std::string::npos)
+                       {
+                         line.erase(c);
+                       }
+                       if (line.find_first_not_of(" \t\r") != std::string::npos)
+                       {
+                         return true;
+                       }
+                     }
+                     return false;
+                   };
+
+  mesh.clear();
+  if (!next_line())
+  {
+    is.setstate(std::ios::failbit);
+    return is;
+  }
+
+  std::istringstream header {line};
+  std::string off;
+  header >> off;
+  if (off != "OFF")
+  {
+    is.setstate(std::ios::failbit);
+    return is;
+  }
+
+  // The counts may follow the keyword on the same line.
+  int nv = -1, nf = -1;
+  if (!(header >> nv >> nf))
+  {
+    if (!next_line())
+    {
+      is.setstate(std::ios::failbit);
+      return is;
+    }
+    std::istringstream counts {line};
+    counts >> nv >> nf;
+  }
+  if (nv < 0 || nf < 0)
+  {
+    is.setstate(std::ios::failbit);
+    return is;
+  }
+
+  std::vector<Point_3> points;
+  points.reserve(nv);
+  for (int i = 0; i < nv; ++i)
+  {
+    double x, y, z;
+    if (!next_line())
+    {
+      is.setstate(std::ios::failbit);
+      return is;
+    }
+    std::istringstream in {line};
+    if (!(in >> x >> y >> z))
+    {
+      is.setstate(std::ios::failbit);
+      return is;
+    }
+    points.emplace_back(x, y, z);
+  }
+
+  std::vector<std::vector<int>> facets(nf);
+  for (std::vector<int>& f : facets)
+  {
+    if (!next_line())
+    {
+      is.setstate(std::ios::failbit);
+      return is;
+    }
+    std::istringstream in {line};
+    int k = 0;
+    if (!(in >> k) || k < 0)
+    {
+      is.setstate(std::ios::failbit);
+      return is;
+    }
+    f.resize(k);
+    for (int& v : f)
+    {
+      if (!(in >> v))
+      {
+        is.setstate(std::ios::failbit);
+        return is;
+      }
+    }
+  }
+
+  if (!mesh.build(points, facets))
+  {
+    is.setstate(std::ios::failbit);
+  }
+  else
+  {
+    // getline may have hit the end of the stream on the last facet.
+    is.clear(is.rdstate() & ~std::ios::failbit);
+  }
+  return is;
+}
+
+/**
+ * @brief      Write a Compact_mesh to an OFF stream, removed elements are
+ *             skipped.
+ */
+template <class Kernel>
+std::ostream& operator<<(std::ostream& os, const Compact_mesh<Kernel>& mesh)
+{
+  std::vector<int> vmap(mesh.num_vertex_slots(), -1);
+  int nv = 0;
+  for (auto v = mesh.vertices_begin(); v != mesh.vertices_end(); ++v)
+  {
+    vmap[v.index()] = nv++;
+  }
+
+  os << "OFF\n" << mesh.size_of_vertices() << " " << mesh.size_of_facets()
+     << " " << mesh.size_of_halfedges() / 2 << "\n";
+  for (auto v = mesh.vertices_begin(); v != mesh.vertices_end(); ++v)
+  {
+    const auto& p = v->point();
+    os << p.x() << " " << p.y() << " " << p.z() << "\n";
+  }
+  for (auto f = mesh.facets_begin(); f != mesh.facets_end(); ++f)
+  {
+    os << f->facet_degree();
+    auto h = f->facet_begin();
+    do
+    {
+      os << " " << vmap[h->vertex().index()];
+      ++h;
+    }
+    while (h != f->facet_begin());
+    os << "\n";
+  }
+  return os;
+}
+
+namespace compact_mesh_impl
+{
+/**
+ * @brief      Builds a Polyhedron_3 from a Compact_mesh with the incremental
+ *             builder.
+ */
+template <class HDS, class Kernel>
+class Build_polyhedron: public CGAL::Modifier_base<HDS>
+{
+public:
+  Build_polyhedron(const Compact_mesh<Kernel>& mesh): mesh_(mesh) {}
+
+  void operator()(HDS& hds)
+  {
+    using Point = typename HDS::Vertex::Point;
+    std::vector<int> vmap(mesh_.num_vertex_slots(), -1);
+    CGAL::Polyhedron_incremental_builder_3<HDS> b(hds, true);
+    b.begin_surface(mesh_.size_of_vertices(),
+                    mesh_.size_of_facets(),
+                    mesh_.size_of_halfedges());
+    int nv = 0;
+    for (auto v = mesh_.vertices_begin(); v != mesh_.vertices_end(); ++v)
+    {
+      vmap[v.index()] = nv++;
+      const auto& p = v->point();
+      b.add_vertex(Point(p.x(), p.y(), p.z()));
+    }
+    for (auto f = mesh_.facets_begin(); f != mesh_.facets_end(); ++f)
+    {
+      b.begin_facet();
+      auto h = f->facet_begin();
+      do
+      {
+        b.add_vertex_to_facet(vmap[h->vertex().index()]);
+        ++h;
+      }
+      while (h != f->facet_begin());
+      b.end_facet();
+    }
+    b.end_surface();
+  }
+
+private:
+  const Compact_mesh<Kernel>& mesh_;
+};  // class Build_polyhedron
+}  // namespace compact_mesh_impl
+
+/**
+ * @brief      Copy a Polyhedron_3 (or any mesh with the same interface) into a
+ *             Compact_mesh. Vertex and facet orders are preserved.
+ *
+ * @param[in]  polyhedron  The source mesh
+ * @param      mesh        The destination mesh
+ *
+ * @return     False if the source mesh cannot be represented.
+ */
+template <class Polyhedron, class Kernel>
+bool polyhedron_to_compact_mesh(const Polyhedron& polyhedron,
+                                Compact_mesh<Kernel>& mesh)
+{
+  using Vertex_const_handle = typename Polyhedron::Vertex_const_handle;
+  using Point_3 = typename Kernel::Point_3;
+
+#if defined (WTLIB_USE_UNORDERED_MAP)
+  std::unordered_map<Vertex_const_handle, int> vmap;
+#else
+  std::map<Vertex_const_handle, int> vmap;
+#endif
+
+  std::vector<Point_3> points;
+  points.reserve(polyhedron.size_of_vertices());
+  for (auto v = polyhedron.vertices_begin(); v != polyhedron.vertices_end(); ++v)
+  {
+    vmap[v] = static_cast<int>(points.size());
+    const auto& p = v->point();
+    points.emplace_back(p.x(), p.y(), p.z());
+  }
+
+  std::vector<std::vector<int>> facets;
+  facets.reserve(polyhedron.size_of_facets());
+  for (auto f = polyhedron.facets_begin(); f != polyhedron.facets_end(); ++f)
+  {
+    facets.emplace_back();
+    auto h = f->facet_begin();
+    do
+    {
+      facets.back().push_back(vmap.at(h->vertex()));
+      ++h;
+    }
+    while (h != f->facet_begin());
+  }
+  return mesh.build(points, facets);
+}
+
+/**
+ * @brief      Copy a Compact_mesh into a Polyhedron_3, removed elements are
+ *             skipped.
+ *
+ * @param[in]  mesh        The source mesh
+ * @param      polyhedron  The destination mesh, cleared first
+ *
+ * @return     False if the incremental builder rejected the mesh.
+ */
+template <class Kernel, class Polyhedron>
+bool compact_mesh_to_polyhedron(const Compact_mesh<Kernel>& mesh,
+                                Polyhedron& polyhedron)
+{
+  polyhedron.clear();
+  compact_mesh_impl::Build_polyhedron<typename Polyhedron::HalfedgeDS, Kernel> builder(mesh);
+  polyhedron.delegate(builder);
+  return polyhedron.size_of_vertices() == mesh.size_of_vertices() &&
+         polyhedron.size_of_facets() == mesh.size_of_facets();
+}
+
+}  // namespace wtlib
+
+namespace std
+{
+template <class M>
+struct hash<wtlib::compact_mesh_impl::Vertex_handle<M>>
+{
+  std::size_t operator()(const wtlib::compact_mesh_impl::Vertex_handle<M>& v) const
+  {
+    return std::hash<int>()(v.index());
+  }
+};
+
+template <class M>
+struct hash<wtlib::compact_mesh_impl::Halfedge_handle<M>>
+{
+  std::size_t operator()(const wtlib::compact_mesh_impl::Halfedge_handle<M>& h) const
+  {
+    return std::hash<int>()(h.index());
+  }
+};
+
+template <class M>
+struct hash<wtlib::compact_mesh_impl::Facet_handle<M>>
+{
+  std::size_t operator()(const wtlib::compact_mesh_impl::Facet_handle<M>& f) const
+  {
+    return std::hash<int>()(f.index());
+  }
+};
+}  // namespace std
+
+#endif  // define WTLIB_COMPACT_MESH_HPP
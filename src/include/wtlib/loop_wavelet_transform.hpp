@@ -6,10 +6,13 @@
  * @brief    Defines the Loop wavelet transform.
  */
 
+#include <wtlib/classification_certificate.hpp>
+#include <wtlib/mesh_components.hpp>
 #include <wtlib/ptq_impl/vertex_classification.hpp>
 #include <wtlib/ptq_impl/loop_wavelet_operations.hpp>
 #include <wtlib/ptq_impl/mesh_vertex_info.hpp>
 #include <wtlib/ptq_impl/subdivision_modifier.hpp>
+#include <wtlib/wavelet_coefficients.hpp>
 #include <wtlib/wavelet_mesh_operations.hpp>
 #include <wtlib/wavelet_operations.hpp>
 
@@ -22,10 +25,10 @@ namespace wtlib
 
 template <class Mesh, class Mesh_ops>
 bool loop_analyze_classify(Mesh& mesh, const Mesh_ops& mesh_ops, int num_levels, std::vector<typename Mesh::Vertex_handle>& vertices,
-  std::vector<typename Mesh::Vertex_handle*>& bands)
+  std::vector<typename Mesh::Vertex_handle*>& bands, int num_threads = 1)
 {
   using PTQ_classify = ptq_impl::PTQ_classify_vertices<Mesh, Mesh_ops>;
-  return PTQ_classify::classify(mesh, mesh_ops, num_levels, vertices, bands, true);
+  return PTQ_classify::classify(mesh, mesh_ops, num_levels, vertices, bands, true, num_threads);
 }
 
 template <class Mesh, class Mesh_ops>
@@ -44,10 +47,11 @@ void loop_analyze_cleanup(Mesh& mesh, const Mesh_ops& mesh_ops)
 
 template <class Mesh, class Mesh_ops>
 void loop_analyze_lift(Mesh& mesh, const Mesh_ops& mesh_ops,
-  typename Mesh::Vertex_handle** first_band, typename Mesh::Vertex_handle** last_band)
+  typename Mesh::Vertex_handle** first_band, typename Mesh::Vertex_handle** last_band,
+  int num_threads)
 {
   using Loop = ptq_impl::Loop_analysis_operations<Mesh, Mesh_ops>;
-  Loop::lift(mesh, mesh_ops, first_band, last_band);
+  Loop::lift(mesh, mesh_ops, first_band, last_band, num_threads);
 }
 
 template <class Mesh, class Mesh_ops>
@@ -76,6 +80,9 @@ template <class Mesh, class Mesh_ops>
 void loop_synthesize_initialize(Mesh& mesh, const Mesh_ops& mesh_ops, int level)
 {
   using Loop = ptq_impl::Loop_synthesis_operations<Mesh, Mesh_ops>;
+  using PTQ_modifier = ptq_impl::PTQ_subdivision_modifier<Mesh, Mesh_ops>;
+  // The synthesis refines the mesh level times.
+  PTQ_modifier::reserve(mesh, level);
   Loop::initialize(mesh, mesh_ops, level);
 }
 
@@ -95,13 +102,143 @@ void loop_synthesize_refine(Mesh& mesh, const Mesh_ops& mesh_ops, int level, std
 
 template <class Mesh, class Mesh_ops>
 void loop_synthesize_lift(Mesh& mesh, const Mesh_ops& mesh_ops,
-  typename Mesh::Vertex_handle** first_band, typename Mesh::Vertex_handle** last_band)
+  typename Mesh::Vertex_handle** first_band, typename Mesh::Vertex_handle** last_band,
+  int num_threads)
 {
   using Loop = ptq_impl::Loop_synthesis_operations<Mesh, Mesh_ops>;
-  return Loop::lift(mesh, mesh_ops, first_band, last_band);
+  return Loop::lift(mesh, mesh_ops, first_band, last_band, num_threads);
+}
+
+
+
+/**
+ * @brief    The Loop forward wavelet transform of num_levels levels, or of as
+ *           many levels as the mesh has up to num_levels if max_levels is
+ *           true, which does not use a certificate. Returns the number of
+ *           transform levels, 0 on failure.
+ */
+template <class Mesh, class Mesh_ops, class Coefs>
+int loop_analyze_levels_with_ops(Mesh& mesh, const Mesh_ops& mesh_ops,
+  Coefs& coefs, int num_levels, int num_threads,
+  Classification_certificate* certificate, bool max_levels)
+{
+  using Vertex_handle = typename Mesh::Vertex_handle;
+  using PTQ_classify = ptq_impl::PTQ_classify_vertices<Mesh, Mesh_ops>;
+
+  assert(!mesh.empty() && mesh.is_pure_triangle());
+  assert(!(certificate && max_levels));
+
+  num_threads = ptq_impl::get_num_threads(num_threads);
+  auto classify = [certificate, max_levels, num_threads](Mesh& m,
+                                                         const Mesh_ops& m_ops,
+                                                         int n,
+                                                         std::vector<Vertex_handle>& vertices,
+                                                         std::vector<Vertex_handle*>& bands)
+                  {
+                    if (max_levels)
+                    {
+                      return PTQ_classify::classify_max_levels(m, m_ops, n, vertices, bands, true, num_threads) > 0;
+                    }
+                    return certificate ?
+                      PTQ_classify::classify(m, m_ops, n, vertices, bands, *certificate, num_threads) :
+                      loop_analyze_classify(m, m_ops, n, vertices, bands, num_threads);
+                  };
+  auto lift = [num_threads](Mesh& m,
+                            const Mesh_ops& m_ops,
+                            Vertex_handle** first_band,
+                            Vertex_handle** last_band)
+              {
+                loop_analyze_lift(m, m_ops, first_band, last_band, num_threads);
+              };
+  auto analysis_ops = make_wavelet_analysis_ops<Mesh, Mesh_ops>(
+                            loop_get_num_types<Mesh, Mesh_ops>,
+                            classify,
+                            loop_analyze_initialize<Mesh, Mesh_ops>,
+                            loop_analyze_cleanup<Mesh, Mesh_ops>,
+                            lift,
+                            loop_analyze_coarsen<Mesh, Mesh_ops>);
+
+  Wavelet_analyze<Mesh_ops, decltype(analysis_ops)> analyze {mesh_ops,
+                                                             analysis_ops};
+  if (max_levels)
+  {
+    return analyze.analyze_max_levels(mesh, coefs, num_levels);
+  }
+  return analyze(mesh, coefs, num_levels) ? num_levels : 0;
+}
+
+/**
+ * @brief    The Loop forward wavelet transform with the given mesh operations,
+ *           where coefs is a std::vector<std::vector<Vector_3>> or a
+ *           Wavelet_coefficients<Vector_3>. Mesh operations whose accessors
+ *           are plain member functions are inlined into the lifting steps.
+ *           A non-null certificate is used to skip the vertex classification
+ *           and is updated otherwise.
+ */
+template <class Mesh, class Mesh_ops, class Coefs>
+bool loop_analyze_with_ops(Mesh& mesh, const Mesh_ops& mesh_ops, Coefs& coefs,
+  int num_levels, int num_threads,
+  Classification_certificate* certificate = nullptr)
+{
+  return loop_analyze_levels_with_ops(mesh, mesh_ops, coefs, num_levels,
+                                      num_threads, certificate, false) > 0;
+}
+
+/**
+ * @brief    The Loop inverse wavelet transform with the given mesh operations,
+ *           where coefs is a std::vector<std::vector<Vector_3>>, whose used
+ *           bands are erased, or a const Wavelet_coefficients<Vector_3>.
+ */
+template <class Mesh, class Mesh_ops, class Coefs>
+void loop_synthesize_with_ops(Mesh& mesh, const Mesh_ops& mesh_ops,
+  Coefs& coefs, int num_levels, int num_threads)
+{
+  using Vertex_handle = typename Mesh::Vertex_handle;
+
+  num_threads = ptq_impl::get_num_threads(num_threads);
+  auto lift = [num_threads](Mesh& m,
+                            const Mesh_ops& m_ops,
+                            Vertex_handle** first_band,
+                            Vertex_handle** last_band)
+              {
+                loop_synthesize_lift(m, m_ops, first_band, last_band, num_threads);
+              };
+  auto synthesis_ops = make_wavelet_synthesis_ops<Mesh, Mesh_ops>(
+                        loop_get_num_types<Mesh, Mesh_ops>,
+                        loop_synthesize_get_mesh_size<Mesh, Mesh_ops>,
+                        loop_synthesize_initialize<Mesh, Mesh_ops>,
+                        loop_synthesize_cleanup<Mesh, Mesh_ops>,
+                        loop_synthesize_refine<Mesh, Mesh_ops>,
+                        lift);
+
+  Wavelet_synthesize<Mesh_ops, decltype(synthesis_ops)>(
+    mesh_ops, synthesis_ops)(mesh, coefs, num_levels);
 }
 
 
+/**
+ * @brief    Overloaded loop_analyze with the given mesh operations, see
+ *           Wavelet_mesh_operations and ptq_impl::Mesh_info_operations.
+ */
+template <class Mesh, class Mesh_ops>
+bool loop_analyze(Mesh& mesh, Mesh_ops& mesh_ops,
+  std::vector<std::vector<typename Mesh::Traits::Vector_3>>& coefs, int num_levels,
+  int num_threads = 1)
+{
+  return loop_analyze_with_ops(mesh, mesh_ops, coefs, num_levels, num_threads);
+}
+
+/**
+ * @brief    Overloaded loop_analyze with the given mesh operations, writing
+ *           the coefficients to a contiguous buffer.
+ */
+template <class Mesh, class Mesh_ops>
+bool loop_analyze(Mesh& mesh, Mesh_ops& mesh_ops,
+  Wavelet_coefficients<typename Mesh::Traits::Vector_3>& coefs, int num_levels,
+  int num_threads = 1)
+{
+  return loop_analyze_with_ops(mesh, mesh_ops, coefs, num_levels, num_threads);
+}
 
 /**
  * @brief    The Loop forward wavelet transform.
@@ -111,6 +248,8 @@ void loop_synthesize_lift(Mesh& mesh, const Mesh_ops& mesh_ops,
  * @param    coefs      The wavelet coefficients, where an inner vector is the
  *                      wavelet coefficients at a resolution.
  * @param    num_levels The number of transform levels.
+ * @param    num_threads The number of threads used by the lifting steps, a
+ *                      value less than 1 uses all hardware threads.
  *
  * @return true         
  * @return false        FWT fails because the input mesh does not have enough
@@ -119,121 +258,133 @@ void loop_synthesize_lift(Mesh& mesh, const Mesh_ops& mesh_ops,
 template<class Mesh>
 bool loop_analyze(Mesh& mesh,
                   std::vector<std::vector<typename Mesh::Traits::Vector_3>>& coefs,
-                  int num_levels)
+                  int num_levels,
+                  int num_threads = 1)
 {
-  using Vertex_handle = typename Mesh::Vertex_handle;
-  using Vertex_const_handle = typename Mesh::Vertex_const_handle;
-
-  using Get_vertex_id = std::function<int(Vertex_const_handle)>;
-  using Set_vertex_id = std::function<void(Vertex_handle, int)>;
-  using Get_vertex_level = std::function<int(Vertex_const_handle)>;
-  using Set_vertex_level = std::function<void(Vertex_handle, int)>;
-  using Get_vertex_type = std::function<int(Vertex_const_handle)>;
-  using Set_vertex_type = std::function<void(Vertex_handle, int)>;
-  using Get_vertex_border = std::function<bool(Vertex_const_handle)>;
-  using Set_vertex_border = std::function<void(Vertex_handle, bool)>;
-  using Mesh_info = ptq_impl::Mesh_info<Mesh>;
-  using Mesh_ops = Wavelet_mesh_operations<
-                                        Mesh,
-                                        Get_vertex_id,
-                                        Set_vertex_id,
-                                        Get_vertex_level,
-                                        Set_vertex_level,
-                                        Get_vertex_type,
-                                        Set_vertex_type,
-                                        Get_vertex_border,
-                                        Set_vertex_border
-                                      >;
-  using Analysis_ops = Wavelet_analysis_ops<Mesh,
-                                            Mesh_ops,
-                                            int (*) (Mesh&, const Mesh_ops&),
-                                            bool (*) (Mesh&,
-                                                      const Mesh_ops&, 
-                                                      int,
-                                                      std::vector<Vertex_handle>&,
-                                                      std::vector<Vertex_handle*>&),
-                                            void (*) (Mesh&, const Mesh_ops&),
-                                            void (*) (Mesh&, const Mesh_ops&),
-                                            void (*) (Mesh&,
-                                                      const Mesh_ops&,
-                                                      Vertex_handle**,
-                                                      Vertex_handle**),
-                                            void (*) (Mesh&, const Mesh_ops&, int)
->;
-  using Wavelet_analyze = Wavelet_analyze<Mesh_ops, Analysis_ops>;
-
-  using std::placeholders::_1;
-  using std::placeholders::_2;
+  // Hold mesh vertex info
+  ptq_impl::Mesh_info<Mesh> mesh_info;
+  ptq_impl::Mesh_info_operations<Mesh> mesh_ops {&mesh_info};
 
-  assert(!mesh.empty() && mesh.is_pure_triangle());
+  return loop_analyze_with_ops(mesh, mesh_ops, coefs, num_levels, num_threads);
+}
 
-  // Setup mesh_ops
+/**
+ * @brief    Overloaded loop_analyze writing the coefficients to a contiguous
+ *           buffer, whose band b holds the inner vector coefs[b] of the
+ *           overload above.
+ */
+template<class Mesh>
+bool loop_analyze(Mesh& mesh,
+                  Wavelet_coefficients<typename Mesh::Traits::Vector_3>& coefs,
+                  int num_levels,
+                  int num_threads = 1)
+{
   // Hold mesh vertex info
-  Mesh_info mesh_info;
-  // Mesh operations functors
-  Get_vertex_id get_vertex_id = std::bind(&Mesh_info::get_vertex_id, &mesh_info,  _1);
-  Set_vertex_id set_vertex_id = std::bind(&Mesh_info::set_vertex_id, &mesh_info,  _1, _2);
-  Get_vertex_type get_vertex_type = std::bind(&Mesh_info::get_vertex_type, &mesh_info,  _1);
-  Set_vertex_type set_vertex_type = std::bind(&Mesh_info::set_vertex_type, &mesh_info,  _1, _2);
-  Get_vertex_border get_vertex_border = std::bind(&Mesh_info::get_vertex_border, &mesh_info,  _1);
-  Set_vertex_border set_vertex_border = std::bind(&Mesh_info::set_vertex_border, &mesh_info,  _1, _2);
-  Get_vertex_level get_vertex_level = std::bind(&Mesh_info::get_vertex_level, &mesh_info,  _1);
-  Set_vertex_level set_vertex_level = std::bind(&Mesh_info::set_vertex_level, &mesh_info,  _1, _2);
-
-  Mesh_ops mesh_ops {get_vertex_id,
-                     set_vertex_id,
-                     get_vertex_level,
-                     set_vertex_level,
-                     get_vertex_type,
-                     set_vertex_type,
-                     get_vertex_border,
-                     set_vertex_border};
-
-  return Wavelet_analyze(mesh_ops, 
-                         Analysis_ops(
-                            loop_get_num_types<Mesh, Mesh_ops>,
-                            loop_analyze_classify<Mesh, Mesh_ops>,
-                            loop_analyze_initialize<Mesh, Mesh_ops>,
-                            loop_analyze_cleanup<Mesh, Mesh_ops>,
-                            loop_analyze_lift<Mesh, Mesh_ops>,
-                            loop_analyze_coarsen<Mesh, Mesh_ops>
-                            )
-                         )(mesh, coefs, num_levels);
+  ptq_impl::Mesh_info<Mesh> mesh_info;
+  ptq_impl::Mesh_info_operations<Mesh> mesh_ops {&mesh_info};
+
+  return loop_analyze_with_ops(mesh, mesh_ops, coefs, num_levels, num_threads);
 }
 
+
 /**
- * @brief    Overloaded loop_analyze.
- * 
+ * @brief    Overloaded loop_analyze with a certificate of the subdivision
+ *           connectivity. If the certificate was produced for the same mesh
+ *           connectivity and number of levels, the vertices are not
+ *           classified again; otherwise it is replaced by the certificate of
+ *           this classification, which can be saved for later transforms.
  */
-template <class Mesh, class Mesh_ops>
-bool loop_analyze(Mesh& mesh, Mesh_ops& mesh_ops,
-  std::vector<std::vector<typename Mesh::Traits::Vector_3>>& coefs, int num_levels)
+template<class Mesh>
+bool loop_analyze(Mesh& mesh,
+                  Wavelet_coefficients<typename Mesh::Traits::Vector_3>& coefs,
+                  int num_levels,
+                  Classification_certificate& certificate,
+                  int num_threads = 1)
 {
-  using Analysis_ops = wtlib::Wavelet_analysis_ops<Mesh, Mesh_ops,
-    int (*) (Mesh&, const Mesh_ops&),
-    bool (*) (Mesh&, const Mesh_ops&, int, std::vector<typename Mesh::Vertex_handle>&, std::vector<typename Mesh::Vertex_handle*>&),
-    void (*) (Mesh&, const Mesh_ops&),
-    void (*) (Mesh&, const Mesh_ops&),
-    void (*) (Mesh&, const Mesh_ops&, typename Mesh::Vertex_handle**, typename Mesh::Vertex_handle**),
-    void (*) (Mesh&, const Mesh_ops&, int)
->;
-  using Wavelet_analyze = Wavelet_analyze<Mesh_ops, Analysis_ops>;
+  // Hold mesh vertex info
+  ptq_impl::Mesh_info<Mesh> mesh_info;
+  ptq_impl::Mesh_info_operations<Mesh> mesh_ops {&mesh_info};
 
-  assert(!mesh.empty() && mesh.is_pure_triangle());
+  return loop_analyze_with_ops(mesh, mesh_ops, coefs, num_levels, num_threads,
+                               &certificate);
+}
 
-  return Wavelet_analyze(mesh_ops,
-                         Analysis_ops(
-                            loop_get_num_types<Mesh, Mesh_ops>,
-                            loop_analyze_classify<Mesh, Mesh_ops>,
-                            loop_analyze_initialize<Mesh, Mesh_ops>,
-                            loop_analyze_cleanup<Mesh, Mesh_ops>,
-                            loop_analyze_lift<Mesh, Mesh_ops>,
-                            loop_analyze_coarsen<Mesh, Mesh_ops>
-                            )
-                         )(mesh, coefs, num_levels);
+/**
+ * @brief    The Loop forward wavelet transform of as many levels as the mesh
+ *           has, found in the same pass as the vertex classification.
+ *
+ * @param    max_levels The maximum number of transform levels, a value less
+ *                      than 1 sets no limit.
+ *
+ * @return   The number of transform levels, 0 if the input mesh does not have
+ *           subdivision connectivity.
+ */
+template<class Mesh>
+int loop_analyze_max_levels(Mesh& mesh,
+                            Wavelet_coefficients<typename Mesh::Traits::Vector_3>& coefs,
+                            int max_levels = 0,
+                            int num_threads = 1)
+{
+  // Hold mesh vertex info
+  ptq_impl::Mesh_info<Mesh> mesh_info;
+  ptq_impl::Mesh_info_operations<Mesh> mesh_ops {&mesh_info};
+
+  return loop_analyze_levels_with_ops(mesh, mesh_ops, coefs, max_levels,
+                                      num_threads, nullptr, true);
 }
 
+/**
+ * @brief    The Loop forward wavelet transform of every connected component of
+ *           the mesh, see analyze_components. Each component is transformed by
+ *           as many levels as it has, so the components may have different
+ *           numbers of levels.
+ *
+ * @param    coefs      The coefficients and number of levels of every
+ *                      component.
+ * @param    max_levels The maximum number of transform levels, a value less
+ *                      than 1 sets no limit.
+ *
+ * @return   The largest number of transform levels of a component, 0 if no
+ *           component has subdivision connectivity.
+ */
+template<class Mesh>
+int loop_analyze_components(Mesh& mesh,
+  std::vector<Component_coefficients<typename Mesh::Traits::Vector_3>>& coefs,
+  int max_levels = 0,
+  int num_threads = 1)
+{
+  return analyze_components(mesh, coefs, num_threads,
+                 [max_levels](Mesh& m,
+                              Wavelet_coefficients<typename Mesh::Traits::Vector_3>& c,
+                              int n)
+                 {
+                   return loop_analyze_max_levels(m, c, max_levels, n);
+                 });
+}
+
+
+/**
+ * @brief    Overloaded loop_synthesize with the given mesh operations.
+ */
+template <class Mesh, class Mesh_ops>
+void loop_synthesize(Mesh& mesh, Mesh_ops& mesh_ops,
+  std::vector<std::vector<typename Mesh::Traits::Vector_3>>& coefs, int num_levels,
+  int num_threads = 1)
+{
+  loop_synthesize_with_ops(mesh, mesh_ops, coefs, num_levels, num_threads);
+}
 
+/**
+ * @brief    Overloaded loop_synthesize with the given mesh operations, reading
+ *           the coefficients from a contiguous buffer.
+ */
+template <class Mesh, class Mesh_ops>
+void loop_synthesize(Mesh& mesh, Mesh_ops& mesh_ops,
+  const Wavelet_coefficients<typename Mesh::Traits::Vector_3>& coefs, int num_levels,
+  int num_threads = 1)
+{
+  loop_synthesize_with_ops(mesh, mesh_ops, coefs, num_levels, num_threads);
+}
 
 /**
  * @brief    The Loop inverse wavelet transform.
@@ -243,121 +394,64 @@ bool loop_analyze(Mesh& mesh, Mesh_ops& mesh_ops,
  * @param    coefs      The wavelet coefficients, where an inner vector should
  *                      be the wavelet coefficients at a resolution, and the
  *                      number should match the number of introduced vertices.
+ *                      The used inner vectors are erased.
  * @param    num_levels The number of transform levels.
+ * @param    num_threads The number of threads used by the lifting steps, a
+ *                      value less than 1 uses all hardware threads.
  *
  */
 template<class Mesh>
 void loop_synthesize(Mesh& mesh,
                      std::vector<std::vector<typename Mesh::Traits::Vector_3>>& coefs,
-                     int num_levels)
+                     int num_levels,
+                     int num_threads = 1)
 {
-  using Vertex_handle = typename Mesh::Vertex_handle;
-  using Vertex_const_handle = typename Mesh::Vertex_const_handle;
-
-  using Get_vertex_id = std::function<int(Vertex_const_handle)>;
-  using Set_vertex_id = std::function<void(Vertex_handle, int)>;
-  using Get_vertex_level = std::function<int(Vertex_const_handle)>;
-  using Set_vertex_level = std::function<void(Vertex_handle, int)>;
-  using Get_vertex_type = std::function<int(Vertex_const_handle)>;
-  using Set_vertex_type = std::function<void(Vertex_handle, int)>;
-  using Get_vertex_border = std::function<bool(Vertex_const_handle)>;
-  using Set_vertex_border = std::function<void(Vertex_handle, bool)>;
-  using Mesh_info = ptq_impl::Mesh_info<Mesh>;
-  using Mesh_ops = Wavelet_mesh_operations<
-                                        Mesh,
-                                        Get_vertex_id,
-                                        Set_vertex_id,
-                                        Get_vertex_level,
-                                        Set_vertex_level,
-                                        Get_vertex_type,
-                                        Set_vertex_type,
-                                        Get_vertex_border,
-                                        Set_vertex_border
-                                      >;
-  using Synthesis_ops = Wavelet_synthesis_ops<Mesh,
-                                              Mesh_ops,
-                                              int (*)(Mesh&, const Mesh_ops&),
-                                              int (*)(Mesh&, const Mesh_ops&, int),
-                                              void (*)(Mesh&, const Mesh_ops&, int),
-                                              void (*)(Mesh&, const Mesh_ops&),
-                                              void (*)(Mesh&,
-                                                       const Mesh_ops&,
-                                                       int,
-                                                       std::vector<Vertex_handle>&,
-                                                       std::vector<Vertex_handle*>&),
-                                              void (*)(Mesh&,
-                                                       const Mesh_ops&,
-                                                       Vertex_handle**,
-                                                       Vertex_handle**)
-                                              >;
-  using Wavelet_synthesize = Wavelet_synthesize<Mesh_ops, Synthesis_ops>;
-
-  using std::placeholders::_1;
-  using std::placeholders::_2;
+  assert(!mesh.empty() && mesh.is_pure_triangle());
 
+  // Hold mesh vertex info
+  ptq_impl::Mesh_info<Mesh> mesh_info;
+  ptq_impl::Mesh_info_operations<Mesh> mesh_ops {&mesh_info};
+
+  loop_synthesize_with_ops(mesh, mesh_ops, coefs, num_levels, num_threads);
+}
+
+/**
+ * @brief    Overloaded loop_synthesize reading the coefficients from a
+ *           contiguous buffer, which is left unchanged.
+ */
+template<class Mesh>
+void loop_synthesize(Mesh& mesh,
+                     const Wavelet_coefficients<typename Mesh::Traits::Vector_3>& coefs,
+                     int num_levels,
+                     int num_threads = 1)
+{
   assert(!mesh.empty() && mesh.is_pure_triangle());
 
-  // Setup mesh_ops
   // Hold mesh vertex info
-  Mesh_info mesh_info;
-  // Mesh operations functors
-  Get_vertex_id get_vertex_id = std::bind(&Mesh_info::get_vertex_id, &mesh_info,  _1);
-  Set_vertex_id set_vertex_id = std::bind(&Mesh_info::set_vertex_id, &mesh_info,  _1, _2);
-  Get_vertex_type get_vertex_type = std::bind(&Mesh_info::get_vertex_type, &mesh_info,  _1);
-  Set_vertex_type set_vertex_type = std::bind(&Mesh_info::set_vertex_type, &mesh_info,  _1, _2);
-  Get_vertex_border get_vertex_border = std::bind(&Mesh_info::get_vertex_border, &mesh_info,  _1);
-  Set_vertex_border set_vertex_border = std::bind(&Mesh_info::set_vertex_border, &mesh_info,  _1, _2);
-  Get_vertex_level get_vertex_level = std::bind(&Mesh_info::get_vertex_level, &mesh_info,  _1);
-  Set_vertex_level set_vertex_level = std::bind(&Mesh_info::set_vertex_level, &mesh_info,  _1, _2);
-
-  Mesh_ops mesh_ops {get_vertex_id,
-                     set_vertex_id,
-                     get_vertex_level,
-                     set_vertex_level,
-                     get_vertex_type,
-                     set_vertex_type,
-                     get_vertex_border,
-                     set_vertex_border};
-  Wavelet_synthesize(mesh_ops,
-                     Synthesis_ops(
-                        loop_get_num_types<Mesh, Mesh_ops>,
-                        loop_synthesize_get_mesh_size<Mesh, Mesh_ops>,
-                        loop_synthesize_initialize<Mesh, Mesh_ops>,
-                        loop_synthesize_cleanup<Mesh, Mesh_ops>,
-                        loop_synthesize_refine<Mesh, Mesh_ops>,
-                        loop_synthesize_lift<Mesh, Mesh_ops>
-                        )
-                     )(mesh, coefs, num_levels);
+  ptq_impl::Mesh_info<Mesh> mesh_info;
+  ptq_impl::Mesh_info_operations<Mesh> mesh_ops {&mesh_info};
+
+  loop_synthesize_with_ops(mesh, mesh_ops, coefs, num_levels, num_threads);
 }
 
 /**
- * @brief    Overloaded loop_synthesize.
- * 
+ * @brief    The Loop inverse wavelet transform of every connected component of
+ *           the coarse mesh, with the coefficients of loop_analyze_components.
  */
-template <class Mesh, class Mesh_ops>
-void loop_synthesize(Mesh& mesh, Mesh_ops& mesh_ops,
-  std::vector<std::vector<typename Mesh::Traits::Vector_3>>& coefs, int num_levels)
+template<class Mesh>
+void loop_synthesize_components(Mesh& mesh,
+  const std::vector<Component_coefficients<typename Mesh::Traits::Vector_3>>& coefs,
+  int num_threads = 1)
 {
-  using Synthesis_ops = Wavelet_synthesis_ops<Mesh, Mesh_ops,
-    int (*)(Mesh&, const Mesh_ops&),
-    int (*)(Mesh&, const Mesh_ops&, int),
-    void (*)(Mesh&, const Mesh_ops&, int),
-    void (*)(Mesh&, const Mesh_ops&),
-    void (*)(Mesh&, const Mesh_ops&, int, std::vector<typename Mesh::Vertex_handle>&, std::vector<typename Mesh::Vertex_handle*>&),
-    void (*)(Mesh&, const Mesh_ops&, typename Mesh::Vertex_handle**, typename Mesh::Vertex_handle**)
-  >;
-  using Wavelet_synthesize = Wavelet_synthesize<Mesh_ops, Synthesis_ops>;
-  Wavelet_synthesize(mesh_ops,
-                     Synthesis_ops(
-                        loop_get_num_types<Mesh, Mesh_ops>,
-                        loop_synthesize_get_mesh_size<Mesh, Mesh_ops>,
-                        loop_synthesize_initialize<Mesh, Mesh_ops>,
-                        loop_synthesize_cleanup<Mesh, Mesh_ops>,
-                        loop_synthesize_refine<Mesh, Mesh_ops>,
-                        loop_synthesize_lift<Mesh, Mesh_ops>
-                        )
-                     )(mesh, coefs, num_levels);
+  synthesize_components(mesh, coefs, num_threads,
+                 [](Mesh& m,
+                    const Wavelet_coefficients<typename Mesh::Traits::Vector_3>& c,
+                    int num_levels,
+                    int n)
+                 {
+                   loop_synthesize(m, c, num_levels, n);
+                 });
 }
 
 }
-#endif
\ No newline at end of file
+#endif
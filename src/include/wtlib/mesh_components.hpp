@@ -0,0 +1,411 @@
+#ifndef WTLIB_MESH_COMPONENTS_HPP
+#define WTLIB_MESH_COMPONENTS_HPP
+
+/**
+ * @file     mesh_components.hpp
+ * @brief    Defines the split of a mesh into its connected components and the
+ *           wavelet transforms of every component on its own.
+ *
+ * The classification finds the subdivision connectivity of a whole mesh, so a
+ * mesh of several connected components (e.g., an assembly of many shells)
+ * fails unless one crawl covers every component. Transforming the components
+ * separately classifies, lifts and coarsens each of them independently, on
+ * its own thread, and each component may have a different number of levels.
+ *
+ * The components are numbered in the memory order of their first vertex, and
+ * a component keeps the memory order of its vertices and facets. Merging the
+ * components lays them out one after another in this order, so the coarse mesh
+ * of the forward transform splits into the same components again for the
+ * inverse transform.
+ */
+
+#include <wtlib/ptq_impl/mesh_vertex_info.hpp>
+#include <wtlib/ptq_impl/parallel_for.hpp>
+#include <wtlib/wavelet_coefficients.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+#include <CGAL/Modifier_base.h>
+#include <CGAL/Polyhedron_incremental_builder_3.h>
+
+namespace wtlib
+{
+/**
+ * @brief    The wavelet coefficients of a connected component and its number
+ *           of transform levels, 0 if the component was left unchanged.
+ *
+ * @tparam   V  The vector type of the mesh (i.e., Mesh::Traits::Vector_3).
+ */
+template <class V>
+struct Component_coefficients
+{
+  int num_levels = 0;
+  Wavelet_coefficients<V> coefs;
+};
+
+namespace ptq_impl
+{
+/**
+ * @brief    The vertices and facets of a mesh as index arrays, labelled by
+ *           connected component.
+ */
+template <class Point_3>
+struct Mesh_components
+{
+  std::vector<Point_3> points;
+  // Three vertex indices per facet, in the memory order of the facets.
+  std::vector<int> triangles;
+  // The component of every vertex.
+  std::vector<int> component;
+  int num_components = 0;
+};
+
+/**
+ * @brief    Builds a Polyhedron_3 from a triangle list with the incremental
+ *           builder.
+ */
+template <class Mesh>
+class Triangle_mesh_builder: public CGAL::Modifier_base<typename Mesh::HDS>
+{
+public:
+  using Point_3 = typename Mesh::Traits::Point_3;
+
+  Triangle_mesh_builder(const std::vector<Point_3>& points,
+                        const std::vector<int>& triangles)
+  : points_(points),
+    triangles_(triangles)
+  {}
+
+  void operator()(typename Mesh::HDS& hds)
+  {
+    CGAL::Polyhedron_incremental_builder_3<typename Mesh::HDS> b(hds, true);
+    b.begin_surface(points_.size(), triangles_.size() / 3);
+    for (const Point_3& p : points_)
+    {
+      b.add_vertex(p);
+    }
+    for (std::size_t t = 0; t < triangles_.size(); t += 3)
+    {
+      b.begin_facet();
+      b.add_vertex_to_facet(triangles_[t]);
+      b.add_vertex_to_facet(triangles_[t + 1]);
+      b.add_vertex_to_facet(triangles_[t + 2]);
+      b.end_facet();
+    }
+    b.end_surface();
+  }
+
+private:
+  const std::vector<Point_3>& points_;
+  const std::vector<int>& triangles_;
+};  // class Triangle_mesh_builder
+
+/**
+ * @brief      Replace a mesh by a triangle list, whose facets start at the
+ *             halfedge pointing to their first vertex.
+ *
+ * @param      mesh       The mesh
+ * @param[in]  points     The points of the vertices
+ * @param      triangles  The triangles, three vertex indices each, which may
+ *                        be reordered
+ */
+template <class Mesh>
+void build_triangle_mesh(Mesh& mesh,
+                         const std::vector<typename Mesh::Traits::Point_3>& points,
+                         std::vector<int>& triangles)
+{
+  if constexpr (std::is_same<typename Mesh::HDS, Mesh>::value)
+  {
+    // The facet of a Compact_mesh starts at the halfedge from its first to
+    // its second vertex, so rotate the triangles to start each facet at the
+    // halfedge pointing to its first vertex.
+    for (std::size_t t = 0; t < triangles.size(); t += 3)
+    {
+      std::rotate(&triangles[t], &triangles[t + 2], &triangles[t + 3]);
+    }
+    bool success = mesh.build_triangles(points, triangles);
+    assert(success);
+    (void)success;
+  }
+  else
+  {
+    mesh.clear();
+    Triangle_mesh_builder<Mesh> builder(points, triangles);
+    mesh.delegate(builder);
+  }
+}
+
+/**
+ * @brief      Copy a mesh to index arrays and label the connected components
+ *             of its vertices in the memory order of their first vertex.
+ */
+template <class Mesh>
+Mesh_components<typename Mesh::Traits::Point_3> find_components(Mesh& mesh)
+{
+  Mesh_info<Mesh> mesh_info;
+  Mesh_info_operations<Mesh> mesh_ops {&mesh_info};
+  Mesh_components<typename Mesh::Traits::Point_3> found;
+
+  int num_vertices = 0;
+  found.points.reserve(mesh.size_of_vertices());
+  for (auto v = mesh.vertices_begin(); v != mesh.vertices_end(); ++v)
+  {
+    mesh_ops.set_vertex_id(v, num_vertices++);
+    found.points.push_back(v->point());
+  }
+  found.triangles.reserve(3 * mesh.size_of_facets());
+  for (auto f = mesh.facets_begin(); f != mesh.facets_end(); ++f)
+  {
+    auto h = f->facet_begin();
+    found.triangles.push_back(mesh_ops.get_vertex_id(h->vertex()));
+    found.triangles.push_back(mesh_ops.get_vertex_id(h->next()->vertex()));
+    found.triangles.push_back(mesh_ops.get_vertex_id(h->next()->next()->vertex()));
+  }
+
+  // Union-find over the facets, with path halving.
+  std::vector<int> root(num_vertices);
+  std::iota(root.begin(), root.end(), 0);
+  auto find = [&root](int v)
+              {
+                while (root[v] != v)
+                {
+                  root[v] = root[root[v]];
+                  v = root[v];
+                }
+                return v;
+              };
+  for (std::size_t t = 0; t < found.triangles.size(); t += 3)
+  {
+    int r0 = find(found.triangles[t]);
+    for (int i = 1; i < 3; ++i)
+    {
+      int r = find(found.triangles[t + i]);
+      if (r != r0)
+      {
+        root[std::max(r, r0)] = std::min(r, r0);
+        r0 = std::min(r, r0);
+      }
+    }
+  }
+
+  // The roots are the lowest vertices of the components, so numbering them in
+  // vertex order numbers the components by their first vertex.
+  found.component.resize(num_vertices);
+  for (int v = 0; v < num_vertices; ++v)
+  {
+    int r = find(v);
+    found.component[v] = (r == v) ? found.num_components++ : found.component[r];
+  }
+  return found;
+}
+
+/**
+ * @brief      Build the meshes of the components found by find_components.
+ */
+template <class Mesh>
+void build_components(const Mesh_components<typename Mesh::Traits::Point_3>& found,
+                      std::vector<Mesh>& components,
+                      int num_threads)
+{
+  using Point_3 = typename Mesh::Traits::Point_3;
+  const int num_components = found.num_components;
+  const int num_vertices = found.points.size();
+
+  // The index of every vertex in its component.
+  std::vector<std::vector<Point_3>> points(num_components);
+  std::vector<int> local(num_vertices);
+  for (int v = 0; v < num_vertices; ++v)
+  {
+    std::vector<Point_3>& component_points = points[found.component[v]];
+    local[v] = component_points.size();
+    component_points.push_back(found.points[v]);
+  }
+  std::vector<std::vector<int>> triangles(num_components);
+  for (int corner : found.triangles)
+  {
+    // The corners of a facet share a component.
+    triangles[found.component[corner]].push_back(local[corner]);
+  }
+
+  components.clear();
+  components.resize(num_components);
+  parallel_for_each_index(num_components, num_threads,
+                          [&](int i)
+                          {
+                            build_triangle_mesh(components[i], points[i],
+                                                triangles[i]);
+                          });
+}
+}  // namespace ptq_impl
+
+/**
+ * @brief      Split a mesh into its connected components, numbered in the
+ *             memory order of their first vertex. A vertex without facets is
+ *             a component of its own.
+ *
+ * @param      mesh         The mesh, which is left unchanged
+ * @param      components   The components
+ * @param[in]  num_threads  The number of threads building the components, a
+ *                          value less than 1 uses all hardware threads.
+ *
+ * @return     The number of components.
+ */
+template <class Mesh>
+int split_components(Mesh& mesh, std::vector<Mesh>& components,
+                     int num_threads = 1)
+{
+  auto found = ptq_impl::find_components(mesh);
+  ptq_impl::build_components(found, components,
+                             ptq_impl::get_num_threads(num_threads));
+  return found.num_components;
+}
+
+/**
+ * @brief      Replace a mesh by the components laid out one after another,
+ *             which invalidates every handle of the mesh.
+ *
+ * @param      components  The components
+ * @param      mesh        The merged mesh
+ */
+template <class Mesh>
+void merge_components(std::vector<Mesh>& components, Mesh& mesh)
+{
+  std::vector<typename Mesh::Traits::Point_3> points;
+  std::vector<int> triangles;
+  for (Mesh& component : components)
+  {
+    ptq_impl::Mesh_info<Mesh> mesh_info;
+    ptq_impl::Mesh_info_operations<Mesh> mesh_ops {&mesh_info};
+    std::size_t offset = points.size();
+    for (auto v = component.vertices_begin(); v != component.vertices_end(); ++v)
+    {
+      mesh_ops.set_vertex_id(v, points.size());
+      points.push_back(v->point());
+    }
+    for (auto f = component.facets_begin(); f != component.facets_end(); ++f)
+    {
+      auto h = f->facet_begin();
+      triangles.push_back(mesh_ops.get_vertex_id(h->vertex()));
+      triangles.push_back(mesh_ops.get_vertex_id(h->next()->vertex()));
+      triangles.push_back(mesh_ops.get_vertex_id(h->next()->next()->vertex()));
+    }
+    assert(offset + component.size_of_vertices() == points.size());
+    (void)offset;
+  }
+  ptq_impl::build_triangle_mesh(mesh, points, triangles);
+}
+
+/**
+ * @brief      The forward wavelet transform of every connected component of a
+ *             mesh. The components are transformed concurrently, each on one
+ *             thread, and merged back into the mesh, which invalidates its
+ *             handles. A connected mesh is transformed in place with all the
+ *             threads.
+ *
+ * @param      mesh         The mesh
+ * @param      coefs        The coefficients of the components, in the order of
+ *                          split_components
+ * @param[in]  num_threads  The number of threads, a value less than 1 uses
+ *                          all hardware threads.
+ * @param[in]  analyze      The transform of a component,
+ *                          analyze(component, coefs, num_threads), returning
+ *                          its number of levels, 0 if it is left unchanged.
+ *
+ * @return     The largest number of levels of a component, 0 if every
+ *             component is left unchanged.
+ */
+template <class Mesh, class Analyze>
+int analyze_components(
+  Mesh& mesh,
+  std::vector<Component_coefficients<typename Mesh::Traits::Vector_3>>& coefs,
+  int num_threads,
+  Analyze analyze)
+{
+  num_threads = ptq_impl::get_num_threads(num_threads);
+  auto found = ptq_impl::find_components(mesh);
+  coefs.clear();
+  coefs.resize(found.num_components);
+  if (found.num_components == 1)
+  {
+    coefs[0].num_levels = analyze(mesh, coefs[0].coefs, num_threads);
+    return coefs[0].num_levels;
+  }
+
+  std::vector<Mesh> components;
+  ptq_impl::build_components(found, components, num_threads);
+  ptq_impl::parallel_for_each_index(
+    found.num_components, num_threads,
+    [&](int i)
+    {
+      if (components[i].size_of_facets() > 0)
+      {
+        coefs[i].num_levels = analyze(components[i], coefs[i].coefs, 1);
+      }
+    });
+
+  int num_levels = 0;
+  for (const auto& c : coefs)
+  {
+    num_levels = std::max(num_levels, c.num_levels);
+  }
+  if (num_levels > 0)
+  {
+    merge_components(components, mesh);
+  }
+  return num_levels;
+}
+
+/**
+ * @brief      The inverse wavelet transform of every connected component of a
+ *             coarse mesh, see analyze_components.
+ *
+ * @param      mesh         The coarse mesh
+ * @param[in]  coefs        The coefficients of the components, which must
+ *                          match the components of the mesh
+ * @param[in]  num_threads  The number of threads, a value less than 1 uses
+ *                          all hardware threads.
+ * @param[in]  synthesize   The transform of a component,
+ *                          synthesize(component, coefs, num_levels,
+ *                          num_threads), called for the components of at
+ *                          least one level.
+ */
+template <class Mesh, class Synthesize>
+void synthesize_components(
+  Mesh& mesh,
+  const std::vector<Component_coefficients<typename Mesh::Traits::Vector_3>>& coefs,
+  int num_threads,
+  Synthesize synthesize)
+{
+  num_threads = ptq_impl::get_num_threads(num_threads);
+  auto found = ptq_impl::find_components(mesh);
+  assert(found.num_components == static_cast<int>(coefs.size()));
+  if (found.num_components == 1)
+  {
+    if (coefs[0].num_levels > 0)
+    {
+      synthesize(mesh, coefs[0].coefs, coefs[0].num_levels, num_threads);
+    }
+    return;
+  }
+
+  std::vector<Mesh> components;
+  ptq_impl::build_components(found, components, num_threads);
+  ptq_impl::parallel_for_each_index(
+    found.num_components, num_threads,
+    [&](int i)
+    {
+      if (coefs[i].num_levels > 0)
+      {
+        synthesize(components[i], coefs[i].coefs, coefs[i].num_levels, 1);
+      }
+    });
+  merge_components(components, mesh);
+}
+}  // namespace wtlib
+
+#endif  // define WTLIB_MESH_COMPONENTS_HPP
@@ -4,6 +4,9 @@
 /**
  * @file     mesh_types.hpp
  * @brief    Defines a custom mesh instantiation.
+ *
+ * The coordinates are double precision by default, define WTLIB_USE_FLOAT to
+ * use single precision instead.
  */
 
 #include <CGAL/Simple_cartesian.h>
@@ -16,6 +19,12 @@
 #include <CGAL/Polyhedron_items_3.h>
 #endif
 
+#if defined (WTLIB_USE_FLOAT)
+using MeshKernel = CGAL::Simple_cartesian<float>;
+#else
+using MeshKernel = CGAL::Simple_cartesian<double>;
+#endif
+
 #if defined (WTLIB_USE_CUSTOM_MESH)
 template <class Refs, class P>
 class MeshVertex: public CGAL::HalfedgeDS_vertex_base<Refs, CGAL::Tag_true, P>
@@ -43,9 +52,9 @@ struct MeshItems: public CGAL::Polyhedron_items_3 {
   };
 };
 
-using Mesh = CGAL::Polyhedron_3<CGAL::Simple_cartesian<double>, MeshItems>;
+using Mesh = CGAL::Polyhedron_3<MeshKernel, MeshItems>;
 #else
-using Mesh = CGAL::Polyhedron_3<CGAL::Simple_cartesian<double>>;
+using Mesh = CGAL::Polyhedron_3<MeshKernel>;
 #endif
 
 #endif
\ No newline at end of file
@@ -9,16 +9,15 @@
  */
 
 
+#include <wtlib/ptq_impl/gather_table.hpp>
+#include <wtlib/ptq_impl/parallel_for.hpp>
 #include <wtlib/ptq_impl/subdivision_modifier.hpp>
 
 #include <CGAL/Origin.h>
 
+#include <algorithm>
+#include <cassert>
 #include <vector>
-#if defined (WTLIB_USE_UNORDERED_MAP)
-#include <unordered_map>
-#else
-#include <map>
-#endif  // if defined WTLIB_USE_UNORDERED_MAP
 
 namespace wtlib::ptq_impl
 {
@@ -26,6 +25,7 @@ template <class Mesh, class Mesh_ops, bool analysis>
 class Butterfly_lift_operations
 {
 public:
+  using FT = typename Mesh::Traits::FT;
   using Point3 = typename Mesh::Traits::Point_3;
   using Vec3 = typename Mesh::Traits::Vector_3;
   using Vertex_handle = typename Mesh::Vertex_handle;
@@ -34,12 +34,6 @@ public:
   using Modifier = PTQ_subdivision_modifier<Mesh, Mesh_ops>;
   using Halfedge_pair = typename Modifier::Halfedge_pair;
 
-#if defined (WTLIB_USE_UNORDERED_MAP)
-  using Vertex_scale = std::unordered_map<Vertex_handle, double>;
-#else
-  using Vertex_scale = std::map<Vertex_handle, double>;
-#endif
-
   Butterfly_lift_operations():max_level_(-1) {}
 
   static int get_num_types(Mesh& mesh, const Mesh_ops& mesh_ops)
@@ -99,11 +93,18 @@ public:
    * @param[in]  m_ops        Mesh operations
    * @param      edges_start  Start of edge vertices
    * @param      edges_end    End of edge vertices
+   * @param[in]  num_threads  The number of threads
+   * @param[in]  parents      The halfedges from the edge vertices to their
+   *                          old vertices by position in the band (see
+   *                          Modifier::get_halfedges_to_old_vertices), found
+   *                          per edge vertex if null.
    */
   void update_scale(Mesh& mesh,
                     const Mesh_ops& m_ops,
                     Vertex_handle* edges_start,
-                    Vertex_handle* edges_end);
+                    Vertex_handle* edges_end,
+                    int num_threads = 1,
+                    const Halfedge_pair* parents = nullptr);
 
   /**
    * @brief      Lifting: using old vertices to modify edge vertices
@@ -112,11 +113,18 @@ public:
    * @param[in]  m_ops        The mesh operations
    * @param      edges_start  Start of edge vertices
    * @param      edges_end    End of edge vertices
+   * @param[in]  num_threads  The number of threads
+   * @param[in]  parents      The halfedges from the edge vertices to their
+   *                          old vertices by position in the band (see
+   *                          Modifier::get_halfedges_to_old_vertices), found
+   *                          per edge vertex if null.
    */
   void olds_to_edges(Mesh& mesh,
                      const Mesh_ops& m_ops,
                      Vertex_handle* edges_start,
-                     Vertex_handle* edges_end) const;
+                     Vertex_handle* edges_end,
+                     int num_threads = 1,
+                     const Halfedge_pair* parents = nullptr) const;
 
   /**
    * @brief      Lifting: using edge vertices to modify old vertices
@@ -125,28 +133,40 @@ public:
    * @param[in]  m_ops        The mesh operations
    * @param      edges_start  Start of edge vertices
    * @param      edges_end    End of edge vertices
+   * @param[in]  num_threads  The number of threads, with more than one
+   *                          thread every old vertex gathers the updates of
+   *                          its edge vertices.
+   * @param[in]  parents      The halfedges from the edge vertices to their
+   *                          old vertices by position in the band (see
+   *                          Modifier::get_halfedges_to_old_vertices), found
+   *                          per edge vertex if null.
    */
   void edges_to_olds(Mesh& mesh,
                      const Mesh_ops& m_ops,
                      Vertex_handle* edges_start,
-                     Vertex_handle* edges_end) const;
+                     Vertex_handle* edges_end,
+                     int num_threads = 1,
+                     const Halfedge_pair* parents = nullptr) const;
 
   /**
    * @brief      Set the scale for vertex
    *
-   * @param[in]  v     The target vertex
-   * @param[in]  s     scale
+   * @param[in]  v      The target vertex
+   * @param[in]  s      scale
+   * @param[in]  m_ops  The mesh operation
    */
-  void set_vertex_scale(Vertex_handle v, double s);
+  void set_vertex_scale(Vertex_handle v, FT s, const Mesh_ops& m_ops);
 
   /**
    * @brief      Read the scale for given vertex
    *
-   * @param[in]  v     The target vertex
+   * @param[in]  v      The target vertex, its scale should have been set by
+   *                    init_scale, set_vertex_scale or update_scale
+   * @param[in]  m_ops  The mesh operation
    *
    * @return     The vertex scale.
    */
-  double get_vertex_scale(Vertex_handle v) const;
+  FT get_vertex_scale(Vertex_handle v, const Mesh_ops& m_ops) const;
 
   /**
    * @brief      Calculate scale ratio used in lift edges to olds
@@ -157,17 +177,30 @@ public:
    *
    * @return     The scale ratio.
    */
-  double get_scale_ratio(Vertex_handle old,
+  FT get_scale_ratio(Vertex_handle old,
                          Vertex_handle edge,
                          const Mesh_ops& m_ops) const; 
 
-  void init_scale(Vertex_handle* head,
+  /**
+   * @brief      Reset the scales, the vertices in [head, end) start from 1 and
+   *             the other vertices from 0.
+   *
+   * @param[in]  m_ops  The mesh operation, the vertex ids should be distinct
+   *                    non-negative integers (e.g., after the classification)
+   * @param      head   Start of the vertices
+   * @param      edge   Start of the finest edge vertices
+   * @param      end    End of the vertices
+   */
+  void init_scale(const Mesh_ops& m_ops,
+                  Vertex_handle* head,
                   Vertex_handle* edge,
                   Vertex_handle* end)
   {
+    // Keep the storage of the previous transform.
+    scales_.clear();
     for (Vertex_handle* p = head; p != end; ++p)
     {
-      scales_.insert({*p, 1.0});
+      scale_at(m_ops.get_vertex_id(*p)) = 1.0;
     }
   }
 
@@ -179,7 +212,19 @@ public:
   }
 
 protected:
-  Vertex_scale scales_;
+  // The scale of a vertex, grown with 0 up to the given vertex id.
+  FT& scale_at(int id)
+  {
+    assert(id >= 0);
+    if (id >= static_cast<int>(scales_.size()))
+    {
+      scales_.resize(id + 1, FT(0));
+    }
+    return scales_[id];
+  }
+
+  // The scales indexed by vertex id.
+  std::vector<FT> scales_;
   int max_level_;
 };  // class Butterfly_lift_operations
 
@@ -196,7 +241,8 @@ public:
   void lift(Mesh& mesh,
             const Mesh_ops& mesh_ops,
             Vertex_handle** first_band,
-            Vertex_handle** last_band)
+            Vertex_handle** last_band,
+            int num_threads = 1)
   {
     assert(this->max_level_ >= 0);
     assert(last_band - first_band == 2);
@@ -206,22 +252,34 @@ public:
 
     assert(last_band - first_band == 1);
 
+    // Both steps start from the halfedges to the old vertices.
+    std::vector<typename Base::Halfedge_pair> parents;
+    Base::Modifier::get_halfedges_to_old_vertices(edge_start,
+                                                  edge_end,
+                                                  mesh_ops,
+                                                  parents,
+                                                  num_threads);
+
     this->olds_to_edges(mesh,
                         mesh_ops,
                         edge_start,
-                        edge_end);
+                        edge_end,
+                        num_threads,
+                        parents.data());
 
     this->edges_to_olds(mesh,
                         mesh_ops,
                         edge_start,
-                        edge_end);
+                        edge_end,
+                        num_threads,
+                        parents.data());
 
   }
 
   void initialize(Mesh &mesh,
                   const Mesh_ops &mesh_ops)
   {
-    this->scales_.clear(); 
+    this->scales_.clear();
     this->max_level_ = -1;
 
     assert(mesh.is_closed());
@@ -251,7 +309,8 @@ public:
   void lift(Mesh& mesh,
             const Mesh_ops& m_ops,
             Vertex_handle** first_band,
-            Vertex_handle** last_band)
+            Vertex_handle** last_band,
+            int num_threads = 1)
   {
     assert(this->max_level_ >= 0);
     assert(last_band - first_band == 2);
@@ -261,15 +320,27 @@ public:
 
     assert(last_band - first_band == 1);
 
+    // Both steps start from the halfedges to the old vertices.
+    std::vector<typename Base::Halfedge_pair> parents;
+    Base::Modifier::get_halfedges_to_old_vertices(edge_start,
+                                                  edge_end,
+                                                  m_ops,
+                                                  parents,
+                                                  num_threads);
+
     this->edges_to_olds(mesh,
                         m_ops,
                         edge_start,
-                        edge_end);
+                        edge_end,
+                        num_threads,
+                        parents.data());
 
     this->olds_to_edges(mesh,
                         m_ops,
                         edge_start,
-                        edge_end);
+                        edge_end,
+                        num_threads,
+                        parents.data());
 
   }
 
@@ -320,21 +391,27 @@ Butterfly_lift_operations<Mesh, Mesh_ops, analysis>::get_vertex_C1(Halfedge_hand
 template <class Mesh, class Mesh_ops, bool analysis>
 void Butterfly_lift_operations<Mesh, Mesh_ops, analysis>::set_vertex_scale(
                                                   Vertex_handle v,
-                                                  double s)
+                                                  FT s,
+                                                  const Mesh_ops& m_ops)
 {
-  scales_[v] = s;
+  scale_at(m_ops.get_vertex_id(v)) = s;
 }
 
 
 template <class Mesh, class Mesh_ops, bool analysis>
-double Butterfly_lift_operations<Mesh, Mesh_ops, analysis>::get_vertex_scale(
-                                                  Vertex_handle v) const
+typename Butterfly_lift_operations<Mesh, Mesh_ops, analysis>::FT
+Butterfly_lift_operations<Mesh, Mesh_ops, analysis>::get_vertex_scale(
+                                                  Vertex_handle v,
+                                                  const Mesh_ops& m_ops) const
 {
-  return scales_.at(v);
+  int id = m_ops.get_vertex_id(v);
+  assert(id >= 0 && id < static_cast<int>(scales_.size()));
+  return scales_[id];
 }
 
 template <class Mesh, class Mesh_ops, bool analysis>
-double Butterfly_lift_operations<Mesh, Mesh_ops, analysis>::get_scale_ratio(
+typename Butterfly_lift_operations<Mesh, Mesh_ops, analysis>::FT
+Butterfly_lift_operations<Mesh, Mesh_ops, analysis>::get_scale_ratio(
                                                   Vertex_handle old,
                                                   Vertex_handle edge,
                                                   const Mesh_ops& m_ops) const
@@ -343,7 +420,7 @@ double Butterfly_lift_operations<Mesh, Mesh_ops, analysis>::get_scale_ratio(
    * For closed mesh, vertex scale is related only to its valence and the
    * current processing level, so the vertex scale can be calculated directly.
    */
-  double no = static_cast<double>(old->degree());
+  FT no = static_cast<FT>(old->degree());
 
   assert(this->max_level_ >= 0);
 
@@ -351,10 +428,10 @@ double Butterfly_lift_operations<Mesh, Mesh_ops, analysis>::get_scale_ratio(
   assert(level > 0);
   int l = max_level_ - level;
   assert(l >= 0);
-  double edge_integral = std::pow(4.0, l);
-  double old_integral = (std::pow(4.0, l + 1) - 1) / 6.0 * no + 1.0;
+  FT edge_integral = std::pow(FT(4), l);
+  FT old_integral = (std::pow(FT(4), l + 1) - 1) / FT(6) * no + FT(1);
   
-  return edge_integral / (2.0 * old_integral);
+  return edge_integral / (FT(2) * old_integral);
 }
 
 
@@ -363,13 +440,78 @@ void Butterfly_lift_operations<Mesh, Mesh_ops, analysis>::update_scale(
                                                   Mesh &mesh,
                                                   const Mesh_ops &m_ops,
                                                   Vertex_handle *edges_start,
-                                                  Vertex_handle *edges_end)
+                                                  Vertex_handle *edges_end,
+                                                  int num_threads,
+                                                  const Halfedge_pair* parents)
 {
+  if (num_threads > 1)
+  {
+    // Each old vertex gathers the scales of its edge vertices, the same
+    // updates in the same order as the scatter form below.
+    Gather_table<Vertex_handle, 8, FT> table;
+    table.build(m_ops,
+                edges_start,
+                edges_end,
+                num_threads,
+                [&m_ops, parents](Vertex_handle e,
+                                  int i,
+                                  std::array<Vertex_handle, 8>& olds,
+                                  std::array<FT, 8>& weights)
+                {
+                  Halfedge_pair hps {parents ?
+                                     parents[i] :
+                                     Modifier::get_halfedges_to_old_vertices(e, m_ops)};
+                  olds = {hps.first->vertex(),
+                          hps.second->vertex(),
+                          get_vertex_B(hps.first),
+                          get_vertex_B(hps.second),
+                          get_vertex_C0(hps.first),
+                          get_vertex_C1(hps.first),
+                          get_vertex_C0(hps.second),
+                          get_vertex_C1(hps.second)};
+                  weights = {0.5, 0.5, 0.125, 0.125,
+                             -0.0625, -0.0625, -0.0625, -0.0625};
+                  return true;
+                });
+
+    // Read the edge scales before the old scales change, and grow the
+    // scales to the largest old id, so they are only indexed concurrently.
+    std::vector<FT> edge_scales;
+    edge_scales.reserve(edges_end - edges_start);
+    for (Vertex_handle *p = edges_start; p != edges_end; ++p)
+    {
+      edge_scales.push_back(get_vertex_scale(*p, m_ops));
+    }
+    int max_id = -1;
+    table.gather(1,
+                 [&m_ops, &max_id](Vertex_handle o, int first, int last)
+                 {
+                   max_id = std::max(max_id, m_ops.get_vertex_id(o));
+                 });
+    if (max_id >= 0)
+    {
+      scale_at(max_id);
+    }
+
+    table.gather(num_threads,
+                 [&](Vertex_handle o, int first, int last)
+                 {
+                   FT& so = scales_[m_ops.get_vertex_id(o)];
+                   for (int c = first; c < last; ++c)
+                   {
+                     so += table.weight(c) * edge_scales[table.edge(c)];
+                   }
+                 });
+    return;
+  }
+
   for (Vertex_handle *p = edges_start; p != edges_end; ++p)
   {
     Vertex_handle e = *p;
-    double se = scales_.at(e);
-    Halfedge_pair hps {Modifier::get_halfedges_to_old_vertices(e, m_ops)};
+    FT se = get_vertex_scale(e, m_ops);
+    Halfedge_pair hps {parents ?
+                       parents[p - edges_start] :
+                       Modifier::get_halfedges_to_old_vertices(e, m_ops)};
 
     Vertex_handle a0 = hps.first->vertex();
     Vertex_handle a1 = hps.second->vertex();
@@ -391,14 +533,14 @@ void Butterfly_lift_operations<Mesh, Mesh_ops, analysis>::update_scale(
     assert(m_ops.get_vertex_level(e) > m_ops.get_vertex_level(c2));
     assert(m_ops.get_vertex_level(e) > m_ops.get_vertex_level(c3));
 
-    scales_[a0] += 0.5 * se;
-    scales_[a1] += 0.5 * se;
-    scales_[b0] += 0.125 * se;
-    scales_[b1] += 0.125 * se;
-    scales_[c0] -= 0.0625 * se;
-    scales_[c1] -= 0.0625 * se;
-    scales_[c2] -= 0.0625 * se;
-    scales_[c3] -= 0.0625 * se;
+    scale_at(m_ops.get_vertex_id(a0)) += 0.5 * se;
+    scale_at(m_ops.get_vertex_id(a1)) += 0.5 * se;
+    scale_at(m_ops.get_vertex_id(b0)) += 0.125 * se;
+    scale_at(m_ops.get_vertex_id(b1)) += 0.125 * se;
+    scale_at(m_ops.get_vertex_id(c0)) -= 0.0625 * se;
+    scale_at(m_ops.get_vertex_id(c1)) -= 0.0625 * se;
+    scale_at(m_ops.get_vertex_id(c2)) -= 0.0625 * se;
+    scale_at(m_ops.get_vertex_id(c3)) -= 0.0625 * se;
   }
 }
 
@@ -407,57 +549,67 @@ void Butterfly_lift_operations<Mesh, Mesh_ops, analysis>::olds_to_edges(
                                                   Mesh &mesh,
                                                   const Mesh_ops &m_ops,
                                                   Vertex_handle *edges_start,
-                                                  Vertex_handle *edges_end) const
+                                                  Vertex_handle *edges_end,
+                                                  int num_threads,
+                                                  const Halfedge_pair* parents) const
 {
-  for (Vertex_handle* p = edges_start; p != edges_end; ++p)
+  // Each edge vertex only reads old vertices.
+  parallel_for(edges_start, edges_end, num_threads,
+               [&m_ops, edges_start, parents](Vertex_handle* first,
+                                              Vertex_handle* last)
   {
-    Vertex_handle e = *p;
-    assert(!m_ops.get_vertex_border(e) && "Open mesh is not supported");
-
-    Halfedge_pair hps {Modifier::get_halfedges_to_old_vertices(e, m_ops)};
-    Vertex_handle a0 = hps.first->vertex();
-    Vertex_handle a1 = hps.second->vertex();
-    Vertex_handle b0 = get_vertex_B(hps.first);
-    Vertex_handle b1 = get_vertex_B(hps.second);
-    Vertex_handle c0 = get_vertex_C0(hps.first);
-    Vertex_handle c1 = get_vertex_C1(hps.first);
-    Vertex_handle c2 = get_vertex_C0(hps.second);
-    Vertex_handle c3 = get_vertex_C1(hps.second);
-
-    assert(!m_ops.get_vertex_border(a0) && "Open mesh is not supported");
-    assert(!m_ops.get_vertex_border(a1) && "Open mesh is not supported");
-    assert(!m_ops.get_vertex_border(b0) && "Open mesh is not supported");
-    assert(!m_ops.get_vertex_border(b1) && "Open mesh is not supported");
-    assert(!m_ops.get_vertex_border(c0) && "Open mesh is not supported");
-    assert(!m_ops.get_vertex_border(c1) && "Open mesh is not supported");
-    assert(!m_ops.get_vertex_border(c2) && "Open mesh is not supported");
-    assert(!m_ops.get_vertex_border(c3) && "Open mesh is not supported");
-
-    Vec3 ve  {CGAL::ORIGIN,  e->point()};
-    Vec3 va0 {CGAL::ORIGIN, a0->point()};
-    Vec3 va1 {CGAL::ORIGIN, a1->point()};
-    Vec3 vb0 {CGAL::ORIGIN, b0->point()};
-    Vec3 vb1 {CGAL::ORIGIN, b1->point()};
-    Vec3 vc0 {CGAL::ORIGIN, c0->point()};
-    Vec3 vc1 {CGAL::ORIGIN, c1->point()};
-    Vec3 vc2 {CGAL::ORIGIN, c2->point()};
-    Vec3 vc3 {CGAL::ORIGIN, c3->point()};
-
-    if (analysis)
+    for (Vertex_handle* p = first; p != last; ++p)
     {
-      ve = ve - 0.5 * (va0 + va1)
-              - 0.125 * (vb0 + vb1)
-              + 0.0625 * (vc0 + vc1 + vc2 + vc3);
-    }
-    else
-    {
-      ve = ve + 0.5 * (va0 + va1)
-              + 0.125 * (vb0 + vb1)
-              - 0.0625 * (vc0 + vc1 + vc2 + vc3);
+      Vertex_handle e = *p;
+      assert(!m_ops.get_vertex_border(e) && "Open mesh is not supported");
+
+      Halfedge_pair hps {parents ?
+                         parents[p - edges_start] :
+                         Modifier::get_halfedges_to_old_vertices(e, m_ops)};
+      Vertex_handle a0 = hps.first->vertex();
+      Vertex_handle a1 = hps.second->vertex();
+      Vertex_handle b0 = get_vertex_B(hps.first);
+      Vertex_handle b1 = get_vertex_B(hps.second);
+      Vertex_handle c0 = get_vertex_C0(hps.first);
+      Vertex_handle c1 = get_vertex_C1(hps.first);
+      Vertex_handle c2 = get_vertex_C0(hps.second);
+      Vertex_handle c3 = get_vertex_C1(hps.second);
+
+      assert(!m_ops.get_vertex_border(a0) && "Open mesh is not supported");
+      assert(!m_ops.get_vertex_border(a1) && "Open mesh is not supported");
+      assert(!m_ops.get_vertex_border(b0) && "Open mesh is not supported");
+      assert(!m_ops.get_vertex_border(b1) && "Open mesh is not supported");
+      assert(!m_ops.get_vertex_border(c0) && "Open mesh is not supported");
+      assert(!m_ops.get_vertex_border(c1) && "Open mesh is not supported");
+      assert(!m_ops.get_vertex_border(c2) && "Open mesh is not supported");
+      assert(!m_ops.get_vertex_border(c3) && "Open mesh is not supported");
+
+      Vec3 ve  {CGAL::ORIGIN,  e->point()};
+      Vec3 va0 {CGAL::ORIGIN, a0->point()};
+      Vec3 va1 {CGAL::ORIGIN, a1->point()};
+      Vec3 vb0 {CGAL::ORIGIN, b0->point()};
+      Vec3 vb1 {CGAL::ORIGIN, b1->point()};
+      Vec3 vc0 {CGAL::ORIGIN, c0->point()};
+      Vec3 vc1 {CGAL::ORIGIN, c1->point()};
+      Vec3 vc2 {CGAL::ORIGIN, c2->point()};
+      Vec3 vc3 {CGAL::ORIGIN, c3->point()};
+
+      if (analysis)
+      {
+        ve = ve - 0.5 * (va0 + va1)
+                - 0.125 * (vb0 + vb1)
+                + 0.0625 * (vc0 + vc1 + vc2 + vc3);
+      }
+      else
+      {
+        ve = ve + 0.5 * (va0 + va1)
+                + 0.125 * (vb0 + vb1)
+                - 0.0625 * (vc0 + vc1 + vc2 + vc3);
+      }
+      // Write result back to mesh vertex
+      e->point() = CGAL::ORIGIN + ve;
     }
-    // Write result back to mesh vertex
-    e->point() = CGAL::ORIGIN + ve;
-  }
+  });
 }
 
 
@@ -466,22 +618,71 @@ void Butterfly_lift_operations<Mesh, Mesh_ops, analysis>::edges_to_olds(
                                                   Mesh &mesh,
                                                   const Mesh_ops &m_ops,
                                                   Vertex_handle *edges_start,
-                                                  Vertex_handle *edges_end) const
+                                                  Vertex_handle *edges_end,
+                                                  int num_threads,
+                                                  const Halfedge_pair* parents) const
 {
+  if (num_threads > 1)
+  {
+    // Both old vertices of an edge vertex are shared with other edge
+    // vertices, so each old vertex gathers its updates instead.
+    Gather_table<Vertex_handle, 2, FT> table;
+    table.build(m_ops,
+                edges_start,
+                edges_end,
+                num_threads,
+                [&](Vertex_handle e,
+                    int i,
+                    std::array<Vertex_handle, 2>& olds,
+                    std::array<FT, 2>& ratios)
+                {
+                  Halfedge_pair hps {parents ?
+                                     parents[i] :
+                                     Modifier::get_halfedges_to_old_vertices(e, m_ops)};
+                  olds = {hps.first->vertex(), hps.second->vertex()};
+                  ratios = {get_scale_ratio(olds[0], e, m_ops),
+                            get_scale_ratio(olds[1], e, m_ops)};
+                  Gather_table<Vertex_handle, 2, FT>::keep_last_duplicate(olds);
+                  return true;
+                });
+
+    table.gather(num_threads,
+                 [&](Vertex_handle a, int first, int last)
+                 {
+                   Vec3 va {CGAL::ORIGIN, a->point()};
+                   for (int c = first; c < last; ++c)
+                   {
+                     Vec3 ve {CGAL::ORIGIN, edges_start[table.edge(c)]->point()};
+                     if (analysis)
+                     {
+                       va = va - table.weight(c) * ve;
+                     }
+                     else
+                     {
+                       va = va + table.weight(c) * ve;
+                     }
+                   }
+                   a->point() = CGAL::ORIGIN + va;
+                 });
+    return;
+  }
+
   for (Vertex_handle* p = edges_start; p != edges_end; ++p)
   {
     Vertex_handle e = *p;
     assert(!m_ops.get_vertex_border(e) && "Open mesh is not supported");
 
-    Halfedge_pair hps {Modifier::get_halfedges_to_old_vertices(e, m_ops)};
+    Halfedge_pair hps {parents ?
+                       parents[p - edges_start] :
+                       Modifier::get_halfedges_to_old_vertices(e, m_ops)};
     Vertex_handle a0 = hps.first->vertex();
     Vertex_handle a1 = hps.second->vertex();
 
     assert(!m_ops.get_vertex_border(a0) && "Open mesh is not supported");
     assert(!m_ops.get_vertex_border(a1) && "Open mesh is not supported");
 
-    double ra0 = get_scale_ratio(a0, e, m_ops);
-    double ra1 = get_scale_ratio(a1, e, m_ops);
+    FT ra0 = get_scale_ratio(a0, e, m_ops);
+    FT ra1 = get_scale_ratio(a1, e, m_ops);
 
     Vec3 ve  {CGAL::ORIGIN, e->point()};
     Vec3 va0 {CGAL::ORIGIN, a0->point()};
@@ -0,0 +1,147 @@
+#ifndef PTQ_IMPL_COUNTING_SORT_HPP
+#define PTQ_IMPL_COUNTING_SORT_HPP
+
+/**
+ * @file     counting_sort.hpp
+ * @brief    Defines the counting sort that orders vertices and edges by their
+ *           integer ids.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace wtlib::ptq_impl
+{
+/**
+ * @brief      Stably sort the items [first, last) by their keys into out with
+ *             a counting sort. A large range is counted and scattered in
+ *             chunks on several threads, every chunk keeps its own counts.
+ *
+ * @param[in]  key          Maps an item to its key in [0, bound)
+ * @param[in]  num_threads  The maximum number of threads
+ */
+template <class Key>
+void counting_sort(const int* first,
+                   const int* last,
+                   int bound,
+                   Key key,
+                   int* out,
+                   int num_threads)
+{
+  // Below this many items per thread, the counts of the chunks cost more
+  // than the threads save.
+  const std::ptrdiff_t min_chunk_size = 1 << 15;
+
+  std::ptrdiff_t size = last - first;
+  int num_chunks = static_cast<int>(std::max<std::ptrdiff_t>(
+                     std::min<std::ptrdiff_t>(num_threads,
+                                              size / min_chunk_size),
+                     1));
+  auto chunk = [first, size, num_chunks](int c)
+               {
+                 return std::make_pair(first + size * c / num_chunks,
+                                       first + size * (c + 1) / num_chunks);
+               };
+  auto run = [num_chunks](auto f)
+             {
+               std::vector<std::thread> threads;
+               threads.reserve(num_chunks - 1);
+               for (int c = 1; c < num_chunks; ++c)
+               {
+                 threads.emplace_back(f, c);
+               }
+               f(0);
+               for (std::thread& t : threads)
+               {
+                 t.join();
+               }
+             };
+
+  std::vector<std::vector<int>> offsets(num_chunks, std::vector<int>(bound, 0));
+  run([&](int c)
+      {
+        std::vector<int>& counts = offsets[c];
+        for (auto [it, end] = chunk(c); it != end; ++it)
+        {
+          ++counts[key(*it)];
+        }
+      });
+
+  // The items of a key are placed chunk after chunk.
+  int offset = 0;
+  for (int k = 0; k < bound; ++k)
+  {
+    for (int c = 0; c < num_chunks; ++c)
+    {
+      int count = offsets[c][k];
+      offsets[c][k] = offset;
+      offset += count;
+    }
+  }
+
+  run([&](int c)
+      {
+        std::vector<int>& next = offsets[c];
+        for (auto [it, end] = chunk(c); it != end; ++it)
+        {
+          out[next[key(*it)]++] = *it;
+        }
+      });
+}
+
+/**
+ * @brief      Sort the items 0, ..., size - 1 by their key pairs (low(i),
+ *             high(i)) into out, in the same order as a counting sort by high
+ *             followed by a counting sort by low. The items are counted and
+ *             scattered by low in their own order, so the keys are read
+ *             sequentially, and the few items sharing a low key (e.g., the
+ *             edges of a vertex) are then insertion sorted by high.
+ *
+ * @param[in]  low    Maps an item to its first key in [0, bound)
+ * @param[in]  high   Maps an item to its second key
+ */
+template <class Low, class High>
+void counting_sort_pairs(int size, int bound, Low low, High high, int* out)
+{
+  std::vector<int> offsets(bound + 1, 0);
+  for (int i = 0; i < size; ++i)
+  {
+    ++offsets[low(i) + 1];
+  }
+  for (int k = 0; k < bound; ++k)
+  {
+    offsets[k + 1] += offsets[k];
+  }
+
+  std::vector<int> highs(size);
+  std::vector<int> next(offsets.begin(), offsets.end() - 1);
+  for (int i = 0; i < size; ++i)
+  {
+    int j = next[low(i)]++;
+    out[j] = i;
+    highs[j] = high(i);
+  }
+
+  for (int k = 0; k < bound; ++k)
+  {
+    for (int j = offsets[k] + 1; j < offsets[k + 1]; ++j)
+    {
+      int item = out[j];
+      int key = highs[j];
+      int p = j;
+      for (; p > offsets[k] && highs[p - 1] > key; --p)
+      {
+        out[p] = out[p - 1];
+        highs[p] = highs[p - 1];
+      }
+      out[p] = item;
+      highs[p] = key;
+    }
+  }
+}
+}  // namespace wtlib::ptq_impl
+
+#endif  // define PTQ_IMPL_COUNTING_SORT_HPP
@@ -0,0 +1,204 @@
+#ifndef PTQ_IMPL_GATHER_TABLE_HPP
+#define PTQ_IMPL_GATHER_TABLE_HPP
+
+/**
+ * @file     gather_table.hpp
+ * @brief    Defines the table turning a scatter lifting step (each edge
+ *           vertex updates several old vertices) into a gather step (each
+ *           old vertex collects its updates), so that the old vertices can be
+ *           updated concurrently.
+ */
+
+#include <wtlib/ptq_impl/parallel_for.hpp>
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace wtlib::ptq_impl
+{
+/**
+ * @brief    The contributions of a band of edge vertices to their old
+ *           vertices, grouped by old vertex.
+ *
+ * The contributions of an old vertex are kept in the order of the edge
+ * vertices, so accumulating them reproduces the floating point operations of
+ * the serial scatter step exactly.
+ *
+ * @tparam   Vertex_handle  The vertex handle of the mesh.
+ * @tparam   N              The number of old vertices updated by an edge
+ *                          vertex.
+ * @tparam   FT             The scalar type of the weights.
+ */
+template <class Vertex_handle, std::size_t N, class FT = double>
+class Gather_table
+{
+public:
+  using Stencil = std::array<Vertex_handle, N>;
+  using Weights = std::array<FT, N>;
+
+  /**
+   * @brief      Build the table.
+   *
+   * @param[in]  m_ops        The mesh operations, the vertex ids should be
+   *                          distinct non-negative integers (e.g., after the
+   *                          classification or refinement).
+   * @param      edge_start   Start of edge vertices
+   * @param      edge_end     End of edge vertices
+   * @param[in]  num_threads  The number of threads
+   * @param[in]  get_stencil  Called as get_stencil(e, i, olds, weights) for
+   *                          the edge vertex e = edge_start[i], sets the old
+   *                          vertices updated by e and their weights, returns
+   *                          false if e does not take part in the step. A slot
+   *                          holding a default constructed handle is skipped.
+   *                          i indexes the per-band data of the caller (e.g.,
+   *                          the halfedges to the old vertices).
+   */
+  template <class Mesh_ops, class Get_stencil>
+  void build(const Mesh_ops& m_ops,
+             Vertex_handle* edge_start,
+             Vertex_handle* edge_end,
+             int num_threads,
+             Get_stencil get_stencil);
+
+  /**
+   * @brief      Call f(old, first, last) for every old vertex with at least
+   *             one contribution, where [first, last) are its contributions.
+   *             Different old vertices are processed concurrently.
+   */
+  template <class Function>
+  void gather(int num_threads, Function f) const;
+
+  /**
+   * @brief      The position of the edge vertex of a contribution in the band
+   *             of edge vertices.
+   */
+  int edge(int c) const
+  {
+    return contributions_[c] / static_cast<int>(N);
+  }
+
+  FT weight(int c) const
+  {
+    return weights_[edge(c)][contributions_[c] % N];
+  }
+
+  /**
+   * @brief      Skip the earlier slots naming the same old vertex as a later
+   *             slot. A lifting step reading all its old vertices before
+   *             writing them keeps only the last write of a repeated vertex.
+   */
+  static void keep_last_duplicate(Stencil& olds)
+  {
+    for (std::size_t k = 0; k < N; ++k)
+    {
+      for (std::size_t l = k + 1; l < N; ++l)
+      {
+        if (olds[l] == olds[k])
+        {
+          olds[k] = Vertex_handle {};
+          break;
+        }
+      }
+    }
+  }
+
+private:
+  std::vector<Stencil> stencils_;
+  std::vector<Weights> weights_;
+  // The old vertex of each id, and its range of contributions.
+  std::vector<Vertex_handle> olds_;
+  std::vector<int> offsets_;
+  // A contribution is N * edge + slot.
+  std::vector<int> contributions_;
+};  // class Gather_table
+
+
+template <class Vertex_handle, std::size_t N, class FT>
+template <class Mesh_ops, class Get_stencil>
+void Gather_table<Vertex_handle, N, FT>::build(const Mesh_ops& m_ops,
+                                           Vertex_handle* edge_start,
+                                           Vertex_handle* edge_end,
+                                           int num_threads,
+                                           Get_stencil get_stencil)
+{
+  const int num_edges = edge_end - edge_start;
+
+  // The stencils of the edge vertices are independent of each other.
+  stencils_.assign(num_edges, Stencil {});
+  weights_.assign(num_edges, Weights {});
+  parallel_for(0, num_edges, num_threads,
+               [&](int first, int last)
+               {
+                 for (int i = first; i < last; ++i)
+                 {
+                   if (!get_stencil(edge_start[i], i, stencils_[i], weights_[i]))
+                   {
+                     stencils_[i].fill(Vertex_handle {});
+                   }
+                 }
+               });
+
+  // Count the contributions of each old vertex, indexed by its id.
+  olds_.clear();
+  offsets_.assign(1, 0);
+  for (const Stencil& olds : stencils_)
+  {
+    for (const Vertex_handle& vo : olds)
+    {
+      if (vo != Vertex_handle {})
+      {
+        int j = m_ops.get_vertex_id(vo);
+        assert(j >= 0);
+        if (j >= static_cast<int>(olds_.size()))
+        {
+          olds_.resize(j + 1);
+          offsets_.resize(j + 2, 0);
+        }
+        assert(olds_[j] == Vertex_handle {} || olds_[j] == vo);
+        olds_[j] = vo;
+        ++offsets_[j + 1];
+      }
+    }
+  }
+  for (std::size_t j = 0; j < olds_.size(); ++j)
+  {
+    offsets_[j + 1] += offsets_[j];
+  }
+
+  // Fill the contributions in the order of the edge vertices.
+  contributions_.resize(offsets_.back());
+  std::vector<int> fill(offsets_.begin(), offsets_.end() - 1);
+  for (int i = 0; i < num_edges; ++i)
+  {
+    for (std::size_t k = 0; k < N; ++k)
+    {
+      const Vertex_handle& vo = stencils_[i][k];
+      if (vo != Vertex_handle {})
+      {
+        contributions_[fill[m_ops.get_vertex_id(vo)]++] = N * i + k;
+      }
+    }
+  }
+}
+
+template <class Vertex_handle, std::size_t N, class FT>
+template <class Function>
+void Gather_table<Vertex_handle, N, FT>::gather(int num_threads, Function f) const
+{
+  parallel_for(0, static_cast<int>(olds_.size()), num_threads,
+               [&](int first, int last)
+               {
+                 for (int j = first; j < last; ++j)
+                 {
+                   if (offsets_[j] != offsets_[j + 1])
+                   {
+                     f(olds_[j], offsets_[j], offsets_[j + 1]);
+                   }
+                 }
+               });
+}
+}  // namespace wtlib::ptq_impl
+
+#endif  // define PTQ_IMPL_GATHER_TABLE_HPP
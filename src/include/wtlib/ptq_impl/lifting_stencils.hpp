@@ -0,0 +1,475 @@
+#ifndef PTQ_IMPL_LIFTING_STENCILS_HPP
+#define PTQ_IMPL_LIFTING_STENCILS_HPP
+
+/**
+ * @file     lifting_stencils.hpp
+ * @brief    Defines the flattened lifting stencils of one transform level.
+ *
+ * A stencil records, for one lifting step, the ids of the vertices it reads
+ * and writes together with its weights. The ids are the positions of the
+ * vertices in the array sorted by PTQ_classify_vertices, so that a level can
+ * be lifted on plain value arrays without walking the mesh. The kernels
+ * of simd_lifting_kernels.hpp apply the stencils with exactly the same
+ * arithmetic, in the same order, as the lifting steps in
+ * loop_wavelet_operations.hpp or butterfly_wavelet_operations.hpp.
+ */
+
+#include <wtlib/ptq_impl/butterfly_wavelet_operations.hpp>
+#include <wtlib/ptq_impl/loop_math_utils.hpp>
+#include <wtlib/ptq_impl/loop_wavelet_operations.hpp>
+#include <wtlib/ptq_impl/simd_lifting_kernels.hpp>
+#include <wtlib/ptq_impl/subdivision_modifier.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <vector>
+
+namespace wtlib::ptq_impl
+{
+inline std::atomic<int>& lifting_tile_size_selection()
+{
+  // The x, y and z values of 4096 vertices take 96 KiB, which leaves room in
+  // a typical L2 cache for the stencils of the tile.
+  static std::atomic<int> size {4096};
+  return size;
+}
+
+/**
+ * @brief      The number of vertex ids per tile of the Loop stencils built
+ *             afterwards.
+ */
+inline int lifting_tile_size()
+{
+  return lifting_tile_size_selection().load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief      Set the number of vertex ids per tile of the Loop stencils
+ *             built afterwards (e.g., a small size to validate the tiling on
+ *             small meshes). The tiling does not change the results.
+ *
+ * @param[in]  size  The number of vertex ids, at least one.
+ */
+inline void set_lifting_tile_size(int size)
+{
+  assert(size > 0);
+  lifting_tile_size_selection().store(size, std::memory_order_relaxed);
+}
+
+/**
+ * @brief    The lifting stencils of one level of the Loop wavelet transform.
+ *
+ * The six lifting steps are applied in three sweeps, each running the two
+ * steps that write disjoint vertices and read none of the vertices written
+ * by the other: the border and inner edges to olds steps, the border and
+ * inner olds to edges steps, then the two dual steps. A sweep goes through
+ * the vertex ids in tiles (see lifting_tile_size), running both steps on the
+ * vertices written in a tile before moving to the next one, so the values of
+ * a tile are read from memory once per sweep instead of once per step.
+ * Every vertex is updated with the same operations, in the same order, as in
+ * the six separate steps.
+ *
+ * @tparam   Vec3  The vector type of the coordinates.
+ */
+template <class Vec3>
+class Loop_stencils
+{
+public:
+  using FT = typename Vec3::FT;
+  using Channels = Channel_arrays<FT>;
+
+  /**
+   * @brief      Check if the mesh is supported by the Loop wavelet transform.
+   */
+  template <class Mesh>
+  static bool is_supported(const Mesh& mesh)
+  {
+    return !mesh.empty() && mesh.is_pure_triangle();
+  }
+
+  /**
+   * @brief      Record the stencils of the current level of the mesh.
+   *
+   * @param      m           The mesh, classified and at the finer resolution
+   *                         of the level.
+   * @param[in]  m_ops       The mesh operations, vertex ids must be the
+   *                         positions in the classified vertex array.
+   * @param      old_start   Start of old vertices
+   * @param      edge_start  Start of edge vertices
+   * @param      edge_end    End of edge vertices
+   * @param[in]  num_levels  The number of transform levels.
+   */
+  template <class Mesh, class Mesh_ops>
+  void build(Mesh& m,
+             const Mesh_ops& m_ops,
+             typename Mesh::Vertex_handle* old_start,
+             typename Mesh::Vertex_handle* edge_start,
+             typename Mesh::Vertex_handle* edge_end,
+             int num_levels);
+
+  /**
+   * @brief      Apply the analysis lifting steps to the channels.
+   */
+  void analyze(const Channels& x) const
+  {
+    lift<true>(x);
+  }
+
+  /**
+   * @brief      Apply the synthesis lifting steps to the channels.
+   */
+  void synthesize(const Channels& x) const
+  {
+    lift<false>(x);
+  }
+
+private:
+  template <bool analysis>
+  void lift(const Channels& x) const;
+
+  // The stencils writing the vertices of one tile of ids.
+  struct Tile
+  {
+    // Border old vertex and its two border edge neighbors {vo, e0, e1}.
+    Id_columns<3> border_olds;
+
+    // Border edge vertex and its two old border neighbors {ve, o0, o1}.
+    Id_columns<3> border_edges;
+
+    // The dual lifting of the border edge vertices, to their two old border
+    // neighbors and the two farther old border vertices.
+    Gather_stencil<FT> border_duals;
+
+    // Inner old vertices and their one-rings, ring i is
+    // rings[ring_offsets[i]] ... rings[ring_offsets[i + 1] - 1].
+    std::vector<int> inner_olds;
+    std::vector<FT> inner_old_betas;
+    std::vector<FT> inner_old_deltas;
+    std::vector<int> ring_offsets;
+    std::vector<int> rings;
+
+    // Inner edge vertex, the old vertices of its edge and the two old
+    // vertices opposite to the edge {ve, o0, o1, o2, o3}.
+    Id_columns<5> inner_edges;
+
+    // The dual lifting of the inner edge vertices to the same old vertices.
+    Gather_stencil<FT> inner_duals;
+  };
+
+  std::vector<Tile> tiles_;
+};  // class Loop_stencils
+
+
+/**
+ * @brief    The lifting stencils of one level of the Butterfly wavelet
+ *           transform.
+ *
+ * @tparam   Vec3  The vector type of the coordinates.
+ */
+template <class Vec3>
+class Butterfly_stencils
+{
+public:
+  using FT = typename Vec3::FT;
+  using Channels = Channel_arrays<FT>;
+
+  /**
+   * @brief      Check if the mesh is supported by the Butterfly wavelet
+   *             transform.
+   */
+  template <class Mesh>
+  static bool is_supported(const Mesh& mesh)
+  {
+    return !mesh.empty() && mesh.is_pure_triangle() && mesh.is_closed();
+  }
+
+  /**
+   * @brief      Record the stencils of the current level of the mesh.
+   *
+   * @see        Loop_stencils::build
+   */
+  template <class Mesh, class Mesh_ops>
+  void build(Mesh& m,
+             const Mesh_ops& m_ops,
+             typename Mesh::Vertex_handle* old_start,
+             typename Mesh::Vertex_handle* edge_start,
+             typename Mesh::Vertex_handle* edge_end,
+             int num_levels);
+
+  /**
+   * @brief      Apply the analysis lifting steps to the channels.
+   */
+  void analyze(const Channels& x) const
+  {
+    Lifting_kernels<FT>::template butterfly_olds_to_edges<true>(x, edges_);
+    Lifting_kernels<FT>::template edges_to_olds<true>(x, olds_);
+  }
+
+  /**
+   * @brief      Apply the synthesis lifting steps to the channels.
+   */
+  void synthesize(const Channels& x) const
+  {
+    Lifting_kernels<FT>::template edges_to_olds<false>(x, olds_);
+    Lifting_kernels<FT>::template butterfly_olds_to_edges<false>(x, edges_);
+  }
+
+private:
+  // Edge vertex and its butterfly mask {e, a0, a1, b0, b1, c0, c1, c2, c3}.
+  Id_columns<9> edges_;
+
+  // The update of a0 and a1 of each edge vertex, weighted by the scale ratios.
+  Gather_stencil<FT> olds_;
+};  // class Butterfly_stencils
+
+
+template <class Vec3>
+template <class Mesh, class Mesh_ops>
+void Loop_stencils<Vec3>::build(Mesh& m,
+                                const Mesh_ops& m_ops,
+                                typename Mesh::Vertex_handle* old_start,
+                                typename Mesh::Vertex_handle* edge_start,
+                                typename Mesh::Vertex_handle* edge_end,
+                                int num_levels)
+{
+  using Vertex_handle = typename Mesh::Vertex_handle;
+  using Halfedge_handle = typename Mesh::Halfedge_handle;
+  using Modifier = PTQ_subdivision_modifier<Mesh, Mesh_ops>;
+  using Halfedge_pair = typename Modifier::Halfedge_pair;
+  using Lift = Loop_lift_operations<Mesh, Mesh_ops, true>;
+
+  auto id = [&m_ops](Vertex_handle v) { return m_ops.get_vertex_id(v); };
+
+  const FT eta0 = -0.525336;
+  const FT eta1 = -0.525336;
+  const FT eta2 =  0.189068;
+  const FT eta3 =  0.189068;
+
+  // A stencil belongs to the tile of the vertex it writes.
+  const int num_ids = edge_end - old_start;
+  const int tile_size = lifting_tile_size();
+  tiles_.clear();
+  tiles_.resize((num_ids + tile_size - 1) / tile_size);
+  auto tile = [&](Vertex_handle v) -> Tile&
+  {
+    assert(id(v) >= 0 && id(v) < num_ids);
+    return tiles_[id(v) / tile_size];
+  };
+  for (Tile& t : tiles_)
+  {
+    t.ring_offsets.assign(1, 0);
+  }
+
+  // The dual lifting stencils {ve, o0, o1, o2, o3} and their weights, in the
+  // order of the edge vertices.
+  std::vector<std::array<int, 5>> border_duals;
+  std::vector<std::array<FT, 4>> border_dual_weights;
+  std::vector<std::array<int, 5>> inner_duals;
+  std::vector<std::array<FT, 4>> inner_dual_weights;
+
+  for (Vertex_handle* v_ptr = old_start; v_ptr != edge_start; ++v_ptr)
+  {
+    Vertex_handle v = *v_ptr;
+    Tile& t = tile(v);
+    if (m_ops.get_vertex_border(v))
+    {
+      Halfedge_pair hps {Modifier::get_halfedges_to_borders(v)};
+      t.border_olds[0].push_back(id(v));
+      t.border_olds[1].push_back(id(hps.first->vertex()));
+      t.border_olds[2].push_back(id(hps.second->vertex()));
+    }
+    else
+    {
+      t.inner_olds.push_back(id(v));
+      t.inner_old_deltas.push_back(Loop_math<FT>::delta(v->degree()));
+      t.inner_old_betas.push_back(Loop_math<FT>::beta(v->degree()));
+
+      auto hcir = v->vertex_begin();
+      do
+      {
+        t.rings.push_back(id(hcir->opposite()->vertex()));
+        ++hcir;
+      }
+      while (hcir != v->vertex_begin());
+      t.ring_offsets.push_back(t.rings.size());
+    }
+  }
+
+  for (Vertex_handle* v_ptr = edge_start; v_ptr != edge_end; ++v_ptr)
+  {
+    Vertex_handle v = *v_ptr;
+    Tile& t = tile(v);
+    if (m_ops.get_vertex_border(v))
+    {
+      Halfedge_pair hps {Modifier::get_halfedges_to_borders(v)};
+      Halfedge_handle h0 = hps.first;
+      Halfedge_handle h1 = hps.second;
+
+      // Navigate to the farther old border neighbors, the same way as
+      // Loop_lift_operations::border_edges_to_border_olds_dual.
+      Vertex_handle vo2 = h0->is_border() ?
+                            h0->next()->next()->vertex() :
+                            h0->opposite()->prev()->prev()->opposite()->vertex();
+      Vertex_handle vo3 = h1->is_border() ?
+                            h1->next()->next()->vertex() :
+                            h1->opposite()->prev()->prev()->opposite()->vertex();
+
+      t.border_edges[0].push_back(id(v));
+      t.border_edges[1].push_back(id(h0->vertex()));
+      t.border_edges[2].push_back(id(h1->vertex()));
+      border_duals.push_back({id(v),
+                              id(h0->vertex()),
+                              id(h1->vertex()),
+                              id(vo2),
+                              id(vo3)});
+      border_dual_weights.push_back({eta0, eta1, eta2, eta3});
+    }
+    else
+    {
+      Halfedge_pair hps {Modifier::get_halfedges_to_old_vertices(v, m_ops)};
+      Vertex_handle vo0 = hps.first->vertex();
+      Vertex_handle vo1 = hps.second->vertex();
+      Vertex_handle vo2 = Lift::opposite_vertex(hps.first);
+      Vertex_handle vo3 = Lift::opposite_vertex(hps.second);
+
+      typename Loop_math<FT>::Vector4 ws {Loop_math<FT>::get_cached_weight(vo0->degree(),
+                                                                           vo1->degree(),
+                                                                           vo2->degree(),
+                                                                           vo3->degree())};
+
+      std::array<int, 5> s {id(v), id(vo0), id(vo1), id(vo2), id(vo3)};
+      for (std::size_t k = 0; k < s.size(); ++k)
+      {
+        t.inner_edges[k].push_back(s[k]);
+      }
+      inner_duals.push_back(s);
+      inner_dual_weights.push_back({ws[0], ws[1], ws[2], ws[3]});
+    }
+  }
+
+  // The dual steps write old vertices, the updates of an old vertex go to
+  // its tile.
+  Gather_stencil<FT> all_border_duals;
+  Gather_stencil<FT> all_inner_duals;
+  all_border_duals.build(num_ids, border_duals, border_dual_weights);
+  all_inner_duals.build(num_ids, inner_duals, inner_dual_weights);
+  for (std::size_t i = 0; i < tiles_.size(); ++i)
+  {
+    int first_id = i * tile_size;
+    int last_id = std::min(first_id + tile_size, num_ids);
+    tiles_[i].border_duals.assign(all_border_duals, first_id, last_id);
+    tiles_[i].inner_duals.assign(all_inner_duals, first_id, last_id);
+  }
+}
+
+template <class Vec3>
+template <bool analysis>
+void Loop_stencils<Vec3>::lift(const Channels& x) const
+{
+  using Kernels = Lifting_kernels<FT>;
+
+  // The two steps of a sweep are independent, an old vertex takes the
+  // border dual updates before the inner ones in the analysis, and after them
+  // in the synthesis.
+  auto olds_sweep = [&x](const Tile& t)
+  {
+    Kernels::template loop_border_edges_to_border_olds<analysis>(x, t.border_olds);
+    Kernels::template loop_inner_edges_to_inner_olds<analysis>(x,
+                                                               t.inner_olds,
+                                                               t.ring_offsets,
+                                                               t.rings,
+                                                               t.inner_old_deltas,
+                                                               t.inner_old_betas);
+  };
+  auto edges_sweep = [&x](const Tile& t)
+  {
+    Kernels::template loop_border_olds_to_border_edges<analysis>(x, t.border_edges);
+    Kernels::template loop_inner_olds_to_inner_edges<analysis>(x, t.inner_edges);
+  };
+  auto duals_sweep = [&x](const Tile& t)
+  {
+    if (analysis)
+    {
+      Kernels::template edges_to_olds<true>(x, t.border_duals);
+      Kernels::template edges_to_olds<true>(x, t.inner_duals);
+    }
+    else
+    {
+      Kernels::template edges_to_olds<false>(x, t.inner_duals);
+      Kernels::template edges_to_olds<false>(x, t.border_duals);
+    }
+  };
+
+  if (analysis)
+  {
+    std::for_each(tiles_.begin(), tiles_.end(), olds_sweep);
+    std::for_each(tiles_.begin(), tiles_.end(), edges_sweep);
+    std::for_each(tiles_.begin(), tiles_.end(), duals_sweep);
+  }
+  else
+  {
+    std::for_each(tiles_.begin(), tiles_.end(), duals_sweep);
+    std::for_each(tiles_.begin(), tiles_.end(), edges_sweep);
+    std::for_each(tiles_.begin(), tiles_.end(), olds_sweep);
+  }
+}
+
+template <class Vec3>
+template <class Mesh, class Mesh_ops>
+void Butterfly_stencils<Vec3>::build(Mesh& m,
+                                     const Mesh_ops& m_ops,
+                                     typename Mesh::Vertex_handle* old_start,
+                                     typename Mesh::Vertex_handle* edge_start,
+                                     typename Mesh::Vertex_handle* edge_end,
+                                     int num_levels)
+{
+  using Vertex_handle = typename Mesh::Vertex_handle;
+  using Modifier = PTQ_subdivision_modifier<Mesh, Mesh_ops>;
+  using Halfedge_pair = typename Modifier::Halfedge_pair;
+  using Butterfly = Butterfly_synthesis_operations<Mesh, Mesh_ops>;
+
+  auto id = [&m_ops](Vertex_handle v) { return m_ops.get_vertex_id(v); };
+
+  // The scale ratios only depend on the valence of the old vertex and on the
+  // distance to the finest level.
+  Butterfly butterfly;
+  butterfly.initialize(m, m_ops, num_levels);
+
+  for (std::vector<int>& column : edges_)
+  {
+    column.clear();
+  }
+  std::vector<std::array<int, 3>> olds;
+  std::vector<std::array<FT, 2>> ratios;
+  for (Vertex_handle* p = edge_start; p != edge_end; ++p)
+  {
+    Vertex_handle e = *p;
+    Halfedge_pair hps {Modifier::get_halfedges_to_old_vertices(e, m_ops)};
+    Vertex_handle a0 = hps.first->vertex();
+    Vertex_handle a1 = hps.second->vertex();
+
+    std::array<int, 9> s {id(e),
+                          id(a0),
+                          id(a1),
+                          id(Butterfly::get_vertex_B(hps.first)),
+                          id(Butterfly::get_vertex_B(hps.second)),
+                          id(Butterfly::get_vertex_C0(hps.first)),
+                          id(Butterfly::get_vertex_C1(hps.first)),
+                          id(Butterfly::get_vertex_C0(hps.second)),
+                          id(Butterfly::get_vertex_C1(hps.second))};
+    for (std::size_t k = 0; k < s.size(); ++k)
+    {
+      edges_[k].push_back(s[k]);
+    }
+    olds.push_back({id(e), id(a0), id(a1)});
+    ratios.push_back({butterfly.get_scale_ratio(a0, e, m_ops),
+                      butterfly.get_scale_ratio(a1, e, m_ops)});
+  }
+
+  olds_.build(edge_end - old_start, olds, ratios);
+}
+}  // namespace wtlib::ptq_impl
+
+#endif  // define PTQ_IMPL_LIFTING_STENCILS_HPP
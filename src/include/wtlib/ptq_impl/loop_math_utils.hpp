@@ -1,11 +1,23 @@
 #ifndef PTQ_IMPL_LOOP_MATH_OPERATIONS_HPP
 #define PTQ_IMPL_LOOP_MATH_OPERATIONS_HPP
 
+#include <array>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
 
 #include <eigen3/Eigen/Dense>
 
+// The largest valence whose alpha, beta, gamma and delta are read from
+// Loop_math's valence table, larger valences are computed on every call.
+#ifndef WTLIB_LOOP_TABLE_MAX_VALENCE
+#define WTLIB_LOOP_TABLE_MAX_VALENCE 32
+#endif
+
 namespace wtlib::ptq_impl
 {
 
@@ -13,55 +25,122 @@ namespace wtlib::ptq_impl
  * @brief    Implement helper functions for computing the coefficients used in
  *           the Loop wavelet transform.
  *
+ * @tparam   FT    The scalar type of the coefficients (i.e., the FT of the
+ *                 mesh kernel).
  */
+template <class FT = double>
 class Loop_math
 {
 public:
-static double alpha(int n)
+using Vector4 = Eigen::Matrix<FT, 4, 1>;
+using Matrix4 = Eigen::Matrix<FT, 4, 4>;
+
+static constexpr int table_max_valence = WTLIB_LOOP_TABLE_MAX_VALENCE;
+
+/**
+ * @brief    The alpha, beta, gamma and delta of the valences 1 to
+ *           table_max_valence, indexed by valence (the entry 0 is unused).
+ */
+struct Valence_table
+{
+  std::array<FT, table_max_valence + 1> alpha;
+  std::array<FT, table_max_valence + 1> beta;
+  std::array<FT, table_max_valence + 1> gamma;
+  std::array<FT, table_max_valence + 1> delta;
+};
+
+/**
+ * @brief      The valence table, computed on first use with the formulas of
+ *             compute_alpha, compute_beta, compute_gamma and compute_delta.
+ *             Schemes built on Wavelet_analysis_ops can read it directly.
+ */
+static const Valence_table& get_valence_table()
+{
+  static const Valence_table table = []()
+  {
+    Valence_table t {};
+    for (int n = 1; n <= table_max_valence; ++n)
+    {
+      t.alpha[n] = compute_alpha(n);
+      t.beta[n] = compute_beta(n);
+      t.gamma[n] = compute_gamma(n);
+      t.delta[n] = compute_delta(n);
+    }
+    return t;
+  }();
+  return table;
+}
+
+static bool in_valence_table(int n)
+{
+  return n >= 1 && n <= table_max_valence;
+}
+
+static FT alpha(int n)
+{
+  return in_valence_table(n) ? get_valence_table().alpha[n] : compute_alpha(n);
+}
+
+static FT beta(int n)
+{
+  return in_valence_table(n) ? get_valence_table().beta[n] : compute_beta(n);
+}
+
+static FT gamma(int n)
+{
+  return in_valence_table(n) ? get_valence_table().gamma[n] : compute_gamma(n);
+}
+
+static FT delta(int n)
+{
+  return in_valence_table(n) ? get_valence_table().delta[n] : compute_delta(n);
+}
+
+static FT compute_alpha(int n)
 {
-  double nd {static_cast<double>(n)};
+  FT nd {static_cast<FT>(n)};
 
-  double eta = 0.375 + 0.25 * std::cos(2 * M_PI / nd);
+  FT eta = FT(0.375) + FT(0.25) * std::cos(FT(2 * M_PI) / nd);
 
-  return 0.375 + eta * eta;
+  return FT(0.375) + eta * eta;
 }
 
-static double beta(int n)
+static FT compute_beta(int n)
 {
-  return (alpha(n) - 0.375) / 0.625;
+  return (compute_alpha(n) - FT(0.375)) / FT(0.625);
 }
 
-static double gamma(int n)
+static FT compute_gamma(int n)
 {
-  return (1.0 - alpha(n)) / static_cast<double>(n);
+  return (FT(1.0) - compute_alpha(n)) / static_cast<FT>(n);
 }
 
-static double delta(int n)
+static FT compute_delta(int n)
 {
-  return (1.0 - beta(n)) / static_cast<double>(n);
+  return (FT(1.0) - compute_beta(n)) / static_cast<FT>(n);
 }
 
-static Eigen::Vector4d get_weight(int n0, int n1, int n2, int n3)
+static Vector4 get_weight(int n0, int n1, int n2, int n3)
 {
-  double n0d = static_cast<double>(n0);
-  double n1d = static_cast<double>(n1);
-  double n2d = static_cast<double>(n2);
-  double n3d = static_cast<double>(n3);
+  FT n0d = static_cast<FT>(n0);
+  FT n1d = static_cast<FT>(n1);
+  FT n2d = static_cast<FT>(n2);
+  FT n3d = static_cast<FT>(n3);
 
-  double alpha0 = alpha(n0);
-  double alpha1 = alpha(n1);
-  double alpha2 = alpha(n2);
-  double alpha3 = alpha(n3);
+  FT alpha0 = alpha(n0);
+  FT alpha1 = alpha(n1);
+  FT alpha2 = alpha(n2);
+  FT alpha3 = alpha(n3);
 
-  double gamma0 = gamma(n0);
-  double gamma1 = gamma(n1);
-  double gamma2 = gamma(n2);
-  double gamma3 = gamma(n3);
+  FT gamma0 = gamma(n0);
+  FT gamma1 = gamma(n1);
+  FT gamma2 = gamma(n2);
+  FT gamma3 = gamma(n3);
 
-  double delta0 = delta(n0);
-  double delta1 = delta(n1);
+  FT delta0 = delta(n0);
+  FT delta1 = delta(n1);
 
-  Eigen::Matrix4d A;
+  Matrix4 A;
   A(0, 0) = alpha0 * alpha0 + gamma1 * gamma1 + gamma2 * gamma2 + gamma3 * gamma3 + (n0d - 3.0) * 0.00390625 + n0d * (0.15625);
   A(1, 1) = gamma0 * gamma0 + alpha1 * alpha1 + gamma2 * gamma2 + gamma3 * gamma3 + (n1d - 3.0) * 0.00390625 + n1d * (0.15625);
   A(2, 2) = gamma0 * gamma0 + gamma1 * gamma1 + alpha2 * alpha2 + (n2d - 2.0) * 0.00390625 + n2d * (0.15625);
@@ -73,7 +152,7 @@ static Eigen::Vector4d get_weight(int n0, int n1, int n2, int n3)
   A(1, 3) = A(3, 1) = gamma0 * gamma0 + alpha1 * gamma1 + alpha3 * gamma3 + 0.33203125;
   A(2, 3) = A(3, 2) = gamma0 * gamma0 + gamma1 * gamma1 + 0.015625;
 
-  Eigen::Vector4d B;
+  Vector4 B;
   B(0) = -(alpha0 * delta0 + gamma1 * delta1 + 0.375);
   B(1) = -(gamma0 * delta0 + alpha1 * delta1 + 0.375);
   B(2) = B(3) = -(gamma0 * delta0 + gamma1 * delta1 + 0.125);
@@ -81,6 +160,106 @@ static Eigen::Vector4d get_weight(int n0, int n1, int n2, int n3)
   return A.inverse() * B;
 }
 
+/**
+ * @brief      Same as get_weight, but looks the weights up in a table shared
+ *             by all levels and transforms. The tuples of valences up to
+ *             weight_table_max_valence are computed on first use, the others
+ *             are computed once and kept as they are met. Safe to call from
+ *             several threads, and equal to get_weight bit for bit.
+ */
+static Vector4 get_cached_weight(int n0, int n1, int n2, int n3)
+{
+  const Weight* w;
+  if (in_weight_table(n0) && in_weight_table(n1) &&
+      in_weight_table(n2) && in_weight_table(n3))
+  {
+    w = &get_weight_table()[weight_table_index(n0, n1, n2, n3)];
+  }
+  else
+  {
+    w = &get_large_weight(n0, n1, n2, n3);
+  }
+  return Vector4((*w)[0], (*w)[1], (*w)[2], (*w)[3]);
+}
+
+// The valences of the tuples in the precomputed table, the most common
+// valences of a semi-regular mesh.
+static constexpr int weight_table_min_valence = 3;
+static constexpr int weight_table_max_valence = 8;
+
+private:
+using Weight = std::array<FT, 4>;
+
+static bool in_weight_table(int n)
+{
+  return n >= weight_table_min_valence && n <= weight_table_max_valence;
+}
+
+static Weight to_weight(const Vector4& v)
+{
+  return {v(0), v(1), v(2), v(3)};
+}
+
+static int weight_table_index(int n0, int n1, int n2, int n3)
+{
+  constexpr int size = weight_table_max_valence - weight_table_min_valence + 1;
+  return (((n0 - weight_table_min_valence) * size +
+           (n1 - weight_table_min_valence)) * size +
+           (n2 - weight_table_min_valence)) * size +
+           (n3 - weight_table_min_valence);
+}
+
+static const std::vector<Weight>& get_weight_table()
+{
+  static const std::vector<Weight> table = []()
+  {
+    constexpr int first = weight_table_min_valence;
+    constexpr int last = weight_table_max_valence;
+    std::vector<Weight> t;
+    for (int n0 = first; n0 <= last; ++n0)
+    {
+      for (int n1 = first; n1 <= last; ++n1)
+      {
+        for (int n2 = first; n2 <= last; ++n2)
+        {
+          for (int n3 = first; n3 <= last; ++n3)
+          {
+            // Same order as weight_table_index.
+            t.push_back(to_weight(get_weight(n0, n1, n2, n3)));
+          }
+        }
+      }
+    }
+    return t;
+  }();
+  return table;
+}
+
+// The weights of the other tuples, keyed by the valences packed in 16 bits
+// each. Elements of an unordered_map stay in place, so the returned
+// reference outlives the lock.
+static const Weight& get_large_weight(int n0, int n1, int n2, int n3)
+{
+  static std::unordered_map<std::uint64_t, Weight> weights;
+  static std::shared_mutex mutex;
+
+  assert(n0 >= 0 && n1 >= 0 && n2 >= 0 && n3 >= 0);
+  assert(n0 < 0x10000 && n1 < 0x10000 && n2 < 0x10000 && n3 < 0x10000);
+  std::uint64_t key = (std::uint64_t(n0) << 48) | (std::uint64_t(n1) << 32) |
+                      (std::uint64_t(n2) << 16) | std::uint64_t(n3);
+  {
+    std::shared_lock<std::shared_mutex> lock {mutex};
+    auto it = weights.find(key);
+    if (it != weights.end())
+    {
+      return it->second;
+    }
+  }
+  Weight w {to_weight(get_weight(n0, n1, n2, n3))};
+  std::unique_lock<std::shared_mutex> lock {mutex};
+  return weights.emplace(key, w).first->second;
+}
+
 };  // class Loop_math
 
 }  // namespace wtlib::ptq_impl
@@ -10,10 +10,14 @@
  */
 
 #include <wtlib/ptq_impl/loop_math_utils.hpp>
+#include <wtlib/ptq_impl/gather_table.hpp>
+#include <wtlib/ptq_impl/parallel_for.hpp>
 #include <wtlib/ptq_impl/subdivision_modifier.hpp>
 
 #include <CGAL/Origin.h>
 
+#include <algorithm>
+#include <array>
 #include <vector>
 #include <cassert>
 
@@ -25,8 +29,10 @@ template <class Mesh, class Mesh_ops, bool analysis>
 class Loop_lift_operations
 {
 public:
+  using FT = typename Mesh::Traits::FT;
   using Point3 = typename Mesh::Traits::Point_3;
   using Vec3 = typename Mesh::Traits::Vector_3;
+  using Math = Loop_math<FT>;
   using Vertex_handle = typename Mesh::Vertex_handle;
   using Halfedge_handle = typename Mesh::Halfedge_handle;
   using Halfedge_around_vertex_circulator = typename Mesh::Halfedge_around_vertex_circulator;
@@ -40,53 +46,115 @@ public:
    * @param[in]  m_ops       The mesh operations
    * @param      first_band  Pointer to pointer to the start vertex handle.
    * @param      last_band   Pointer to pointer to the end vertex handle.
+   * @param[in]  num_threads The number of threads used by each step.
    */
   static void lift(Mesh& m, 
                    const Mesh_ops& m_ops,
                    Vertex_handle** first_band,
-                   Vertex_handle** last_band);
+                   Vertex_handle** last_band,
+                   int num_threads = 1);
 
   static void border_edges_to_border_olds(
                           Mesh& m, 
                           const Mesh_ops& m_ops,
                           Vertex_handle* old_start,
                           Vertex_handle* edge_start,
-                          Vertex_handle* edge_end);
+                          Vertex_handle* edge_end,
+                          int num_threads = 1);
 
   static void border_olds_to_border_edges(
                           Mesh& m, 
                           const Mesh_ops& m_ops,
                           Vertex_handle* old_start,
                           Vertex_handle* edge_start,
-                          Vertex_handle* edge_end);
+                          Vertex_handle* edge_end,
+                          int num_threads = 1);
 
   static void inner_edges_to_inner_olds(
                           Mesh& m, 
                           const Mesh_ops& m_ops,
                           Vertex_handle* old_start,
                           Vertex_handle* edge_start,
-                          Vertex_handle* edge_end);
+                          Vertex_handle* edge_end,
+                          int num_threads = 1);
 
+  // The steps reading the halfedges from the edge vertices to their old
+  // vertices take them from parents, by position in the edge band, if it is
+  // given (see Modifier::get_halfedges_to_old_vertices), and circulate the
+  // edge vertices otherwise.
   static void inner_olds_to_inner_edges(
                           Mesh& m, 
                           const Mesh_ops& m_ops,
                           Vertex_handle* old_start,
                           Vertex_handle* edge_start,
-                          Vertex_handle* edge_end);
+                          Vertex_handle* edge_end,
+                          int num_threads = 1,
+                          const Halfedge_pair* parents = nullptr);
 
   static void border_edges_to_border_olds_dual(
                           Mesh& m, 
                           const Mesh_ops& m_ops,
                           Vertex_handle* old_start,
                           Vertex_handle* edge_start,
-                          Vertex_handle* edge_end);
+                          Vertex_handle* edge_end,
+                          int num_threads = 1);
 
   static void inner_edges_to_inner_olds_dual(
                           Mesh& m, 
                           const Mesh_ops& m_ops,
                           Vertex_handle* old_start,
                           Vertex_handle* edge_start,
-                          Vertex_handle* edge_end);
+                          Vertex_handle* edge_end,
+                          int num_threads = 1,
+                          const Halfedge_pair* parents = nullptr);
+
+  // The same steps on the vertices [first, last) they update, the old
+  // vertices or the edge vertices, which must all be border vertices for the
+  // border steps and inner vertices for the inner steps (see Band_partition).
+  // The border marks are not checked.
+  static void border_edges_to_border_olds(
+                          Mesh& m,
+                          const Mesh_ops& m_ops,
+                          Vertex_handle* first,
+                          Vertex_handle* last,
+                          int num_threads = 1);
+
+  static void border_olds_to_border_edges(
+                          Mesh& m,
+                          const Mesh_ops& m_ops,
+                          Vertex_handle* first,
+                          Vertex_handle* last,
+                          int num_threads = 1);
+
+  static void inner_edges_to_inner_olds(
+                          Mesh& m,
+                          const Mesh_ops& m_ops,
+                          Vertex_handle* first,
+                          Vertex_handle* last,
+                          int num_threads = 1);
+
+  static void inner_olds_to_inner_edges(
+                          Mesh& m,
+                          const Mesh_ops& m_ops,
+                          Vertex_handle* first,
+                          Vertex_handle* last,
+                          int num_threads = 1,
+                          const Halfedge_pair* parents = nullptr);
+
+  static void border_edges_to_border_olds_dual(
+                          Mesh& m,
+                          const Mesh_ops& m_ops,
+                          Vertex_handle* first,
+                          Vertex_handle* last,
+                          int num_threads = 1);
+
+  static void inner_edges_to_inner_olds_dual(
+                          Mesh& m,
+                          const Mesh_ops& m_ops,
+                          Vertex_handle* first,
+                          Vertex_handle* last,
+                          int num_threads = 1,
+                          const Halfedge_pair* parents = nullptr);
 
   static void initialize(
                     Mesh& m,
@@ -112,11 +180,128 @@ public:
    */
   static Vertex_handle opposite_vertex(Halfedge_handle h);
 
+  /**
+   * @brief      Gather form of a dual lifting step, which updates every old
+   *             vertex with the contributions of its edge vertices. Each old
+   *             vertex accumulates its contributions in the order of the edge
+   *             vertices, so the result is bit-identical to the scatter form
+   *             of the serial step, while the old vertices can be updated
+   *             concurrently.
+   *
+   * @param[in]  m_ops        The mesh operations
+   * @param      edge_start   Start of edge vertices
+   * @param      edge_end     End of edge vertices
+   * @param[in]  num_threads  The number of threads
+   * @param[in]  get_stencil  Called as get_stencil(e, i, olds, weights) for
+   *                          the edge vertex e = edge_start[i], sets the four
+   *                          old vertices updated by e and their weights,
+   *                          returns false if e does not take part in the
+   *                          step.
+   */
+  template <class Get_stencil>
+  static void edges_to_olds_gather(const Mesh_ops& m_ops,
+                                   Vertex_handle* edge_start,
+                                   Vertex_handle* edge_end,
+                                   int num_threads,
+                                   Get_stencil get_stencil);
+
   static int get_num_types(Mesh& mesh,
                            const Mesh_ops& m_ops)
   {
     return 2;
   }
+
+  /**
+   * @brief    The old and edge vertices of a level split into border and
+   *           inner vertices, each in band order, so that every lifting step
+   *           only goes through the vertices it updates, with its (first,
+   *           last) overload. On a closed mesh the inner ranges are the bands
+   *           themselves and the border ranges are empty.
+   */
+  class Band_partition
+  {
+  public:
+    /**
+     * @brief      Split the bands of a level.
+     *
+     * @param[in]  m_ops       The mesh operations
+     * @param      old_start   Start of old vertices
+     * @param      edge_start  Start of edge vertices
+     * @param      edge_end    End of edge vertices
+     */
+    void build(const Mesh_ops& m_ops,
+               Vertex_handle* old_start,
+               Vertex_handle* edge_start,
+               Vertex_handle* edge_end);
+
+    bool has_border() const
+    {
+      return border_old_start != border_old_end ||
+             border_edge_start != border_edge_end;
+    }
+
+    Vertex_handle* border_old_start {nullptr};
+    Vertex_handle* border_old_end {nullptr};
+    Vertex_handle* border_edge_start {nullptr};
+    Vertex_handle* border_edge_end {nullptr};
+    Vertex_handle* inner_old_start {nullptr};
+    Vertex_handle* inner_old_end {nullptr};
+    Vertex_handle* inner_edge_start {nullptr};
+    Vertex_handle* inner_edge_end {nullptr};
+
+  private:
+    std::vector<Vertex_handle> border_olds_;
+    std::vector<Vertex_handle> border_edges_;
+    std::vector<Vertex_handle> inner_olds_;
+    std::vector<Vertex_handle> inner_edges_;
+  };  // class Band_partition
+
+private:
+  // The steps on the vertices of [first, last) for which takes_part(v) is
+  // true, the parents are indexed by position in [first, last).
+  template <class Takes_part>
+  static void border_edges_to_border_olds_if(const Mesh_ops& m_ops,
+                                             Vertex_handle* first,
+                                             Vertex_handle* last,
+                                             int num_threads,
+                                             Takes_part takes_part);
+
+  template <class Takes_part>
+  static void border_olds_to_border_edges_if(const Mesh_ops& m_ops,
+                                             Vertex_handle* first,
+                                             Vertex_handle* last,
+                                             int num_threads,
+                                             Takes_part takes_part);
+
+  template <class Takes_part>
+  static void inner_edges_to_inner_olds_if(const Mesh_ops& m_ops,
+                                           Vertex_handle* first,
+                                           Vertex_handle* last,
+                                           int num_threads,
+                                           Takes_part takes_part);
+
+  template <class Takes_part>
+  static void inner_olds_to_inner_edges_if(const Mesh_ops& m_ops,
+                                           Vertex_handle* first,
+                                           Vertex_handle* last,
+                                           int num_threads,
+                                           const Halfedge_pair* parents,
+                                           Takes_part takes_part);
+
+  template <class Takes_part>
+  static void border_edges_to_border_olds_dual_if(const Mesh_ops& m_ops,
+                                                  Vertex_handle* first,
+                                                  Vertex_handle* last,
+                                                  int num_threads,
+                                                  Takes_part takes_part);
+
+  template <class Takes_part>
+  static void inner_edges_to_inner_olds_dual_if(const Mesh_ops& m_ops,
+                                                Vertex_handle* first,
+                                                Vertex_handle* last,
+                                                int num_threads,
+                                                const Halfedge_pair* parents,
+                                                Takes_part takes_part);
 };  // class Loop_lift_operations
 
 
@@ -131,7 +316,8 @@ public:
                 Mesh& m, 
                 const Mesh_ops& m_ops,
                 Vertex_handle** first_band,
-                Vertex_handle** last_band)
+                Vertex_handle** last_band,
+                int num_threads = 1)
   {
     assert(last_band - first_band == 2);
     Vertex_handle* old_start = *first_band;
@@ -139,36 +325,57 @@ public:
     Vertex_handle* edge_start = *last_band;
     assert(last_band - first_band == 1);
 
-    Lift::border_edges_to_border_olds(m, 
-                                      m_ops,
-                                      old_start,
-                                      edge_start,
-                                      edge_end);
-    Lift::border_olds_to_border_edges(m, 
-                                      m_ops,
-                                      old_start,
-                                      edge_start,
-                                      edge_end);
-    Lift::inner_edges_to_inner_olds(m, 
+    // Each step only goes through the vertices it updates, the border steps
+    // are skipped on a closed mesh.
+    typename Lift::Band_partition p;
+    p.build(m_ops, old_start, edge_start, edge_end);
+
+    // Both inner steps start from the halfedges to the old vertices.
+    std::vector<typename Lift::Halfedge_pair> parents;
+    Lift::Modifier::get_halfedges_to_old_vertices(p.inner_edge_start,
+                                                  p.inner_edge_end,
+                                                  m_ops,
+                                                  parents,
+                                                  num_threads);
+
+    if (p.has_border())
+    {
+      Lift::border_edges_to_border_olds(m,
+                                        m_ops,
+                                        p.border_old_start,
+                                        p.border_old_end,
+                                        num_threads);
+      Lift::border_olds_to_border_edges(m,
+                                        m_ops,
+                                        p.border_edge_start,
+                                        p.border_edge_end,
+                                        num_threads);
+    }
+    Lift::inner_edges_to_inner_olds(m,
                                     m_ops,
-                                    old_start,
-                                    edge_start,
-                                    edge_end);
-    Lift::inner_olds_to_inner_edges(m, 
+                                    p.inner_old_start,
+                                    p.inner_old_end,
+                                    num_threads);
+    Lift::inner_olds_to_inner_edges(m,
                                     m_ops,
-                                    old_start,
-                                    edge_start,
-                                    edge_end);
-    Lift::border_edges_to_border_olds_dual(m, 
-                                           m_ops,
-                                           old_start,
-                                           edge_start,
-                                           edge_end);
-    Lift::inner_edges_to_inner_olds_dual(m, 
+                                    p.inner_edge_start,
+                                    p.inner_edge_end,
+                                    num_threads,
+                                    parents.data());
+    if (p.has_border())
+    {
+      Lift::border_edges_to_border_olds_dual(m,
+                                             m_ops,
+                                             p.border_edge_start,
+                                             p.border_edge_end,
+                                             num_threads);
+    }
+    Lift::inner_edges_to_inner_olds_dual(m,
                                          m_ops,
-                                         old_start,
-                                         edge_start,
-                                         edge_end);
+                                         p.inner_edge_start,
+                                         p.inner_edge_end,
+                                         num_threads,
+                                         parents.data());
   }
 
   static int get_num_types(Mesh& mesh, const Mesh_ops& mesh_ops)
@@ -213,7 +420,8 @@ public:
                 Mesh& m, 
                 const Mesh_ops& m_ops,
                 Vertex_handle** first_band,
-                Vertex_handle** last_band)
+                Vertex_handle** last_band,
+                int num_threads = 1)
   {
     assert(last_band - first_band == 2);
     Vertex_handle* old_start = *first_band;
@@ -221,40 +429,116 @@ public:
     Vertex_handle* edge_start = *last_band;
     assert(last_band - first_band == 1);
 
-    Lift::inner_edges_to_inner_olds_dual(m, 
+    // Each step only goes through the vertices it updates, the border steps
+    // are skipped on a closed mesh.
+    typename Lift::Band_partition p;
+    p.build(m_ops, old_start, edge_start, edge_end);
+
+    // Both inner steps start from the halfedges to the old vertices.
+    std::vector<typename Lift::Halfedge_pair> parents;
+    Lift::Modifier::get_halfedges_to_old_vertices(p.inner_edge_start,
+                                                  p.inner_edge_end,
+                                                  m_ops,
+                                                  parents,
+                                                  num_threads);
+
+    Lift::inner_edges_to_inner_olds_dual(m,
                                          m_ops,
-                                         old_start,
-                                         edge_start,
-                                         edge_end);
-    Lift::border_edges_to_border_olds_dual(m, 
-                                           m_ops,
-                                           old_start,
-                                           edge_start,
-                                           edge_end);
-    Lift::inner_olds_to_inner_edges(m, 
+                                         p.inner_edge_start,
+                                         p.inner_edge_end,
+                                         num_threads,
+                                         parents.data());
+    if (p.has_border())
+    {
+      Lift::border_edges_to_border_olds_dual(m,
+                                             m_ops,
+                                             p.border_edge_start,
+                                             p.border_edge_end,
+                                             num_threads);
+    }
+    Lift::inner_olds_to_inner_edges(m,
                                     m_ops,
-                                    old_start,
-                                    edge_start,
-                                    edge_end);
-    Lift::inner_edges_to_inner_olds(m, 
+                                    p.inner_edge_start,
+                                    p.inner_edge_end,
+                                    num_threads,
+                                    parents.data());
+    Lift::inner_edges_to_inner_olds(m,
                                     m_ops,
-                                    old_start,
-                                    edge_start,
-                                    edge_end);
-    Lift::border_olds_to_border_edges(m, 
-                                      m_ops,
-                                      old_start,
-                                      edge_start,
-                                      edge_end);
-    Lift::border_edges_to_border_olds(m, 
-                                      m_ops,
-                                      old_start,
-                                      edge_start,
-                                      edge_end);
+                                    p.inner_old_start,
+                                    p.inner_old_end,
+                                    num_threads);
+    if (p.has_border())
+    {
+      Lift::border_olds_to_border_edges(m,
+                                        m_ops,
+                                        p.border_edge_start,
+                                        p.border_edge_end,
+                                        num_threads);
+      Lift::border_edges_to_border_olds(m,
+                                        m_ops,
+                                        p.border_old_start,
+                                        p.border_old_end,
+                                        num_threads);
+    }
   }
 };  // class Loop_synthesis_operations
 
 
+template <class Mesh, class Mesh_ops, bool analysis>
+void Loop_lift_operations<Mesh, Mesh_ops, analysis>::Band_partition::build(
+                                                const Mesh_ops& m_ops,
+                                                Vertex_handle* old_start,
+                                                Vertex_handle* edge_start,
+                                                Vertex_handle* edge_end)
+{
+  border_olds_.clear();
+  border_edges_.clear();
+  inner_olds_.clear();
+  inner_edges_.clear();
+
+  auto is_border = [&m_ops](Vertex_handle v)
+  {
+    return m_ops.get_vertex_border(v);
+  };
+  Vertex_handle* first_border = std::find_if(old_start, edge_end, is_border);
+  if (first_border == edge_end)
+  {
+    // Closed mesh, the bands are used as they are.
+    border_old_start = border_old_end = nullptr;
+    border_edge_start = border_edge_end = nullptr;
+    inner_old_start = old_start;
+    inner_old_end = edge_start;
+    inner_edge_start = edge_start;
+    inner_edge_end = edge_end;
+    return;
+  }
+
+  // The vertices before the first border vertex are inner ones.
+  Vertex_handle* inner_old_last = std::min(first_border, edge_start);
+  inner_olds_.assign(old_start, inner_old_last);
+  inner_edges_.assign(edge_start, std::max(first_border, edge_start));
+  for (Vertex_handle* v_ptr = first_border; v_ptr != edge_end; ++v_ptr)
+  {
+    bool is_edge = v_ptr >= edge_start;
+    if (is_border(*v_ptr))
+    {
+      (is_edge ? border_edges_ : border_olds_).push_back(*v_ptr);
+    }
+    else
+    {
+      (is_edge ? inner_edges_ : inner_olds_).push_back(*v_ptr);
+    }
+  }
+  border_old_start = border_olds_.data();
+  border_old_end = border_old_start + border_olds_.size();
+  border_edge_start = border_edges_.data();
+  border_edge_end = border_edge_start + border_edges_.size();
+  inner_old_start = inner_olds_.data();
+  inner_old_end = inner_old_start + inner_olds_.size();
+  inner_edge_start = inner_edges_.data();
+  inner_edge_end = inner_edge_start + inner_edges_.size();
+}
+
 template <class Mesh, class Mesh_ops, bool analysis>
 typename Loop_lift_operations<Mesh, Mesh_ops, analysis>::Vertex_handle
 Loop_lift_operations<Mesh, Mesh_ops, analysis>::opposite_vertex(Halfedge_handle h)
@@ -276,47 +560,136 @@ Loop_lift_operations<Mesh, Mesh_ops, analysis>::opposite_vertex(Halfedge_handle
   return h->vertex();
 }
 
+template <class Mesh, class Mesh_ops, bool analysis>
+template <class Get_stencil>
+void Loop_lift_operations<Mesh, Mesh_ops, analysis>::edges_to_olds_gather(
+                                                const Mesh_ops &m_ops,
+                                                Vertex_handle *edge_start,
+                                                Vertex_handle *edge_end,
+                                                int num_threads,
+                                                Get_stencil get_stencil)
+{
+  Gather_table<Vertex_handle, 4, FT> table;
+  table.build(m_ops,
+              edge_start,
+              edge_end,
+              num_threads,
+              [&get_stencil](Vertex_handle e,
+                             int i,
+                             std::array<Vertex_handle, 4>& olds,
+                             std::array<FT, 4>& weights)
+              {
+                if (!get_stencil(e, i, olds, weights))
+                {
+                  return false;
+                }
+                // The serial step reads the four old vertices before writing
+                // them back.
+                Gather_table<Vertex_handle, 4, FT>::keep_last_duplicate(olds);
+                return true;
+              });
+
+  table.gather(num_threads,
+               [&](Vertex_handle vo, int first, int last)
+               {
+                 Vec3 o {CGAL::ORIGIN, vo->point()};
+                 for (int c = first; c < last; ++c)
+                 {
+                   Vec3 e {CGAL::ORIGIN, edge_start[table.edge(c)]->point()};
+                   if (analysis)
+                   {
+                     o = o - table.weight(c) * e;
+                   }
+                   else
+                   {
+                     o = o + table.weight(c) * e;
+                   }
+                 }
+                 vo->point() = CGAL::ORIGIN + o;
+               });
+}
+
 template <class Mesh, class Mesh_ops, bool analysis>
 void Loop_lift_operations<Mesh, Mesh_ops, analysis>::border_edges_to_border_olds(
                                                 Mesh &m, 
                                                 const Mesh_ops &m_ops, 
                                                 Vertex_handle *first_band, 
                                                 Vertex_handle *edge_start,
-                                                Vertex_handle *last_band)
+                                                Vertex_handle *last_band,
+                                                int num_threads)
 {
-  for (Vertex_handle* v_ptr = first_band; v_ptr != edge_start; ++v_ptr)
-  {
-    Vertex_handle vo = *v_ptr;
-    if (m_ops.get_vertex_border(vo))
-    {
-      Halfedge_pair hps {Modifier::get_halfedges_to_borders(vo)};
-
-      Vertex_handle e0 = hps.first->vertex();
-      Vertex_handle e1 = hps.second->vertex();
-
-      assert(m_ops.get_vertex_border(e0));
-      assert(m_ops.get_vertex_border(e1));
-      assert(m_ops.get_vertex_level(e0) > m_ops.get_vertex_level(vo));
-      assert(m_ops.get_vertex_level(e1) > m_ops.get_vertex_level(vo));
+  border_edges_to_border_olds_if(m_ops,
+                                 first_band,
+                                 edge_start,
+                                 num_threads,
+                                 [&m_ops](Vertex_handle v)
+                                 {
+                                   return m_ops.get_vertex_border(v);
+                                 });
+}
 
-      Vec3 res {CGAL::ORIGIN, vo->point()};
-      Vec3 ve0 {CGAL::ORIGIN, e0->point()};
-      Vec3 ve1 {CGAL::ORIGIN, e1->point()};
+template <class Mesh, class Mesh_ops, bool analysis>
+void Loop_lift_operations<Mesh, Mesh_ops, analysis>::border_edges_to_border_olds(
+                                                Mesh &m,
+                                                const Mesh_ops &m_ops,
+                                                Vertex_handle *first,
+                                                Vertex_handle *last,
+                                                int num_threads)
+{
+  border_edges_to_border_olds_if(m_ops,
+                                 first,
+                                 last,
+                                 num_threads,
+                                 [](Vertex_handle) { return true; });
+}
 
-      if (analysis)
-      {
-        res = res - 0.25 * (ve0 + ve1);
-        res = res * 2.0;
-      }
-      else
+template <class Mesh, class Mesh_ops, bool analysis>
+template <class Takes_part>
+void Loop_lift_operations<Mesh, Mesh_ops, analysis>::border_edges_to_border_olds_if(
+                                                const Mesh_ops &m_ops,
+                                                Vertex_handle *old_first,
+                                                Vertex_handle *old_last,
+                                                int num_threads,
+                                                Takes_part takes_part)
+{
+  // Each border old vertex only reads edge vertices.
+  parallel_for(old_first, old_last, num_threads,
+               [&m_ops, &takes_part](Vertex_handle* first, Vertex_handle* last)
+  {
+    for (Vertex_handle* v_ptr = first; v_ptr != last; ++v_ptr)
+    {
+      Vertex_handle vo = *v_ptr;
+      if (takes_part(vo))
       {
-        res = res / 2.0;
-        res = res + 0.25 * (ve0 + ve1);
+        Halfedge_pair hps {Modifier::get_halfedges_to_borders(vo)};
+
+        Vertex_handle e0 = hps.first->vertex();
+        Vertex_handle e1 = hps.second->vertex();
+
+        assert(m_ops.get_vertex_border(e0));
+        assert(m_ops.get_vertex_border(e1));
+        assert(m_ops.get_vertex_level(e0) > m_ops.get_vertex_level(vo));
+        assert(m_ops.get_vertex_level(e1) > m_ops.get_vertex_level(vo));
+
+        Vec3 res {CGAL::ORIGIN, vo->point()};
+        Vec3 ve0 {CGAL::ORIGIN, e0->point()};
+        Vec3 ve1 {CGAL::ORIGIN, e1->point()};
+
+        if (analysis)
+        {
+          res = res - 0.25 * (ve0 + ve1);
+          res = res * 2.0;
+        }
+        else
+        {
+          res = res / 2.0;
+          res = res + 0.25 * (ve0 + ve1);
+        }
+
+        vo->point() = CGAL::ORIGIN + res;
       }
-
-      vo->point() = CGAL::ORIGIN + res;
     }
-  }
+  });
 }
 
 template <class Mesh, class Mesh_ops, bool analysis>
@@ -325,38 +698,78 @@ void Loop_lift_operations<Mesh, Mesh_ops, analysis>::border_olds_to_border_edges
                                                 const Mesh_ops &m_ops,
                                                 Vertex_handle *first_band,
                                                 Vertex_handle *edge_start,
-                                                Vertex_handle *last_band)
+                                                Vertex_handle *last_band,
+                                                int num_threads)
+{
+  border_olds_to_border_edges_if(m_ops,
+                                 edge_start,
+                                 last_band,
+                                 num_threads,
+                                 [&m_ops](Vertex_handle v)
+                                 {
+                                   return m_ops.get_vertex_border(v);
+                                 });
+}
+
+template <class Mesh, class Mesh_ops, bool analysis>
+void Loop_lift_operations<Mesh, Mesh_ops, analysis>::border_olds_to_border_edges(
+                                                Mesh &m,
+                                                const Mesh_ops &m_ops,
+                                                Vertex_handle *first,
+                                                Vertex_handle *last,
+                                                int num_threads)
 {
-  for (Vertex_handle* v_ptr = edge_start; v_ptr != last_band; ++v_ptr)
+  border_olds_to_border_edges_if(m_ops,
+                                 first,
+                                 last,
+                                 num_threads,
+                                 [](Vertex_handle) { return true; });
+}
+
+template <class Mesh, class Mesh_ops, bool analysis>
+template <class Takes_part>
+void Loop_lift_operations<Mesh, Mesh_ops, analysis>::border_olds_to_border_edges_if(
+                                                const Mesh_ops &m_ops,
+                                                Vertex_handle *edge_first,
+                                                Vertex_handle *edge_last,
+                                                int num_threads,
+                                                Takes_part takes_part)
+{
+  // Each border edge vertex only reads old vertices.
+  parallel_for(edge_first, edge_last, num_threads,
+               [&m_ops, &takes_part](Vertex_handle* first, Vertex_handle* last)
   {
-    Vertex_handle ve = *v_ptr;
-    if (m_ops.get_vertex_border(ve))
+    for (Vertex_handle* v_ptr = first; v_ptr != last; ++v_ptr)
     {
-      Halfedge_pair hps {Modifier::get_halfedges_to_borders(ve)};
-      Vertex_handle o0 = hps.first->vertex();
-      Vertex_handle o1 = hps.second->vertex();
-      
-      assert(m_ops.get_vertex_border(o0));
-      assert(m_ops.get_vertex_border(o1));
-      assert(m_ops.get_vertex_level(o0) < m_ops.get_vertex_level(ve));
-      assert(m_ops.get_vertex_level(o1) < m_ops.get_vertex_level(ve));
-
-      Vec3 res {CGAL::ORIGIN, ve->point()};
-      Vec3 vo0 {CGAL::ORIGIN, o0->point()};
-      Vec3 vo1 {CGAL::ORIGIN, o1->point()};
-
-      if (analysis)
+      Vertex_handle ve = *v_ptr;
+      if (takes_part(ve))
       {
-        res = res - 0.5 * (vo0 + vo1);
+        Halfedge_pair hps {Modifier::get_halfedges_to_borders(ve)};
+        Vertex_handle o0 = hps.first->vertex();
+        Vertex_handle o1 = hps.second->vertex();
+        
+        assert(m_ops.get_vertex_border(o0));
+        assert(m_ops.get_vertex_border(o1));
+        assert(m_ops.get_vertex_level(o0) < m_ops.get_vertex_level(ve));
+        assert(m_ops.get_vertex_level(o1) < m_ops.get_vertex_level(ve));
+
+        Vec3 res {CGAL::ORIGIN, ve->point()};
+        Vec3 vo0 {CGAL::ORIGIN, o0->point()};
+        Vec3 vo1 {CGAL::ORIGIN, o1->point()};
+
+        if (analysis)
+        {
+          res = res - 0.5 * (vo0 + vo1);
+        }
+        else
+        {
+          res = res + 0.5 * (vo0 + vo1);
+        }
+
+        ve->point() = CGAL::ORIGIN + res;
       }
-      else
-      {
-        res = res + 0.5 * (vo0 + vo1);
-      }
-
-      ve->point() = CGAL::ORIGIN + res;
     }
-  }
+  });
 }
 
 template <class Mesh, class Mesh_ops, bool analysis>
@@ -365,48 +778,88 @@ void Loop_lift_operations<Mesh, Mesh_ops, analysis>::inner_edges_to_inner_olds(
                                                 const Mesh_ops &m_ops,
                                                 Vertex_handle *first_band,
                                                 Vertex_handle *edge_start,
-                                                Vertex_handle *last_band)
+                                                Vertex_handle *last_band,
+                                                int num_threads)
 {
-  for (Vertex_handle* v_ptr = first_band; v_ptr != edge_start; ++v_ptr)
-  {
-    // The center old vertex of current mask.
-    Vertex_handle v = *v_ptr;
-
-    // The old vertex should be interior vertex.
-    if (!m_ops.get_vertex_border(v))
-    {
-      double delta {Loop_math::delta(v->degree())};
-      double beta {Loop_math::beta(v->degree())};
+  inner_edges_to_inner_olds_if(m_ops,
+                               first_band,
+                               edge_start,
+                               num_threads,
+                               [&m_ops](Vertex_handle v)
+                               {
+                                 return !m_ops.get_vertex_border(v);
+                               });
+}
 
-      Halfedge_around_vertex_circulator hcir = v->vertex_begin();
+template <class Mesh, class Mesh_ops, bool analysis>
+void Loop_lift_operations<Mesh, Mesh_ops, analysis>::inner_edges_to_inner_olds(
+                                                Mesh &m,
+                                                const Mesh_ops &m_ops,
+                                                Vertex_handle *first,
+                                                Vertex_handle *last,
+                                                int num_threads)
+{
+  inner_edges_to_inner_olds_if(m_ops,
+                               first,
+                               last,
+                               num_threads,
+                               [](Vertex_handle) { return true; });
+}
 
-      Vec3 o {CGAL::ORIGIN, v->point()};
-      Vec3 e_sum {0.0, 0.0, 0.0};
-      do
-      {
-        Vertex_handle ve = hcir->opposite()->vertex();
-        assert(!m_ops.get_vertex_border(ve));
-        assert(m_ops.get_vertex_level(ve) > m_ops.get_vertex_level(v)); 
-        Vec3 e {CGAL::ORIGIN, ve->point()};
-        e_sum = e_sum + e;
-        ++hcir;
-      }
-      while (hcir != v->vertex_begin());
+template <class Mesh, class Mesh_ops, bool analysis>
+template <class Takes_part>
+void Loop_lift_operations<Mesh, Mesh_ops, analysis>::inner_edges_to_inner_olds_if(
+                                                const Mesh_ops &m_ops,
+                                                Vertex_handle *old_first,
+                                                Vertex_handle *old_last,
+                                                int num_threads,
+                                                Takes_part takes_part)
+{
+  // Each inner old vertex only reads edge vertices.
+  parallel_for(old_first, old_last, num_threads,
+               [&m_ops, &takes_part](Vertex_handle* first, Vertex_handle* last)
+  {
+    for (Vertex_handle* v_ptr = first; v_ptr != last; ++v_ptr)
+    {
+      // The center old vertex of current mask.
+      Vertex_handle v = *v_ptr;
 
-      if (analysis)
-      {
-        o = o - delta * (e_sum);
-        o = o / beta;
-      }
-      else
+      // The old vertex should be interior vertex.
+      if (takes_part(v))
       {
-        o = o * beta;
-        o = o + delta * (e_sum);
+        FT delta {Math::delta(v->degree())};
+        FT beta {Math::beta(v->degree())};
+
+        Halfedge_around_vertex_circulator hcir = v->vertex_begin();
+
+        Vec3 o {CGAL::ORIGIN, v->point()};
+        Vec3 e_sum {0.0, 0.0, 0.0};
+        do
+        {
+          Vertex_handle ve = hcir->opposite()->vertex();
+          assert(!m_ops.get_vertex_border(ve));
+          assert(m_ops.get_vertex_level(ve) > m_ops.get_vertex_level(v)); 
+          Vec3 e {CGAL::ORIGIN, ve->point()};
+          e_sum = e_sum + e;
+          ++hcir;
+        }
+        while (hcir != v->vertex_begin());
+
+        if (analysis)
+        {
+          o = o - delta * (e_sum);
+          o = o / beta;
+        }
+        else
+        {
+          o = o * beta;
+          o = o + delta * (e_sum);
+        }
+
+        v->point() = CGAL::ORIGIN + o;
       }
-
-      v->point() = CGAL::ORIGIN + o;
     }
-  }
+  });
 }
 
 template <class Mesh, class Mesh_ops, bool analysis>
@@ -415,51 +868,99 @@ void Loop_lift_operations<Mesh, Mesh_ops, analysis>::inner_olds_to_inner_edges(
                                                 const Mesh_ops &m_ops,
                                                 Vertex_handle *first_band,
                                                 Vertex_handle *edge_start,
-                                                Vertex_handle *last_band)
+                                                Vertex_handle *last_band,
+                                                int num_threads,
+                                                const Halfedge_pair* parents)
 {
-  // Using Old vertices to modify inner edge vertices
-  for (Vertex_handle* v_ptr = edge_start; v_ptr != last_band; ++v_ptr)
-  {
-    // The center edge vertex of the current mask
-    Vertex_handle v = *v_ptr;
-
-    // The edge vertex should be interior vertex
-    if (!m_ops.get_vertex_border(v))
-    {
-      Halfedge_pair hps {Modifier::get_halfedges_to_old_vertices(v, m_ops)};
-      Halfedge_handle h0 = hps.first;
-      Halfedge_handle h1 = hps.second;
-
-      Vertex_handle vo0 = h0->vertex();
-      Vertex_handle vo1 = h1->vertex();
+  inner_olds_to_inner_edges_if(m_ops,
+                               edge_start,
+                               last_band,
+                               num_threads,
+                               parents,
+                               [&m_ops](Vertex_handle v)
+                               {
+                                 return !m_ops.get_vertex_border(v);
+                               });
+}
 
-      Vertex_handle vo2 = opposite_vertex(h0);
-      Vertex_handle vo3 = opposite_vertex(h1);
-      assert(vo0 != Vertex_handle {});
-      assert(vo1 != Vertex_handle {});
-      assert(vo2 != Vertex_handle {});
-      assert(vo3 != Vertex_handle {});
-      assert(m_ops.get_vertex_level(vo2) < m_ops.get_vertex_level(v));
-      assert(m_ops.get_vertex_level(vo3) < m_ops.get_vertex_level(v));
+template <class Mesh, class Mesh_ops, bool analysis>
+void Loop_lift_operations<Mesh, Mesh_ops, analysis>::inner_olds_to_inner_edges(
+                                                Mesh &m,
+                                                const Mesh_ops &m_ops,
+                                                Vertex_handle *first,
+                                                Vertex_handle *last,
+                                                int num_threads,
+                                                const Halfedge_pair* parents)
+{
+  inner_olds_to_inner_edges_if(m_ops,
+                               first,
+                               last,
+                               num_threads,
+                               parents,
+                               [](Vertex_handle) { return true; });
+}
 
-      Vec3 o0 {CGAL::ORIGIN, vo0->point()};
-      Vec3 o1 {CGAL::ORIGIN, vo1->point()};
-      Vec3 o2 {CGAL::ORIGIN, vo2->point()};
-      Vec3 o3 {CGAL::ORIGIN, vo3->point()};
-      Vec3 e {CGAL::ORIGIN, v->point()};
+template <class Mesh, class Mesh_ops, bool analysis>
+template <class Takes_part>
+void Loop_lift_operations<Mesh, Mesh_ops, analysis>::inner_olds_to_inner_edges_if(
+                                                const Mesh_ops &m_ops,
+                                                Vertex_handle *edge_first,
+                                                Vertex_handle *edge_last,
+                                                int num_threads,
+                                                const Halfedge_pair* parents,
+                                                Takes_part takes_part)
+{
+  // Using Old vertices to modify inner edge vertices, each inner edge vertex
+  // only reads old vertices.
+  parallel_for(edge_first, edge_last, num_threads,
+               [&m_ops, &takes_part, edge_first, parents](Vertex_handle* first,
+                                                          Vertex_handle* last)
+  {
+    for (Vertex_handle* v_ptr = first; v_ptr != last; ++v_ptr)
+    {
+      // The center edge vertex of the current mask
+      Vertex_handle v = *v_ptr;
 
-      if (analysis)
+      // The edge vertex should be interior vertex
+      if (takes_part(v))
       {
-        e = e - 0.375 * (o0 + o1) - 0.125 * (o2 + o3);
+        Halfedge_pair hps {parents ?
+                           parents[v_ptr - edge_first] :
+                           Modifier::get_halfedges_to_old_vertices(v, m_ops)};
+        Halfedge_handle h0 = hps.first;
+        Halfedge_handle h1 = hps.second;
+
+        Vertex_handle vo0 = h0->vertex();
+        Vertex_handle vo1 = h1->vertex();
+
+        Vertex_handle vo2 = opposite_vertex(h0);
+        Vertex_handle vo3 = opposite_vertex(h1);
+        assert(vo0 != Vertex_handle {});
+        assert(vo1 != Vertex_handle {});
+        assert(vo2 != Vertex_handle {});
+        assert(vo3 != Vertex_handle {});
+        assert(m_ops.get_vertex_level(vo2) < m_ops.get_vertex_level(v));
+        assert(m_ops.get_vertex_level(vo3) < m_ops.get_vertex_level(v));
+
+        Vec3 o0 {CGAL::ORIGIN, vo0->point()};
+        Vec3 o1 {CGAL::ORIGIN, vo1->point()};
+        Vec3 o2 {CGAL::ORIGIN, vo2->point()};
+        Vec3 o3 {CGAL::ORIGIN, vo3->point()};
+        Vec3 e {CGAL::ORIGIN, v->point()};
+
+        if (analysis)
+        {
+          e = e - 0.375 * (o0 + o1) - 0.125 * (o2 + o3);
+        }
+        else
+        {
+          e = e + 0.375 * (o0 + o1) + 0.125 * (o2 + o3);
+        }
+
+        v->point() = CGAL::ORIGIN + e;
       }
-      else
-      {
-        e = e + 0.375 * (o0 + o1) + 0.125 * (o2 + o3);
-      }
-
-      v->point() = CGAL::ORIGIN + e;
     }
-  }
+  });
 }
 
 template <class Mesh, class Mesh_ops, bool analysis>
@@ -468,15 +969,88 @@ void Loop_lift_operations<Mesh, Mesh_ops, analysis>::border_edges_to_border_olds
                                                 const Mesh_ops &m_ops,
                                                 Vertex_handle *first_band,
                                                 Vertex_handle *edge_start,
-                                                Vertex_handle *last_band)
+                                                Vertex_handle *last_band,
+                                                int num_threads)
 {
-  for (Vertex_handle* v_ptr = edge_start; v_ptr != last_band; ++v_ptr)
+  border_edges_to_border_olds_dual_if(m_ops,
+                                      edge_start,
+                                      last_band,
+                                      num_threads,
+                                      [&m_ops](Vertex_handle v)
+                                      {
+                                        return m_ops.get_vertex_border(v);
+                                      });
+}
+
+template <class Mesh, class Mesh_ops, bool analysis>
+void Loop_lift_operations<Mesh, Mesh_ops, analysis>::border_edges_to_border_olds_dual(
+                                                Mesh &m,
+                                                const Mesh_ops &m_ops,
+                                                Vertex_handle *first,
+                                                Vertex_handle *last,
+                                                int num_threads)
+{
+  border_edges_to_border_olds_dual_if(m_ops,
+                                      first,
+                                      last,
+                                      num_threads,
+                                      [](Vertex_handle) { return true; });
+}
+
+template <class Mesh, class Mesh_ops, bool analysis>
+template <class Takes_part>
+void Loop_lift_operations<Mesh, Mesh_ops, analysis>::border_edges_to_border_olds_dual_if(
+                                                const Mesh_ops &m_ops,
+                                                Vertex_handle *edge_first,
+                                                Vertex_handle *edge_last,
+                                                int num_threads,
+                                                Takes_part takes_part)
+{
+  FT eta0 = -0.525336;
+  FT eta1 = -0.525336;
+  FT eta2 =  0.189068;
+  FT eta3 =  0.189068;
+
+  if (num_threads > 1)
+  {
+    // Several edge vertices update the same old vertex, use the gather form.
+    edges_to_olds_gather(m_ops,
+                         edge_first,
+                         edge_last,
+                         num_threads,
+                         [&](Vertex_handle v,
+                             int,
+                             std::array<Vertex_handle, 4>& olds,
+                             std::array<FT, 4>& weights)
+                         {
+                           if (!takes_part(v))
+                           {
+                             return false;
+                           }
+                           Halfedge_pair hps {Modifier::get_halfedges_to_borders(v)};
+                           Halfedge_handle h0 = hps.first;
+                           Halfedge_handle h1 = hps.second;
+                           olds[0] = h0->vertex();
+                           olds[1] = h1->vertex();
+                           olds[2] = h0->is_border() ?
+                             h0->next()->next()->vertex() :
+                             h0->opposite()->prev()->prev()->opposite()->vertex();
+                           olds[3] = h1->is_border() ?
+                             h1->next()->next()->vertex() :
+                             h1->opposite()->prev()->prev()->opposite()->vertex();
+                           weights = {eta0, eta1, eta2, eta3};
+                           return true;
+                         });
+    return;
+  }
+
+  for (Vertex_handle* v_ptr = edge_first; v_ptr != edge_last; ++v_ptr)
   {
     // The center edge vertex of the current mask
     Vertex_handle v = *v_ptr;
 
     // The edge vertex should be border vertex
-    if (m_ops.get_vertex_border(v))
+    if (takes_part(v))
     {
       // The two outgoing halfedges from v to its old neighbors
       Halfedge_pair hps {Modifier::get_halfedges_to_borders(v)};
@@ -531,11 +1105,6 @@ void Loop_lift_operations<Mesh, Mesh_ops, analysis>::border_edges_to_border_olds
       Vec3 o2 {CGAL::ORIGIN, vo2->point()};
       Vec3 o3 {CGAL::ORIGIN, vo3->point()};
 
-      double eta0 = -0.525336;
-      double eta1 = -0.525336;
-      double eta2 =  0.189068;
-      double eta3 =  0.189068;
-
       if (analysis)
       {
         o0 = o0 - eta0 * e;
@@ -566,18 +1135,93 @@ void Loop_lift_operations<Mesh, Mesh_ops, analysis>::inner_edges_to_inner_olds_d
                                                 const Mesh_ops &m_ops,
                                                 Vertex_handle *first_band,
                                                 Vertex_handle *edge_start,
-                                                Vertex_handle *last_band)
+                                                Vertex_handle *last_band,
+                                                int num_threads,
+                                                const Halfedge_pair* parents)
+{
+  inner_edges_to_inner_olds_dual_if(m_ops,
+                                    edge_start,
+                                    last_band,
+                                    num_threads,
+                                    parents,
+                                    [&m_ops](Vertex_handle v)
+                                    {
+                                      return !m_ops.get_vertex_border(v);
+                                    });
+}
+
+template <class Mesh, class Mesh_ops, bool analysis>
+void Loop_lift_operations<Mesh, Mesh_ops, analysis>::inner_edges_to_inner_olds_dual(
+                                                Mesh &m,
+                                                const Mesh_ops &m_ops,
+                                                Vertex_handle *first,
+                                                Vertex_handle *last,
+                                                int num_threads,
+                                                const Halfedge_pair* parents)
 {
+  inner_edges_to_inner_olds_dual_if(m_ops,
+                                    first,
+                                    last,
+                                    num_threads,
+                                    parents,
+                                    [](Vertex_handle) { return true; });
+}
+
+template <class Mesh, class Mesh_ops, bool analysis>
+template <class Takes_part>
+void Loop_lift_operations<Mesh, Mesh_ops, analysis>::inner_edges_to_inner_olds_dual_if(
+                                                const Mesh_ops &m_ops,
+                                                Vertex_handle *edge_first,
+                                                Vertex_handle *edge_last,
+                                                int num_threads,
+                                                const Halfedge_pair* parents,
+                                                Takes_part takes_part)
+{
+  if (num_threads > 1)
+  {
+    // Several edge vertices update the same old vertex, use the gather form.
+    edges_to_olds_gather(m_ops,
+                         edge_first,
+                         edge_last,
+                         num_threads,
+                         [&m_ops, &takes_part, parents](Vertex_handle v,
+                                                        int i,
+                                                        std::array<Vertex_handle, 4>& olds,
+                                                        std::array<FT, 4>& weights)
+                         {
+                           if (!takes_part(v))
+                           {
+                             return false;
+                           }
+                           Halfedge_pair hps {parents ?
+                                              parents[i] :
+                                              Modifier::get_halfedges_to_old_vertices(v, m_ops)};
+                           olds[0] = hps.first->vertex();
+                           olds[1] = hps.second->vertex();
+                           olds[2] = opposite_vertex(hps.first);
+                           olds[3] = opposite_vertex(hps.second);
+                           typename Math::Vector4 ws {Math::get_cached_weight(olds[0]->degree(),
+                                                                              olds[1]->degree(),
+                                                                              olds[2]->degree(),
+                                                                              olds[3]->degree())};
+                           weights = {ws[0], ws[1], ws[2], ws[3]};
+                           return true;
+                         });
+    return;
+  }
+
   // Using inner edge vertices to modify old vertices on Loop mask.
-  for (Vertex_handle* v_ptr = edge_start; v_ptr != last_band; ++v_ptr)
+  for (Vertex_handle* v_ptr = edge_first; v_ptr != edge_last; ++v_ptr)
   {
     // The center edge vertex of the current mask
     Vertex_handle v = *v_ptr;
 
     // The edge vertex should be interior vertex
-    if (!m_ops.get_vertex_border(v))
+    if (takes_part(v))
     {
-      Halfedge_pair hps {Modifier::get_halfedges_to_old_vertices(v, m_ops)};
+      Halfedge_pair hps {parents ?
+                         parents[v_ptr - edge_first] :
+                         Modifier::get_halfedges_to_old_vertices(v, m_ops)};
       Halfedge_handle h0 = hps.first;
       Halfedge_handle h1 = hps.second;
 
@@ -601,15 +1245,15 @@ void Loop_lift_operations<Mesh, Mesh_ops, analysis>::inner_edges_to_inner_olds_d
       Vec3 o3 {CGAL::ORIGIN, vo3->point()};
 
       // Calculated weights at old vertices
-      Eigen::Vector4d ws {Loop_math::get_weight(vo0->degree(),
-                                                vo1->degree(), 
-                                                vo2->degree(), 
-                                                vo3->degree())};
+      typename Math::Vector4 ws {Math::get_cached_weight(vo0->degree(),
+                                                         vo1->degree(), 
+                                                         vo2->degree(), 
+                                                         vo3->degree())};
 
-      double w0 = ws[0];
-      double w1 = ws[1];
-      double w2 = ws[2];
-      double w3 = ws[3];
+      FT w0 = ws[0];
+      FT w1 = ws[1];
+      FT w2 = ws[2];
+      FT w3 = ws[3];
 
       // Geometry at center edge vertex
       Vec3 e {CGAL::ORIGIN, v->point()};
@@ -638,4 +1282,4 @@ void Loop_lift_operations<Mesh, Mesh_ops, analysis>::inner_edges_to_inner_olds_d
 }
 }  // namespace wtlib::ptq_impl
 
-#endif  // define PTQ_IMPL_LOOP_ANALYSIS_OPERATIONS_HPP
\ No newline at end of file
+#endif  // define PTQ_IMPL_LOOP_ANALYSIS_OPERATIONS_HPP
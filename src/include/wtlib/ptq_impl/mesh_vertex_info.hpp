@@ -130,5 +130,69 @@ private:
 #endif
 };  // define class Mesh_info
 
+
+/**
+ * @brief    Mesh operations reading and writing a Mesh_info directly.
+ *
+ * Unlike a Wavelet_mesh_operations built from std::function objects, the
+ * accessors are plain member functions, so the compiler can inline them into
+ * the lifting loops. The Mesh_info must outlive the operations.
+ */
+template <class M>
+class Mesh_info_operations
+{
+public:
+  using Mesh = M;
+  using Vertex_const_handle = typename Mesh::Vertex_const_handle;
+  using Vertex_handle = typename Mesh::Vertex_handle;
+
+  explicit Mesh_info_operations(Mesh_info<Mesh>* mesh_info)
+  : mesh_info_(mesh_info)
+  {}
+
+  int get_vertex_id(Vertex_const_handle v) const
+  {
+    return mesh_info_->get_vertex_id(v);
+  }
+
+  void set_vertex_id(Vertex_handle v, int id) const
+  {
+    mesh_info_->set_vertex_id(v, id);
+  }
+
+  int get_vertex_level(Vertex_const_handle v) const
+  {
+    return mesh_info_->get_vertex_level(v);
+  }
+
+  void set_vertex_level(Vertex_handle v, int level) const
+  {
+    mesh_info_->set_vertex_level(v, level);
+  }
+
+  int get_vertex_type(Vertex_const_handle v) const
+  {
+    return mesh_info_->get_vertex_type(v);
+  }
+
+  void set_vertex_type(Vertex_handle v, int type) const
+  {
+    mesh_info_->set_vertex_type(v, type);
+  }
+
+  bool get_vertex_border(Vertex_const_handle v) const
+  {
+    return mesh_info_->get_vertex_border(v);
+  }
+
+  void set_vertex_border(Vertex_handle v, bool border) const
+  {
+    mesh_info_->set_vertex_border(v, border);
+  }
+
+private:
+  Mesh_info<Mesh>* mesh_info_;
+};  // class Mesh_info_operations
+
 }  // define wtlib::ptq_impl
 #endif   // define PTQ_IMPL_MESH_VERTEX_INFO_HPP
\ No newline at end of file
@@ -0,0 +1,129 @@
+#ifndef PTQ_IMPL_PARALLEL_FOR_HPP
+#define PTQ_IMPL_PARALLEL_FOR_HPP
+
+/**
+ * @file     parallel_for.hpp
+ * @brief    Defines a minimal fork-join loop used by the parallel lifting
+ *           steps.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace wtlib::ptq_impl
+{
+/**
+ * @brief      Resolve a requested number of threads.
+ *
+ * @param[in]  num_threads  The requested number of threads, a value less than
+ *                          1 selects the number of hardware threads.
+ *
+ * @return     The number of threads to use, at least 1.
+ */
+inline int get_num_threads(int num_threads)
+{
+  if (num_threads > 0)
+  {
+    return num_threads;
+  }
+  int hardware_threads = static_cast<int>(std::thread::hardware_concurrency());
+  return hardware_threads > 0 ? hardware_threads : 1;
+}
+
+/**
+ * @brief      Split the range [first, last) into contiguous chunks and call
+ *             f(chunk_first, chunk_last) for each chunk on its own thread. The
+ *             calling thread processes the first chunk. A range too small to
+ *             be worth splitting is processed by the calling thread alone.
+ *
+ * @param[in]  first        The first element, an index or a random access
+ *                          iterator.
+ * @param[in]  last         One past the last element.
+ * @param[in]  num_threads  The maximum number of threads.
+ * @param[in]  f            The function, it must be safe to call it on
+ *                          disjoint chunks concurrently.
+ */
+template <class Iterator, class Function>
+void parallel_for(Iterator first, Iterator last, int num_threads, Function f)
+{
+  // Below this many elements per thread, spawning threads costs more than it
+  // saves.
+  const std::ptrdiff_t min_chunk_size = 256;
+
+  std::ptrdiff_t size = last - first;
+  std::ptrdiff_t num_chunks = std::min<std::ptrdiff_t>(num_threads,
+                                                       size / min_chunk_size);
+  if (num_chunks <= 1)
+  {
+    f(first, last);
+    return;
+  }
+
+  std::vector<std::pair<Iterator, Iterator>> chunks;
+  chunks.reserve(num_chunks);
+  std::ptrdiff_t chunk_size = size / num_chunks;
+  std::ptrdiff_t remainder = size % num_chunks;
+  Iterator chunk_first = first;
+  for (std::ptrdiff_t i = 0; i < num_chunks; ++i)
+  {
+    Iterator chunk_last = chunk_first + (chunk_size + (i < remainder ? 1 : 0));
+    chunks.emplace_back(chunk_first, chunk_last);
+    chunk_first = chunk_last;
+  }
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_chunks - 1);
+  for (std::ptrdiff_t i = 1; i < num_chunks; ++i)
+  {
+    threads.emplace_back(f, chunks[i].first, chunks[i].second);
+  }
+  f(chunks[0].first, chunks[0].second);
+  for (std::thread& t : threads)
+  {
+    t.join();
+  }
+}
+
+/**
+ * @brief      Call f(i) for every index i in [0, size), on up to num_threads
+ *             threads that take the next index as they become free. Unlike
+ *             parallel_for, it suits a few tasks of very different costs. The
+ *             calling thread takes part.
+ *
+ * @param[in]  size         The number of tasks.
+ * @param[in]  num_threads  The maximum number of threads.
+ * @param[in]  f            The function, it must be safe to call it on
+ *                          different indices concurrently.
+ */
+template <class Function>
+void parallel_for_each_index(int size, int num_threads, Function f)
+{
+  std::atomic<int> next {0};
+  auto run = [&next, size, &f]()
+             {
+               for (int i = next++; i < size; i = next++)
+               {
+                 f(i);
+               }
+             };
+
+  int num_workers = std::min(num_threads, size);
+  std::vector<std::thread> threads;
+  threads.reserve(std::max(num_workers - 1, 0));
+  for (int i = 1; i < num_workers; ++i)
+  {
+    threads.emplace_back(run);
+  }
+  run();
+  for (std::thread& t : threads)
+  {
+    t.join();
+  }
+}
+}  // namespace wtlib::ptq_impl
+
+#endif  // define PTQ_IMPL_PARALLEL_FOR_HPP
@@ -0,0 +1,1114 @@
+#ifndef PTQ_IMPL_SIMD_LIFTING_KERNELS_HPP
+#define PTQ_IMPL_SIMD_LIFTING_KERNELS_HPP
+
+/**
+ * @file     simd_lifting_kernels.hpp
+ * @brief    Defines the kernels applying the flattened lifting stencils to
+ *           channel arrays, with AVX2 and AVX-512 versions for double
+ *           channels selected at runtime.
+ *
+ * A kernel evaluates a stencil with the same operations, in the same order,
+ * as the lifting step on a mesh. The vector versions evaluate several
+ * stencils at once, gathering the neighbour values by index, and use no
+ * fused multiply-add, so all versions give bit-identical results and the
+ * scalar version can be used to validate the others (see set_simd_isa).
+ *
+ * Define WTLIB_DISABLE_SIMD to only build the scalar version.
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#if !defined (WTLIB_DISABLE_SIMD) && defined (__GNUC__) && \
+    (defined (__x86_64__) || defined (__i386__))
+#define WTLIB_USE_X86_SIMD
+#include <immintrin.h>
+#define WTLIB_TARGET_AVX2 __attribute__((target("avx2")))
+#define WTLIB_TARGET_AVX512 __attribute__((target("avx2,avx512f")))
+#endif
+
+namespace wtlib::ptq_impl
+{
+/**
+ * @brief    The instruction sets of the lifting kernels, from the narrowest
+ *           to the widest.
+ */
+enum class Simd_isa
+{
+  scalar = 0,
+  avx2 = 1,
+  avx512 = 2
+};
+
+/**
+ * @brief      The widest instruction set supported by both the build and the
+ *             CPU.
+ */
+inline Simd_isa supported_simd_isa()
+{
+#if defined (WTLIB_USE_X86_SIMD)
+  static const Simd_isa isa = []
+  {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2"))
+    {
+      return Simd_isa::avx512;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+      return Simd_isa::avx2;
+    }
+    return Simd_isa::scalar;
+  }();
+  return isa;
+#else
+  return Simd_isa::scalar;
+#endif
+}
+
+inline std::atomic<Simd_isa>& simd_isa_selection()
+{
+  static std::atomic<Simd_isa> isa {supported_simd_isa()};
+  return isa;
+}
+
+/**
+ * @brief      The instruction set used by the lifting kernels, the widest
+ *             supported one unless set_simd_isa selected another.
+ */
+inline Simd_isa simd_isa()
+{
+  return simd_isa_selection().load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief      Select the instruction set used by the lifting kernels (e.g.,
+ *             Simd_isa::scalar to validate the vector kernels).
+ *
+ * @param[in]  isa   The instruction set, narrowed to the widest supported
+ *                   one.
+ *
+ * @return     The selected instruction set.
+ */
+inline Simd_isa set_simd_isa(Simd_isa isa)
+{
+  isa = std::min(isa, supported_simd_isa());
+  simd_isa_selection().store(isa, std::memory_order_relaxed);
+  return isa;
+}
+
+/**
+ * @brief    The value arrays of the channels lifted together (e.g., the x, y
+ *           and z coordinates), each indexed by vertex id.
+ */
+template <class FT>
+using Channel_arrays = std::vector<FT*>;
+
+/**
+ * @brief    The number of channels whose accumulators the vector kernels
+ *           keep in registers at once.
+ */
+constexpr std::size_t channels_per_pass = 3;
+
+/**
+ * @brief    The vertex ids of a set of fixed size stencils, column k holds
+ *           the k-th vertex of every stencil.
+ */
+template <std::size_t N>
+using Id_columns = std::array<std::vector<int>, N>;
+
+/**
+ * @brief    The updates of a scatter lifting step (each edge vertex updates
+ *           several old vertices), grouped by the updated old vertex.
+ *
+ * The updates of an old vertex are kept in the order of the edge vertices,
+ * so applying them reproduces the scatter step exactly.
+ *
+ * @tparam   FT    The scalar type of the weights.
+ */
+template <class FT>
+class Gather_stencil
+{
+public:
+  /**
+   * @brief      Group the updates of a scatter step.
+   *
+   * @param[in]  num_ids   The number of vertex ids.
+   * @param[in]  stencils  The edge vertex followed by the N old vertices it
+   *                       updates, for every edge vertex.
+   * @param[in]  weights   The weights of the N old vertices of every edge
+   *                       vertex.
+   */
+  template <std::size_t M, std::size_t N>
+  void build(int num_ids,
+             const std::vector<std::array<int, M>>& stencils,
+             const std::vector<std::array<FT, N>>& weights)
+  {
+    static_assert(M == N + 1, "A stencil is an edge vertex and N olds");
+
+    // A step reading all its old vertices before writing them keeps only the
+    // last write of a repeated vertex.
+    auto is_last = [](const std::array<int, M>& s, std::size_t k)
+    {
+      for (std::size_t l = k + 1; l < M; ++l)
+      {
+        if (s[l] == s[k])
+        {
+          return false;
+        }
+      }
+      return true;
+    };
+
+    std::vector<int> counts(num_ids, 0);
+    for (const std::array<int, M>& s : stencils)
+    {
+      for (std::size_t k = 1; k < M; ++k)
+      {
+        if (is_last(s, k))
+        {
+          ++counts[s[k]];
+        }
+      }
+    }
+
+    targets_.clear();
+    offsets_.assign(1, 0);
+    std::vector<int> next(num_ids, -1);
+    for (int id = 0; id < num_ids; ++id)
+    {
+      if (counts[id] > 0)
+      {
+        next[id] = offsets_.back();
+        targets_.push_back(id);
+        offsets_.push_back(offsets_.back() + counts[id]);
+      }
+    }
+
+    sources_.resize(offsets_.back());
+    weights_.resize(offsets_.back());
+    for (std::size_t i = 0; i < stencils.size(); ++i)
+    {
+      const std::array<int, M>& s = stencils[i];
+      for (std::size_t k = 1; k < M; ++k)
+      {
+        if (is_last(s, k))
+        {
+          int c = next[s[k]]++;
+          sources_[c] = s[0];
+          weights_[c] = weights[i][k - 1];
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief      Keep the updates of the old vertices of g whose ids are in
+   *             [first_id, last_id).
+   */
+  void assign(const Gather_stencil& g, int first_id, int last_id)
+  {
+    auto first = std::lower_bound(g.targets_.begin(), g.targets_.end(),
+                                  first_id);
+    auto last = std::lower_bound(first, g.targets_.end(), last_id);
+    const int i0 = first - g.targets_.begin();
+    const int i1 = last - g.targets_.begin();
+    const int c0 = g.offsets_[i0];
+    const int c1 = g.offsets_[i1];
+
+    targets_.assign(first, last);
+    offsets_.clear();
+    for (int i = i0; i <= i1; ++i)
+    {
+      offsets_.push_back(g.offsets_[i] - c0);
+    }
+    sources_.assign(g.sources_.begin() + c0, g.sources_.begin() + c1);
+    weights_.assign(g.weights_.begin() + c0, g.weights_.begin() + c1);
+  }
+
+  int size() const
+  {
+    return targets_.size();
+  }
+
+  /**
+   * @brief      The updated old vertices, the updates of targets()[i] are
+   *             offsets()[i] ... offsets()[i + 1] - 1.
+   */
+  const std::vector<int>& targets() const
+  {
+    return targets_;
+  }
+
+  const std::vector<int>& offsets() const
+  {
+    return offsets_;
+  }
+
+  const std::vector<int>& sources() const
+  {
+    return sources_;
+  }
+
+  const std::vector<FT>& weights() const
+  {
+    return weights_;
+  }
+
+private:
+  std::vector<int> targets_;
+  std::vector<int> offsets_;
+  std::vector<int> sources_;
+  std::vector<FT> weights_;
+};  // class Gather_stencil
+
+#if defined (WTLIB_USE_X86_SIMD)
+/**
+ * @brief    The AVX2 lifting kernels on double channels. A kernel
+ *           processes the stencils in blocks of four and returns the number
+ *           of processed stencils, the caller processes the rest.
+ */
+class Avx2_lifting_kernels
+{
+public:
+  template <bool analysis>
+  WTLIB_TARGET_AVX2
+  static int loop_border_edges_to_border_olds(
+                                        const Channel_arrays<double>& x,
+                                        const Id_columns<3>& s)
+  {
+    const int n = s[0].size() / 4 * 4;
+    const __m256d quarter = _mm256_set1_pd(0.25);
+    const __m256d two = _mm256_set1_pd(2.0);
+    for (int i = 0; i < n; i += 4)
+    {
+      __m128i vo = load_ids(&s[0][i]);
+      __m128i e0 = load_ids(&s[1][i]);
+      __m128i e1 = load_ids(&s[2][i]);
+      for (double* a : x)
+      {
+        __m256d res = gather(a, vo);
+        __m256d sum = _mm256_add_pd(gather(a, e0), gather(a, e1));
+        if (analysis)
+        {
+          res = _mm256_sub_pd(res, _mm256_mul_pd(quarter, sum));
+          res = _mm256_mul_pd(res, two);
+        }
+        else
+        {
+          res = _mm256_div_pd(res, two);
+          res = _mm256_add_pd(res, _mm256_mul_pd(quarter, sum));
+        }
+        scatter(a, &s[0][i], res);
+      }
+    }
+    return n;
+  }
+
+  template <bool analysis>
+  WTLIB_TARGET_AVX2
+  static int loop_border_olds_to_border_edges(
+                                        const Channel_arrays<double>& x,
+                                        const Id_columns<3>& s)
+  {
+    const int n = s[0].size() / 4 * 4;
+    const __m256d half = _mm256_set1_pd(0.5);
+    for (int i = 0; i < n; i += 4)
+    {
+      __m128i ve = load_ids(&s[0][i]);
+      __m128i o0 = load_ids(&s[1][i]);
+      __m128i o1 = load_ids(&s[2][i]);
+      for (double* a : x)
+      {
+        __m256d res = gather(a, ve);
+        __m256d sum = _mm256_mul_pd(half,
+                                    _mm256_add_pd(gather(a, o0), gather(a, o1)));
+        res = analysis ? _mm256_sub_pd(res, sum) : _mm256_add_pd(res, sum);
+        scatter(a, &s[0][i], res);
+      }
+    }
+    return n;
+  }
+
+  template <bool analysis>
+  WTLIB_TARGET_AVX2
+  static int loop_inner_edges_to_inner_olds(const Channel_arrays<double>& x,
+                                            const std::vector<int>& olds,
+                                            const std::vector<int>& offsets,
+                                            const std::vector<int>& rings,
+                                            const std::vector<double>& deltas,
+                                            const std::vector<double>& betas)
+  {
+    const int n = olds.size() / 4 * 4;
+    for (int i = 0; i < n; i += 4)
+    {
+      __m128i vo = load_ids(&olds[i]);
+      __m128i first = load_ids(&offsets[i]);
+      __m128i size = _mm_sub_epi32(load_ids(&offsets[i + 1]), first);
+      int max_size = max_range(&offsets[i]);
+
+      for (std::size_t c0 = 0; c0 < x.size(); c0 += channels_per_pass)
+      {
+        const std::size_t num_channels = std::min(x.size() - c0,
+                                                  channels_per_pass);
+
+        // Sum the rings of the four old vertices, each in its own order.
+        __m256d sums[channels_per_pass];
+        for (std::size_t c = 0; c < num_channels; ++c)
+        {
+          sums[c] = _mm256_setzero_pd();
+        }
+        for (int j = 0; j < max_size; ++j)
+        {
+          __m128i active = _mm_cmpgt_epi32(size, _mm_set1_epi32(j));
+          __m256d mask = to_mask(active);
+          __m128i ids = _mm_mask_i32gather_epi32(_mm_setzero_si128(),
+                                                 rings.data(),
+                                                 _mm_add_epi32(first, _mm_set1_epi32(j)),
+                                                 active,
+                                                 4);
+          for (std::size_t c = 0; c < num_channels; ++c)
+          {
+            __m256d e = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), x[c0 + c], ids, mask, 8);
+            sums[c] = _mm256_blendv_pd(sums[c], _mm256_add_pd(sums[c], e), mask);
+          }
+        }
+
+        __m256d delta = _mm256_loadu_pd(&deltas[i]);
+        __m256d beta = _mm256_loadu_pd(&betas[i]);
+        for (std::size_t c = 0; c < num_channels; ++c)
+        {
+          __m256d o = gather(x[c0 + c], vo);
+          if (analysis)
+          {
+            o = _mm256_sub_pd(o, _mm256_mul_pd(delta, sums[c]));
+            o = _mm256_div_pd(o, beta);
+          }
+          else
+          {
+            o = _mm256_mul_pd(o, beta);
+            o = _mm256_add_pd(o, _mm256_mul_pd(delta, sums[c]));
+          }
+          scatter(x[c0 + c], &olds[i], o);
+        }
+      }
+    }
+    return n;
+  }
+
+  template <bool analysis>
+  WTLIB_TARGET_AVX2
+  static int loop_inner_olds_to_inner_edges(const Channel_arrays<double>& x,
+                                            const Id_columns<5>& s)
+  {
+    const int n = s[0].size() / 4 * 4;
+    const __m256d w01 = _mm256_set1_pd(0.375);
+    const __m256d w23 = _mm256_set1_pd(0.125);
+    for (int i = 0; i < n; i += 4)
+    {
+      __m128i ve = load_ids(&s[0][i]);
+      __m128i o0 = load_ids(&s[1][i]);
+      __m128i o1 = load_ids(&s[2][i]);
+      __m128i o2 = load_ids(&s[3][i]);
+      __m128i o3 = load_ids(&s[4][i]);
+      for (double* a : x)
+      {
+        __m256d e = gather(a, ve);
+        __m256d s01 = _mm256_mul_pd(w01,
+                                    _mm256_add_pd(gather(a, o0), gather(a, o1)));
+        __m256d s23 = _mm256_mul_pd(w23,
+                                    _mm256_add_pd(gather(a, o2), gather(a, o3)));
+        if (analysis)
+        {
+          e = _mm256_sub_pd(_mm256_sub_pd(e, s01), s23);
+        }
+        else
+        {
+          e = _mm256_add_pd(_mm256_add_pd(e, s01), s23);
+        }
+        scatter(a, &s[0][i], e);
+      }
+    }
+    return n;
+  }
+
+  template <bool analysis>
+  WTLIB_TARGET_AVX2
+  static int edges_to_olds(const Channel_arrays<double>& x,
+                           const Gather_stencil<double>& g)
+  {
+    const int n = g.size() / 4 * 4;
+    const std::vector<int>& offsets = g.offsets();
+    for (int i = 0; i < n; i += 4)
+    {
+      __m128i vo = load_ids(&g.targets()[i]);
+      __m128i first = load_ids(&offsets[i]);
+      __m128i size = _mm_sub_epi32(load_ids(&offsets[i + 1]), first);
+      int max_size = max_range(&offsets[i]);
+
+      for (std::size_t c0 = 0; c0 < x.size(); c0 += channels_per_pass)
+      {
+        const std::size_t num_channels = std::min(x.size() - c0,
+                                                  channels_per_pass);
+
+        __m256d olds[channels_per_pass];
+        for (std::size_t c = 0; c < num_channels; ++c)
+        {
+          olds[c] = gather(x[c0 + c], vo);
+        }
+        for (int j = 0; j < max_size; ++j)
+        {
+          __m128i active = _mm_cmpgt_epi32(size, _mm_set1_epi32(j));
+          __m256d mask = to_mask(active);
+          __m128i updates = _mm_add_epi32(first, _mm_set1_epi32(j));
+          __m128i ids = _mm_mask_i32gather_epi32(_mm_setzero_si128(),
+                                                 g.sources().data(),
+                                                 updates,
+                                                 active,
+                                                 4);
+          __m256d w = _mm256_mask_i32gather_pd(_mm256_setzero_pd(),
+                                               g.weights().data(),
+                                               updates,
+                                               mask,
+                                               8);
+          for (std::size_t c = 0; c < num_channels; ++c)
+          {
+            __m256d e = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), x[c0 + c], ids, mask, 8);
+            __m256d o = analysis ?
+                          _mm256_sub_pd(olds[c], _mm256_mul_pd(w, e)) :
+                          _mm256_add_pd(olds[c], _mm256_mul_pd(w, e));
+            olds[c] = _mm256_blendv_pd(olds[c], o, mask);
+          }
+        }
+        for (std::size_t c = 0; c < num_channels; ++c)
+        {
+          scatter(x[c0 + c], &g.targets()[i], olds[c]);
+        }
+      }
+    }
+    return n;
+  }
+
+  template <bool analysis>
+  WTLIB_TARGET_AVX2
+  static int butterfly_olds_to_edges(const Channel_arrays<double>& x,
+                                     const Id_columns<9>& s)
+  {
+    const int n = s[0].size() / 4 * 4;
+    const __m256d wa = _mm256_set1_pd(0.5);
+    const __m256d wb = _mm256_set1_pd(0.125);
+    const __m256d wc = _mm256_set1_pd(0.0625);
+    for (int i = 0; i < n; i += 4)
+    {
+      __m128i ids[9];
+      for (int k = 0; k < 9; ++k)
+      {
+        ids[k] = load_ids(&s[k][i]);
+      }
+      for (double* a : x)
+      {
+        __m256d ve = gather(a, ids[0]);
+        __m256d sa = _mm256_mul_pd(wa, _mm256_add_pd(gather(a, ids[1]),
+                                                     gather(a, ids[2])));
+        __m256d sb = _mm256_mul_pd(wb, _mm256_add_pd(gather(a, ids[3]),
+                                                     gather(a, ids[4])));
+        __m256d sc = _mm256_add_pd(gather(a, ids[5]), gather(a, ids[6]));
+        sc = _mm256_add_pd(sc, gather(a, ids[7]));
+        sc = _mm256_mul_pd(wc, _mm256_add_pd(sc, gather(a, ids[8])));
+        if (analysis)
+        {
+          ve = _mm256_add_pd(_mm256_sub_pd(_mm256_sub_pd(ve, sa), sb), sc);
+        }
+        else
+        {
+          ve = _mm256_sub_pd(_mm256_add_pd(_mm256_add_pd(ve, sa), sb), sc);
+        }
+        scatter(a, &s[0][i], ve);
+      }
+    }
+    return n;
+  }
+
+private:
+  WTLIB_TARGET_AVX2
+  static __m128i load_ids(const int* ids)
+  {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(ids));
+  }
+
+  WTLIB_TARGET_AVX2
+  static __m256d gather(const double* a, __m128i ids)
+  {
+    return _mm256_i32gather_pd(a, ids, 8);
+  }
+
+  WTLIB_TARGET_AVX2
+  static void scatter(double* a, const int* ids, __m256d v)
+  {
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, v);
+    for (int k = 0; k < 4; ++k)
+    {
+      a[ids[k]] = lanes[k];
+    }
+  }
+
+  WTLIB_TARGET_AVX2
+  static __m256d to_mask(__m128i active)
+  {
+    return _mm256_castsi256_pd(_mm256_cvtepi32_epi64(active));
+  }
+
+  // The largest of the four ranges offsets[k] ... offsets[k + 1].
+  static int max_range(const int* offsets)
+  {
+    int size = 0;
+    for (int k = 0; k < 4; ++k)
+    {
+      size = std::max(size, offsets[k + 1] - offsets[k]);
+    }
+    return size;
+  }
+};  // class Avx2_lifting_kernels
+
+/**
+ * @brief    The AVX-512 lifting kernels on double channels, processing
+ *           the stencils in blocks of eight.
+ *
+ * The arithmetic uses the explicit rounding intrinsics, which the compiler
+ * never contracts into fused multiply-adds.
+ *
+ * @see      Avx2_lifting_kernels
+ */
+class Avx512_lifting_kernels
+{
+public:
+  template <bool analysis>
+  WTLIB_TARGET_AVX512
+  static int loop_border_edges_to_border_olds(
+                                        const Channel_arrays<double>& x,
+                                        const Id_columns<3>& s)
+  {
+    const int n = s[0].size() / 8 * 8;
+    const __m512d quarter = _mm512_set1_pd(0.25);
+    const __m512d two = _mm512_set1_pd(2.0);
+    for (int i = 0; i < n; i += 8)
+    {
+      __m256i vo = load_ids(&s[0][i]);
+      __m256i e0 = load_ids(&s[1][i]);
+      __m256i e1 = load_ids(&s[2][i]);
+      for (double* a : x)
+      {
+        __m512d res = gather(a, vo);
+        __m512d sum = add(gather(a, e0), gather(a, e1));
+        if (analysis)
+        {
+          res = mul(sub(res, mul(quarter, sum)), two);
+        }
+        else
+        {
+          res = add(div(res, two), mul(quarter, sum));
+        }
+        _mm512_i32scatter_pd(a, vo, res, 8);
+      }
+    }
+    return n;
+  }
+
+  template <bool analysis>
+  WTLIB_TARGET_AVX512
+  static int loop_border_olds_to_border_edges(
+                                        const Channel_arrays<double>& x,
+                                        const Id_columns<3>& s)
+  {
+    const int n = s[0].size() / 8 * 8;
+    const __m512d half = _mm512_set1_pd(0.5);
+    for (int i = 0; i < n; i += 8)
+    {
+      __m256i ve = load_ids(&s[0][i]);
+      __m256i o0 = load_ids(&s[1][i]);
+      __m256i o1 = load_ids(&s[2][i]);
+      for (double* a : x)
+      {
+        __m512d res = gather(a, ve);
+        __m512d sum = mul(half, add(gather(a, o0), gather(a, o1)));
+        res = analysis ? sub(res, sum) : add(res, sum);
+        _mm512_i32scatter_pd(a, ve, res, 8);
+      }
+    }
+    return n;
+  }
+
+  template <bool analysis>
+  WTLIB_TARGET_AVX512
+  static int loop_inner_edges_to_inner_olds(const Channel_arrays<double>& x,
+                                            const std::vector<int>& olds,
+                                            const std::vector<int>& offsets,
+                                            const std::vector<int>& rings,
+                                            const std::vector<double>& deltas,
+                                            const std::vector<double>& betas)
+  {
+    const int n = olds.size() / 8 * 8;
+    for (int i = 0; i < n; i += 8)
+    {
+      __m256i vo = load_ids(&olds[i]);
+      __m256i first = load_ids(&offsets[i]);
+      __m256i size = _mm256_sub_epi32(load_ids(&offsets[i + 1]), first);
+      int max_size = max_range(&offsets[i]);
+
+      for (std::size_t c0 = 0; c0 < x.size(); c0 += channels_per_pass)
+      {
+        const std::size_t num_channels = std::min(x.size() - c0,
+                                                  channels_per_pass);
+
+        __m512d sums[channels_per_pass];
+        for (std::size_t c = 0; c < num_channels; ++c)
+        {
+          sums[c] = _mm512_setzero_pd();
+        }
+        for (int j = 0; j < max_size; ++j)
+        {
+          __m256i active = _mm256_cmpgt_epi32(size, _mm256_set1_epi32(j));
+          __mmask8 mask = to_mask(active);
+          __m256i ids = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(),
+                                                    rings.data(),
+                                                    _mm256_add_epi32(first, _mm256_set1_epi32(j)),
+                                                    active,
+                                                    4);
+          for (std::size_t c = 0; c < num_channels; ++c)
+          {
+            __m512d e = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), mask, ids, x[c0 + c], 8);
+            sums[c] = _mm512_mask_add_round_pd(sums[c], mask, sums[c], e,
+                                               _MM_FROUND_CUR_DIRECTION);
+          }
+        }
+
+        __m512d delta = _mm512_loadu_pd(&deltas[i]);
+        __m512d beta = _mm512_loadu_pd(&betas[i]);
+        for (std::size_t c = 0; c < num_channels; ++c)
+        {
+          __m512d o = gather(x[c0 + c], vo);
+          if (analysis)
+          {
+            o = div(sub(o, mul(delta, sums[c])), beta);
+          }
+          else
+          {
+            o = add(mul(o, beta), mul(delta, sums[c]));
+          }
+          _mm512_i32scatter_pd(x[c0 + c], vo, o, 8);
+        }
+      }
+    }
+    return n;
+  }
+
+  template <bool analysis>
+  WTLIB_TARGET_AVX512
+  static int loop_inner_olds_to_inner_edges(const Channel_arrays<double>& x,
+                                            const Id_columns<5>& s)
+  {
+    const int n = s[0].size() / 8 * 8;
+    const __m512d w01 = _mm512_set1_pd(0.375);
+    const __m512d w23 = _mm512_set1_pd(0.125);
+    for (int i = 0; i < n; i += 8)
+    {
+      __m256i ve = load_ids(&s[0][i]);
+      __m256i o0 = load_ids(&s[1][i]);
+      __m256i o1 = load_ids(&s[2][i]);
+      __m256i o2 = load_ids(&s[3][i]);
+      __m256i o3 = load_ids(&s[4][i]);
+      for (double* a : x)
+      {
+        __m512d e = gather(a, ve);
+        __m512d s01 = mul(w01, add(gather(a, o0), gather(a, o1)));
+        __m512d s23 = mul(w23, add(gather(a, o2), gather(a, o3)));
+        e = analysis ? sub(sub(e, s01), s23) : add(add(e, s01), s23);
+        _mm512_i32scatter_pd(a, ve, e, 8);
+      }
+    }
+    return n;
+  }
+
+  template <bool analysis>
+  WTLIB_TARGET_AVX512
+  static int edges_to_olds(const Channel_arrays<double>& x,
+                           const Gather_stencil<double>& g)
+  {
+    const int n = g.size() / 8 * 8;
+    const std::vector<int>& offsets = g.offsets();
+    for (int i = 0; i < n; i += 8)
+    {
+      __m256i vo = load_ids(&g.targets()[i]);
+      __m256i first = load_ids(&offsets[i]);
+      __m256i size = _mm256_sub_epi32(load_ids(&offsets[i + 1]), first);
+      int max_size = max_range(&offsets[i]);
+
+      for (std::size_t c0 = 0; c0 < x.size(); c0 += channels_per_pass)
+      {
+        const std::size_t num_channels = std::min(x.size() - c0,
+                                                  channels_per_pass);
+
+        __m512d olds[channels_per_pass];
+        for (std::size_t c = 0; c < num_channels; ++c)
+        {
+          olds[c] = gather(x[c0 + c], vo);
+        }
+        for (int j = 0; j < max_size; ++j)
+        {
+          __m256i active = _mm256_cmpgt_epi32(size, _mm256_set1_epi32(j));
+          __mmask8 mask = to_mask(active);
+          __m256i updates = _mm256_add_epi32(first, _mm256_set1_epi32(j));
+          __m256i ids = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(),
+                                                    g.sources().data(),
+                                                    updates,
+                                                    active,
+                                                    4);
+          __m512d w = _mm512_mask_i32gather_pd(_mm512_setzero_pd(),
+                                               mask,
+                                               updates,
+                                               g.weights().data(),
+                                               8);
+          for (std::size_t c = 0; c < num_channels; ++c)
+          {
+            __m512d e = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), mask, ids, x[c0 + c], 8);
+            if (analysis)
+            {
+              olds[c] = _mm512_mask_sub_round_pd(olds[c], mask, olds[c], mul(w, e),
+                                                 _MM_FROUND_CUR_DIRECTION);
+            }
+            else
+            {
+              olds[c] = _mm512_mask_add_round_pd(olds[c], mask, olds[c], mul(w, e),
+                                                 _MM_FROUND_CUR_DIRECTION);
+            }
+          }
+        }
+        for (std::size_t c = 0; c < num_channels; ++c)
+        {
+          _mm512_i32scatter_pd(x[c0 + c], vo, olds[c], 8);
+        }
+      }
+    }
+    return n;
+  }
+
+  template <bool analysis>
+  WTLIB_TARGET_AVX512
+  static int butterfly_olds_to_edges(const Channel_arrays<double>& x,
+                                     const Id_columns<9>& s)
+  {
+    const int n = s[0].size() / 8 * 8;
+    const __m512d wa = _mm512_set1_pd(0.5);
+    const __m512d wb = _mm512_set1_pd(0.125);
+    const __m512d wc = _mm512_set1_pd(0.0625);
+    for (int i = 0; i < n; i += 8)
+    {
+      __m256i ids[9];
+      for (int k = 0; k < 9; ++k)
+      {
+        ids[k] = load_ids(&s[k][i]);
+      }
+      for (double* a : x)
+      {
+        __m512d ve = gather(a, ids[0]);
+        __m512d sa = mul(wa, add(gather(a, ids[1]), gather(a, ids[2])));
+        __m512d sb = mul(wb, add(gather(a, ids[3]), gather(a, ids[4])));
+        __m512d sc = add(add(gather(a, ids[5]), gather(a, ids[6])),
+                         gather(a, ids[7]));
+        sc = mul(wc, add(sc, gather(a, ids[8])));
+        ve = analysis ? add(sub(sub(ve, sa), sb), sc) :
+                        sub(add(add(ve, sa), sb), sc);
+        _mm512_i32scatter_pd(a, ids[0], ve, 8);
+      }
+    }
+    return n;
+  }
+
+private:
+  WTLIB_TARGET_AVX512
+  static __m256i load_ids(const int* ids)
+  {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ids));
+  }
+
+  WTLIB_TARGET_AVX512
+  static __m512d gather(const double* a, __m256i ids)
+  {
+    return _mm512_i32gather_pd(ids, a, 8);
+  }
+
+  WTLIB_TARGET_AVX512
+  static __mmask8 to_mask(__m256i active)
+  {
+    return static_cast<__mmask8>(
+             _mm256_movemask_ps(_mm256_castsi256_ps(active)));
+  }
+
+  WTLIB_TARGET_AVX512
+  static __m512d add(__m512d a, __m512d b)
+  {
+    return _mm512_add_round_pd(a, b, _MM_FROUND_CUR_DIRECTION);
+  }
+
+  WTLIB_TARGET_AVX512
+  static __m512d sub(__m512d a, __m512d b)
+  {
+    return _mm512_sub_round_pd(a, b, _MM_FROUND_CUR_DIRECTION);
+  }
+
+  WTLIB_TARGET_AVX512
+  static __m512d mul(__m512d a, __m512d b)
+  {
+    return _mm512_mul_round_pd(a, b, _MM_FROUND_CUR_DIRECTION);
+  }
+
+  WTLIB_TARGET_AVX512
+  static __m512d div(__m512d a, __m512d b)
+  {
+    return _mm512_div_round_pd(a, b, _MM_FROUND_CUR_DIRECTION);
+  }
+
+  // The largest of the eight ranges offsets[k] ... offsets[k + 1].
+  static int max_range(const int* offsets)
+  {
+    int size = 0;
+    for (int k = 0; k < 8; ++k)
+    {
+      size = std::max(size, offsets[k + 1] - offsets[k]);
+    }
+    return size;
+  }
+};  // class Avx512_lifting_kernels
+#endif  // defined (WTLIB_USE_X86_SIMD)
+
+/**
+ * @brief    The lifting kernels on channel arrays. Each kernel runs the
+ *           vector kernel of the selected instruction set (double
+ *           channels only) and evaluates the remaining stencils in scalar
+ *           code.
+ *
+ * @tparam   FT    The scalar type of the channels.
+ */
+template <class FT>
+class Lifting_kernels
+{
+public:
+  using Channels = Channel_arrays<FT>;
+
+  /**
+   * @brief      Loop_lift_operations::border_edges_to_border_olds, with the
+   *             stencils {vo, e0, e1}.
+   */
+  template <bool analysis>
+  static void loop_border_edges_to_border_olds(const Channels& x,
+                                               const Id_columns<3>& s)
+  {
+    int first = run_vector_kernel([&](auto kernels)
+    {
+      return decltype(kernels)::template
+               loop_border_edges_to_border_olds<analysis>(x, s);
+    });
+    for (std::size_t i = first; i < s[0].size(); ++i)
+    {
+      for (FT* a : x)
+      {
+        FT res = a[s[0][i]];
+        FT sum = a[s[1][i]] + a[s[2][i]];
+        if (analysis)
+        {
+          res = res - FT(0.25) * sum;
+          res = res * FT(2.0);
+        }
+        else
+        {
+          res = res / FT(2.0);
+          res = res + FT(0.25) * sum;
+        }
+        a[s[0][i]] = res;
+      }
+    }
+  }
+
+  /**
+   * @brief      Loop_lift_operations::border_olds_to_border_edges, with the
+   *             stencils {ve, o0, o1}.
+   */
+  template <bool analysis>
+  static void loop_border_olds_to_border_edges(const Channels& x,
+                                               const Id_columns<3>& s)
+  {
+    int first = run_vector_kernel([&](auto kernels)
+    {
+      return decltype(kernels)::template
+               loop_border_olds_to_border_edges<analysis>(x, s);
+    });
+    for (std::size_t i = first; i < s[0].size(); ++i)
+    {
+      for (FT* a : x)
+      {
+        FT sum = FT(0.5) * (a[s[1][i]] + a[s[2][i]]);
+        a[s[0][i]] = analysis ? a[s[0][i]] - sum : a[s[0][i]] + sum;
+      }
+    }
+  }
+
+  /**
+   * @brief      Loop_lift_operations::inner_edges_to_inner_olds, the ring of
+   *             olds[i] is rings[offsets[i]] ... rings[offsets[i + 1] - 1].
+   */
+  template <bool analysis>
+  static void loop_inner_edges_to_inner_olds(const Channels& x,
+                                             const std::vector<int>& olds,
+                                             const std::vector<int>& offsets,
+                                             const std::vector<int>& rings,
+                                             const std::vector<FT>& deltas,
+                                             const std::vector<FT>& betas)
+  {
+    int first = run_vector_kernel([&](auto kernels)
+    {
+      return decltype(kernels)::template
+               loop_inner_edges_to_inner_olds<analysis>(x,
+                                                        olds,
+                                                        offsets,
+                                                        rings,
+                                                        deltas,
+                                                        betas);
+    });
+    for (std::size_t i = first; i < olds.size(); ++i)
+    {
+      for (FT* a : x)
+      {
+        FT o = a[olds[i]];
+        FT sum = FT(0.0);
+        for (int j = offsets[i]; j < offsets[i + 1]; ++j)
+        {
+          sum = sum + a[rings[j]];
+        }
+        if (analysis)
+        {
+          o = o - deltas[i] * sum;
+          o = o / betas[i];
+        }
+        else
+        {
+          o = o * betas[i];
+          o = o + deltas[i] * sum;
+        }
+        a[olds[i]] = o;
+      }
+    }
+  }
+
+  /**
+   * @brief      Loop_lift_operations::inner_olds_to_inner_edges, with the
+   *             stencils {ve, o0, o1, o2, o3}.
+   */
+  template <bool analysis>
+  static void loop_inner_olds_to_inner_edges(const Channels& x,
+                                             const Id_columns<5>& s)
+  {
+    int first = run_vector_kernel([&](auto kernels)
+    {
+      return decltype(kernels)::template
+               loop_inner_olds_to_inner_edges<analysis>(x, s);
+    });
+    for (std::size_t i = first; i < s[0].size(); ++i)
+    {
+      for (FT* a : x)
+      {
+        FT s01 = FT(0.375) * (a[s[1][i]] + a[s[2][i]]);
+        FT s23 = FT(0.125) * (a[s[3][i]] + a[s[4][i]]);
+        FT e = a[s[0][i]];
+        a[s[0][i]] = analysis ? e - s01 - s23 : e + s01 + s23;
+      }
+    }
+  }
+
+  /**
+   * @brief      A scatter lifting step from edge vertices to old vertices
+   *             (e.g., the dual lifting of the Loop transform), applied in
+   *             its gather form.
+   */
+  template <bool analysis>
+  static void edges_to_olds(const Channels& x, const Gather_stencil<FT>& g)
+  {
+    int first = run_vector_kernel([&](auto kernels)
+    {
+      return decltype(kernels)::template edges_to_olds<analysis>(x, g);
+    });
+    for (int i = first; i < g.size(); ++i)
+    {
+      for (FT* a : x)
+      {
+        FT o = a[g.targets()[i]];
+        for (int c = g.offsets()[i]; c < g.offsets()[i + 1]; ++c)
+        {
+          FT e = a[g.sources()[c]];
+          o = analysis ? o - g.weights()[c] * e : o + g.weights()[c] * e;
+        }
+        a[g.targets()[i]] = o;
+      }
+    }
+  }
+
+  /**
+   * @brief      Butterfly_lift_operations::olds_to_edges, with the stencils
+   *             {e, a0, a1, b0, b1, c0, c1, c2, c3}.
+   */
+  template <bool analysis>
+  static void butterfly_olds_to_edges(const Channels& x,
+                                      const Id_columns<9>& s)
+  {
+    int first = run_vector_kernel([&](auto kernels)
+    {
+      return decltype(kernels)::template
+               butterfly_olds_to_edges<analysis>(x, s);
+    });
+    for (std::size_t i = first; i < s[0].size(); ++i)
+    {
+      for (FT* a : x)
+      {
+        FT sa = FT(0.5) * (a[s[1][i]] + a[s[2][i]]);
+        FT sb = FT(0.125) * (a[s[3][i]] + a[s[4][i]]);
+        FT sc = FT(0.0625) * (a[s[5][i]] + a[s[6][i]] + a[s[7][i]] + a[s[8][i]]);
+        FT ve = a[s[0][i]];
+        a[s[0][i]] = analysis ? ve - sa - sb + sc : ve + sa + sb - sc;
+      }
+    }
+  }
+
+private:
+  /**
+   * @brief      Call kernel(kernels) with the vector kernels of the selected
+   *             instruction set, if any.
+   *
+   * @return     The number of stencils processed by the vector kernel.
+   */
+  template <class Kernel>
+  static int run_vector_kernel(Kernel kernel)
+  {
+#if defined (WTLIB_USE_X86_SIMD)
+    if constexpr (std::is_same<FT, double>::value)
+    {
+      switch (simd_isa())
+      {
+        case Simd_isa::avx512:
+          return kernel(Avx512_lifting_kernels {});
+        case Simd_isa::avx2:
+          return kernel(Avx2_lifting_kernels {});
+        default:
+          break;
+      }
+    }
+#endif
+    return 0;
+  }
+};  // class Lifting_kernels
+}  // namespace wtlib::ptq_impl
+
+#endif  // define PTQ_IMPL_SIMD_LIFTING_KERNELS_HPP
@@ -8,12 +8,18 @@
  *
  */
 
+#include <wtlib/ptq_impl/counting_sort.hpp>
+#include <wtlib/ptq_impl/parallel_for.hpp>
+
+#include <algorithm>
 #include <vector>
-#include <set>
+#include <type_traits>
+#include <utility>
 
 #include <CGAL/HalfedgeDS_decorator.h>
 #include <CGAL/Modifier_base.h>
 #include <CGAL/Origin.h>
+#include <CGAL/Polyhedron_incremental_builder_3.h>
 
 namespace wtlib::ptq_impl
 {
@@ -41,6 +47,15 @@ public:
 
   static int ptq_mesh_size(Mesh& mesh, int num_levels);
 
+  /**
+   * @brief      Reserve the storage of the mesh for num_levels PTQ
+   *             refinements, so the refinements do not grow it level by level.
+   *
+   * @param      mesh        The mesh
+   * @param[in]  num_levels  The number levels
+   */
+  static void reserve(Mesh& mesh, int num_levels);
+
   /**
    * @brief      Helper function to get two outgoing halfedges from a new
    *             vertex to two old vertices.
@@ -53,6 +68,25 @@ public:
   static Halfedge_pair get_halfedges_to_old_vertices(Vertex_handle v,
                                                       const Mesh_ops& m_ops);
 
+  /**
+   * @brief      Overloaded get_halfedges_to_old_vertices for the vertices of
+   *             [first, last), stored by position in the range. The lifting
+   *             steps of a level record them once and look them up instead of
+   *             circulating every edge vertex in every step. The halfedges
+   *             stay valid until the mesh is coarsened or refined.
+   *
+   * @param[in]  first        Start of the vertices
+   * @param[in]  last         End of the vertices
+   * @param[in]  m_ops        The mesh_ops
+   * @param      hps          The two outgoing halfedges of every vertex
+   * @param[in]  num_threads  The number of threads
+   */
+  static void get_halfedges_to_old_vertices(const Vertex_handle* first,
+                                            const Vertex_handle* last,
+                                            const Mesh_ops& m_ops,
+                                            std::vector<Halfedge_pair>& hps,
+                                            int num_threads = 1);
+
   /**
    * @brief      Helper function to get two outgoing halfedges from v to
    *             vertices that are on the border.
@@ -82,7 +116,57 @@ public:
                   std::vector<Vertex_handle*>& bands);
 
   /**
-   * @brief      Coarsen mesh, remove vertices with given level. 
+   * @brief      Refine mesh topology num_levels times at once. The result is
+   *             the same as num_levels calls of refine from level (ids, levels,
+   *             types, borders, bands and facets), but the connectivity of the
+   *             finest level is computed on index arrays by refine_triangles
+   *             and the mesh is rebuilt once, without the intermediate meshes.
+   *             Every vertex handle of the mesh is invalidated, vertices holds
+   *             the new handles on return.
+   *
+   * @param      mesh        Input mesh, the vertex ids are the positions in
+   *                         vertices
+   * @param[in]  mesh_ops    The mesh operations
+   * @param[in]  level       The current resolution level
+   * @param[in]  num_levels  The number of refinements
+   * @param      vertices    The Vertex_handles array, of all the vertices
+   * @param      bands       The vertices band.
+   */
+  static void refine_levels(
+                  Mesh& mesh,
+                  const Mesh_ops& mesh_ops,
+                  int level,
+                  int num_levels,
+                  std::vector<Vertex_handle>& vertices,
+                  std::vector<Vertex_handle*>& bands);
+
+  /**
+   * @brief      Refine a triangle list based on Primal Triangle Quadrisection
+   *             rule, the index form of refine. The edge vertices are numbered
+   *             from num_vertices in the order refine numbers them, and the
+   *             triangles are ordered as refine orders the facets.
+   *
+   * @param      triangles     Three vertex ids per triangle, refined in place
+   * @param[in]  num_vertices  The number of vertices, ids are in
+   *                           [0, num_vertices)
+   * @param      parents       The two end vertices of every edge vertex are
+   *                           appended
+   * @param      borders       The border flag of every vertex, the flags of
+   *                           the edge vertices are appended
+   *
+   * @return     The number of vertices after the refinement.
+   */
+  static int refine_triangles(
+                  std::vector<int>& triangles,
+                  int num_vertices,
+                  std::vector<std::pair<int, int>>& parents,
+                  std::vector<char>& borders);
+
+  /**
+   * @brief      Coarsen mesh, remove vertices with given level. A mesh that
+   *             is its own halfedge data structure (e.g., Compact_mesh) is
+   *             coarsened by coarsen_by_rebuild, other meshes by
+   *             coarsen_by_joins.
    *
    * @param      mesh      The input mesh to be coarsened
    * @param[in]  mesh_ops  The mesh_operations
@@ -93,6 +177,38 @@ public:
                   const Mesh_ops& mesh_ops,
                   int level);
 
+  /**
+   * @brief      Coarsen mesh by joining the facets around every old vertex,
+   *             then joining every vertex of the given level into a
+   *             neighbor. Every remaining handle stays valid.
+   *
+   * @param      mesh      The input mesh to be coarsened
+   * @param[in]  mesh_ops  The mesh_operations
+   * @param[in]  level     The vertices level to be removed.
+   */
+  static void coarsen_by_joins(
+                  Mesh& mesh,
+                  const Mesh_ops& mesh_ops,
+                  int level);
+
+  /**
+   * @brief      Coarsen mesh by collecting the coarse triangles from the
+   *             inner triangles of the refined facets, i.e. the facets whose
+   *             vertices are all of the given level, and rebuilding the
+   *             connectivity in one pass with Mesh::rebuild_triangles. The
+   *             remaining vertex handles stay valid, every halfedge and facet
+   *             handle is invalidated.
+   *
+   * @param      mesh      The input mesh to be coarsened, which is its own
+   *                       halfedge data structure
+   * @param[in]  mesh_ops  The mesh_operations
+   * @param[in]  level     The vertices level to be removed.
+   */
+  static void coarsen_by_rebuild(
+                  Mesh& mesh,
+                  const Mesh_ops& mesh_ops,
+                  int level);
+
 protected:
   /**
    * @brief      This class is used to access Mesh protected member hds
@@ -108,6 +224,24 @@ protected:
     Halfedge_handle h_;
   };  // class Join_vertex
 
+  /**
+   * @brief      Builds a Polyhedron_3 from a triangle list with the
+   *             incremental builder.
+   */
+  class Build_triangles: public CGAL::Modifier_base<typename Mesh::HDS>
+  {
+  public:
+    using Point_3 = typename Mesh::Traits::Point_3;
+
+    Build_triangles(const std::vector<Point_3>& points,
+                    const std::vector<int>& triangles);
+    void operator()(typename Mesh::HDS& hds);
+
+  private:
+    const std::vector<Point_3>& points_;
+    const std::vector<int>& triangles_;
+  };  // class Build_triangles
+
 };  // class PTQ_subdivision_modifier
 
 template <class Mesh, class Mesh_ops>
@@ -134,6 +268,24 @@ int PTQ_subdivision_modifier<Mesh, Mesh_ops>::ptq_mesh_size(Mesh &mesh, int num_
                            + vertices_size;
 }
 
+// A refinement adds a vertex on every edge, splits every edge in two and adds
+// three edges inside every facet, and quadruples the facets.
+template <class Mesh, class Mesh_ops>
+void PTQ_subdivision_modifier<Mesh, Mesh_ops>::reserve(Mesh &mesh, int num_levels)
+{
+  assert(num_levels >= 0);
+  std::size_t vertices_size = mesh.size_of_vertices();
+  std::size_t edges_size = mesh.size_of_halfedges() / 2;
+  std::size_t facets_size = mesh.size_of_facets();
+  for (int level = 0; level < num_levels; ++level)
+  {
+    vertices_size += edges_size;
+    edges_size = 2 * edges_size + 3 * facets_size;
+    facets_size *= 4;
+  }
+  mesh.reserve(vertices_size, 2 * edges_size, facets_size);
+}
+
 template <class Mesh, class Mesh_ops>
 typename PTQ_subdivision_modifier<Mesh, Mesh_ops>::Halfedge_pair
 PTQ_subdivision_modifier<Mesh, Mesh_ops>::get_halfedges_to_old_vertices(
@@ -199,6 +351,25 @@ PTQ_subdivision_modifier<Mesh, Mesh_ops>::get_halfedges_to_old_vertices(
 #endif
 }
 
+template <class Mesh, class Mesh_ops>
+void PTQ_subdivision_modifier<Mesh, Mesh_ops>::get_halfedges_to_old_vertices(
+                                          const Vertex_handle* first,
+                                          const Vertex_handle* last,
+                                          const Mesh_ops& m_ops,
+                                          std::vector<Halfedge_pair>& hps,
+                                          int num_threads)
+{
+  hps.resize(last - first);
+  parallel_for(0, static_cast<int>(last - first), num_threads,
+               [&](int begin, int end)
+               {
+                 for (int i = begin; i < end; ++i)
+                 {
+                   hps[i] = get_halfedges_to_old_vertices(first[i], m_ops);
+                 }
+               });
+}
+
 
 template <class Mesh, class Mesh_ops>
 typename PTQ_subdivision_modifier<Mesh, Mesh_ops>::Halfedge_pair
@@ -254,50 +425,65 @@ void PTQ_subdivision_modifier<Mesh, Mesh_ops>::refine(
   assert(m.is_pure_triangle());
 
 
-  // Used to compare edge based on its two end vertices id
-  auto edge_compair = [&m_ops](const Edge_iterator& lhs,
-                               const Edge_iterator& rhs) -> bool
-                      {
-                        int s_lhs = m_ops.get_vertex_id(lhs->vertex());
-                        int l_lhs = m_ops.get_vertex_id(lhs->opposite()->vertex());
-                        if (s_lhs > l_lhs)
-                        {
-                          std::swap(s_lhs, l_lhs);
-                        }
-
-                        int s_rhs = m_ops.get_vertex_id(rhs->vertex());
-                        int l_rhs = m_ops.get_vertex_id(rhs->opposite()->vertex());
-                        if (s_rhs > l_rhs)
-                        {
-                          std::swap(s_rhs, l_rhs);
-                        }
-
-                        return s_lhs == s_rhs ? l_lhs < l_rhs : s_lhs < s_rhs;
-                      };
+  // The storage of the refined mesh, a no-op if it is reserved for all the
+  // levels already.
+  reserve(m, 1);
 
-  // Store mesh edges in a sorted order.
-  std::set<Edge_iterator, decltype(edge_compair)> edges_set(edge_compair);
-
-  // Sort all the mesh edges based on their end vertices id.
+  // Sort all the mesh edges based on their end vertices id, with two counting
+  // sorts by the larger id and then stably by the smaller one.
+  std::vector<Edge_iterator> edges;
+  std::vector<int> lows;
+  std::vector<int> highs;
+  edges.reserve(edges_size);
+  lows.reserve(edges_size);
+  highs.reserve(edges_size);
   for (Edge_iterator e = m.edges_begin(); e != m.edges_end(); ++e)
   {
-    assert(edges_set.find(e) == edges_set.end());
-    edges_set.insert(e);
+    int s = m_ops.get_vertex_id(e->vertex());
+    int l = m_ops.get_vertex_id(e->opposite()->vertex());
+    assert(s < vertices_size && l < vertices_size);
+    edges.push_back(e);
+    lows.push_back(std::min(s, l));
+    highs.push_back(std::max(s, l));
   }
 
-  assert(edges_set.size() == edges_size);
+  assert(edges.size() == edges_size);
+
+  std::vector<int> order(edges_size);
+  std::vector<int> by_high(edges_size);
+  for (int i = 0; i < edges_size; ++i)
+  {
+    order[i] = i;
+  }
+  counting_sort(order.data(),
+                order.data() + edges_size,
+                vertices_size,
+                [&highs](int i) { return highs[i]; },
+                by_high.data(),
+                1);
+  counting_sort(by_high.data(),
+                by_high.data() + edges_size,
+                vertices_size,
+                [&lows](int i) { return lows[i]; },
+                order.data(),
+                1);
 
   // Insert a new vertex on every edge, push the new vertex in vertices, and
   // assign new vertex an id starting from the current vertices_size
-  for (auto [eitr, idx] = std::make_pair(edges_set.begin(), vertices_size);
-       eitr != edges_set.end(); ++eitr, ++idx)
+  for (int k = 0; k < edges_size; ++k)
   {
+    int idx = vertices_size + k;
+    Edge_iterator e = edges[order[k]];
+    assert(k == 0 ||
+           lows[order[k - 1]] != lows[order[k]] ||
+           highs[order[k - 1]] != highs[order[k]]);
+
     // Two end vertices
-    Vertex_handle p0 = (*eitr)->vertex();
-    Vertex_handle p1 = (*eitr)->opposite()->vertex();
+    Vertex_handle p0 = e->vertex();
+    Vertex_handle p1 = e->opposite()->vertex();
 
     // The inserted new vertex
-    Halfedge_handle h = *eitr;
+    Halfedge_handle h = e;
     Halfedge_handle hoppo = h->opposite();
     Halfedge_handle hnew = m.split_vertex(hoppo->prev(), h);
     
@@ -372,11 +558,244 @@ void PTQ_subdivision_modifier<Mesh, Mesh_ops>::refine(
   assert(facets_size * 4 == m.size_of_facets());
 }
 
+template <class Mesh, class Mesh_ops>
+void PTQ_subdivision_modifier<Mesh, Mesh_ops>::refine_levels(
+                              Mesh& m,
+                              const Mesh_ops& m_ops,
+                              int level,
+                              int num_levels,
+                              std::vector<Vertex_handle>& vertices,
+                              std::vector<Vertex_handle*>& bands)
+{
+  using Point_3 = typename Mesh::Traits::Point_3;
+  int vertices_size = m.size_of_vertices();
+  assert(!m.empty());
+  assert(m.is_pure_triangle());
+  assert(vertices.size() == vertices_size);
+  assert(bands.size() == level + 2);
+
+  // Copy the vertices and facets to index arrays, where a vertex is its id.
+  std::vector<Point_3> points;
+  std::vector<char> borders;
+  std::vector<int> levels;
+  std::vector<int> types;
+  points.reserve(vertices_size);
+  borders.reserve(vertices_size);
+  levels.reserve(vertices_size);
+  types.reserve(vertices_size);
+  for (const Vertex_handle& v : vertices)
+  {
+    assert(m_ops.get_vertex_id(v) == &v - vertices.data());
+    points.push_back(v->point());
+    borders.push_back(m_ops.get_vertex_border(v));
+    levels.push_back(m_ops.get_vertex_level(v));
+    types.push_back(m_ops.get_vertex_type(v));
+  }
+
+  std::vector<std::pair<int, int>> parents(vertices_size, {-1, -1});
+#if defined (WTLIB_USE_CUSTOM_MESH)
+  for (int i = 0; i < vertices_size; ++i)
+  {
+    if (vertices[i]->parents.first != Vertex_handle {})
+    {
+      parents[i] = {m_ops.get_vertex_id(vertices[i]->parents.first),
+                    m_ops.get_vertex_id(vertices[i]->parents.second)};
+    }
+  }
+#endif
+
+  std::vector<int> triangles;
+  triangles.reserve(3 * m.size_of_facets());
+  for (Facet_handle f = m.facets_begin(); f != m.facets_end(); ++f)
+  {
+    Halfedge_handle h = f->facet_begin();
+    triangles.push_back(m_ops.get_vertex_id(h->vertex()));
+    triangles.push_back(m_ops.get_vertex_id(h->next()->vertex()));
+    triangles.push_back(m_ops.get_vertex_id(h->next()->next()->vertex()));
+  }
+
+  // The band offsets, the existing bands are kept.
+  std::vector<int> offsets;
+  for (Vertex_handle* b : bands)
+  {
+    offsets.push_back(b - bands[0]);
+  }
+  int size = vertices_size;
+  for (int l = 0; l < num_levels; ++l)
+  {
+    size = refine_triangles(triangles, size, parents, borders);
+    offsets.push_back(size);
+  }
+  points.resize(size, CGAL::ORIGIN);
+
+  // Build the finest mesh once.
+  if constexpr (std::is_same<typename Mesh::HDS, Mesh>::value)
+  {
+    // The facet of a Compact_mesh starts at the halfedge from its first to
+    // its second vertex, so rotate the triangles to start each facet at the
+    // halfedge pointing to its first vertex.
+    for (std::size_t t = 0; t < triangles.size(); t += 3)
+    {
+      std::rotate(&triangles[t], &triangles[t + 2], &triangles[t + 3]);
+    }
+    bool success = m.build_triangles(points, triangles);
+    assert(success);
+    (void)success;
+  }
+  else
+  {
+    m.clear();
+    Build_triangles build_triangles(points, triangles);
+    m.delegate(build_triangles);
+  }
+  assert(m.size_of_vertices() == size);
+
+  vertices.clear();
+  vertices.reserve(size);
+  for (Vertex_handle v = m.vertices_begin(); v != m.vertices_end(); ++v)
+  {
+    vertices.push_back(v);
+  }
+  bands.clear();
+  for (int offset : offsets)
+  {
+    bands.push_back(vertices.data() + offset);
+  }
+
+  // Assign id, level, type, border to all the vertices, the vertices of
+  // band b are the vertices of level b.
+  assert(bands.size() == level + num_levels + 2);
+  for (int b = 0; b + 1 < offsets.size(); ++b)
+  {
+    for (int i = offsets[b]; i < offsets[b + 1]; ++i)
+    {
+      Vertex_handle v = vertices[i];
+      m_ops.set_vertex_id(v, i);
+      m_ops.set_vertex_level(v, i < vertices_size ? levels[i] : b);
+      m_ops.set_vertex_type(v, i < vertices_size ? types[i] : 1);
+      m_ops.set_vertex_border(v, borders[i]);
+    #if defined (WTLIB_USE_CUSTOM_MESH)
+      if (parents[i].first >= 0)
+      {
+        v->parents = std::make_pair(vertices[parents[i].first],
+                                    vertices[parents[i].second]);
+      }
+    #endif
+    }
+  }
+}
+
+template <class Mesh, class Mesh_ops>
+int PTQ_subdivision_modifier<Mesh, Mesh_ops>::refine_triangles(
+                              std::vector<int>& triangles,
+                              int num_vertices,
+                              std::vector<std::pair<int, int>>& parents,
+                              std::vector<char>& borders)
+{
+  int corners_size = triangles.size();
+  int facets_size = corners_size / 3;
+  assert(corners_size % 3 == 0);
+  auto low = [&triangles](int c)
+             {
+               int n = c % 3 == 2 ? c - 2 : c + 1;
+               return std::min(triangles[c], triangles[n]);
+             };
+  auto high = [&triangles](int c)
+              {
+                int n = c % 3 == 2 ? c - 2 : c + 1;
+                return std::max(triangles[c], triangles[n]);
+              };
+
+  // Sort the corners, i.e. the halfedges from a corner to the next one, by
+  // their end vertices the same way refine sorts the edges, the two
+  // halfedges of an edge become neighbors.
+  std::vector<int> order(corners_size);
+  counting_sort_pairs(corners_size, num_vertices, low, high, order.data());
+
+  // Number the edge vertices in the order of their edges, an edge with a
+  // single halfedge is on the border.
+  std::vector<int> edge_vertices(corners_size);
+  int idx = num_vertices;
+  for (int k = 0; k < corners_size; ++idx)
+  {
+    int c = order[k];
+    int lo = low(c);
+    int hi = high(c);
+    edge_vertices[c] = idx;
+    parents.emplace_back(lo, hi);
+    if (k + 1 < corners_size &&
+        low(order[k + 1]) == lo && high(order[k + 1]) == hi)
+    {
+      edge_vertices[order[k + 1]] = idx;
+      borders.push_back(false);
+      k += 2;
+    }
+    else
+    {
+      borders.push_back(true);
+      k += 1;
+    }
+    assert(k == corners_size ||
+           low(order[k]) != lo || high(order[k]) != hi);
+  }
+
+  // Split every triangle into the inner triangle, in place, and the three
+  // corner triangles appended, the same way refine splits the facets. refine
+  // starts a facet at the end vertex of its edge split last, i.e. the edge
+  // with the largest edge vertex, {v0, v1, v2}, and splits off the corners
+  // v1, v2 and v0 in this order.
+  triangles.resize(4 * corners_size);
+  for (int f = 0; f < facets_size; ++f)
+  {
+    int* t = &triangles[3 * f];
+    const int* e = &edge_vertices[3 * f];
+    int k = e[0] > e[1] ? (e[0] > e[2] ? 0 : 2) : (e[1] > e[2] ? 1 : 2);
+    int i0 = (k + 1) % 3;
+    int i1 = (k + 2) % 3;
+    int v0 = t[i0];
+    int v1 = t[i1];
+    int v2 = t[k];
+    int e01 = e[i0];
+    int e12 = e[i1];
+    int e20 = e[k];
+    t[0] = e01;
+    t[1] = e12;
+    t[2] = e20;
+    int* corners = &triangles[3 * facets_size + 9 * f];
+    corners[0] = e01;
+    corners[1] = v1;
+    corners[2] = e12;
+    corners[3] = e12;
+    corners[4] = v2;
+    corners[5] = e20;
+    corners[6] = e20;
+    corners[7] = v0;
+    corners[8] = e01;
+  }
+  return idx;
+}
+
 template <class Mesh, class Mesh_ops>
 void PTQ_subdivision_modifier<Mesh, Mesh_ops>::coarsen(
                               Mesh &m,
                               const Mesh_ops &m_ops,
                               int level)
+{
+  if constexpr (std::is_same<typename Mesh::HDS, Mesh>::value)
+  {
+    coarsen_by_rebuild(m, m_ops, level);
+  }
+  else
+  {
+    coarsen_by_joins(m, m_ops, level);
+  }
+}
+
+template <class Mesh, class Mesh_ops>
+void PTQ_subdivision_modifier<Mesh, Mesh_ops>::coarsen_by_joins(
+                              Mesh &m,
+                              const Mesh_ops &m_ops,
+                              int level)
 {
   // Remove halfedges between vertices with level
   for (Vertex_handle v = m.vertices_begin(); v != m.vertices_end(); ++v)
@@ -426,10 +845,66 @@ void PTQ_subdivision_modifier<Mesh, Mesh_ops>::coarsen(
 
       Halfedge_handle hcir = v->vertex_begin();
 
-      Join_vertex join_vertex(hcir->opposite());
-      m.delegate(join_vertex);
+      if constexpr (std::is_same<typename Mesh::HDS, Mesh>::value)
+      {
+        // The mesh is its own halfedge data structure (e.g., Compact_mesh),
+        // the low-level join_vertex is a member.
+        m.join_vertex(hcir->opposite());
+      }
+      else
+      {
+        Join_vertex join_vertex(hcir->opposite());
+        m.delegate(join_vertex);
+      }
+    }
+  }
+}
+
+template <class Mesh, class Mesh_ops>
+void PTQ_subdivision_modifier<Mesh, Mesh_ops>::coarsen_by_rebuild(
+                              Mesh &m,
+                              const Mesh_ops &m_ops,
+                              int level)
+{
+  static_assert(std::is_same<typename Mesh::HDS, Mesh>::value,
+                "The mesh must be its own halfedge data structure.");
+
+  // A refined facet is split into an inner triangle of edge vertices
+  // (e01, e12, e20) and the corner triangles (e01, v1, e12), (e12, v2, e20)
+  // and (e20, v0, e01). The opposite of the inner halfedge to e01 is followed
+  // by the halfedge to v0, so the old vertices come in the order of the inner
+  // halfedges.
+  // The levels are read once per vertex rather than once per corner.
+  std::vector<char> removed(m.num_vertex_slots(), 0);
+  for (Vertex_handle v = m.vertices_begin(); v != m.vertices_end(); ++v)
+  {
+    removed[v.index()] = m_ops.get_vertex_level(v) == level;
+  }
+
+  std::vector<int> triangles;
+  triangles.reserve(3 * (m.size_of_facets() / 4));
+  for (int f = 0; f < m.num_facet_slots(); ++f)
+  {
+    int h = m.facet_halfedge(f);
+    if (m.is_removed_facet(f) ||
+        !removed[m.target(h)] ||
+        !removed[m.target(m.next(h))] ||
+        !removed[m.target(m.prev(h))])
+    {
+      continue;
+    }
+    for (int i = 0; i < 3; ++i, h = m.next(h))
+    {
+      int v = m.target(m.next(m.opposite(h)));
+      assert(!removed[v]);
+      triangles.push_back(v);
     }
   }
+  assert(4 * triangles.size() == 3 * m.size_of_facets());
+
+  bool success = m.rebuild_triangles(triangles);
+  assert(success);
+  (void)success;
 }
 
 template <class Mesh, class Mesh_ops>
@@ -447,5 +922,33 @@ void PTQ_subdivision_modifier<Mesh, Mesh_ops>::Join_vertex::operator()(typename
   d.join_vertex(h_);
 }
 
+template <class Mesh, class Mesh_ops>
+PTQ_subdivision_modifier<Mesh, Mesh_ops>::Build_triangles::Build_triangles(
+                                            const std::vector<Point_3>& points,
+                                            const std::vector<int>& triangles)
+  : points_(points),
+    triangles_(triangles)
+{}
+
+template <class Mesh, class Mesh_ops>
+void PTQ_subdivision_modifier<Mesh, Mesh_ops>::Build_triangles::operator()(typename Mesh::HDS &hds)
+{
+  CGAL::Polyhedron_incremental_builder_3<typename Mesh::HDS> b(hds, true);
+  b.begin_surface(points_.size(), triangles_.size() / 3);
+  for (const Point_3& p : points_)
+  {
+    b.add_vertex(p);
+  }
+  for (std::size_t t = 0; t < triangles_.size(); t += 3)
+  {
+    b.begin_facet();
+    b.add_vertex_to_facet(triangles_[t]);
+    b.add_vertex_to_facet(triangles_[t + 1]);
+    b.add_vertex_to_facet(triangles_[t + 2]);
+    b.end_facet();
+  }
+  b.end_surface();
+}
+
 }  // namespace wtlib::ptq_impl
 #endif
\ No newline at end of file
@@ -7,13 +7,17 @@
  *
  */
 
+#include <wtlib/classification_certificate.hpp>
+#include <wtlib/ptq_impl/counting_sort.hpp>
+#include <wtlib/ptq_impl/parallel_for.hpp>
 #include <wtlib/ptq_impl/vertex_classification_mirror_mesh.hpp>
 
-#include <CGAL/Polyhedron_3.h>
-#include <CGAL/Polyhedron_incremental_builder_3.h>
-
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <limits>
 #include <queue>
+#include <utility>
 #include <vector>
 
 #if defined (WTLIB_HASH_IN_PLACE_LIST_ITERATOR)
@@ -37,20 +41,17 @@ namespace wtlib::ptq_impl
  *           and is three triangles away from it along the vertex's triangle
  *           fan.
  *
- * @tparam   Mirror_mesh    the type of a mirror mesh.
+ *           A crawler keeps its own marks of the visited faces and only reads
+ *           the mirror, so the crawlers of several seeds can run
+ *           concurrently.
  */
-template <class Mirror_mesh>
 class PTQ_finer_faces_crawler
 {
 public:
-  using Facet_handle = typename Mirror_mesh::Facet_handle;
-  using Vertex_handle = typename Mirror_mesh::Vertex_handle;
-  using Halfedge_handle = typename Mirror_mesh::Halfedge_handle;
-  using Halfedge_around_vertex_circulator = typename Mirror_mesh::Halfedge_around_vertex_circulator;
-  using Faces = std::vector<Facet_handle>;
-
-  PTQ_finer_faces_crawler(Mirror_mesh& mirror, Facet_handle seed)
-  : mirror_(mirror),
+  using Faces = std::vector<int>;
+
+  PTQ_finer_faces_crawler(const Mirror_mesh& mirror, int seed)
+  : mirror_(&mirror),
     seed_(seed),
     success_(false)
   {
@@ -60,22 +61,9 @@ public:
 
   PTQ_finer_faces_crawler& operator=(const PTQ_finer_faces_crawler&) = delete;
 
-  PTQ_finer_faces_crawler(PTQ_finer_faces_crawler&& c)
-  : mirror_(c.mirror_),
-    seed_(c.seed_),
-    faces_(std::move(c.faces_)),
-    success_(c.success_)
-  {
-  }
+  PTQ_finer_faces_crawler(PTQ_finer_faces_crawler&&) = default;
 
-  PTQ_finer_faces_crawler& operator=(PTQ_finer_faces_crawler&& c)
-  {
-    mirror_ = c.mirror_;
-    seed_ = c.seed_;
-    faces_ = std::move(c.faces_);
-    success_ = c.success_;
-    return *this;
-  }
+  PTQ_finer_faces_crawler& operator=(PTQ_finer_faces_crawler&&) = default;
 
   bool success() const
   {
@@ -90,19 +78,29 @@ public:
    * @return true 
    * @return false 
    */
-  bool crawl();
+  bool crawl()
+  {
+    return crawl([] { return false; });
+  }
 
   /**
-   * @brief    A helper function to enqueue the adjacent center triangles of a
-   *           center triangle. The queue is used to implement recursion.
+   * @brief    Overloaded crawl, which gives up as soon as stop() returns true.
    *
-   * @param    v         A vertex in a triangle.
-   * @param    v_prev    The previous vertex of v in the triangle. 
+   * @param    stop      A predicate checked before each face is processed.
+   */
+  template <class Stop>
+  bool crawl(Stop stop);
+
+  /**
+   * @brief    A helper function to enqueue the opposite center triangle along
+   *           the triangle fan of a vertex. The queue is used to implement
+   *           recursion.
+   *
+   * @param    h         The halfedge of the current triangle pointing to the
+   *                     vertex.
    * @param    queue     The faces queue.
    */
-  void enqueue_opposite_face(Vertex_handle v,
-                             Vertex_handle v_prev,
-                             std::queue<Facet_handle>& queue) const;
+  void enqueue_opposite_face(int h, std::queue<int>& queue) const;
 
   /**
    * @brief    Check if the number of center triangles is a quarter of the
@@ -111,7 +109,12 @@ public:
    * @return true      implies subdivision connectivity found.
    * @return false 
    */
-  bool is_equivalence() const;
+  bool is_equivalence() const
+  {
+    return faces_.size() == 0 ? false :
+              (mirror_->size_of_facets() % faces_.size() == 0 ? 
+                  mirror_->size_of_facets() / faces_.size() == 4 : false);
+  }
 
   Faces& faces()
   {
@@ -123,104 +126,98 @@ public:
     return faces_;
   }
 private:
-  Mirror_mesh& mirror_;
-  Facet_handle seed_;
+  const Mirror_mesh* mirror_;
+  int seed_;
   Faces faces_;
+  // The visited faces.
+  std::vector<bool> visited_;
   bool success_;
 };  // class PTQ_finer_faces_crawler
 
-template <class Mirror_mesh>
-void PTQ_finer_faces_crawler<Mirror_mesh>::enqueue_opposite_face(
-                                          Vertex_handle v,
-                                          Vertex_handle v_prev,
-                                          std::queue<Facet_handle> &queue) const
+inline void PTQ_finer_faces_crawler::enqueue_opposite_face(
+                                                  int h,
+                                                  std::queue<int>& queue) const
 {
-  if (!v->is_border())
+  if (!mirror_->is_border(mirror_->vertex(h)))
   {
-    Halfedge_around_vertex_circulator hcir = v->vertex_begin();
-
-    // Get the halfedge circulator from v_prev to v.
-    do
+    // Circulate to the incident fine face, three triangles away.
+    for (int i = 0; i < 3 && h >= 0; ++i)
     {
-      if (hcir->opposite()->vertex() == v_prev)
-      {
-        break;
-      }
-      ++hcir;
+      h = mirror_->opposite(Mirror_mesh::next(h));
     }
-    while (hcir != v->vertex_begin());
-
-    // Circulate to its incident fine face.
-    ++hcir;
-    ++hcir;
-    ++hcir;
-
-    Facet_handle f = hcir->facet();
 
-    if (!f->visited())
+    if (h >= 0 && !visited_[Mirror_mesh::facet(h)])
     {
-      queue.push(f);
+      queue.push(Mirror_mesh::facet(h));
     }
   }
 }
 
-template <class Mirror_mesh>
-bool PTQ_finer_faces_crawler<Mirror_mesh>::crawl()
+template <class Stop>
+bool PTQ_finer_faces_crawler::crawl(Stop stop)
 {
+  const Mirror_mesh& mirror = *mirror_;
+  faces_.clear();
+  visited_.assign(mirror.size_of_facets(), false);
+
 // Use a queue instead of recursive function
-  std::queue<Facet_handle> face_queue;
+  std::queue<int> face_queue;
   face_queue.push(seed_);
 
   while (!face_queue.empty())
   {
+    if (stop())
+    {
+      success_ = false;
+      return false;
+    }
+
     // Current processing face.
-    Facet_handle f = face_queue.front();
+    int f = face_queue.front();
     face_queue.pop();
 
     // Check whether this face is visited, since duplicate face maybe added
     // to the queue.
-    if (f->visited())
+    if (visited_[f])
     {
       continue;
     }
 
-    // Get its three incident vertices
-    Halfedge_handle h0 = f->facet_begin();
-    Halfedge_handle h1 = h0->next();
-    Halfedge_handle h2 = h1->next();
+    // Get its three halfedges, pointing to its three vertices.
+    int h0 = Mirror_mesh::facet_begin(f);
+    int h1 = Mirror_mesh::next(h0);
+    int h2 = Mirror_mesh::next(h1);
 
     // If the triangle is on the boundary, return false. Since PTQ cannot
     // produce center triangle on boundary.
-    if (   h0->is_border_edge()
-        || h1->is_border_edge()
-        || h2->is_border_edge())
+    if (   mirror.is_border_edge(h0)
+        || mirror.is_border_edge(h1)
+        || mirror.is_border_edge(h2))
     {
       success_ = false;
       return false;
     }
-    Vertex_handle v0 = h0->vertex();
-    Vertex_handle v1 = h1->vertex();
-    Vertex_handle v2 = h2->vertex();
-
-    assert(h2->next() == h0);
+    int v0 = mirror.vertex(h0);
+    int v1 = mirror.vertex(h1);
+    int v2 = mirror.vertex(h2);
 
     // Check if valences of the three vertices are all 6(inner) or 4(border)
     // since subdivision can only produce regular vertices
-    int val_v0 = v0->degree();
-    int val_v1 = v1->degree();
-    int val_v2 = v2->degree();
+    int val_v0 = mirror.degree(v0);
+    int val_v1 = mirror.degree(v1);
+    int val_v2 = mirror.degree(v2);
 
     // If one of the valences is not 6 or 4, terminate crawl.
-    if (   (v0->is_border() ? val_v0 != 4 : val_v0 != 6)
-        || (v1->is_border() ? val_v1 != 4 : val_v1 != 6)
-        || (v2->is_border() ? val_v2 != 4 : val_v2 != 6))
+    if (   (mirror.is_border(v0) ? val_v0 != 4 : val_v0 != 6)
+        || (mirror.is_border(v1) ? val_v1 != 4 : val_v1 != 6)
+        || (mirror.is_border(v2) ? val_v2 != 4 : val_v2 != 6))
     {
       success_ = false;
       return false;
     }
 
     // Mark the current face as visited
-    f->set_visited(true);
+    visited_[f] = true;
 
     // Passed valence check, vertices are all regular vertices
     // Push the current faces to the candidate faces container
@@ -228,23 +225,15 @@ bool PTQ_finer_faces_crawler<Mirror_mesh>::crawl()
 
     // Enqueue its three opposite faces. The opposite face share one vertex with
     // current face f, and is three triangles away along the triangle fan.
-    enqueue_opposite_face(v0, v2, face_queue);
-    enqueue_opposite_face(v1, v0, face_queue);
-    enqueue_opposite_face(v2, v1, face_queue);
+    enqueue_opposite_face(h0, face_queue);
+    enqueue_opposite_face(h1, face_queue);
+    enqueue_opposite_face(h2, face_queue);
   }
 
   success_ = is_equivalence();
   return success_;
 }
 
-template <class Mirror_mesh>
-bool PTQ_finer_faces_crawler<Mirror_mesh>::is_equivalence() const
-{
-  return faces_.size() == 0 ? false :
-            (mirror_.size_of_facets() % faces_.size() == 0 ? 
-                mirror_.size_of_facets() / faces_.size() == 4 : false);
-}
-
 
 /**
  * @brief    Track the parents of a vertex.
@@ -258,35 +247,17 @@ public:
   using Vertex_handle = typename Mesh::Vertex_handle;
   using Halfedge_handle = typename Mesh::Halfedge_handle;
 #if defined (WTLIB_USE_CUSTOM_MESH)
-  std::pair<Vertex_handle, Vertex_handle> get_hs_to_parents(Vertex_handle v) const
-  {
-    return v->parents;
-  }
-
   void set_hs_to_parents(Vertex_handle v, std::pair<Vertex_handle, Vertex_handle> parents) const
   {
     v->parents = parents;
   }
 #else
-  std::pair<Vertex_handle, Vertex_handle> get_hs_to_parents(Vertex_handle v) const
-  {
-    return tracker_.at(v);
-  }
-
-  void set_hs_to_parents(Vertex_handle v, std::pair<Vertex_handle, Vertex_handle> parents)
+  // The subdivision modifier finds the parents among the neighbours of a
+  // vertex, and the classification sorts by the parent indices it keeps.
+  void set_hs_to_parents(Vertex_handle v, std::pair<Vertex_handle, Vertex_handle> parents) const
   {
-    tracker_.insert({v, parents});
   }
 #endif
-
-private:
-#if !defined (WTLIB_USE_CUSTOM_MESH)
-#if defined (WTLIB_USE_UNORDERED_MAP)
-  std::unordered_map<Vertex_handle, std::pair<Vertex_handle, Vertex_handle>> tracker_;
-#else
-  std::map<Vertex_handle, std::pair<Vertex_handle, Vertex_handle>> tracker_;
-#endif
-#endif
 };
 
 
@@ -304,21 +275,10 @@ public:
   using Halfedge_handle = typename Mesh::Halfedge_handle;
   using Facet_handle = typename Mesh::Facet_handle;
 
-  using Mirror_mesh = CGAL::Polyhedron_3<Traits<Mesh>, Mirror_mesh_items>;
-  using Mirror_vertex_handle = typename Mirror_mesh::Vertex_handle;
-  using Mirror_facet_handle = typename Mirror_mesh::Facet_handle;
-  using Mirror_halfedge_handle = typename Mirror_mesh::Halfedge_handle;
-  using Crawler = PTQ_finer_faces_crawler<Mirror_mesh>;
+  using Crawler = PTQ_finer_faces_crawler;
 
   using Vertex_tracker = V_tracker<Mesh>;
 
-#if !defined(WTLIB_USE_CUSTOM_MESH)
-#if defined (WTLIB_USE_UNORDERED_MAP)
-  using Vertex_property = std::unordered_map<Vertex_handle, int>;
-#else
-  using Vertex_property = std::map<Vertex_handle, int>;
-#endif  // WTLIB_USE_UNORDERED_MAP
-#endif
   enum Vertex_type
   {
     OLD_VERTEX = 0,
@@ -347,6 +307,9 @@ public:
    * @param      vertices           The array of vertices
    * @param      bands              The bands
    * @param[in]  reset_vertices_id  Reset vertices id tag
+   * @param[in]  num_threads        The number of threads running the crawlers
+   *                                and sorting the vertices, a value less
+   *                                than 1 uses all hardware threads.
    *
    * @return     True if has subdivision connectivity, false otherwise.
    */
@@ -356,9 +319,72 @@ public:
                 int num_levels,
                 std::vector<Vertex_handle>& vertices,
                 std::vector<Vertex_handle*>& bands,
-                bool reset_vertices_id
+                bool reset_vertices_id,
+                int num_threads = 1
                );
 
+  /**
+   * @brief      Overloaded classify with a certificate of an earlier
+   *             classification of the mesh. If the certificate matches the
+   *             connectivity of the mesh and the number of levels, the
+   *             vertices and bands are restored from it without detecting the
+   *             subdivision connectivity. Otherwise the vertices are classified
+   *             and the certificate is replaced by the result. The vertex ids
+   *             are reset.
+   *
+   * @param      certificate        The certificate, see
+   *                                Classification_certificate
+   *
+   * @return     True if has subdivision connectivity, false otherwise.
+   */
+  static bool classify(
+                Mesh& mesh,
+                const Mesh_ops& mesh_ops,
+                int num_levels,
+                std::vector<Vertex_handle>& vertices,
+                std::vector<Vertex_handle*>& bands,
+                Classification_certificate& certificate,
+                int num_threads = 1
+               );
+
+  /**
+   * @brief      Detect as many levels of subdivision connectivity as the mesh
+   *             has, up to max_levels, and classify the vertices of the levels
+   *             found, in one pass. The vertices and bands are the ones of
+   *             classify for the returned number of levels.
+   *
+   * @param[in]  max_levels         The maximum number of levels, a value less
+   *                                than 1 is bounded by the number of facets
+   *                                only, see max_num_levels.
+   *
+   * @return     The number of levels found, 0 if the mesh does not have
+   *             subdivision connectivity.
+   */
+  static int classify_max_levels(
+                Mesh& mesh,
+                const Mesh_ops& mesh_ops,
+                int max_levels,
+                std::vector<Vertex_handle>& vertices,
+                std::vector<Vertex_handle*>& bands,
+                bool reset_vertices_id,
+                int num_threads = 1
+               );
+
+  /**
+   * @brief      An upper bound of the number of levels of subdivision
+   *             connectivity, since every level of PTQ quadruples the number
+   *             of facets.
+   */
+  static int max_num_levels(const Mesh& mesh)
+  {
+    int num_levels = 0;
+    for (std::size_t f = mesh.size_of_facets(); f > 0 && f % 4 == 0; f /= 4)
+    {
+      ++num_levels;
+    }
+    return num_levels;
+  }
+
   /**
    * @brief      Gets the number of vertex types.
    *
@@ -374,30 +400,60 @@ public:
 
 protected:
   /**
-   * @brief      Construct a mirror mesh from the input mesh.
-   *
-   * @param      mesh  The input mesh
+   * @brief      Construct a mirror mesh from the input mesh. The point of a
+   *             mirror vertex is the index of its vertex in the array handles.
    *
+   * @param      mesh      The input mesh
+   * @param[in]  m_ops     The mesh operations, the vertex ids are the vertex
+   *                       indices
+   * @param      mirror    The mirror
+   * @param      handles   The vertices of the input mesh
    */
-  static void extract(Mesh& mesh, Mirror_mesh& mirror);
+  static void extract(Mesh& mesh,
+                      const Mesh_ops& m_ops,
+                      Mirror_mesh& mirror,
+                      std::vector<Vertex_handle>& handles);
 
 
   /**
-   * @brief      Check number of triangles faces and connected irregular vertices
+   * @brief      Classify the vertices of num_levels levels, see classify. If
+   *             max_levels is true, the detection stops at the first level
+   *             without subdivision connectivity and the levels found are
+   *             classified.
    *
-   * @param      mirror
+   * @return     The number of levels classified, 0 on failure.
+   */
+  static int classify_levels(Mesh& mesh,
+                             const Mesh_ops& mesh_ops,
+                             int num_levels,
+                             std::vector<Vertex_handle>& vertices,
+                             std::vector<Vertex_handle*>& bands,
+                             bool reset_vertices_id,
+                             bool max_levels,
+                             int num_threads);
+
+
+  /**
+   * @brief      Restore the vertices and bands of a classification from its
+   *             certificate, and reset the vertex ids.
    *
-   * @return     pass or fail
+   * @return     false if the certificate does not fit the mesh.
    */
-  static bool precheck(Mirror_mesh& mirror);
+  static bool restore(Mesh& mesh,
+                      const Mesh_ops& m_ops,
+                      const Classification_certificate& certificate,
+                      std::vector<Vertex_handle>& vertices,
+                      std::vector<Vertex_handle*>& bands);
 
 
   /**
-   * @brief      Reset all the faces of the mirror to unvisited.
+   * @brief      Check number of triangles faces and connected irregular vertices
    *
    * @param      mirror
+   *
+   * @return     pass or fail
    */
-  static void reset_facets_marks(Mirror_mesh& mirror);
+  static bool precheck(const Mirror_mesh& mirror);
 
 
   /**
@@ -407,7 +463,7 @@ protected:
    *
    * @return     size of border halfedges
    */
-  static int size_of_borders(Mirror_mesh& mirror);
+  static int size_of_borders(const Mirror_mesh& mirror);
 
 
   /**
@@ -417,7 +473,25 @@ protected:
    *
    * @return     The seed faces.
    */
-  static std::vector<Mirror_facet_handle> get_seed_faces(Mirror_mesh& mirror);
+  static std::vector<int> get_seed_faces(const Mirror_mesh& mirror);
+
+
+  /**
+   * @brief      Run the crawlers and find the successful one with the lowest
+   *             index, which is the one the crawlers would find one after
+   *             another. On a large mirror the crawlers run concurrently, and
+   *             a crawler gives up once a crawler with a lower index has
+   *             succeeded.
+   *
+   * @param      crawlers        The crawlers of the seed faces
+   * @param[in]  size_of_facets  The number of faces of the mirror
+   * @param[in]  num_threads     The number of threads
+   *
+   * @return     The index of the crawler, or -1 if all the crawlers fail.
+   */
+  static int run_crawlers(std::vector<Crawler>& crawlers,
+                          std::size_t size_of_facets,
+                          int num_threads);
 
 
   /**
@@ -425,17 +499,27 @@ protected:
    *
    * @param      mirror      The mirror mesh
    * @param[in]  fine_faces  The crawled finer faces
+   * @param[in]  handles     The vertices of the mesh, indexed by the points
+   *                         of the mirror
    * @param[in]  m_ops       The mesh operations
+   * @param      order       The indices of the vertices in the array vertices
+   * @param      parents     The indices of the parents of the vertices, by
+   *                         vertex index
    * @param      vertices    The array of vertices
    * @param      bands       The array of band delimiters
    * @param[in]  level       The current processing level
    * @param[in]  v_back_idx  The vertices index from last to first
    * @param      v_tracker   The vertex parent tracker
+   *
+   * @return     false if the finer faces do not form a PTQ
    */
-  static void coarsen_mirror_dump_vertices(
+  static bool coarsen_mirror_dump_vertices(
                                Mirror_mesh& mirror,
-                               const std::vector<Mirror_facet_handle>& fine_faces,
+                               const std::vector<int>& fine_faces,
+                               const std::vector<Vertex_handle>& handles,
                                const Mesh_ops& m_ops,
+                               std::vector<int>& order,
+                               std::vector<std::pair<int, int>>& parents,
                                std::vector<Vertex_handle>& vertices,
                                std::vector<Vertex_handle*>& bands,
                                int level,
@@ -444,20 +528,29 @@ protected:
 
 
   /**
-   * @brief      Sort vertices in the array vertices based on id and parent id
+   * @brief      Sort the vertices of every band by id, the base band, or by
+   *             the ids of their parents, and fill the array vertices. The
+   *             ids are the vertex indices until they are reset.
    *
-   * @param[in]  v_tracker  Vertex parent tracker
+   * @param[in]  parents    The indices of the parents of the vertices, by
+   *                        vertex index
+   * @param[in]  handles    The vertices of the mesh, by vertex index
    * @param[in]  m_ops      mesh operations
+   * @param      order      The indices of the vertices in the array vertices
    * @param      vertices   The array of vertices
    * @param      bands      The band delimiters
    * @param[in]  reset_id   if reset id. Should be true.
+   * @param[in]  num_threads  The number of threads
    */
   static void sort_vertices(
-                const Vertex_tracker& v_tracker,
+                const std::vector<std::pair<int, int>>& parents,
+                const std::vector<Vertex_handle>& handles,
                 const Mesh_ops& m_ops,
+                std::vector<int>& order,
                 std::vector<Vertex_handle>& vertices,
                 std::vector<Vertex_handle*>& bands,
-                bool reset_id);
+                bool reset_id,
+                int num_threads);
 
   /**
    * @brief      Check if a border loop is composed of only two halfedges
@@ -472,41 +565,18 @@ protected:
   /**
    * @brief      Calculate the sum of ids of all finer vertices
    *
-   * @param[in]  faces  The finer faces
-   * @param[in]  m_ops  The mesh_operations
+   * @param[in]  mirror   The mirror mesh
+   * @param[in]  faces    The finer faces
+   * @param[in]  handles  The vertices of the mesh
+   * @param[in]  m_ops    The mesh_operations
    *
    * @return     sum
    */
-  static int sum_of_vids(const std::vector<Mirror_facet_handle>& faces,
+  static int sum_of_vids(const Mirror_mesh& mirror,
+                         const std::vector<int>& faces,
+                         const std::vector<Vertex_handle>& handles,
                          const Mesh_ops& m_ops);
 
-
-  /**
-   * @brief      This class is used to access Mirror_mesh protected member hds
-   *             since there is no public method to access it before CGAL 4.5
-   */
-  class Extract_mesh: public CGAL::Modifier_base<typename Mirror_mesh::HDS>
-  {
-  public:
-    Extract_mesh(Mesh& mesh);
-    void operator()(typename Mirror_mesh::HDS& hds);
-  private:
-    Mesh& mesh_;
-  };  // class Extract_mesh
-
-  /**
-   * @brief      This class is used to access Mirror_mesh protected member hds
-   *             since there is no public method to access it before CGAL 4.5
-   */
-  class Join_vertex: public CGAL::Modifier_base<typename Mirror_mesh::HDS>
-  {
-  public:
-    Join_vertex(Mirror_halfedge_handle h);
-    void operator()(typename Mirror_mesh::HDS& hds);
-  private:
-    Mirror_halfedge_handle h_;
-  };  // class Join_vertex
-
 };  // class PTQ_classify_vertices
 
 template <class Mesh, class Mesh_ops>
@@ -527,12 +597,60 @@ bool PTQ_classify_vertices<Mesh, Mesh_ops>::classify(
                     int num_levels,
                     std::vector<Vertex_handle>& vertices,
                     std::vector<Vertex_handle*>& bands,
-                    bool reset_vertices_id)
+                    bool reset_vertices_id,
+                    int num_threads)
+{
+  return classify_levels(mesh,
+                         mesh_ops,
+                         num_levels,
+                         vertices,
+                         bands,
+                         reset_vertices_id,
+                         false,
+                         get_num_threads(num_threads)) > 0;
+}
+
+template <class Mesh, class Mesh_ops>
+int PTQ_classify_vertices<Mesh, Mesh_ops>::classify_max_levels(
+                    Mesh &mesh,
+                    const Mesh_ops &mesh_ops,
+                    int max_levels,
+                    std::vector<Vertex_handle>& vertices,
+                    std::vector<Vertex_handle*>& bands,
+                    bool reset_vertices_id,
+                    int num_threads)
+{
+  assert(!mesh.empty() && mesh.is_pure_triangle());
+  int num_levels = max_num_levels(mesh);
+  if (max_levels > 0)
+  {
+    num_levels = std::min(num_levels, max_levels);
+  }
+  return classify_levels(mesh,
+                         mesh_ops,
+                         num_levels,
+                         vertices,
+                         bands,
+                         reset_vertices_id,
+                         true,
+                         get_num_threads(num_threads));
+}
+
+template <class Mesh, class Mesh_ops>
+int PTQ_classify_vertices<Mesh, Mesh_ops>::classify_levels(
+                    Mesh &mesh,
+                    const Mesh_ops &mesh_ops,
+                    int num_levels,
+                    std::vector<Vertex_handle>& vertices,
+                    std::vector<Vertex_handle*>& bands,
+                    bool reset_vertices_id,
+                    bool max_levels,
+                    int num_threads)
 {
   assert(!mesh.empty() && mesh.is_pure_triangle());
   if (num_levels < 1)
   {
-    return false;
+    return 0;
   }
 
   // Initialize vertices level, type and id which is determined by layout in memory
@@ -556,12 +674,18 @@ bool PTQ_classify_vertices<Mesh, Mesh_ops>::classify(
   // the original mesh. The reason to do so is to avoid breaking the topology of
   // the original mesh.
   Mirror_mesh mirror;
-  extract(mesh, mirror);
+  std::vector<Vertex_handle> handles;
+  extract(mesh, mesh_ops, mirror, handles);
   int border_size = size_of_borders(mirror);
 
   // The vertex parents tracker.
   Vertex_tracker v_tracker;
 
+  // The vertex indices in the order of the array vertices, and the parents of
+  // the finer vertices.
+  std::vector<int> order(mesh.size_of_vertices());
+  std::vector<std::pair<int, int>> parents(mesh.size_of_vertices(), {-1, -1});
+
   int level = num_levels;
 
   // Identify the given levels of subdivision connectivity.
@@ -572,37 +696,22 @@ bool PTQ_classify_vertices<Mesh, Mesh_ops>::classify(
       break;
     }
 
-    // Reset all facets to unvisited.
-    reset_facets_marks(mirror);
-
     // Find seed faces for crawling
-    std::vector<Mirror_facet_handle> seeds {get_seed_faces(mirror)};
+    std::vector<int> seeds {get_seed_faces(mirror)};
     std::vector<Crawler> crawlers;
 
     // Construct crawlers
-    for (const Mirror_facet_handle& seed : seeds)
+    for (int seed : seeds)
     {
       crawlers.emplace_back(mirror, seed);
     }
     assert(crawlers.size() > 0 && "At least one crawler");
     assert(crawlers.size() == seeds.size());
 
-    // TODO: Multi-thread
-    bool success = false;
-    int crawler_id = 0;
-    for (int i = 0; i < crawlers.size(); ++i)
-    {
-      if (crawlers[i].crawl())
-      {
-        success = true;
-#ifndef IS_RUNNING_TESTS
-        crawler_id = i;
-        break;
-#endif
-      }
-    }
-
-    if (!success)
+    int crawler_id = run_crawlers(crawlers,
+                                  mirror.size_of_facets(),
+                                  num_threads);
+    if (crawler_id < 0)
     {
       break;
     }
@@ -618,7 +727,7 @@ bool PTQ_classify_vertices<Mesh, Mesh_ops>::classify(
     {
       if (crawlers[i].success())
       {
-        int vid_sum = sum_of_vids(crawlers[i].faces(), mesh_ops);
+        int vid_sum = sum_of_vids(mirror, crawlers[i].faces(), handles, mesh_ops);
         if (vid_sum > max)
         {
           max = vid_sum;
@@ -630,33 +739,57 @@ bool PTQ_classify_vertices<Mesh, Mesh_ops>::classify(
 
     // Found subdivision connectivity. Then coarsen the mirror for the next
     // level detection.
-    const std::vector<Mirror_facet_handle>& ffs = crawlers[crawler_id].faces();
-    coarsen_mirror_dump_vertices(mirror,
-                              ffs,
-                              mesh_ops,
-                              vertices,
-                              bands,
-                              level,
-                              v_back_idx,
-                              v_tracker);
-
-
-    // In case some mesh borders will be closed (caused by the CGAL HDS) after coarsen
+    const std::vector<int>& ffs = crawlers[crawler_id].faces();
+    int level_back_idx = v_back_idx;
+    if (!coarsen_mirror_dump_vertices(mirror,
+                                      ffs,
+                                      handles,
+                                      mesh_ops,
+                                      order,
+                                      parents,
+                                      vertices,
+                                      bands,
+                                      level,
+                                      v_back_idx,
+                                      v_tracker))
+    {
+      break;
+    }
+
+    // In case some mesh borders will be closed after coarsen
     if (border_size > 0 && !border_post_check(mirror))
     {
+      // The finer vertices of this level stay in the coarsest level found.
+      for (int i = v_back_idx; i < level_back_idx; ++i)
+      {
+        mesh_ops.set_vertex_type(handles[order[i]], OLD_VERTEX);
+      }
       break;
     }
   }
 
+  if (level > 0 && max_levels && level < num_levels)
+  {
+    // Number the levels from the coarsest level found, whose vertices have
+    // the level of the failed detection or the one below it.
+    for (auto v = mesh.vertices_begin(); v != mesh.vertices_end(); ++v)
+    {
+      mesh_ops.set_vertex_level(v,
+                                std::max(mesh_ops.get_vertex_level(v) - level,
+                                         0));
+    }
+    bands.erase(bands.begin() + 1, bands.begin() + 1 + level);
+    num_levels -= level;
+    level = 0;
+  }
+
   if (level == 0)
   {
     // Now only base level vertices in mesh_ext
-    for (Mirror_vertex_handle v = mirror.vertices_begin();
-         v != mirror.vertices_end();
-         ++v)
+    for (int v = 0; v < mirror.size_of_vertices(); ++v)
     {
       --v_back_idx;
-      vertices[v_back_idx] = v->point();
+      order[v_back_idx] = mirror.point(v);
     }
 
     // v_back_idx should be zero;
@@ -664,127 +797,370 @@ bool PTQ_classify_vertices<Mesh, Mesh_ops>::classify(
 
     // Bands should have at least 3 elements
     assert(bands.size() >= 3);
-    sort_vertices(v_tracker,
+    sort_vertices(parents,
+                  handles,
                   mesh_ops,
+                  order,
                   vertices,
                   bands,
-                  reset_vertices_id);
+                  reset_vertices_id,
+                  num_threads);
+    return num_levels;
+  }
+
+  return 0;
+}
+
+template <class Mesh, class Mesh_ops>
+bool PTQ_classify_vertices<Mesh, Mesh_ops>::classify(
+                    Mesh &mesh,
+                    const Mesh_ops &mesh_ops,
+                    int num_levels,
+                    std::vector<Vertex_handle>& vertices,
+                    std::vector<Vertex_handle*>& bands,
+                    Classification_certificate& certificate,
+                    int num_threads)
+{
+  assert(!mesh.empty() && mesh.is_pure_triangle());
+  if (num_levels < 1)
+  {
+    return false;
+  }
+
+  // The hash is taken over the vertex indices, the same ids that classify
+  // starts from.
+  int num_vertices = 0;
+  for (auto v = mesh.vertices_begin(); v != mesh.vertices_end(); ++v)
+  {
+    mesh_ops.set_vertex_id(v, num_vertices++);
+  }
+  std::uint64_t hash = connectivity_hash(mesh,
+                                         [&mesh_ops](typename Mesh::Vertex_const_handle v)
+                                         {
+                                           return mesh_ops.get_vertex_id(v);
+                                         });
+
+  if (certificate.connectivity_hash == hash &&
+      certificate.num_levels() == num_levels &&
+      restore(mesh, mesh_ops, certificate, vertices, bands))
+  {
     return true;
   }
 
-  return false;
+  if (!classify(mesh, mesh_ops, num_levels, vertices, bands, true, num_threads))
+  {
+    return false;
+  }
+
+  // The ids are the positions in the array vertices now, map them back to the
+  // vertex indices.
+  certificate.connectivity_hash = hash;
+  certificate.level_sizes.clear();
+  for (int level = 0; level <= num_levels; ++level)
+  {
+    certificate.level_sizes.push_back(bands[level + 1] - bands[0]);
+  }
+  certificate.vertex_order.resize(num_vertices);
+  bool identity = true;
+  int index = 0;
+  for (auto v = mesh.vertices_begin(); v != mesh.vertices_end(); ++v, ++index)
+  {
+    int id = mesh_ops.get_vertex_id(v);
+    certificate.vertex_order[id] = index;
+    identity = identity && id == index;
+  }
+  if (identity)
+  {
+    certificate.vertex_order.clear();
+  }
+  return true;
 }
 
+// The type and level of a vertex follow from its band, and the parents of an
+// edge vertex are its two neighbours of lower levels.
 template <class Mesh, class Mesh_ops>
-void PTQ_classify_vertices<Mesh, Mesh_ops>::sort_vertices(
-                  const Vertex_tracker &v_tracker,
-                  const Mesh_ops& m_ops,
-                  std::vector<Vertex_handle> &vertices,
-                  std::vector<Vertex_handle *> &bands,
-                  bool reset_id)
+bool PTQ_classify_vertices<Mesh, Mesh_ops>::restore(
+                            Mesh& mesh,
+                            const Mesh_ops& m_ops,
+                            const Classification_certificate& certificate,
+                            std::vector<Vertex_handle>& vertices,
+                            std::vector<Vertex_handle*>& bands)
 {
-  using Parent = std::pair<Vertex_handle, Vertex_handle>;
-  using Vitr = typename std::vector<Vertex_handle>::iterator;
+  const std::vector<int>& sizes = certificate.level_sizes;
+  const std::vector<int>& order = certificate.vertex_order;
+  int num_vertices = mesh.size_of_vertices();
+  int num_levels = certificate.num_levels();
+  if (sizes.empty() ||
+      sizes.front() < 1 ||
+      sizes.back() != num_vertices ||
+      !std::is_sorted(sizes.begin(), sizes.end()) ||
+      !(order.empty() || static_cast<int>(order.size()) == num_vertices))
+  {
+    return false;
+  }
 
-  // Compare by parent vertices' id, used to sort vertices.
-  auto vcomp = [&v_tracker, &m_ops](const Vertex_handle& lhs,
-                                    const Vertex_handle& rhs)
-                {
-                  Parent p_lhs = v_tracker.get_hs_to_parents(lhs);
-                  Parent p_rhs = v_tracker.get_hs_to_parents(rhs);
+  std::vector<Vertex_handle> handles;
+  handles.reserve(num_vertices);
+  for (auto v = mesh.vertices_begin(); v != mesh.vertices_end(); ++v)
+  {
+    handles.push_back(v);
+  }
 
-                  int s_lhs = m_ops.get_vertex_id(p_lhs.first);
-                  int l_lhs = m_ops.get_vertex_id(p_lhs.second);
-                  if (s_lhs > l_lhs)
-                  {
-                    std::swap(s_lhs, l_lhs);
-                  }
+  if (!order.empty())
+  {
+    std::vector<bool> seen(num_vertices, false);
+    for (int v : order)
+    {
+      if (v < 0 || v >= num_vertices || seen[v])
+      {
+        return false;
+      }
+      seen[v] = true;
+    }
+  }
+
+  vertices.resize(num_vertices);
+  for (int i = 0; i < num_vertices; ++i)
+  {
+    vertices[i] = handles[order.empty() ? i : order[i]];
+  }
 
-                  int s_rhs = m_ops.get_vertex_id(p_rhs.first);
-                  int l_rhs = m_ops.get_vertex_id(p_rhs.second);
-                  if (s_rhs > l_rhs)
+  int level = 0;
+  for (int i = 0; i < num_vertices; ++i)
+  {
+    while (i >= sizes[level])
+    {
+      ++level;
+    }
+    m_ops.set_vertex_type(vertices[i], level == 0 ? OLD_VERTEX : EDGE_VERTEX);
+    m_ops.set_vertex_level(vertices[i], level);
+    m_ops.set_vertex_id(vertices[i], i);
+  }
+
+#if defined (WTLIB_USE_CUSTOM_MESH)
+  // In the finest mesh, the edge from a vertex of level l to a neighbour of
+  // the level l mesh is split by the vertices of the finer levels, which are
+  // regular. The edge is followed straight through them, i.e., three facets
+  // further around an inner vertex, or along the border.
+  auto follow = [&m_ops](Halfedge_handle h, int level, int max_steps)
+                {
+                  for (int step = 1;
+                       m_ops.get_vertex_level(h->vertex()) > level;
+                       ++step)
                   {
-                    std::swap(s_rhs, l_rhs);
+                    if (step >= max_steps)
+                    {
+                      return Vertex_handle {};
+                    }
+                    Halfedge_handle g = h;
+                    if (h->is_border_edge())
+                    {
+                      do
+                      {
+                        g = g->next()->opposite();
+                      }
+                      while (g != h && !g->is_border_edge());
+                    }
+                    else
+                    {
+                      g = g->next()->opposite()->next()->opposite()->next()->opposite();
+                    }
+                    h = g->opposite();
                   }
-
-                  return s_lhs != s_rhs ? s_lhs < s_rhs : l_lhs < l_rhs;
+                  return h->vertex();
                 };
 
-  // First sort base resolution vertices
+  Vertex_tracker v_tracker;
+  for (int i = sizes[0]; i < num_vertices; ++i)
+  {
+    Vertex_handle v = vertices[i];
+    int v_level = m_ops.get_vertex_level(v);
+    std::pair<Vertex_handle, Vertex_handle> parents;
+    int count = 0;
+    auto hcir = v->vertex_begin();
+    do
+    {
+      Vertex_handle u = follow(hcir->opposite(),
+                               v_level,
+                               1 << (num_levels - v_level));
+      if (u == Vertex_handle {})
+      {
+        return false;
+      }
+      if (m_ops.get_vertex_level(u) < v_level)
+      {
+        (count == 0 ? parents.first : parents.second) = u;
+        ++count;
+      }
+      ++hcir;
+    }
+    while (hcir != v->vertex_begin() && count <= 2);
+    if (count != 2)
+    {
+      return false;
+    }
+    v_tracker.set_hs_to_parents(v, parents);
+  }
+#endif
+
+  bands.resize(num_levels + 2);
+  bands[0] = &vertices.front();
+  for (int l = 0; l <= num_levels; ++l)
+  {
+    bands[l + 1] = &vertices.front() + sizes[l];
+  }
+  return true;
+}
+
+// The vertices of a band are sorted by the pair of their parent ids with two
+// counting sorts, by the larger id and then stably by the smaller one. The
+// parents of a band have lower ids than the band once the ids are reset.
+template <class Mesh, class Mesh_ops>
+void PTQ_classify_vertices<Mesh, Mesh_ops>::sort_vertices(
+                  const std::vector<std::pair<int, int>>& parents,
+                  const std::vector<Vertex_handle>& handles,
+                  const Mesh_ops& m_ops,
+                  std::vector<int>& order,
+                  std::vector<Vertex_handle>& vertices,
+                  std::vector<Vertex_handle*>& bands,
+                  bool reset_id,
+                  int num_threads)
+{
+  const int num_vertices = order.size();
   assert(bands[0] == &vertices[0]);
-  std::sort(bands[0],
-            bands[1], 
-            [&m_ops](const Vertex_handle& lhs,
-                     const Vertex_handle& rhs)
-            {
-              return m_ops.get_vertex_id(lhs) < m_ops.get_vertex_id(rhs);
-            });
 
+  // The ids by vertex index.
+  std::vector<int> ids(num_vertices);
+  for (int v = 0; v < num_vertices; ++v)
+  {
+    ids[v] = v;
+  }
+
+  // First sort base resolution vertices
+  std::vector<int> sorted(num_vertices);
+  int base_size = bands[1] - bands[0];
+  counting_sort(&order[0],
+                &order[0] + base_size,
+                num_vertices,
+                [](int v) { return v; },
+                &sorted[0],
+                num_threads);
+  std::copy(sorted.begin(), sorted.begin() + base_size, order.begin());
   if (reset_id)
   {
-    for (int i = 0; i < (bands[1] - bands[0]); ++i)
+    for (int i = 0; i < base_size; ++i)
     {
-      m_ops.set_vertex_id(vertices[i], i);
+      ids[order[i]] = i;
     }
   }
 
-
   // Sort vertices in each level
   // Since [bands[0], bands[1]) are old vertices, so i start from 2.
+  std::vector<int> lows;
+  std::vector<int> highs;
+  std::vector<int> positions;
   for (int i = 2; i < bands.size(); ++i)
   {
-    Vertex_handle* start {bands[i - 1]};
-    Vertex_handle* end {bands[i]};
-    std::sort(start, end, vcomp);
+    int first = bands[i - 1] - bands[0];
+    int size = bands[i] - bands[i - 1];
+    int bound = reset_id ? first : num_vertices;
+
+    // The keys are indexed by the positions in the band.
+    lows.resize(size);
+    highs.resize(size);
+    positions.resize(size);
+    parallel_for(0,
+                 size,
+                 num_threads,
+                 [&](int k_first, int k_last)
+                 {
+                   for (int k = k_first; k < k_last; ++k)
+                   {
+                     const std::pair<int, int>& p = parents[order[first + k]];
+                     int s = ids[p.first];
+                     int l = ids[p.second];
+                     lows[k] = std::min(s, l);
+                     highs[k] = std::max(s, l);
+                     positions[k] = k;
+                   }
+                 });
+
+    int* by_high = &sorted[first];
+    counting_sort(positions.data(),
+                  positions.data() + size,
+                  bound,
+                  [&highs](int k) { return highs[k]; },
+                  by_high,
+                  num_threads);
+    counting_sort(by_high,
+                  by_high + size,
+                  bound,
+                  [&lows](int k) { return lows[k]; },
+                  positions.data(),
+                  num_threads);
+    for (int k = 0; k < size; ++k)
+    {
+      sorted[first + k] = order[first + positions[k]];
+    }
+    std::copy(sorted.begin() + first,
+              sorted.begin() + first + size,
+              order.begin() + first);
 
     // Reset id of vertices in current processing level.
     if (reset_id)
     {
-      int lower_v_size = bands[i - 1] - bands[0];
-      assert(m_ops.get_vertex_id(*(start - 1)) == lower_v_size - 1);
-      // Set id for vertices in current processing band.
-      for (auto [vitr, id] = std::make_pair(start, lower_v_size);
-           vitr != end; ++vitr, ++id)
+      for (int k = first; k < first + size; ++k)
       {
-        m_ops.set_vertex_id(*vitr, id);
+        ids[order[k]] = k;
       }
     }
   }
-}
-
-template <class Mesh, class Mesh_ops>
-void PTQ_classify_vertices<Mesh, Mesh_ops>::extract(Mesh& mesh, Mirror_mesh& mirror)
-{
-  Extract_mesh ext(mesh);
-  mirror.delegate(ext);
-
-  assert(mirror.size_of_facets() == mesh.size_of_facets());
-  assert(mirror.size_of_vertices() == mesh.size_of_vertices());
 
-  for (Mirror_halfedge_handle h_h = mirror.edges_begin();
-       h_h != mirror.edges_end();
-       ++h_h)
+  for (int i = 0; i < num_vertices; ++i)
+  {
+    vertices[i] = handles[order[i]];
+  }
+  if (reset_id)
   {
-    if (h_h->is_border_edge())
+    for (int i = 0; i < num_vertices; ++i)
     {
-      h_h->vertex()->set_border(true);
-      h_h->opposite()->vertex()->set_border(true);
+      m_ops.set_vertex_id(vertices[i], i);
     }
   }
 }
 
 template <class Mesh, class Mesh_ops>
-void PTQ_classify_vertices<Mesh, Mesh_ops>::reset_facets_marks(Mirror_mesh& mirror)
+void PTQ_classify_vertices<Mesh, Mesh_ops>::extract(
+                                          Mesh& mesh,
+                                          const Mesh_ops& m_ops,
+                                          Mirror_mesh& mirror,
+                                          std::vector<Vertex_handle>& handles)
 {
-  for (Mirror_facet_handle f = mirror.facets_begin(); f != mirror.facets_end(); ++f)
+  handles.clear();
+  handles.reserve(mesh.size_of_vertices());
+  for (auto v = mesh.vertices_begin(); v != mesh.vertices_end(); ++v)
   {
-    f->set_visited(false);
+    handles.push_back(v);
   }
+
+  std::vector<Mirror_mesh::Corners> facets;
+  facets.reserve(mesh.size_of_facets());
+  for (auto f = mesh.facets_begin(); f != mesh.facets_end(); ++f)
+  {
+    Halfedge_handle h = f->facet_begin();
+    facets.push_back({m_ops.get_vertex_id(h->vertex()),
+                      m_ops.get_vertex_id(h->next()->vertex()),
+                      m_ops.get_vertex_id(h->next()->next()->vertex())});
+  }
+  mirror.assign(handles.size(), facets);
+
+  assert(mirror.size_of_facets() == mesh.size_of_facets());
+  assert(mirror.size_of_vertices() == mesh.size_of_vertices());
 }
 
 
 template <class Mesh, class Mesh_ops>
-bool PTQ_classify_vertices<Mesh, Mesh_ops>::precheck(Mirror_mesh& mirror)
+bool PTQ_classify_vertices<Mesh, Mesh_ops>::precheck(const Mirror_mesh& mirror)
 {
   assert(!mirror.empty());
   // Face size should be a factor of 4
@@ -794,20 +1170,26 @@ bool PTQ_classify_vertices<Mesh, Mesh_ops>::precheck(Mirror_mesh& mirror)
   }
 
   // Irregular vertices should not connected.
-  for (auto h = mirror.edges_begin(); h != mirror.edges_end(); ++h)
+  for (int h = 0; h < mirror.size_of_halfedges(); ++h)
   {
+    // Visit every edge once.
+    if (!mirror.is_border_edge(h) && mirror.opposite(h) < h)
+    {
+      continue;
+    }
+
     bool irregular = true;
 
-    Mirror_vertex_handle v0 = h->vertex();
-    Mirror_vertex_handle v1 = h->opposite()->vertex();
+    int v0 = mirror.vertex(h);
+    int v1 = mirror.source(h);
 
     // Regular border vertex has valence 4.
     // Regular inner vertex has valence 6.
-    irregular = v0->is_border() ? 
-                (irregular && v0->degree() != 4) : (irregular && v0->degree() != 6);
+    irregular = mirror.is_border(v0) ? 
+                (irregular && mirror.degree(v0) != 4) : (irregular && mirror.degree(v0) != 6);
 
-    irregular = v1->is_border() ? 
-                (irregular && v1->degree() != 4) : (irregular && v1->degree() != 6);
+    irregular = mirror.is_border(v1) ? 
+                (irregular && mirror.degree(v1) != 4) : (irregular && mirror.degree(v1) != 6);
 
     if (irregular)
     {
@@ -818,13 +1200,12 @@ bool PTQ_classify_vertices<Mesh, Mesh_ops>::precheck(Mirror_mesh& mirror)
 }
 
 template <class Mesh, class Mesh_ops>
-int PTQ_classify_vertices<Mesh, Mesh_ops>::size_of_borders(Mirror_mesh& mirror)
+int PTQ_classify_vertices<Mesh, Mesh_ops>::size_of_borders(const Mirror_mesh& mirror)
 {
   int size = 0;
-  for (Mirror_halfedge_handle h = mirror.halfedges_begin();
-       h != mirror.halfedges_end(); ++h)
+  for (int h = 0; h < mirror.size_of_halfedges(); ++h)
   {
-    if (h->is_border())
+    if (mirror.is_border_edge(h))
     {
       ++size;
     }
@@ -833,119 +1214,157 @@ int PTQ_classify_vertices<Mesh, Mesh_ops>::size_of_borders(Mirror_mesh& mirror)
 }
 
 template <class Mesh, class Mesh_ops>
-std::vector<typename PTQ_classify_vertices<Mesh, Mesh_ops>::Mirror_facet_handle>
-PTQ_classify_vertices<Mesh, Mesh_ops>::get_seed_faces(Mirror_mesh& mesh)
+std::vector<int>
+PTQ_classify_vertices<Mesh, Mesh_ops>::get_seed_faces(const Mirror_mesh& mesh)
 {
-  std::vector<Mirror_facet_handle> seeds;
+  std::vector<int> seeds;
 
-  Mirror_facet_handle f = mesh.facets_begin();
+  int f = 0;
 
   seeds.push_back(f);
 
-  Mirror_halfedge_handle h = f->facet_begin();
+  int h = Mirror_mesh::facet_begin(f);
 
   do
   {
-    if (!h->is_border_edge())
+    if (!mesh.is_border_edge(h))
     {
-      seeds.push_back(h->opposite()->face());
+      seeds.push_back(Mirror_mesh::facet(mesh.opposite(h)));
     }
-    h = h->next();
+    h = Mirror_mesh::next(h);
   }
-  while (h != f->facet_begin());
+  while (h != Mirror_mesh::facet_begin(f));
 
   return seeds;
 }
 
+template <class Mesh, class Mesh_ops>
+int PTQ_classify_vertices<Mesh, Mesh_ops>::run_crawlers(
+                                            std::vector<Crawler>& crawlers,
+                                            std::size_t size_of_facets,
+                                            int num_threads)
+{
+  // Below this many faces, a crawl costs less than starting a thread.
+  const std::size_t min_parallel_facets = 4096;
+
+  const int size = crawlers.size();
+
+  // The lowest index of the successful crawlers so far.
+  std::atomic<int> first_success {size};
+
+  auto run = [&crawlers, &first_success](int i)
+             {
+#if defined(IS_RUNNING_TESTS)
+               // The tests compare all the successful crawlers.
+               auto stop = [] { return false; };
+#else
+               auto stop = [&first_success, i]
+                           {
+                             return first_success.load(std::memory_order_relaxed) < i;
+                           };
+               if (stop())
+               {
+                 return;
+               }
+#endif
+               if (crawlers[i].crawl(stop))
+               {
+                 int first = first_success.load();
+                 while (i < first &&
+                        !first_success.compare_exchange_weak(first, i))
+                 {
+                 }
+               }
+             };
+
+  // The crawlers are taken in index order, so a crawler after a successful
+  // one gives up without crawling.
+  parallel_for_each_index(size,
+                          size_of_facets < min_parallel_facets ? 1 : num_threads,
+                          run);
+
+  int first = first_success.load();
+  return first < size ? first : -1;
+}
+
 template <class Mesh,class Mesh_ops>
-void PTQ_classify_vertices<Mesh, Mesh_ops>::coarsen_mirror_dump_vertices(
+bool PTQ_classify_vertices<Mesh, Mesh_ops>::coarsen_mirror_dump_vertices(
                                Mirror_mesh& mirror,
-                               const std::vector<Mirror_facet_handle>& fine_faces,
+                               const std::vector<int>& fine_faces,
+                               const std::vector<Vertex_handle>& handles,
                                const Mesh_ops& m_ops,
+                               std::vector<int>& order,
+                               std::vector<std::pair<int, int>>& parents,
                                std::vector<Vertex_handle>& vertices,
                                std::vector<Vertex_handle*>& bands,
                                int level,
                                int& v_back_idx,
                                Vertex_tracker& v_tracker)
 {
-  // Remove faces
-  for (const Mirror_facet_handle& f : fine_faces)
-  {
-    Mirror_halfedge_handle h = f->facet_begin();
-    std::vector<int> ids(3);
-    for (int i = 0; i < 3; ++i)
-    {
-      assert(m_ops.get_vertex_level(h->vertex()->point()) == level);
-      ids[i] = m_ops.get_vertex_id(h->vertex()->point());
-      h->vertex()->set_finer(true);
-      h = mirror.join_facet(h);
-      assert(h == f->facet_begin());
-    }
-    assert(h == f->facet_begin());
-    assert(f->facet_degree() == 6);
-  }
-
   assert(v_back_idx == mirror.size_of_vertices());
 
-  // Dump the finer vertices to the array and remove from mirror
-  for (Mirror_vertex_handle v = mirror.vertices_begin();
-       v != mirror.vertices_end();)
+  // Remove the finer vertices from the mirror and dump them to the array
+  bool coarsened = mirror.coarsen(fine_faces,
+                 [&](int point, int parent0, int parent1)
+                 {
+                   Vertex_handle v0 = handles[point];
+                   // Parent vertices.
+                   Vertex_handle p0 = handles[parent0];
+                   Vertex_handle p1 = handles[parent1];
+                   assert(p0 != p1);
+                   assert(m_ops.get_vertex_level(v0) == level);
+
+                   // Set this vertex type to EDGE_VERTEX
+                   m_ops.set_vertex_type(v0, EDGE_VERTEX);
+
+                   // Set the level of its parents to level - 1
+                   m_ops.set_vertex_level(p0, level - 1);
+                   m_ops.set_vertex_level(p1, level - 1);
+
+                   // Check vertex type
+                   assert(m_ops.get_vertex_type(p0) == OLD_VERTEX);
+                   assert(m_ops.get_vertex_type(p1) == OLD_VERTEX);
+
+                   // Insert v0 and the halfedges to its parent to vertex tracker.
+                   v_tracker.set_hs_to_parents(v0, {p0, p1});
+                   parents[point] = {parent0, parent1};
+
+                   --v_back_idx;
+                   order[v_back_idx] = point;
+                   assert(v_back_idx > 0);
+                 });
+
+  if (!coarsened)
   {
-    Mirror_vertex_handle tmp = v++;
-    if (tmp->is_finer())
-    {
-      assert(tmp->degree() == 2);
-      // Add its neighbors to v_tracker
-      Vertex_handle v0 = tmp->point();
-      Mirror_halfedge_handle h0 = tmp->vertex_begin();
-      Mirror_halfedge_handle h1 = h0->next();
-      assert(h1->opposite()->vertex() == tmp);
-      // Parent vertices.
-      // h0 is pointed to tmp
-      Vertex_handle p0 = h0->opposite()->vertex()->point();
-      // h1->opposite() is pointed to tmp
-      Vertex_handle p1 = h1->vertex()->point();
-      assert(p0 != p1);
-      assert(m_ops.get_vertex_level(v0) == level);
-
-      // Set this vertex type to EDGE_VERTEX
-      m_ops.set_vertex_type(v0, EDGE_VERTEX);
-
-      // Set the level of its parents to level - 1
-      m_ops.set_vertex_level(p0, level - 1);
-      m_ops.set_vertex_level(p1, level - 1);
-
-      // Check vertex type
-      assert(m_ops.get_vertex_type(p0) == OLD_VERTEX);
-      assert(m_ops.get_vertex_type(p1) == OLD_VERTEX);
-
-      // Insert v0 and the halfedges to its parent to vertex tracker.
-      v_tracker.set_hs_to_parents(v0, {p0, p1});
-
-      --v_back_idx;
-      vertices[v_back_idx] = v0;
-      assert(v_back_idx > 0);
-
-      // Coarsen mirror
-      Join_vertex join_vertex(h0->opposite());
-      mirror.delegate(join_vertex);
-    }
+    return false;
   }
+
   assert(v_back_idx == mirror.size_of_vertices());
   bands[level] = &vertices[v_back_idx];
+  return true;
 }
 
+// A border loop of two halfedges is left where two border edges join the
+// same vertices in opposite directions.
 template <class Mesh, class Mesh_ops>
 bool PTQ_classify_vertices<Mesh, Mesh_ops>::border_post_check(const Mirror_mesh& mirror)
 {
-  for (auto h = mirror.halfedges_begin(); h != mirror.halfedges_end(); ++h)
+  std::vector<std::pair<int, int>> borders;
+  for (int h = 0; h < mirror.size_of_halfedges(); ++h)
   {
-    if (h->is_border())
+    if (mirror.is_border_edge(h))
     {
-      if (h->next()->next() == h)
-      {
-        return false;
-      }
+      borders.emplace_back(mirror.source(h), mirror.vertex(h));
+    }
+  }
+  std::sort(borders.begin(), borders.end());
+  for (const std::pair<int, int>& b : borders)
+  {
+    if (std::binary_search(borders.begin(),
+                           borders.end(),
+                           std::make_pair(b.second, b.first)))
+    {
+      return false;
     }
   }
   return true;
@@ -953,93 +1372,33 @@ bool PTQ_classify_vertices<Mesh, Mesh_ops>::border_post_check(const Mirror_mesh&
 
 template <class Mesh, class Mesh_ops>
 int PTQ_classify_vertices<Mesh, Mesh_ops>::sum_of_vids(
-                  const std::vector<Mirror_facet_handle>& faces,
+                  const Mirror_mesh& mirror,
+                  const std::vector<int>& faces,
+                  const std::vector<Vertex_handle>& handles,
                   const Mesh_ops& m_ops)
 {
   int sum = 0;
-  for (const Mirror_facet_handle& f : faces)
+  for (int f : faces)
   {
-    Mirror_halfedge_handle h = f->facet_begin();
+    int h = Mirror_mesh::facet_begin(f);
     do
     {
-      if (h->vertex()->is_border())
+      int v = mirror.vertex(h);
+      if (mirror.is_border(v))
       {
-        sum += m_ops.get_vertex_id(h->vertex()->point());
+        sum += m_ops.get_vertex_id(handles[mirror.point(v)]);
       }
       else
       {
-        sum += m_ops.get_vertex_id(h->vertex()->point()) / 2.0;
+        sum += m_ops.get_vertex_id(handles[mirror.point(v)]) / 2.0;
       }
-      h = h->next();
+      h = Mirror_mesh::next(h);
     }
-    while (h != f->facet_begin());
+    while (h != Mirror_mesh::facet_begin(f));
   }
 
   return sum;
 }
 
-template <class Mesh, class Mesh_ops>
-PTQ_classify_vertices<Mesh, Mesh_ops>::Extract_mesh::Extract_mesh(Mesh& mesh): mesh_(mesh)
-{}
-
-
-template <class Mesh, class Mesh_ops>
-void PTQ_classify_vertices<Mesh, Mesh_ops>::Extract_mesh::operator()(typename Mirror_mesh::HDS &hds)
-{
-#if !defined (WTLIB_USE_CUSTOM_MESH)
-  Vertex_property vids;
-#endif
-  CGAL::Polyhedron_incremental_builder_3<typename Mirror_mesh::HDS> b(hds);
-
-  b.begin_surface(mesh_.size_of_vertices(), mesh_.size_of_facets());
-
-  for (auto [v, id] = std::make_pair(mesh_.vertices_begin(), 0);
-       v != mesh_.vertices_end();
-       ++v, ++id)
-  {
-    b.add_vertex(v);
-#if !defined (WTLIB_USE_CUSTOM_MESH)
-    vids[v] = id;
-#else
-    v->id = id;
-#endif
-  }
-
-  for (auto f = mesh_.facets_begin(); f != mesh_.facets_end(); ++f)
-  {
-    b.begin_facet();
-
-    Halfedge_handle h = f->facet_begin();
-    do
-    {
-      Vertex_handle v = h->vertex();
-#if !defined (WTLIB_USE_CUSTOM_MESH)
-      int id = vids.at(v);
-#else
-      int id = v->id;
-#endif
-      b.add_vertex_to_facet(id);
-      h = h->next();
-    }
-    while (h != f->facet_begin());
-
-    b.end_facet();
-  }
-  b.end_surface();
-}
-
-
-template <class Mesh, class Mesh_ops>
-PTQ_classify_vertices<Mesh, Mesh_ops>::Join_vertex::Join_vertex(Mirror_halfedge_handle h):h_(h)
-{}
-
-
-template <class Mesh, class Mesh_ops>
-void PTQ_classify_vertices<Mesh, Mesh_ops>::Join_vertex::operator()(typename Mirror_mesh::HDS &hds)
-{
-  CGAL::HalfedgeDS_decorator<typename Mirror_mesh::HDS> d(hds);
-  d.join_vertex(h_);
 }
-
-}
-#endif
\ No newline at end of file
+#endif
@@ -3,140 +3,338 @@
 
 /**
  * @file  vertex_classification_mirror_mesh.hpp
- * @brief This file defines several basic types that are used to instantiate
- *        CGAL::Polyhedron_3 and then define the mirror mesh. The mirror mesh is
- *        used for avoding breaking the original mesh structure while
- *        identifying subdivision connectivity and classifying vertices.
+ * @brief This file defines the mirror mesh, which copies the connectivity of a
+ *        triangle mesh into flat arrays. The mirror is used for avoding
+ *        breaking the original mesh structure while identifying subdivision
+ *        connectivity and classifying vertices.
  *
  */
 
-#include <CGAL/HalfedgeDS_face_base.h>
-#include <CGAL/HalfedgeDS_vertex_base.h>
-#include <CGAL/HalfedgeDS_halfedge_base.h>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <utility>
+#include <vector>
 
 namespace wtlib::ptq_impl
 {
 
 /**
- * @brief The type traits of the mirror mesh. The type traits follow the
- *        requirement of CGAL, so the CGAL halfedge data structure can be used
- *        to construct the mirror mesh.
+ * @brief The mirror mesh, an index-based triangle mesh. The halfedges of a
+ *        facet f are 3 * f, 3 * f + 1 and 3 * f + 2, halfedge 3 * f + k goes
+ *        from corner k to corner (k + 1) % 3 of the facet. A border halfedge
+ *        has no opposite, i.e., the mirror only stores the halfedges of the
+ *        facets. Every vertex holds the index of the vertex of the mesh that
+ *        is mirrored as its point.
  *
- * @tparam M 
+ *        The border flags of the vertices are computed from the mesh that is
+ *        mirrored and kept by coarsening, and the degree of a vertex counts
+ *        its incident edges, border edges included.
  */
-template <class M>
-class Traits
+class Mirror_mesh
 {
 public:
+  using Corners = std::array<int, 3>;
+
   /**
-   * @brief The point type of the mirror, which is a vertex handle of the mesh
-   *        that is mirrored.
+   * @brief      Copy the connectivity of a triangle mesh.
    *
+   * @param[in]  num_vertices  The number of vertices, the points of the
+   *                           vertices are 0, ..., num_vertices - 1.
+   * @param[in]  facets        The three vertices of every facet, in
+   *                           counterclockwise order.
    */
-  using Point_3 = typename M::Vertex_handle;
-  using Point = Point_3;
-  
-  class No_plane {};
-  using Plane_3 = No_plane;
-
-  using size_type = std::size_t;
-  using FT = double;
-};
+  void assign(int num_vertices, const std::vector<Corners>& facets)
+  {
+    corners_.clear();
+    corners_.reserve(3 * facets.size());
+    for (const Corners& f : facets)
+    {
+      corners_.insert(corners_.end(), f.begin(), f.end());
+    }
 
-/**
- * @brief The vertex definition of the mirror mesh, which holds a vertex handle
- *        of the original mesh as its point. 
- *
- * @tparam Refs   The type of a container that hold the vertices.
- * @tparam P      Point type, which will be instantiated as Vertex_handle.
- */
-template <class Refs, class P>
-class Mirror_vertex: public CGAL::HalfedgeDS_vertex_base<Refs, CGAL::Tag_true, P>
-{
-public:
-  using Base = CGAL::HalfedgeDS_vertex_base<Refs, CGAL::Tag_true, P>;
-  using Point = P;
-  using Target = Point;
+    points_.resize(num_vertices);
+    for (int v = 0; v < num_vertices; ++v)
+    {
+      points_[v] = v;
+    }
+
+    // Bucket the halfedges by their source vertices, then find the opposite
+    // of a halfedge among the halfedges leaving its target.
+    int num_halfedges = corners_.size();
+    std::vector<int> offsets(num_vertices + 1, 0);
+    for (int h = 0; h < num_halfedges; ++h)
+    {
+      ++offsets[source(h) + 1];
+    }
+    for (int v = 0; v < num_vertices; ++v)
+    {
+      offsets[v + 1] += offsets[v];
+    }
+    std::vector<int> outgoing(num_halfedges);
+    {
+      std::vector<int> fill(offsets.begin(), offsets.end() - 1);
+      for (int h = 0; h < num_halfedges; ++h)
+      {
+        outgoing[fill[source(h)]++] = h;
+      }
+    }
+
+    opposites_.assign(num_halfedges, -1);
+    for (int h = 0; h < num_halfedges; ++h)
+    {
+      int s = source(h);
+      int t = vertex(h);
+      for (int i = offsets[t]; i < offsets[t + 1]; ++i)
+      {
+        if (vertex(outgoing[i]) == s)
+        {
+          opposites_[h] = outgoing[i];
+          break;
+        }
+      }
+    }
 
-  
-  Mirror_vertex(): Base(), border_(false), finer_(false) {};
-  Mirror_vertex(const Point& p): Base(p), border_(false), finer_(false) {};
+    borders_.assign(num_vertices, false);
+    for (int h = 0; h < num_halfedges; ++h)
+    {
+      if (is_border_edge(h))
+      {
+        borders_[source(h)] = true;
+        borders_[vertex(h)] = true;
+      }
+    }
 
-  void set_border(bool b)
+    update_degrees();
+  }
+
+  /**
+   * @brief      Coarsen the mirror by one level of PTQ. The center facets
+   *             become the facets of the coarser mirror, in their relative
+   *             order, and the vertices of the center facets (the finer
+   *             vertices) are removed.
+   *
+   * @param[in]  center_facets  The center facets, none of which has a border
+   *                            edge.
+   * @param[in]  dump           Called as dump(point, parent0, parent1) with the
+   *                            points of every finer vertex and of the two
+   *                            vertices of its coarser edge, in the vertex
+   *                            order.
+   *
+   * @return     false if the center facets do not form a PTQ, i.e., a finer
+   *             vertex would split an edge of a coarser vertex to itself or to
+   *             another finer vertex. The mirror is left unchanged then.
+   */
+  template <class Dump>
+  bool coarsen(const std::vector<int>& center_facets, Dump dump);
+
+  int size_of_vertices() const
   {
-    border_ = b;
+    return points_.size();
   }
-  
-  bool is_border() const
+
+  int size_of_facets() const
   {
-    return border_;
+    return corners_.size() / 3;
   }
-  
-  void set_finer(bool finer)
+
+  int size_of_halfedges() const
   {
-    finer_ = finer;
+    return corners_.size();
   }
 
-  bool is_finer() const
+  bool empty() const
   {
-    return finer_;
+    return corners_.empty();
   }
 
-private:
-  bool border_;
+  static int facet(int h)
+  {
+    return h / 3;
+  }
 
   /**
-   * @brief Flags whether the mirror as well as the mirrored vertex is a finer
-   *        vertex.
-   *
+   * @brief      The first halfedge of a facet, which points to its corner 0.
    */
-  bool finer_;
-};
+  static int facet_begin(int f)
+  {
+    return 3 * f + 2;
+  }
+
+  static int next(int h)
+  {
+    return h % 3 == 2 ? h - 2 : h + 1;
+  }
 
+  static int prev(int h)
+  {
+    return h % 3 == 0 ? h + 2 : h - 1;
+  }
 
-template <class Refs>
-class Mirror_face: public CGAL::HalfedgeDS_face_base<Refs>
-{
-public:
-  void set_visited(bool v)
+  /**
+   * @brief      The target vertex of a halfedge.
+   */
+  int vertex(int h) const
   {
-    visited_ = v;
+    return corners_[next(h)];
   }
 
-  bool visited() const
+  int source(int h) const
   {
-    return visited_;
+    return corners_[h];
+  }
+
+  /**
+   * @brief      The opposite halfedge, or -1 for a border edge.
+   */
+  int opposite(int h) const
+  {
+    return opposites_[h];
+  }
+
+  bool is_border_edge(int h) const
+  {
+    return opposites_[h] < 0;
+  }
+
+  int point(int v) const
+  {
+    return points_[v];
+  }
+
+  bool is_border(int v) const
+  {
+    return borders_[v];
+  }
+
+  int degree(int v) const
+  {
+    return degrees_[v];
   }
 
 private:
-  bool visited_;
+  void update_degrees()
+  {
+    // An edge is counted by its halfedge pointing to the vertex, a border
+    // edge by the halfedge leaving the vertex.
+    degrees_.assign(points_.size(), 0);
+    for (int h = 0; h < size_of_halfedges(); ++h)
+    {
+      ++degrees_[vertex(h)];
+      if (is_border_edge(h))
+      {
+        ++degrees_[source(h)];
+      }
+    }
+  }
+
+  std::vector<int> corners_;
+  std::vector<int> opposites_;
+  std::vector<int> points_;
+  std::vector<bool> borders_;
+  std::vector<int> degrees_;
 };
 
-/**
- * @brief    Items wrapper. It is required by CGAL::Polyhedron_3 specifications.
- * 
- */
-class Mirror_mesh_items
+// A center facet (e0, e1, e2) is surrounded by the corner facets across its
+// halfedges. The corner facet across ek -> ek+1 holds the coarser vertex ok,
+// so the coarser facet is (o0, o1, o2) and ek+1 splits its edge ok -> ok+1.
+// That edge is made of the halfedge ok -> ek+1 of the corner facet k, and the
+// halfedge ek+1 -> ok+1 of the corner facet k + 1. The opposites of the
+// coarser halfedges follow from the opposites of their first halves, which
+// are second halves of the neighbouring coarser halfedges.
+template <class Dump>
+bool Mirror_mesh::coarsen(const std::vector<int>& center_facets, Dump dump)
 {
-public:
-  template <class Refs, class Traits>
-  struct Vertex_wrapper
+  std::vector<int> centers {center_facets};
+  std::sort(centers.begin(), centers.end());
+
+  std::vector<bool> finer(size_of_vertices(), false);
+  std::vector<std::pair<int, int>> parents(size_of_vertices(), {-1, -1});
+  // The coarser halfedge of which a halfedge is the second half.
+  std::vector<int> owners(size_of_halfedges(), -1);
+  std::vector<int> corners;
+  corners.reserve(3 * centers.size());
+
+  for (int g = 0; g < static_cast<int>(centers.size()); ++g)
   {
-    using Point = typename Traits::Point_3;
-    using Vertex = Mirror_vertex<Refs, Point>;
-  };
+    int f = centers[g];
+    int opposites[3];
+    for (int k = 0; k < 3; ++k)
+    {
+      opposites[k] = opposite(3 * f + k);
+      assert(opposites[k] >= 0);
+    }
+    for (int k = 0; k < 3; ++k)
+    {
+      int e = source(3 * f + (k + 1) % 3);
+      int o0 = source(prev(opposites[k]));
+      int o1 = source(prev(opposites[(k + 1) % 3]));
+      finer[e] = true;
+      if (parents[e].first < 0)
+      {
+        parents[e] = {o0, o1};
+      }
+      corners.push_back(o0);
+      owners[next(opposites[(k + 1) % 3])] = 3 * g + k;
+    }
+  }
 
-  template <class Refs, class Traits>
-  struct Halfedge_wrapper
+  for (int v = 0; v < size_of_vertices(); ++v)
   {
-    using Halfedge = CGAL::HalfedgeDS_halfedge_base<Refs>;
-  };
+    if (finer[v] &&
+        (parents[v].first == parents[v].second ||
+         finer[parents[v].first] ||
+         finer[parents[v].second]))
+    {
+      return false;
+    }
+  }
 
-  template <class Refs, class Traits>
-  struct Face_wrapper
+  std::vector<int> opposites(corners.size());
+  for (int g = 0; g < static_cast<int>(centers.size()); ++g)
   {
-    using Face = Mirror_face<Refs>;
-  };
-};
+    int f = centers[g];
+    for (int k = 0; k < 3; ++k)
+    {
+      int first_half = prev(opposite(3 * f + k));
+      int h = opposite(first_half);
+      opposites[3 * g + k] = h < 0 ? -1 : owners[h];
+      assert(h < 0 || owners[h] >= 0);
+    }
+  }
+
+  for (int v = 0; v < size_of_vertices(); ++v)
+  {
+    if (finer[v])
+    {
+      dump(points_[v], points_[parents[v].first], points_[parents[v].second]);
+    }
+  }
+
+  // Remove the finer vertices, the other vertices keep their relative order.
+  std::vector<int> indices(size_of_vertices(), -1);
+  int size = 0;
+  for (int v = 0; v < size_of_vertices(); ++v)
+  {
+    if (!finer[v])
+    {
+      indices[v] = size;
+      points_[size] = points_[v];
+      borders_[size] = borders_[v];
+      ++size;
+    }
+  }
+  points_.resize(size);
+  borders_.resize(size);
+
+  for (int& v : corners)
+  {
+    v = indices[v];
+  }
+  corners_ = std::move(corners);
+  opposites_ = std::move(opposites);
+  update_degrees();
+  return true;
+}
 }  // namespace wtlib::ptq_impl
 #endif
@@ -0,0 +1,1091 @@
+#ifndef WTLIB_TRANSFORM_PLAN_HPP
+#define WTLIB_TRANSFORM_PLAN_HPP
+
+/**
+ * @file     transform_plan.hpp
+ * @brief    Defines a reusable plan of the Loop and Butterfly wavelet
+ *           transforms for meshes sharing one connectivity.
+ *
+ * Building a plan classifies the vertices and records the lifting stencils of
+ * every level once. Afterwards the forward and inverse transforms of any
+ * vertex positions with the same connectivity (e.g., the frames of an
+ * animation) only gather and scatter over the x, y and z coordinate arrays,
+ * without classifying the vertices or coarsening/refining a mesh. The same
+ * stencils also lift any number of per-vertex attribute channels (e.g.,
+ * normals, colours or scalar fields), together with the positions or on their
+ * own. The lifting kernels of double values use AVX2 or AVX-512 when the CPU
+ * supports them (see ptq_impl::set_simd_isa).
+ *
+ * The levels and bands of the plan are index ranges of the classified
+ * vertices, so the overloads taking a mesh transform its geometry while the
+ * finest connectivity stays intact: a forward and inverse transform of the
+ * mesh only reads and writes the vertex positions.
+ */
+
+#include <wtlib/classification_certificate.hpp>
+#include <wtlib/compact_mesh.hpp>
+#include <wtlib/ptq_impl/lifting_stencils.hpp>
+#include <wtlib/ptq_impl/mesh_vertex_info.hpp>
+#include <wtlib/ptq_impl/subdivision_modifier.hpp>
+#include <wtlib/ptq_impl/vertex_classification.hpp>
+#include <wtlib/wavelet_coefficients.hpp>
+
+#include <CGAL/Origin.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace wtlib
+{
+/**
+ * @brief    A precomputed wavelet transform of a fixed mesh connectivity.
+ *
+ * @tparam   Kernel    The geometric kernel of the vertex positions.
+ * @tparam   Stencils  The lifting stencils of one level (e.g.,
+ *                     ptq_impl::Loop_stencils).
+ */
+template <class Kernel, class Stencils>
+class Transform_plan
+{
+public:
+  using Point_3 = typename Kernel::Point_3;
+  using Vector_3 = typename Kernel::Vector_3;
+  using FT = typename Kernel::FT;
+
+  /**
+   * @brief    The wavelet coefficients of one attribute channel, where
+   *           coefs[level][i] is the i-th coefficient of a level.
+   */
+  using Channel_coefficients = std::vector<std::vector<FT>>;
+
+  /**
+   * @brief      Build the plan from a mesh with subdivision connectivity.
+   *             The mesh is not modified.
+   *
+   * @param[in]  mesh        The finest resolution mesh (e.g., a
+   *                         CGAL::Polyhedron_3)
+   * @param[in]  num_levels  The number of transform levels.
+   *
+   * @return     false if the mesh does not have enough levels of subdivision
+   *             connectivity, true otherwise.
+   */
+  template <class Polyhedron>
+  bool build(const Polyhedron& mesh, int num_levels);
+
+  /**
+   * @brief      Overloaded build for a Compact_mesh.
+   */
+  bool build(const Compact_mesh<Kernel>& mesh, int num_levels);
+
+  /**
+   * @brief      Overloaded build with a certificate of the subdivision
+   *             connectivity, which skips the vertex classification if it
+   *             matches the mesh and is replaced otherwise (see
+   *             ptq_impl::PTQ_classify_vertices::classify).
+   */
+  template <class Polyhedron>
+  bool build(const Polyhedron& mesh,
+             int num_levels,
+             Classification_certificate& certificate);
+
+  bool build(const Compact_mesh<Kernel>& mesh,
+             int num_levels,
+             Classification_certificate& certificate);
+
+  /**
+   * @brief      Refine a coarse mesh num_levels times with the PTQ rule and
+   *             build the plan of the refined mesh. The connectivity of the
+   *             finest level is computed at once and the mesh is rebuilt once
+   *             (see ptq_impl::PTQ_subdivision_modifier::refine_levels), then
+   *             synthesize(mesh, points, coefs) lifts the levels on the
+   *             finest mesh. The refined vertices are ordered as the inverse
+   *             transform orders them, the edge vertices are at the origin.
+   *
+   * @param      mesh        The coarse mesh, refined in place.
+   * @param[in]  num_levels  The number of transform levels.
+   *
+   * @return     false if the mesh is not supported, in which case it is not
+   *             modified.
+   */
+  template <class Polyhedron>
+  bool build_refined(Polyhedron& mesh, int num_levels);
+
+  bool build_refined(Compact_mesh<Kernel>& mesh, int num_levels);
+
+  /**
+   * @brief      The forward wavelet transform.
+   *
+   * @param      points  The vertex positions of the finest mesh, in the
+   *                     vertex order of the mesh used to build the plan. On
+   *                     return the positions of the coarsest mesh, in the
+   *                     vertex order of the coarsened mesh.
+   * @param      coefs   The wavelet coefficients, in the same layout as the
+   *                     coefficients of loop_analyze and butterfly_analyze.
+   *
+   * @return     false if the number of points does not match the plan.
+   */
+  bool analyze(std::vector<Point_3>& points,
+               std::vector<std::vector<Vector_3>>& coefs) const;
+
+  /**
+   * @brief      The inverse wavelet transform.
+   *
+   * @param      points  The vertex positions of the coarsest mesh. On return
+   *                     the positions of the finest mesh, in the vertex order
+   *                     of the mesh used to build the plan.
+   * @param[in]  coefs   The wavelet coefficients.
+   *
+   * @return     false if the number of points or coefficients does not match
+   *             the plan.
+   */
+  bool synthesize(std::vector<Point_3>& points,
+                  const std::vector<std::vector<Vector_3>>& coefs) const;
+
+  /**
+   * @brief      The forward wavelet transform of per-vertex attributes.
+   *
+   * @param      values        The attributes of the finest mesh, num_channels
+   *                           interleaved values per vertex, in the vertex
+   *                           order of the mesh used to build the plan. On
+   *                           return the attributes of the coarsest mesh, in
+   *                           the vertex order of the coarsened mesh.
+   * @param[in]  num_channels  The number of values per vertex.
+   * @param      coefs         The wavelet coefficients of each channel.
+   *
+   * @return     false if the number of values does not match the plan.
+   */
+  bool analyze(std::vector<FT>& values,
+               int num_channels,
+               std::vector<Channel_coefficients>& coefs) const;
+
+  /**
+   * @brief      The inverse wavelet transform of per-vertex attributes.
+   *
+   * @param      values        The interleaved attributes of the coarsest
+   *                           mesh. On return the attributes of the finest
+   *                           mesh, in the vertex order of the mesh used to
+   *                           build the plan.
+   * @param[in]  num_channels  The number of values per vertex.
+   * @param[in]  coefs         The wavelet coefficients of each channel.
+   *
+   * @return     false if the number of values or coefficients does not match
+   *             the plan.
+   */
+  bool synthesize(std::vector<FT>& values,
+                  int num_channels,
+                  const std::vector<Channel_coefficients>& coefs) const;
+
+  /**
+   * @brief      The forward wavelet transform of the vertex positions and of
+   *             per-vertex attributes, lifted in the same pass.
+   *
+   * @see        The overloads for positions and for attributes.
+   */
+  bool analyze(std::vector<Point_3>& points,
+               std::vector<std::vector<Vector_3>>& coefs,
+               std::vector<FT>& values,
+               int num_channels,
+               std::vector<Channel_coefficients>& value_coefs) const;
+
+  /**
+   * @brief      The inverse wavelet transform of the vertex positions and of
+   *             per-vertex attributes, lifted in the same pass.
+   */
+  bool synthesize(std::vector<Point_3>& points,
+                  const std::vector<std::vector<Vector_3>>& coefs,
+                  std::vector<FT>& values,
+                  int num_channels,
+                  const std::vector<Channel_coefficients>& value_coefs) const;
+
+  /**
+   * @brief      The forward wavelet transform of the geometry of a mesh, which
+   *             keeps the mesh unchanged.
+   *
+   * @param[in]  mesh    The finest resolution mesh, with the connectivity of
+   *                     the mesh used to build the plan.
+   * @param      points  On return the positions of the coarsest mesh, in the
+   *                     vertex order of the coarsened mesh.
+   * @param      coefs   The wavelet coefficients, with one band per level.
+   *
+   * @return     false if the number of vertices does not match the plan.
+   */
+  template <class Polyhedron>
+  bool analyze(const Polyhedron& mesh,
+               std::vector<Point_3>& points,
+               Wavelet_coefficients<Vector_3>& coefs) const;
+
+  /**
+   * @brief      The inverse wavelet transform of the geometry of a mesh, which
+   *             sets the vertex positions and keeps the connectivity.
+   *
+   * @param      mesh    The finest resolution mesh, with the connectivity of
+   *                     the mesh used to build the plan.
+   * @param[in]  points  The positions of the coarsest mesh.
+   * @param[in]  coefs   The wavelet coefficients.
+   *
+   * @return     false if the number of vertices, points or coefficients does
+   *             not match the plan.
+   */
+  template <class Polyhedron>
+  bool synthesize(Polyhedron& mesh,
+                  const std::vector<Point_3>& points,
+                  const Wavelet_coefficients<Vector_3>& coefs) const;
+
+  int num_levels() const
+  {
+    return static_cast<int>(levels_.size());
+  }
+
+  bool empty() const
+  {
+    return vertex_order_.empty();
+  }
+
+  /**
+   * @brief      The number of vertices of the mesh at a resolution level,
+   *             where 0 is the coarsest level.
+   */
+  int size_of_vertices(int level) const
+  {
+    return level_sizes_[level];
+  }
+
+  int size_of_vertices() const
+  {
+    return vertex_order_.size();
+  }
+
+  /**
+   * @brief      The index of each classified vertex in the vertex order of the
+   *             mesh used to build the plan.
+   */
+  const std::vector<int>& vertex_order() const
+  {
+    return vertex_order_;
+  }
+
+private:
+  // The channels of the vertices, in the classified order. The vertex
+  // positions take three channels.
+  struct Channels
+  {
+    Channels(int num_channels, std::size_t n)
+      : values(num_channels, std::vector<FT>(n))
+    {
+    }
+
+    ptq_impl::Channel_arrays<FT> arrays()
+    {
+      ptq_impl::Channel_arrays<FT> arrays;
+      for (std::vector<FT>& v : values)
+      {
+        arrays.push_back(v.data());
+      }
+      return arrays;
+    }
+
+    template <class Point_or_vector>
+    void set(int channel, std::size_t i, const Point_or_vector& p)
+    {
+      values[channel][i] = p.x();
+      values[channel + 1][i] = p.y();
+      values[channel + 2][i] = p.z();
+    }
+
+    Vector_3 vector(int channel, std::size_t i) const
+    {
+      return Vector_3(values[channel][i],
+                      values[channel + 1][i],
+                      values[channel + 2][i]);
+    }
+
+    std::vector<std::vector<FT>> values;
+  };
+
+  bool build(const Compact_mesh<Kernel>& mesh,
+             int num_levels,
+             Classification_certificate* certificate);
+
+  // Record the stencils of the classified mesh m, which is coarsened.
+  template <class Mesh_ops>
+  void build_levels(Compact_mesh<Kernel>& m,
+                    const Mesh_ops& mesh_ops,
+                    std::vector<typename Compact_mesh<Kernel>::Vertex_handle>& vertices,
+                    std::vector<typename Compact_mesh<Kernel>::Vertex_handle*>& bands,
+                    int num_levels);
+
+  bool check_points(const std::vector<Point_3>& points) const;
+
+  bool check_points(const std::vector<Point_3>& points,
+                    const std::vector<std::vector<Vector_3>>& coefs) const;
+
+  bool check_values(const std::vector<FT>& values, int num_channels) const;
+
+  bool check_values(const std::vector<FT>& values,
+                    int num_channels,
+                    const std::vector<Channel_coefficients>& coefs) const;
+
+  // Load the finest mesh into the channels.
+  void load_points(const std::vector<Point_3>& points,
+                   Channels& x,
+                   int channel) const;
+
+  void load_values(const std::vector<FT>& values,
+                   int num_channels,
+                   Channels& x,
+                   int channel) const;
+
+  // Store the analyzed channels as the coarsest mesh and the coefficients.
+  void store_points(const Channels& x,
+                    int channel,
+                    std::vector<Point_3>& points,
+                    std::vector<std::vector<Vector_3>>& coefs) const;
+
+  void store_values(const Channels& x,
+                    int channel,
+                    int num_channels,
+                    std::vector<FT>& values,
+                    std::vector<Channel_coefficients>& coefs) const;
+
+  // Load the coarsest mesh and the coefficients into the channels.
+  void load_points(const std::vector<Point_3>& points,
+                   const std::vector<std::vector<Vector_3>>& coefs,
+                   Channels& x,
+                   int channel) const;
+
+  void load_values(const std::vector<FT>& values,
+                   int num_channels,
+                   const std::vector<Channel_coefficients>& coefs,
+                   Channels& x,
+                   int channel) const;
+
+  void store_points(const Channels& x,
+                    int channel,
+                    std::vector<Point_3>& points,
+                    Wavelet_coefficients<Vector_3>& coefs) const;
+
+  // Load the coarsest mesh and the coefficients into the channels.
+  void load_points(const std::vector<Point_3>& points,
+                   const Wavelet_coefficients<Vector_3>& coefs,
+                   Channels& x,
+                   int channel) const;
+
+  // Store the synthesized channels as the finest mesh.
+  void store_points(const Channels& x,
+                    int channel,
+                    std::vector<Point_3>& points) const;
+
+  void store_values(const Channels& x,
+                    int channel,
+                    int num_channels,
+                    std::vector<FT>& values) const;
+
+  void analyze(Channels& x) const;
+
+  void synthesize(Channels& x) const;
+
+  std::vector<int> vertex_order_;
+  std::vector<int> level_sizes_;
+  // The stencils of lifting level l into level l + 1.
+  std::vector<Stencils> levels_;
+};  // class Transform_plan
+
+template <class Kernel>
+using Loop_transform_plan =
+  Transform_plan<Kernel, ptq_impl::Loop_stencils<typename Kernel::Vector_3>>;
+
+template <class Kernel>
+using Butterfly_transform_plan =
+  Transform_plan<Kernel, ptq_impl::Butterfly_stencils<typename Kernel::Vector_3>>;
+
+
+template <class Kernel, class Stencils>
+template <class Polyhedron>
+bool Transform_plan<Kernel, Stencils>::build(const Polyhedron& mesh,
+                                             int num_levels)
+{
+  Compact_mesh<Kernel> cm;
+  if (!polyhedron_to_compact_mesh(mesh, cm))
+  {
+    return false;
+  }
+  return build(cm, num_levels);
+}
+
+template <class Kernel, class Stencils>
+bool Transform_plan<Kernel, Stencils>::build(const Compact_mesh<Kernel>& mesh,
+                                             int num_levels)
+{
+  return build(mesh, num_levels, nullptr);
+}
+
+template <class Kernel, class Stencils>
+template <class Polyhedron>
+bool Transform_plan<Kernel, Stencils>::build(
+                                    const Polyhedron& mesh,
+                                    int num_levels,
+                                    Classification_certificate& certificate)
+{
+  Compact_mesh<Kernel> cm;
+  if (!polyhedron_to_compact_mesh(mesh, cm))
+  {
+    return false;
+  }
+  return build(cm, num_levels, &certificate);
+}
+
+template <class Kernel, class Stencils>
+bool Transform_plan<Kernel, Stencils>::build(
+                                    const Compact_mesh<Kernel>& mesh,
+                                    int num_levels,
+                                    Classification_certificate& certificate)
+{
+  return build(mesh, num_levels, &certificate);
+}
+
+template <class Kernel, class Stencils>
+bool Transform_plan<Kernel, Stencils>::build(
+                                    const Compact_mesh<Kernel>& mesh,
+                                    int num_levels,
+                                    Classification_certificate* certificate)
+{
+  using Mesh = Compact_mesh<Kernel>;
+  using Vertex_handle = typename Mesh::Vertex_handle;
+  using Mesh_info = ptq_impl::Mesh_info<Mesh>;
+  using Mesh_ops = ptq_impl::Mesh_info_operations<Mesh>;
+  using PTQ_classify = ptq_impl::PTQ_classify_vertices<Mesh, Mesh_ops>;
+
+  vertex_order_.clear();
+  level_sizes_.clear();
+  levels_.clear();
+
+  if (!Stencils::is_supported(mesh) || num_levels < 1)
+  {
+    return false;
+  }
+
+  // Coarsen a copy, the vertex indices of a fresh copy are the positions in
+  // the vertex order of the given mesh.
+  Mesh m {mesh};
+  m.collect_garbage();
+
+  Mesh_info mesh_info;
+  Mesh_ops mesh_ops {&mesh_info};
+
+  // Initialize the border information, the same as Wavelet_analyze.
+  for (auto v = m.vertices_begin(); v != m.vertices_end(); ++v)
+  {
+    mesh_ops.set_vertex_border(v, false);
+  }
+  for (auto h = m.halfedges_begin(); h != m.halfedges_end(); ++h)
+  {
+    if (h->is_border_edge())
+    {
+      mesh_ops.set_vertex_border(h->vertex(), true);
+      mesh_ops.set_vertex_border(h->opposite()->vertex(), true);
+    }
+  }
+
+  std::vector<Vertex_handle> vertices;
+  std::vector<Vertex_handle*> bands;
+  if (!(certificate ?
+        PTQ_classify::classify(m, mesh_ops, num_levels, vertices, bands, *certificate) :
+        PTQ_classify::classify(m, mesh_ops, num_levels, vertices, bands, true)))
+  {
+    return false;
+  }
+
+  build_levels(m, mesh_ops, vertices, bands, num_levels);
+  return true;
+}
+
+template <class Kernel, class Stencils>
+template <class Polyhedron>
+bool Transform_plan<Kernel, Stencils>::build_refined(Polyhedron& mesh,
+                                                     int num_levels)
+{
+  Compact_mesh<Kernel> cm;
+  if (!polyhedron_to_compact_mesh(mesh, cm) || !build_refined(cm, num_levels))
+  {
+    return false;
+  }
+  return compact_mesh_to_polyhedron(cm, mesh);
+}
+
+template <class Kernel, class Stencils>
+bool Transform_plan<Kernel, Stencils>::build_refined(Compact_mesh<Kernel>& mesh,
+                                                     int num_levels)
+{
+  using Mesh = Compact_mesh<Kernel>;
+  using Vertex_handle = typename Mesh::Vertex_handle;
+  using Mesh_info = ptq_impl::Mesh_info<Mesh>;
+  using Mesh_ops = ptq_impl::Mesh_info_operations<Mesh>;
+  using PTQ_modifier = ptq_impl::PTQ_subdivision_modifier<Mesh, Mesh_ops>;
+
+  vertex_order_.clear();
+  level_sizes_.clear();
+  levels_.clear();
+
+  if (!Stencils::is_supported(mesh) || num_levels < 1)
+  {
+    return false;
+  }
+
+  Mesh m {mesh};
+  m.collect_garbage();
+
+  Mesh_info mesh_info;
+  Mesh_ops mesh_ops {&mesh_info};
+
+  // Initialize the coarse mesh, the same as Wavelet_synthesize.
+  std::vector<Vertex_handle> vertices;
+  for (auto [v, id] = std::make_pair(m.vertices_begin(), 0);
+       v != m.vertices_end();
+       ++v, ++id)
+  {
+    vertices.push_back(v);
+    mesh_ops.set_vertex_id(v, id);
+    mesh_ops.set_vertex_level(v, 0);
+    mesh_ops.set_vertex_type(v, 0);
+    mesh_ops.set_vertex_border(v, false);
+  }
+  for (auto h = m.halfedges_begin(); h != m.halfedges_end(); ++h)
+  {
+    if (h->is_border_edge())
+    {
+      mesh_ops.set_vertex_border(h->vertex(), true);
+      mesh_ops.set_vertex_border(h->opposite()->vertex(), true);
+    }
+  }
+  std::vector<Vertex_handle*> bands {vertices.data(),
+                                     vertices.data() + vertices.size()};
+
+  // The refined vertices are classified by the refinement, their ids are
+  // their positions in vertices and in the refined mesh.
+  PTQ_modifier::refine_levels(m, mesh_ops, 0, num_levels, vertices, bands);
+  mesh = m;
+
+  build_levels(m, mesh_ops, vertices, bands, num_levels);
+  return true;
+}
+
+template <class Kernel, class Stencils>
+template <class Mesh_ops>
+void Transform_plan<Kernel, Stencils>::build_levels(
+            Compact_mesh<Kernel>& m,
+            const Mesh_ops& mesh_ops,
+            std::vector<typename Compact_mesh<Kernel>::Vertex_handle>& vertices,
+            std::vector<typename Compact_mesh<Kernel>::Vertex_handle*>& bands,
+            int num_levels)
+{
+  using Mesh = Compact_mesh<Kernel>;
+  using Vertex_handle = typename Mesh::Vertex_handle;
+  using PTQ_modifier = ptq_impl::PTQ_subdivision_modifier<Mesh, Mesh_ops>;
+
+  // After the classification, the id of a vertex is its position in the
+  // array of vertices, which is the index used by the stencils.
+  vertex_order_.reserve(vertices.size());
+  for (const Vertex_handle& v : vertices)
+  {
+    vertex_order_.push_back(v.index());
+  }
+  for (int level = 0; level <= num_levels; ++level)
+  {
+    level_sizes_.push_back(bands[level + 1] - bands[0]);
+  }
+
+  levels_.resize(num_levels);
+  for (int level = num_levels - 1; level >= 0; --level)
+  {
+    levels_[level].build(m,
+                         mesh_ops,
+                         bands[0],
+                         bands[level + 1],
+                         bands[level + 2],
+                         num_levels);
+    PTQ_modifier::coarsen(m, mesh_ops, level + 1);
+  }
+}
+
+template <class Kernel, class Stencils>
+bool Transform_plan<Kernel, Stencils>::analyze(
+                                std::vector<Point_3>& points,
+                                std::vector<std::vector<Vector_3>>& coefs) const
+{
+  if (!check_points(points))
+  {
+    return false;
+  }
+
+  Channels x {3, vertex_order_.size()};
+  load_points(points, x, 0);
+  analyze(x);
+  store_points(x, 0, points, coefs);
+  return true;
+}
+
+template <class Kernel, class Stencils>
+bool Transform_plan<Kernel, Stencils>::synthesize(
+                          std::vector<Point_3>& points,
+                          const std::vector<std::vector<Vector_3>>& coefs) const
+{
+  if (!check_points(points, coefs))
+  {
+    return false;
+  }
+
+  Channels x {3, vertex_order_.size()};
+  load_points(points, coefs, x, 0);
+  synthesize(x);
+  store_points(x, 0, points);
+  return true;
+}
+
+template <class Kernel, class Stencils>
+bool Transform_plan<Kernel, Stencils>::analyze(
+                                std::vector<FT>& values,
+                                int num_channels,
+                                std::vector<Channel_coefficients>& coefs) const
+{
+  if (!check_values(values, num_channels))
+  {
+    return false;
+  }
+
+  Channels x {num_channels, vertex_order_.size()};
+  load_values(values, num_channels, x, 0);
+  analyze(x);
+  store_values(x, 0, num_channels, values, coefs);
+  return true;
+}
+
+template <class Kernel, class Stencils>
+bool Transform_plan<Kernel, Stencils>::synthesize(
+                          std::vector<FT>& values,
+                          int num_channels,
+                          const std::vector<Channel_coefficients>& coefs) const
+{
+  if (!check_values(values, num_channels, coefs))
+  {
+    return false;
+  }
+
+  Channels x {num_channels, vertex_order_.size()};
+  load_values(values, num_channels, coefs, x, 0);
+  synthesize(x);
+  store_values(x, 0, num_channels, values);
+  return true;
+}
+
+template <class Kernel, class Stencils>
+bool Transform_plan<Kernel, Stencils>::analyze(
+                          std::vector<Point_3>& points,
+                          std::vector<std::vector<Vector_3>>& coefs,
+                          std::vector<FT>& values,
+                          int num_channels,
+                          std::vector<Channel_coefficients>& value_coefs) const
+{
+  if (!check_points(points) || !check_values(values, num_channels))
+  {
+    return false;
+  }
+
+  Channels x {3 + num_channels, vertex_order_.size()};
+  load_points(points, x, 0);
+  load_values(values, num_channels, x, 3);
+  analyze(x);
+  store_points(x, 0, points, coefs);
+  store_values(x, 3, num_channels, values, value_coefs);
+  return true;
+}
+
+template <class Kernel, class Stencils>
+bool Transform_plan<Kernel, Stencils>::synthesize(
+                    std::vector<Point_3>& points,
+                    const std::vector<std::vector<Vector_3>>& coefs,
+                    std::vector<FT>& values,
+                    int num_channels,
+                    const std::vector<Channel_coefficients>& value_coefs) const
+{
+  if (!check_points(points, coefs) ||
+      !check_values(values, num_channels, value_coefs))
+  {
+    return false;
+  }
+
+  Channels x {3 + num_channels, vertex_order_.size()};
+  load_points(points, coefs, x, 0);
+  load_values(values, num_channels, value_coefs, x, 3);
+  synthesize(x);
+  store_points(x, 0, points);
+  store_values(x, 3, num_channels, values);
+  return true;
+}
+
+template <class Kernel, class Stencils>
+template <class Polyhedron>
+bool Transform_plan<Kernel, Stencils>::analyze(
+                                  const Polyhedron& mesh,
+                                  std::vector<Point_3>& points,
+                                  Wavelet_coefficients<Vector_3>& coefs) const
+{
+  if (empty() || mesh.size_of_vertices() != vertex_order_.size())
+  {
+    return false;
+  }
+
+  points.clear();
+  points.reserve(vertex_order_.size());
+  for (auto v = mesh.vertices_begin(); v != mesh.vertices_end(); ++v)
+  {
+    points.push_back(v->point());
+  }
+
+  Channels x {3, vertex_order_.size()};
+  load_points(points, x, 0);
+  analyze(x);
+  store_points(x, 0, points, coefs);
+  return true;
+}
+
+template <class Kernel, class Stencils>
+template <class Polyhedron>
+bool Transform_plan<Kernel, Stencils>::synthesize(
+                            Polyhedron& mesh,
+                            const std::vector<Point_3>& points,
+                            const Wavelet_coefficients<Vector_3>& coefs) const
+{
+  if (empty() ||
+      mesh.size_of_vertices() != vertex_order_.size() ||
+      points.size() != level_sizes_[0] ||
+      coefs.num_bands() < num_levels())
+  {
+    return false;
+  }
+  for (int level = 0; level < num_levels(); ++level)
+  {
+    if (coefs.band_size(level) != level_sizes_[level + 1] - level_sizes_[level])
+    {
+      return false;
+    }
+  }
+
+  Channels x {3, vertex_order_.size()};
+  load_points(points, coefs, x, 0);
+  synthesize(x);
+
+  std::vector<Point_3> finest;
+  store_points(x, 0, finest);
+  auto p = finest.begin();
+  for (auto v = mesh.vertices_begin(); v != mesh.vertices_end(); ++v, ++p)
+  {
+    v->point() = *p;
+  }
+  return true;
+}
+
+template <class Kernel, class Stencils>
+bool Transform_plan<Kernel, Stencils>::check_points(
+                                      const std::vector<Point_3>& points) const
+{
+  return !empty() && points.size() == vertex_order_.size();
+}
+
+template <class Kernel, class Stencils>
+bool Transform_plan<Kernel, Stencils>::check_points(
+                          const std::vector<Point_3>& points,
+                          const std::vector<std::vector<Vector_3>>& coefs) const
+{
+  if (empty() ||
+      points.size() != level_sizes_[0] ||
+      coefs.size() < levels_.size())
+  {
+    return false;
+  }
+  for (int level = 0; level < num_levels(); ++level)
+  {
+    if (coefs[level].size() != level_sizes_[level + 1] - level_sizes_[level])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <class Kernel, class Stencils>
+bool Transform_plan<Kernel, Stencils>::check_values(
+                                             const std::vector<FT>& values,
+                                             int num_channels) const
+{
+  return !empty() &&
+         num_channels > 0 &&
+         values.size() == num_channels * vertex_order_.size();
+}
+
+template <class Kernel, class Stencils>
+bool Transform_plan<Kernel, Stencils>::check_values(
+                          const std::vector<FT>& values,
+                          int num_channels,
+                          const std::vector<Channel_coefficients>& coefs) const
+{
+  if (empty() ||
+      num_channels <= 0 ||
+      values.size() != num_channels * level_sizes_[0] ||
+      coefs.size() != num_channels)
+  {
+    return false;
+  }
+  for (const Channel_coefficients& channel_coefs : coefs)
+  {
+    if (channel_coefs.size() < levels_.size())
+    {
+      return false;
+    }
+    for (int level = 0; level < num_levels(); ++level)
+    {
+      if (channel_coefs[level].size() !=
+          level_sizes_[level + 1] - level_sizes_[level])
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+template <class Kernel, class Stencils>
+void Transform_plan<Kernel, Stencils>::load_points(
+                                          const std::vector<Point_3>& points,
+                                          Channels& x,
+                                          int channel) const
+{
+  for (std::size_t i = 0; i < vertex_order_.size(); ++i)
+  {
+    x.set(channel, i, points[vertex_order_[i]]);
+  }
+}
+
+template <class Kernel, class Stencils>
+void Transform_plan<Kernel, Stencils>::load_values(
+                                          const std::vector<FT>& values,
+                                          int num_channels,
+                                          Channels& x,
+                                          int channel) const
+{
+  for (std::size_t i = 0; i < vertex_order_.size(); ++i)
+  {
+    const FT* v = &values[vertex_order_[i] * num_channels];
+    for (int c = 0; c < num_channels; ++c)
+    {
+      x.values[channel + c][i] = v[c];
+    }
+  }
+}
+
+template <class Kernel, class Stencils>
+void Transform_plan<Kernel, Stencils>::store_points(
+                              const Channels& x,
+                              int channel,
+                              std::vector<Point_3>& points,
+                              std::vector<std::vector<Vector_3>>& coefs) const
+{
+  coefs = std::vector<std::vector<Vector_3>>(num_levels());
+  for (int level = 0; level < num_levels(); ++level)
+  {
+    coefs[level].reserve(level_sizes_[level + 1] - level_sizes_[level]);
+    for (int i = level_sizes_[level]; i < level_sizes_[level + 1]; ++i)
+    {
+      coefs[level].push_back(x.vector(channel, i));
+    }
+  }
+
+  // The coarse vertices keep their relative order.
+  points.resize(level_sizes_[0]);
+  for (int i = 0; i < level_sizes_[0]; ++i)
+  {
+    points[i] = CGAL::ORIGIN + x.vector(channel, i);
+  }
+}
+
+template <class Kernel, class Stencils>
+void Transform_plan<Kernel, Stencils>::store_values(
+                                  const Channels& x,
+                                  int channel,
+                                  int num_channels,
+                                  std::vector<FT>& values,
+                                  std::vector<Channel_coefficients>& coefs) const
+{
+  coefs.assign(num_channels, Channel_coefficients(num_levels()));
+  for (int c = 0; c < num_channels; ++c)
+  {
+    const std::vector<FT>& a = x.values[channel + c];
+    for (int level = 0; level < num_levels(); ++level)
+    {
+      coefs[c][level].assign(a.begin() + level_sizes_[level],
+                             a.begin() + level_sizes_[level + 1]);
+    }
+  }
+
+  values.resize(num_channels * level_sizes_[0]);
+  for (int i = 0; i < level_sizes_[0]; ++i)
+  {
+    for (int c = 0; c < num_channels; ++c)
+    {
+      values[i * num_channels + c] = x.values[channel + c][i];
+    }
+  }
+}
+
+template <class Kernel, class Stencils>
+void Transform_plan<Kernel, Stencils>::load_points(
+                          const std::vector<Point_3>& points,
+                          const std::vector<std::vector<Vector_3>>& coefs,
+                          Channels& x,
+                          int channel) const
+{
+  for (std::size_t i = 0; i < points.size(); ++i)
+  {
+    x.set(channel, i, points[i]);
+  }
+  for (int level = 0; level < num_levels(); ++level)
+  {
+    int first = level_sizes_[level];
+    for (std::size_t i = 0; i < coefs[level].size(); ++i)
+    {
+      x.set(channel, first + i, coefs[level][i]);
+    }
+  }
+}
+
+template <class Kernel, class Stencils>
+void Transform_plan<Kernel, Stencils>::load_values(
+                          const std::vector<FT>& values,
+                          int num_channels,
+                          const std::vector<Channel_coefficients>& coefs,
+                          Channels& x,
+                          int channel) const
+{
+  for (int c = 0; c < num_channels; ++c)
+  {
+    std::vector<FT>& a = x.values[channel + c];
+    for (int i = 0; i < level_sizes_[0]; ++i)
+    {
+      a[i] = values[i * num_channels + c];
+    }
+    for (int level = 0; level < num_levels(); ++level)
+    {
+      std::copy(coefs[c][level].begin(),
+                coefs[c][level].end(),
+                a.begin() + level_sizes_[level]);
+    }
+  }
+}
+
+// The bands of the coefficients are consecutive index ranges of the
+// classified vertices, so every coordinate array is copied at once.
+template <class Kernel, class Stencils>
+void Transform_plan<Kernel, Stencils>::store_points(
+                                  const Channels& x,
+                                  int channel,
+                                  std::vector<Point_3>& points,
+                                  Wavelet_coefficients<Vector_3>& coefs) const
+{
+  std::vector<int> band_sizes;
+  for (int level = 0; level < num_levels(); ++level)
+  {
+    band_sizes.push_back(level_sizes_[level + 1] - level_sizes_[level]);
+  }
+  coefs.assign(band_sizes);
+
+  FT* arrays[] = {coefs.x(), coefs.y(), coefs.z()};
+  for (int c = 0; c < 3; ++c)
+  {
+    const std::vector<FT>& a = x.values[channel + c];
+    std::copy(a.begin() + level_sizes_[0], a.end(), arrays[c]);
+  }
+
+  points.resize(level_sizes_[0]);
+  for (int i = 0; i < level_sizes_[0]; ++i)
+  {
+    points[i] = CGAL::ORIGIN + x.vector(channel, i);
+  }
+}
+
+template <class Kernel, class Stencils>
+void Transform_plan<Kernel, Stencils>::load_points(
+                            const std::vector<Point_3>& points,
+                            const Wavelet_coefficients<Vector_3>& coefs,
+                            Channels& x,
+                            int channel) const
+{
+  for (std::size_t i = 0; i < points.size(); ++i)
+  {
+    x.set(channel, i, points[i]);
+  }
+
+  const FT* arrays[] = {coefs.x(), coefs.y(), coefs.z()};
+  int size = vertex_order_.size() - level_sizes_[0];
+  for (int c = 0; c < 3; ++c)
+  {
+    std::copy(arrays[c],
+              arrays[c] + size,
+              x.values[channel + c].begin() + level_sizes_[0]);
+  }
+}
+
+template <class Kernel, class Stencils>
+void Transform_plan<Kernel, Stencils>::store_points(
+                                            const Channels& x,
+                                            int channel,
+                                            std::vector<Point_3>& points) const
+{
+  points.resize(vertex_order_.size());
+  for (std::size_t i = 0; i < vertex_order_.size(); ++i)
+  {
+    points[vertex_order_[i]] = CGAL::ORIGIN + x.vector(channel, i);
+  }
+}
+
+template <class Kernel, class Stencils>
+void Transform_plan<Kernel, Stencils>::store_values(
+                                            const Channels& x,
+                                            int channel,
+                                            int num_channels,
+                                            std::vector<FT>& values) const
+{
+  values.resize(num_channels * vertex_order_.size());
+  for (std::size_t i = 0; i < vertex_order_.size(); ++i)
+  {
+    FT* v = &values[vertex_order_[i] * num_channels];
+    for (int c = 0; c < num_channels; ++c)
+    {
+      v[c] = x.values[channel + c][i];
+    }
+  }
+}
+
+// A level only lifts the vertices of its own and the coarser levels, so the
+// coefficients of the finer levels are complete before the coarser levels are
+// lifted.
+template <class Kernel, class Stencils>
+void Transform_plan<Kernel, Stencils>::analyze(Channels& x) const
+{
+  ptq_impl::Channel_arrays<FT> arrays {x.arrays()};
+  for (int level = num_levels() - 1; level >= 0; --level)
+  {
+    levels_[level].analyze(arrays);
+  }
+}
+
+template <class Kernel, class Stencils>
+void Transform_plan<Kernel, Stencils>::synthesize(Channels& x) const
+{
+  ptq_impl::Channel_arrays<FT> arrays {x.arrays()};
+  for (int level = 0; level < num_levels(); ++level)
+  {
+    levels_[level].synthesize(arrays);
+  }
+}
+}  // namespace wtlib
+
+#endif  // define WTLIB_TRANSFORM_PLAN_HPP
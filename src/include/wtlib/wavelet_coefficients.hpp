@@ -0,0 +1,332 @@
+#ifndef WTLIB_WAVELET_COEFFICIENTS_HPP
+#define WTLIB_WAVELET_COEFFICIENTS_HPP
+
+/**
+ * @file     wavelet_coefficients.hpp
+ * @brief    Defines a contiguous container of the wavelet coefficients of all
+ *           bands.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace wtlib
+{
+/**
+ * @brief    The wavelet coefficients of all bands, stored as three contiguous
+ *           coordinate arrays (x, y, z) and a table of band offsets.
+ *
+ * Band b holds the entries [band_offset(b), band_offset(b + 1)) of the arrays,
+ * in the same order as the inner vectors of the
+ * std::vector<std::vector<Vector_3>> coefficients. The forward transform
+ * writes a band by index and the inverse transform reads it in place, so a
+ * container reused across transforms of the same size is not reallocated.
+ *
+ * @tparam   V  The vector type of the mesh (i.e., Mesh::Traits::Vector_3).
+ */
+template <class V>
+class Wavelet_coefficients
+{
+public:
+  using Vector_3 = V;
+  using FT = typename Vector_3::FT;
+
+  /**
+   * @brief    A view of the coefficients of one band.
+   *
+   * @tparam   T  FT or const FT.
+   */
+  template <class T>
+  class Band_view
+  {
+  public:
+    Band_view(T* x, T* y, T* z, int size)
+    : x_(x), y_(y), z_(z), size_(size)
+    {}
+
+    int size() const
+    {
+      return size_;
+    }
+
+    bool empty() const
+    {
+      return size_ == 0;
+    }
+
+    Vector_3 operator[](int i) const
+    {
+      assert(i >= 0 && i < size_);
+      return Vector_3(x_[i], y_[i], z_[i]);
+    }
+
+    void set(int i, const Vector_3& v) const
+    {
+      assert(i >= 0 && i < size_);
+      x_[i] = v.x();
+      y_[i] = v.y();
+      z_[i] = v.z();
+    }
+
+    T* x() const
+    {
+      return x_;
+    }
+
+    T* y() const
+    {
+      return y_;
+    }
+
+    T* z() const
+    {
+      return z_;
+    }
+
+  private:
+    T* x_;
+    T* y_;
+    T* z_;
+    int size_;
+  };  // class Band_view
+
+  using Band = Band_view<FT>;
+  using Const_band = Band_view<const FT>;
+
+  Wavelet_coefficients()
+  : offsets_(1, 0)
+  {}
+
+  /**
+   * @brief      Create zero coefficients with the given band sizes.
+   */
+  explicit Wavelet_coefficients(const std::vector<int>& band_sizes)
+  {
+    assign(band_sizes);
+  }
+
+  /**
+   * @brief      Copy the coefficients of a vector of bands.
+   */
+  explicit Wavelet_coefficients(const std::vector<std::vector<Vector_3>>& coefs)
+  {
+    std::vector<int> band_sizes;
+    band_sizes.reserve(coefs.size());
+    for (const std::vector<Vector_3>& band_coefs : coefs)
+    {
+      band_sizes.push_back(band_coefs.size());
+    }
+    assign(band_sizes);
+    for (int b = 0; b < num_bands(); ++b)
+    {
+      Band band_view {band(b)};
+      for (int i = 0; i < band_view.size(); ++i)
+      {
+        band_view.set(i, coefs[b][i]);
+      }
+    }
+  }
+
+  /**
+   * @brief      Set the band sizes and zero all coefficients. The storage is
+   *             only reallocated if the total size grows beyond the capacity.
+   */
+  void assign(const std::vector<int>& band_sizes)
+  {
+    offsets_.assign(1, 0);
+    offsets_.reserve(band_sizes.size() + 1);
+    for (int size : band_sizes)
+    {
+      assert(size >= 0);
+      offsets_.push_back(offsets_.back() + size);
+    }
+    x_.assign(offsets_.back(), FT(0));
+    y_.assign(offsets_.back(), FT(0));
+    z_.assign(offsets_.back(), FT(0));
+  }
+
+  /**
+   * @brief      Set the band sizes, keeping the leading coefficients of every
+   *             band that remains and zeroing the new ones (e.g., to pad
+   *             missing coefficients).
+   */
+  void resize_bands(const std::vector<int>& band_sizes)
+  {
+    if (band_sizes == get_band_sizes())
+    {
+      return;
+    }
+    Wavelet_coefficients resized {band_sizes};
+    for (int b = 0; b < std::min(num_bands(), resized.num_bands()); ++b)
+    {
+      int size = std::min(band_size(b), resized.band_size(b));
+      std::copy_n(&x_[offsets_[b]], size, &resized.x_[resized.offsets_[b]]);
+      std::copy_n(&y_[offsets_[b]], size, &resized.y_[resized.offsets_[b]]);
+      std::copy_n(&z_[offsets_[b]], size, &resized.z_[resized.offsets_[b]]);
+    }
+    swap(resized);
+  }
+
+  /**
+   * @brief      Append an empty band.
+   */
+  void add_band()
+  {
+    offsets_.push_back(offsets_.back());
+  }
+
+  /**
+   * @brief      Append a coefficient to the last band.
+   */
+  void push_back(const Vector_3& v)
+  {
+    assert(num_bands() > 0);
+    x_.push_back(v.x());
+    y_.push_back(v.y());
+    z_.push_back(v.z());
+    ++offsets_.back();
+  }
+
+  /**
+   * @brief      Remove the trailing empty bands.
+   */
+  void pop_empty_bands()
+  {
+    while (num_bands() > 0 && band_size(num_bands() - 1) == 0)
+    {
+      offsets_.pop_back();
+    }
+  }
+
+  void clear()
+  {
+    offsets_.assign(1, 0);
+    x_.clear();
+    y_.clear();
+    z_.clear();
+  }
+
+  void swap(Wavelet_coefficients& other)
+  {
+    offsets_.swap(other.offsets_);
+    x_.swap(other.x_);
+    y_.swap(other.y_);
+    z_.swap(other.z_);
+  }
+
+  int num_bands() const
+  {
+    return static_cast<int>(offsets_.size()) - 1;
+  }
+
+  bool empty() const
+  {
+    return num_bands() == 0;
+  }
+
+  /**
+   * @brief      The number of coefficients of all bands.
+   */
+  int size() const
+  {
+    return offsets_.back();
+  }
+
+  int band_size(int b) const
+  {
+    assert(b >= 0 && b < num_bands());
+    return offsets_[b + 1] - offsets_[b];
+  }
+
+  /**
+   * @brief      The index of the first coefficient of a band in the
+   *             coordinate arrays.
+   */
+  int band_offset(int b) const
+  {
+    assert(b >= 0 && b <= num_bands());
+    return offsets_[b];
+  }
+
+  std::vector<int> get_band_sizes() const
+  {
+    std::vector<int> band_sizes;
+    band_sizes.reserve(num_bands());
+    for (int b = 0; b < num_bands(); ++b)
+    {
+      band_sizes.push_back(band_size(b));
+    }
+    return band_sizes;
+  }
+
+  Band band(int b)
+  {
+    assert(b >= 0 && b < num_bands());
+    return Band(x_.data() + offsets_[b],
+                y_.data() + offsets_[b],
+                z_.data() + offsets_[b],
+                band_size(b));
+  }
+
+  Const_band band(int b) const
+  {
+    assert(b >= 0 && b < num_bands());
+    return Const_band(x_.data() + offsets_[b],
+                      y_.data() + offsets_[b],
+                      z_.data() + offsets_[b],
+                      band_size(b));
+  }
+
+  /**
+   * @brief      The coefficient at an index of the coordinate arrays.
+   */
+  Vector_3 operator[](int i) const
+  {
+    assert(i >= 0 && i < size());
+    return Vector_3(x_[i], y_[i], z_[i]);
+  }
+
+  void set(int i, const Vector_3& v)
+  {
+    assert(i >= 0 && i < size());
+    x_[i] = v.x();
+    y_[i] = v.y();
+    z_[i] = v.z();
+  }
+
+  FT* x() { return x_.data(); }
+  FT* y() { return y_.data(); }
+  FT* z() { return z_.data(); }
+  const FT* x() const { return x_.data(); }
+  const FT* y() const { return y_.data(); }
+  const FT* z() const { return z_.data(); }
+
+  /**
+   * @brief      Copy the coefficients to a vector of bands.
+   */
+  std::vector<std::vector<Vector_3>> to_vectors() const
+  {
+    std::vector<std::vector<Vector_3>> coefs(num_bands());
+    for (int b = 0; b < num_bands(); ++b)
+    {
+      Const_band band_view {band(b)};
+      coefs[b].reserve(band_view.size());
+      for (int i = 0; i < band_view.size(); ++i)
+      {
+        coefs[b].push_back(band_view[i]);
+      }
+    }
+    return coefs;
+  }
+
+private:
+  // The offsets of the bands, the last entry is the total size.
+  std::vector<int> offsets_;
+  std::vector<FT> x_;
+  std::vector<FT> y_;
+  std::vector<FT> z_;
+};  // class Wavelet_coefficients
+}  // namespace wtlib
+
+#endif  // define WTLIB_WAVELET_COEFFICIENTS_HPP
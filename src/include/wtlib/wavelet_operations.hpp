@@ -1,6 +1,8 @@
 #ifndef WAVELET_OPERATIONS_HPP
 #define WAVELET_OPERATIONS_HPP
 
+#include <wtlib/wavelet_coefficients.hpp>
+
 #include <vector>
 #include <CGAL/Origin.h>
 
@@ -77,6 +79,19 @@ private:
   Coarsen coarsen_;
 };  // class Wavelet_analysis_ops
 
+/**
+ * @brief    Create Wavelet_analysis_ops from plain function objects, whose
+ *           types are deduced (e.g., lambdas).
+ */
+template <class Mesh, class Mesh_ops, class F1, class F2, class F3, class F4,
+  class F5, class F6>
+Wavelet_analysis_ops<Mesh, Mesh_ops, F1, F2, F3, F4, F5, F6>
+make_wavelet_analysis_ops(F1 get_num_types, F2 classify_vertices,
+  F3 initialize, F4 cleanup, F5 lift, F6 coarsen)
+{
+  return {get_num_types, classify_vertices, initialize, cleanup, lift, coarsen};
+}
+
 
 template <class M, class MO, class F1, class F2, class F3, class F4,
   class F5, class F6>
@@ -147,6 +162,19 @@ private:
   Lift lift_;
 };  // class Wavelet_synthesis_ops
 
+/**
+ * @brief    Create Wavelet_synthesis_ops from plain function objects, whose
+ *           types are deduced (e.g., lambdas).
+ */
+template <class Mesh, class Mesh_ops, class F1, class F2, class F3, class F4,
+  class F5, class F6>
+Wavelet_synthesis_ops<Mesh, Mesh_ops, F1, F2, F3, F4, F5, F6>
+make_wavelet_synthesis_ops(F1 get_num_types, F2 get_mesh_size,
+  F3 initialize, F4 cleanup, F5 refine, F6 lift)
+{
+  return {get_num_types, get_mesh_size, initialize, cleanup, refine, lift};
+}
+
 
 template<class T1, class T2>
 class Wavelet_analyze
@@ -163,6 +191,44 @@ public:
   {}
 
   bool operator()(Mesh& mesh, std::vector<std::vector<Vector_3>>& coefs, int num_levels) const
+  {
+    Wavelet_coefficients<Vector_3> band_coefs;
+    if (!(*this)(mesh, band_coefs, num_levels)) {
+      return false;
+    }
+    coefs = band_coefs.to_vectors();
+    return true;
+  }
+
+  bool operator()(Mesh& mesh, Wavelet_coefficients<Vector_3>& coefs, int num_levels) const
+  {
+    return analyze(mesh, coefs, num_levels, false) > 0;
+  }
+
+  /**
+   * @brief    The forward transform with a classification that may find fewer
+   *           levels than max_levels, whose number follows from the bands it
+   *           returns.
+   *
+   * @return   The number of transform levels, 0 if the classification fails.
+   */
+  int analyze_max_levels(Mesh& mesh, std::vector<std::vector<Vector_3>>& coefs, int max_levels) const
+  {
+    Wavelet_coefficients<Vector_3> band_coefs;
+    int num_levels = analyze(mesh, band_coefs, max_levels, true);
+    if (num_levels > 0) {
+      coefs = band_coefs.to_vectors();
+    }
+    return num_levels;
+  }
+
+  int analyze_max_levels(Mesh& mesh, Wavelet_coefficients<Vector_3>& coefs, int max_levels) const
+  {
+    return analyze(mesh, coefs, max_levels, true);
+  }
+
+private:
+  int analyze(Mesh& mesh, Wavelet_coefficients<Vector_3>& coefs, int num_levels, bool max_levels) const
   {
     // Initialize the border information for each vertex.
     // First, set the border flag to false for each vertex.
@@ -191,7 +257,7 @@ public:
     const int num_types = analysis_ops_.get_num_types(mesh, mesh_ops_);
 
     // Get the total number of bands.
-    const int num_bands = (num_types - 1) * num_levels;
+    int num_bands = (num_types - 1) * num_levels;
 
     // Create arrays for the vertices and bands.
     std::vector<typename Mesh::Vertex_handle> vertices;
@@ -208,11 +274,20 @@ public:
     // for each vertex.
     // The parameters vertices and bands are set by function.
     if (!analysis_ops_.classify_vertices(mesh, mesh_ops_, num_levels, vertices, bands)) {
-      return false;
+      return 0;
+    }
+    if (max_levels) {
+      num_bands = bands.size() - 2;
+      num_levels = num_bands / (num_types - 1);
     }
 
-    // Initialize band array with an empty array for each band.
-    coefs = std::move(std::vector<std::vector<Vector_3>>(num_bands));
+    // Lay out the coefficients of each band, whose sizes are known after the
+    // classification.
+    std::vector<int> band_sizes(num_bands);
+    for (int i = 0; i < num_bands; ++i) {
+      band_sizes[i] = bands[i + 2] - bands[i + 1];
+    }
+    coefs.assign(band_sizes);
 
     // Perform any initialization.
     // This may be a no-op for some wavelet transforms.
@@ -242,11 +317,11 @@ public:
       for (int i = 0; i < num_types - 1; ++i) {
         typename Mesh::Vertex_handle* start = tmp_bands[i + 1];
         typename Mesh::Vertex_handle* end = tmp_bands[i + 2];
-        std::vector<Vector_3>& band_coefs = coefs[band_no - (num_types - 1) + i];
-        int band_size = end - start;
-        band_coefs.reserve(band_size);
-        for (typename Mesh::Vertex_handle* p = start; p != end; ++p) {
-          band_coefs.push_back((*p)->point() - CGAL::ORIGIN);
+        typename Wavelet_coefficients<Vector_3>::Band band_coefs =
+          coefs.band(band_no - (num_types - 1) + i);
+        assert(end - start == band_coefs.size());
+        for (int j = 0; j < band_coefs.size(); ++j) {
+          band_coefs.set(j, start[j]->point() - CGAL::ORIGIN);
         }
       }
 
@@ -260,10 +335,9 @@ public:
     // This may be a no-op for some wavelet transforms.
     analysis_ops_.cleanup(mesh, mesh_ops_);
 
-    return true;
+    return num_levels;
   }
 
-private:
   Mesh_ops mesh_ops_;
   Analysis_ops analysis_ops_;
 };  // class Wavelet_analyze
@@ -285,6 +359,20 @@ public:
 
 
   void operator()(Mesh& mesh, std::vector<std::vector<Vector_3>>& coefs, int num_levels)
+  {
+    const int num_bands = (synthesis_ops_.get_num_types(mesh, mesh_ops_) - 1) * num_levels;
+    assert(coefs.size() >= num_bands);
+    (*this)(mesh, Wavelet_coefficients<Vector_3>(coefs), num_levels);
+
+    // Discard the used coefficient arrays.
+    coefs.erase(coefs.begin(), coefs.begin() + num_bands);
+  }
+
+  /**
+   * @brief    The inverse transform reading the coefficients in place, which
+   *           are left unchanged.
+   */
+  void operator()(Mesh& mesh, const Wavelet_coefficients<Vector_3>& coefs, int num_levels)
   {
     // Get the number of vertex types, which depends on the
     // topological refinement rule.
@@ -357,13 +445,11 @@ public:
       for (int i = 0; i < num_types - 1; ++i) {
         typename Mesh::Vertex_handle* start = tmp_bands[i + 1];
         typename Mesh::Vertex_handle* end = tmp_bands[i + 2];
-        const std::vector<Vector_3>& band_coefs = coefs[band_no + i];
-        const Vector_3* band_coef = band_coefs.data();
-        int band_size = end - start;
-        assert(band_size == band_coefs.size());
-        for (typename Mesh::Vertex_handle* v = start; v != end; ++v) {
-          (*v)->point() = CGAL::ORIGIN + (*band_coef);
-          ++band_coef;
+        typename Wavelet_coefficients<Vector_3>::Const_band band_coefs =
+          coefs.band(band_no + i);
+        assert(end - start == band_coefs.size());
+        for (int j = 0; j < band_coefs.size(); ++j) {
+          start[j]->point() = CGAL::ORIGIN + band_coefs[j];
         }
       }
 
@@ -377,9 +463,6 @@ public:
 
     // Perform any cleanup after wavelet synthesis.
     synthesis_ops_.cleanup(mesh, mesh_ops_);
-
-    // Discard the empty coefficient arrays.
-    coefs.erase(coefs.begin(), coefs.begin() + band_no);
   }
 private:
   Mesh_ops mesh_ops_;
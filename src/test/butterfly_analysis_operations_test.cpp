@@ -134,17 +134,17 @@ TEST_CASE("Check initialize",
 
     REQUIRE(bands.size() == 3);
     butterfly.initialize(m, m_ops);
-    butterfly.init_scale(bands[0], bands[1], bands[2]);
+    butterfly.init_scale(m_ops, bands[0], bands[1], bands[2]);
     for (auto p = bands[1]; p != bands[2]; ++p)
     {
       REQUIRE(Classify::EDGE_VERTEX == m_ops.get_vertex_type(*p));
-      REQUIRE(1.0 == butterfly.get_vertex_scale(*p));
+      REQUIRE(1.0 == butterfly.get_vertex_scale(*p, m_ops));
     }
 
     for (auto p = bands[0]; p != bands[1]; ++p)
     {
       REQUIRE(Classify::OLD_VERTEX == m_ops.get_vertex_type(*p));
-      REQUIRE(1.0 == butterfly.get_vertex_scale(*p));
+      REQUIRE(1.0 == butterfly.get_vertex_scale(*p, m_ops));
     }
   }
 }
@@ -181,7 +181,7 @@ TEST_CASE("Check update scale",
 
     REQUIRE(bands.size() == num_levels + 2);
     butterfly.initialize(m, m_ops);
-    butterfly.init_scale(bands[0], bands[num_levels], bands[num_levels + 1]);
+    butterfly.init_scale(m_ops, bands[0], bands[num_levels], bands[num_levels + 1]);
 
     for (int level = num_levels; level > 0; --level)
     {
@@ -196,7 +196,7 @@ TEST_CASE("Check update scale",
         INFO("    vid: " << vid);
         INFO("    degree: " << n);
         INFO("    expect_scale: " << expect_scale);
-        REQUIRE(expect_scale  == butterfly.get_vertex_scale(o));
+        REQUIRE(expect_scale  == butterfly.get_vertex_scale(o, m_ops));
       }
 
       for (auto p = bands[level]; p != bands[level + 1]; ++p)
@@ -211,9 +211,9 @@ TEST_CASE("Check update scale",
         double calc_ratio_a0 = butterfly.get_scale_ratio(a0, e, m_ops);
         double calc_ratio_a1 = butterfly.get_scale_ratio(a1, e, m_ops);
 
-        double se = butterfly.get_vertex_scale(e);
-        double sa0 = butterfly.get_vertex_scale(a0);
-        double sa1 = butterfly.get_vertex_scale(a1);
+        double se = butterfly.get_vertex_scale(e, m_ops);
+        double sa0 = butterfly.get_vertex_scale(a0, m_ops);
+        double sa1 = butterfly.get_vertex_scale(a1, m_ops);
 
         INFO("   edge id: " << edge_id);
         INFO("   scale at e: " << se);
@@ -229,6 +229,55 @@ TEST_CASE("Check update scale",
   }
 }
 
+TEST_CASE("Check multithreaded update scale",
+          "[Butterfly analysis operations]")
+
+{
+  std::vector<std::string> files;
+  Utils::loadFiles(files, std::string(TEST_DATA_DIR) + "subdivided_meshes/");
+  REQUIRE_FALSE(files.empty());
+  for (const std::string& file : files)
+  {
+    INFO("Processing " << file);
+    Mesh m {Utils::loadMesh(file)};
+    if (!m.is_closed())
+    {
+      continue;
+    }
+    Butterfly_analysis butterfly0;
+    Butterfly_analysis butterfly1;
+
+    std::vector<int> size_of_levels {Utils::getSubdivisionLevels(file)};
+    int num_levels = size_of_levels.size() - 1;
+
+    Mesh_ops m_ops {Utils::initMeshOps()};
+    Utils::initMeshInfo(m, m_ops);
+
+    std::vector<Vertex_handle> vertices;
+    std::vector<Vertex_handle*> bands;
+
+    REQUIRE(Classify::classify(m, m_ops, num_levels, vertices, bands, true));
+
+    butterfly0.initialize(m, m_ops);
+    butterfly1.initialize(m, m_ops);
+    butterfly0.init_scale(m_ops, bands[0], bands[num_levels], bands[num_levels + 1]);
+    butterfly1.init_scale(m_ops, bands[0], bands[num_levels], bands[num_levels + 1]);
+
+    for (int level = num_levels; level > 0; --level)
+    {
+      butterfly0.update_scale(m, m_ops, bands[level], bands[level + 1], 1);
+      butterfly1.update_scale(m, m_ops, bands[level], bands[level + 1], 4);
+
+      for (auto p = bands[0]; p != bands[level]; ++p)
+      {
+        REQUIRE(butterfly0.get_vertex_scale(*p, m_ops) == butterfly1.get_vertex_scale(*p, m_ops));
+      }
+
+      Modifier::coarsen(m, m_ops, level);
+    }
+  }
+}
+
 TEST_CASE("Check lift one loop close5",
           "[Butterfly analysis operations]")
 
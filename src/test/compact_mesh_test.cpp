@@ -0,0 +1,294 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch.hpp>
+
+#include <test_utils.hpp>
+
+#include <wtlib/butterfly_wavelet_transform.hpp>
+#include <wtlib/compact_mesh.hpp>
+#include <wtlib/loop_wavelet_transform.hpp>
+
+#include <CGAL/IO/Polyhedron_iostream.h>
+#include <CGAL/Simple_cartesian.h>
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+
+#ifndef TEST_DATA_DIR
+#define TEST_DATA_DIR "."
+#endif
+
+using Point = typename Mesh::Traits::Point_3;
+using Vector = typename Mesh::Traits::Vector_3;
+using Compact_mesh = wtlib::Compact_mesh<CGAL::Simple_cartesian<double>>;
+
+using Vertex_const_handle = typename Mesh::Vertex_const_handle;
+using Vertex_handle = typename Mesh::Vertex_handle;
+
+using Get_vertex_id = std::function<int(Vertex_const_handle)>;
+using Set_vertex_id = std::function<void(Vertex_handle, int)>;
+using Get_vertex_level = std::function<int(Vertex_const_handle)>;
+using Set_vertex_level = std::function<void(Vertex_handle, int)>;
+using Get_vertex_type = std::function<int(Vertex_const_handle)>;
+using Set_vertex_type = std::function<void(Vertex_handle, int)>;
+using Get_vertex_border = std::function<bool(Vertex_const_handle)>;
+using Set_vertex_border = std::function<void(Vertex_handle, bool)>;
+
+using Mesh_ops = wtlib::Wavelet_mesh_operations<
+                                Mesh,
+                                Get_vertex_id,
+                                Set_vertex_id,
+                                Get_vertex_level,
+                                Set_vertex_level,
+                                Get_vertex_type,
+                                Set_vertex_type,
+                                Get_vertex_border,
+                                Set_vertex_border>;
+using Utils = Wtlib_test_helper<Mesh, Mesh_ops>;
+
+template <class M0, class M1>
+void require_same_points(const M0& m0, const M1& m1)
+{
+  REQUIRE(m0.size_of_vertices() == m1.size_of_vertices());
+  auto v1 = m1.vertices_begin();
+  for (auto v0 = m0.vertices_begin(); v0 != m0.vertices_end(); ++v0, ++v1)
+  {
+    const Point& p0 = v0->point();
+    const Point& p1 = v1->point();
+
+    REQUIRE(p0.x() == Approx(p1.x()).margin(1e-12));
+    REQUIRE(p0.y() == Approx(p1.y()).margin(1e-12));
+    REQUIRE(p0.z() == Approx(p1.z()).margin(1e-12));
+  }
+}
+
+void require_same_coefs(const std::vector<std::vector<Vector>>& coefs0,
+                        const std::vector<std::vector<Vector>>& coefs1)
+{
+  REQUIRE(coefs0.size() == coefs1.size());
+  for (int i = 0; i < coefs0.size(); ++i)
+  {
+    REQUIRE(coefs0[i].size() == coefs1[i].size());
+    for (int j = 0; j < coefs0[i].size(); ++j)
+    {
+      REQUIRE(coefs0[i][j].x() == Approx(coefs1[i][j].x()).margin(1e-12));
+      REQUIRE(coefs0[i][j].y() == Approx(coefs1[i][j].y()).margin(1e-12));
+      REQUIRE(coefs0[i][j].z() == Approx(coefs1[i][j].z()).margin(1e-12));
+    }
+  }
+}
+
+TEST_CASE("Check compact mesh conversion",
+          "[Compact mesh]")
+{
+  std::vector<std::string> files;
+  Utils::loadFiles(files, std::string(TEST_DATA_DIR) + "subdivided_meshes/");
+  Utils::loadFiles(files, std::string(TEST_DATA_DIR) + "unsubdivided_meshes/");
+  REQUIRE_FALSE(files.empty());
+
+  for (const std::string& file : files)
+  {
+    INFO("Processing " << file);
+    Mesh m0 {Utils::loadMesh(file)};
+
+    Compact_mesh cm;
+    REQUIRE(wtlib::polyhedron_to_compact_mesh(m0, cm));
+    REQUIRE(cm.size_of_vertices() == m0.size_of_vertices());
+    REQUIRE(cm.size_of_halfedges() == m0.size_of_halfedges());
+    REQUIRE(cm.size_of_facets() == m0.size_of_facets());
+    REQUIRE(cm.is_closed() == m0.is_closed());
+    REQUIRE(cm.is_pure_triangle() == m0.is_pure_triangle());
+    require_same_points(m0, cm);
+
+    // Reading the file directly gives the same mesh.
+    Compact_mesh cm_file;
+    std::ifstream in {file};
+    REQUIRE(in >> cm_file);
+    REQUIRE(cm_file.size_of_halfedges() == cm.size_of_halfedges());
+    require_same_points(cm_file, cm);
+
+    Mesh m1;
+    REQUIRE(wtlib::compact_mesh_to_polyhedron(cm, m1));
+    REQUIRE(m1.size_of_halfedges() == m0.size_of_halfedges());
+    REQUIRE(m1.size_of_facets() == m0.size_of_facets());
+    require_same_points(m0, m1);
+
+    for (auto [v0, v1] = std::make_pair(m0.vertices_begin(), cm.vertices_begin());
+         v0 != m0.vertices_end(); ++v0, ++v1)
+    {
+      REQUIRE(v0->degree() == v1->degree());
+    }
+  }
+}
+
+TEST_CASE("Check loop transforms on compact mesh",
+          "[Compact mesh]")
+{
+  std::vector<std::string> files;
+  Utils::loadFiles(files, std::string(TEST_DATA_DIR) + "subdivided_meshes/");
+  REQUIRE_FALSE(files.empty());
+
+  for (const std::string& file : files)
+  {
+    INFO("Processing " << file);
+    std::vector<int> vsize_levels {Utils::getSubdivisionLevels(file)};
+    int num_levels = vsize_levels.size() - 1;
+
+    Mesh m0 {Utils::loadMesh(file)};
+    Compact_mesh cm;
+    REQUIRE(wtlib::polyhedron_to_compact_mesh(m0, cm));
+    Compact_mesh original {cm};
+
+    std::vector<std::vector<Vector>> coefs0;
+    std::vector<std::vector<Vector>> coefs1;
+
+    REQUIRE(wtlib::loop_analyze(m0, coefs0, num_levels));
+    REQUIRE(wtlib::loop_analyze(cm, coefs1, num_levels));
+
+    REQUIRE(m0.size_of_halfedges() == cm.size_of_halfedges());
+    REQUIRE(m0.size_of_facets() == cm.size_of_facets());
+    require_same_points(m0, cm);
+    require_same_coefs(coefs0, coefs1);
+
+    // The synthesis recovers the input only if its edge vertices are in the
+    // order of refine, so the compact mesh is compared with the polyhedron.
+    wtlib::loop_synthesize(m0, coefs0, num_levels);
+    wtlib::loop_synthesize(cm, coefs1, num_levels);
+    REQUIRE(cm.size_of_halfedges() == original.size_of_halfedges());
+    REQUIRE(cm.size_of_facets() == original.size_of_facets());
+
+    cm.collect_garbage();
+    require_same_points(m0, cm);
+  }
+}
+
+TEST_CASE("Check butterfly transforms on compact mesh",
+          "[Compact mesh]")
+{
+  std::vector<std::string> files;
+  Utils::loadFiles(files, std::string(TEST_DATA_DIR) + "subdivided_meshes/");
+  REQUIRE_FALSE(files.empty());
+
+  for (const std::string& file : files)
+  {
+    INFO("Processing " << file);
+    std::vector<int> vsize_levels {Utils::getSubdivisionLevels(file)};
+    int num_levels = vsize_levels.size() - 1;
+
+    Mesh m0 {Utils::loadMesh(file)};
+    if (!m0.is_closed())
+    {
+      continue;
+    }
+    Compact_mesh cm;
+    REQUIRE(wtlib::polyhedron_to_compact_mesh(m0, cm));
+    Compact_mesh original {cm};
+
+    std::vector<std::vector<Vector>> coefs0;
+    std::vector<std::vector<Vector>> coefs1;
+
+    REQUIRE(wtlib::butterfly_analyze(m0, coefs0, num_levels));
+    REQUIRE(wtlib::butterfly_analyze(cm, coefs1, num_levels));
+
+    require_same_points(m0, cm);
+    require_same_coefs(coefs0, coefs1);
+
+    wtlib::butterfly_synthesize(m0, coefs0, num_levels);
+    wtlib::butterfly_synthesize(cm, coefs1, num_levels);
+    REQUIRE(cm.size_of_halfedges() == original.size_of_halfedges());
+
+    cm.collect_garbage();
+    require_same_points(m0, cm);
+  }
+}
+
+TEST_CASE("Check coarsen of compact mesh",
+          "[Compact mesh]")
+{
+  using Compact_mesh_info = wtlib::ptq_impl::Mesh_info<Compact_mesh>;
+  using Compact_mesh_ops = wtlib::ptq_impl::Mesh_info_operations<Compact_mesh>;
+  using Classify = wtlib::ptq_impl::PTQ_classify_vertices<Compact_mesh,
+                                                          Compact_mesh_ops>;
+  using Modifier = wtlib::ptq_impl::PTQ_subdivision_modifier<Compact_mesh,
+                                                             Compact_mesh_ops>;
+  using Compact_vertex_handle = typename Compact_mesh::Vertex_handle;
+
+  // The facets as vertex slots, each starting at its smallest slot.
+  auto get_facets = [](const Compact_mesh& cm)
+                    {
+                      std::vector<std::array<int, 3>> facets;
+                      for (int f = 0; f < cm.num_facet_slots(); ++f)
+                      {
+                        if (cm.is_removed_facet(f))
+                        {
+                          continue;
+                        }
+                        int h = cm.facet_halfedge(f);
+                        std::array<int, 3> t {cm.target(h),
+                                              cm.target(cm.next(h)),
+                                              cm.target(cm.prev(h))};
+                        std::rotate(t.begin(),
+                                    std::min_element(t.begin(), t.end()),
+                                    t.end());
+                        facets.push_back(t);
+                      }
+                      std::sort(facets.begin(), facets.end());
+                      return facets;
+                    };
+
+  std::vector<std::string> files;
+  Utils::loadFiles(files, std::string(TEST_DATA_DIR) + "subdivided_meshes/");
+  Utils::loadFiles(files, std::string(TEST_DATA_DIR) + "randomized_meshes/");
+  REQUIRE_FALSE(files.empty());
+
+  for (const std::string& file : files)
+  {
+    INFO("Processing " << file);
+    std::vector<int> vsize_levels {Utils::getSubdivisionLevels(file)};
+    int num_levels = vsize_levels.size() - 1;
+
+    Mesh m0 {Utils::loadMesh(file)};
+    Compact_mesh cm0;
+    Compact_mesh cm1;
+    REQUIRE(wtlib::polyhedron_to_compact_mesh(m0, cm0));
+    REQUIRE(wtlib::polyhedron_to_compact_mesh(m0, cm1));
+
+    Compact_mesh_info info0;
+    Compact_mesh_info info1;
+    Compact_mesh_ops ops0 {&info0};
+    Compact_mesh_ops ops1 {&info1};
+    std::vector<Compact_vertex_handle> vertices0;
+    std::vector<Compact_vertex_handle> vertices1;
+    std::vector<Compact_vertex_handle*> bands0;
+    std::vector<Compact_vertex_handle*> bands1;
+    REQUIRE(Classify::classify(cm0, ops0, num_levels, vertices0, bands0, true));
+    REQUIRE(Classify::classify(cm1, ops1, num_levels, vertices1, bands1, true));
+
+    for (int level = num_levels; level > 0; --level)
+    {
+      Modifier::coarsen_by_joins(cm0, ops0, level);
+      Modifier::coarsen_by_rebuild(cm1, ops1, level);
+
+      REQUIRE(cm1.size_of_vertices() == vsize_levels[level - 1]);
+      REQUIRE(cm1.size_of_vertices() == cm0.size_of_vertices());
+      REQUIRE(cm1.size_of_halfedges() == cm0.size_of_halfedges());
+      REQUIRE(cm1.size_of_facets() == cm0.size_of_facets());
+      REQUIRE(cm1.is_closed() == cm0.is_closed());
+      REQUIRE(get_facets(cm1) == get_facets(cm0));
+
+      // The remaining vertices keep their slots and handles.
+      for (int v = 0; v < cm0.num_vertex_slots(); ++v)
+      {
+        REQUIRE(cm1.is_removed_vertex(v) == cm0.is_removed_vertex(v));
+      }
+      for (auto v = cm1.vertices_begin(); v != cm1.vertices_end(); ++v)
+      {
+        int id = ops1.get_vertex_id(v);
+        REQUIRE(id < cm1.size_of_vertices());
+        REQUIRE(v == vertices1[id]);
+        REQUIRE(v->degree() == vertices0[id]->degree());
+      }
+    }
+  }
+}
@@ -396,6 +396,57 @@ TEST_CASE("Check inner_edges_to_inner_olds_dual",
 }
 
 
+TEST_CASE("Check Band_partition",
+          "[Loop analysis operations]")
+{
+  for (std::string name : {"loop_test_open4_9_25.off", "loop_test_close4_6_18.off"})
+  {
+    INFO("Processing " << name);
+    Mesh m {Utils::loadMesh(std::string(TEST_DATA_DIR) + "subdivided_meshes/" + name)};
+    Mesh_ops m_ops {Utils::initMeshOps()};
+    Utils::initMeshInfo(m, m_ops);
+
+    std::vector<Vertex_handle> vertices;
+    std::vector<Vertex_handle*> bands;
+    REQUIRE(Classify::classify(m, m_ops, 1, vertices, bands, false));
+
+    Loop::Band_partition p;
+    p.build(m_ops, bands[0], bands[1], bands[2]);
+    REQUIRE(p.has_border() == !m.is_closed());
+    if (!p.has_border())
+    {
+      REQUIRE(p.inner_old_start == bands[0]);
+      REQUIRE(p.inner_old_end == bands[1]);
+      REQUIRE(p.inner_edge_start == bands[1]);
+      REQUIRE(p.inner_edge_end == bands[2]);
+    }
+
+    // Each band is split in order, by the border mark.
+    auto check_split = [&](Vertex_handle* first,
+                           Vertex_handle* last,
+                           Vertex_handle* border_first,
+                           Vertex_handle* border_last,
+                           Vertex_handle* inner_first,
+                           Vertex_handle* inner_last)
+    {
+      std::vector<Vertex_handle> border;
+      std::vector<Vertex_handle> inner;
+      for (Vertex_handle* v = first; v != last; ++v)
+      {
+        (m_ops.get_vertex_border(*v) ? border : inner).push_back(*v);
+      }
+      REQUIRE(std::vector<Vertex_handle>(border_first, border_last) == border);
+      REQUIRE(std::vector<Vertex_handle>(inner_first, inner_last) == inner);
+    };
+    check_split(bands[0], bands[1],
+                p.border_old_start, p.border_old_end,
+                p.inner_old_start, p.inner_old_end);
+    check_split(bands[1], bands[2],
+                p.border_edge_start, p.border_edge_end,
+                p.inner_edge_start, p.inner_edge_end);
+  }
+}
+
 TEST_CASE("Check analysis on loop_test_open3_7_19",
           "[Loop analysis operations]")
 {
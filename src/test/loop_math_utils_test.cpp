@@ -5,7 +5,8 @@
 #include <wtlib/ptq_impl/loop_math_utils.hpp>
 
 
-using LM = wtlib::ptq_impl::Loop_math;
+using LM = wtlib::ptq_impl::Loop_math<>;
+using Float_LM = wtlib::ptq_impl::Loop_math<float>;
 using Eigen::Vector4d;
 
 TEST_CASE("Check alpha", "[Loop math]")
@@ -289,3 +290,73 @@ TEST_CASE("Check get_weight", "[Loop math]")
   REQUIRE(w(2) == Approx(0.003793).margin(1e-6));
   REQUIRE(w(3) == Approx(0.062377).margin(1e-6));
 }
+
+TEST_CASE("Check get_weight in single precision", "[Loop math]")
+{
+  for (int n = 3; n <= 12; ++n)
+  {
+    REQUIRE(Float_LM::alpha(n) == Approx(LM::alpha(n)).margin(1e-6));
+    REQUIRE(Float_LM::beta(n) == Approx(LM::beta(n)).margin(1e-6));
+    REQUIRE(Float_LM::gamma(n) == Approx(LM::gamma(n)).margin(1e-6));
+    REQUIRE(Float_LM::delta(n) == Approx(LM::delta(n)).margin(1e-6));
+
+    Float_LM::Vector4 w {Float_LM::get_weight(n, 6, 6, 6)};
+    Vector4d m {LM::get_weight(n, 6, 6, 6)};
+    for (int i = 0; i < 4; ++i)
+    {
+      REQUIRE(w(i) == Approx(m(i)).margin(1e-6));
+    }
+  }
+}
+
+TEST_CASE("Check get_cached_weight", "[Loop math]")
+{
+  // Tuples inside and outside the precomputed table, twice to read the ones
+  // kept on first use.
+  for (int repeat = 0; repeat < 2; ++repeat)
+  {
+    for (int n0 : {2, 3, 6, 8, 9, 100})
+    {
+      for (int n1 : {3, 6, 7, 20})
+      {
+        for (int n2 : {2, 5, 6, 12})
+        {
+          for (int n3 : {3, 6, 8, 40})
+          {
+            Vector4d w {LM::get_cached_weight(n0, n1, n2, n3)};
+            Vector4d m {LM::get_weight(n0, n1, n2, n3)};
+            for (int i = 0; i < 4; ++i)
+            {
+              REQUIRE(w(i) == m(i));
+            }
+          }
+        }
+      }
+    }
+  }
+
+  Float_LM::Vector4 w {Float_LM::get_cached_weight(5, 6, 6, 10)};
+  Float_LM::Vector4 m {Float_LM::get_weight(5, 6, 6, 10)};
+  REQUIRE(w == m);
+}
+
+TEST_CASE("Check valence table", "[Loop math]")
+{
+  const LM::Valence_table& table {LM::get_valence_table()};
+  for (int n = 1; n <= LM::table_max_valence; ++n)
+  {
+    REQUIRE(table.alpha[n] == LM::compute_alpha(n));
+    REQUIRE(table.beta[n] == LM::compute_beta(n));
+    REQUIRE(table.gamma[n] == LM::compute_gamma(n));
+    REQUIRE(table.delta[n] == LM::compute_delta(n));
+    REQUIRE(LM::alpha(n) == table.alpha[n]);
+    REQUIRE(LM::delta(n) == table.delta[n]);
+  }
+
+  // Valences past the table are computed.
+  int n {LM::table_max_valence + 1};
+  REQUIRE(LM::alpha(n) == LM::compute_alpha(n));
+  REQUIRE(LM::beta(n) == LM::compute_beta(n));
+  REQUIRE(LM::gamma(n) == LM::compute_gamma(n));
+  REQUIRE(LM::delta(n) == LM::compute_delta(n));
+}
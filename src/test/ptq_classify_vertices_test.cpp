@@ -10,6 +10,10 @@
 #include <CGAL/Polyhedron_3.h>
 #include <CGAL/IO/Polyhedron_iostream.h>
 
+#include <algorithm>
+#include <random>
+#include <sstream>
+
 #ifndef TEST_DATA_DIR
 #define TEST_DATA_DIR "."
 #endif
@@ -735,3 +739,183 @@ TEST_CASE("Check vertex id property",
     }
   }
 }
+
+
+TEST_CASE("Classify meshes with a certificate of the classification",
+          "[PTQ_classify_vertices]")
+{
+  std::vector<std::string> files;
+
+  Utils::loadFiles(files, std::string(TEST_DATA_DIR) + "randomized_meshes/");
+  REQUIRE_FALSE(files.empty());
+  for (const std::string& file : files)
+  {
+    INFO("Processing " << file);
+    Mesh m {Utils::loadMesh(file)};
+    int num_levels = Utils::getSubdivisionLevels(file).size() - 1;
+
+    Mesh_ops m_ops_ctrl {Utils::initMeshOps()};
+    Utils::initMeshInfo(m, m_ops_ctrl);
+    std::vector<Vertex_handle> vertices_ctrl;
+    std::vector<Vertex_handle*> bands_ctrl;
+    REQUIRE(Classify::classify(m, m_ops_ctrl, num_levels, vertices_ctrl, bands_ctrl, true));
+
+    // An empty certificate is replaced by the result of the classification.
+    wtlib::Classification_certificate certificate;
+    Mesh_ops m_ops_exp {Utils::initMeshOps()};
+    Utils::initMeshInfo(m, m_ops_exp);
+    std::vector<Vertex_handle> vertices;
+    std::vector<Vertex_handle*> bands;
+    REQUIRE(Classify::classify(m, m_ops_exp, num_levels, vertices, bands, certificate));
+    REQUIRE(vertices == vertices_ctrl);
+    REQUIRE(certificate.num_levels() == num_levels);
+    REQUIRE(certificate.level_sizes.back() == m.size_of_vertices());
+
+    // The certificate survives a round trip through a stream.
+    std::stringstream stream;
+    stream << certificate;
+    wtlib::Classification_certificate loaded;
+    REQUIRE(static_cast<bool>(stream >> loaded));
+    REQUIRE(loaded == certificate);
+
+    // A matching certificate restores the same classification.
+    Mesh_ops m_ops_restored {Utils::initMeshOps()};
+    Utils::initMeshInfo(m, m_ops_restored);
+    vertices.clear();
+    bands.clear();
+    REQUIRE(Classify::classify(m, m_ops_restored, num_levels, vertices, bands, loaded));
+    REQUIRE(loaded == certificate);
+    REQUIRE(vertices == vertices_ctrl);
+    REQUIRE(bands.size() == bands_ctrl.size());
+    for (int i = 0; i < bands.size(); ++i)
+    {
+      REQUIRE(bands[i] - bands[0] == bands_ctrl[i] - bands_ctrl[0]);
+    }
+    for (Vertex_handle v = m.vertices_begin(); v != m.vertices_end(); ++v)
+    {
+      REQUIRE(m_ops_restored.get_vertex_id(v) == m_ops_ctrl.get_vertex_id(v));
+      REQUIRE(m_ops_restored.get_vertex_level(v) == m_ops_ctrl.get_vertex_level(v));
+      REQUIRE(m_ops_restored.get_vertex_type(v) == m_ops_ctrl.get_vertex_type(v));
+    }
+
+    // A certificate of another number of levels is replaced.
+    if (num_levels > 1)
+    {
+      wtlib::Classification_certificate other {certificate};
+      REQUIRE(Classify::classify(m, m_ops_restored, num_levels - 1, vertices, bands, other));
+      REQUIRE(other.num_levels() == num_levels - 1);
+      REQUIRE(other.connectivity_hash == certificate.connectivity_hash);
+    }
+  }
+}
+
+TEST_CASE("Classify the maximum levels of subdivision connectivity",
+          "[PTQ_classify_vertices]")
+{
+  std::vector<std::string> files;
+
+  Utils::loadFiles(files, std::string(TEST_DATA_DIR) + "randomized_meshes/");
+  REQUIRE_FALSE(files.empty());
+  for (const std::string& file : files)
+  {
+    INFO("Processing " << file);
+    Mesh m {Utils::loadMesh(file)};
+    int num_levels = Utils::getSubdivisionLevels(file).size() - 1;
+
+    Mesh_ops m_ops_ctrl {Utils::initMeshOps()};
+    Utils::initMeshInfo(m, m_ops_ctrl);
+    std::vector<Vertex_handle> vertices_ctrl;
+    std::vector<Vertex_handle*> bands_ctrl;
+    REQUIRE(Classify::classify(m, m_ops_ctrl, num_levels, vertices_ctrl, bands_ctrl, true));
+
+    // The levels found match the fixed number of levels of the mesh.
+    for (int max_levels : {0, num_levels, num_levels + 1})
+    {
+      Mesh_ops m_ops_exp {Utils::initMeshOps()};
+      Utils::initMeshInfo(m, m_ops_exp);
+      std::vector<Vertex_handle> vertices;
+      std::vector<Vertex_handle*> bands;
+      REQUIRE(Classify::classify_max_levels(m, m_ops_exp, max_levels, vertices, bands, true) == num_levels);
+      REQUIRE(vertices == vertices_ctrl);
+      REQUIRE(bands.size() == bands_ctrl.size());
+      for (int i = 0; i < bands.size(); ++i)
+      {
+        REQUIRE(bands[i] - bands[0] == bands_ctrl[i] - bands_ctrl[0]);
+      }
+      for (Vertex_handle v = m.vertices_begin(); v != m.vertices_end(); ++v)
+      {
+        REQUIRE(m_ops_exp.get_vertex_id(v) == m_ops_ctrl.get_vertex_id(v));
+        REQUIRE(m_ops_exp.get_vertex_level(v) == m_ops_ctrl.get_vertex_level(v));
+        REQUIRE(m_ops_exp.get_vertex_type(v) == m_ops_ctrl.get_vertex_type(v));
+      }
+    }
+
+    // Fewer levels than the mesh has are classified like a fixed number.
+    if (num_levels > 1)
+    {
+      Mesh_ops m_ops_fixed {Utils::initMeshOps()};
+      Utils::initMeshInfo(m, m_ops_fixed);
+      std::vector<Vertex_handle> vertices_fixed;
+      std::vector<Vertex_handle*> bands_fixed;
+      REQUIRE(Classify::classify(m, m_ops_fixed, 1, vertices_fixed, bands_fixed, true));
+
+      Mesh_ops m_ops_exp {Utils::initMeshOps()};
+      Utils::initMeshInfo(m, m_ops_exp);
+      std::vector<Vertex_handle> vertices;
+      std::vector<Vertex_handle*> bands;
+      REQUIRE(Classify::classify_max_levels(m, m_ops_exp, 1, vertices, bands, true) == 1);
+      REQUIRE(vertices == vertices_fixed);
+    }
+  }
+
+  files.clear();
+  Utils::loadFiles(files, std::string(TEST_DATA_DIR) + "unsubdivided_meshes/");
+  REQUIRE_FALSE(files.empty());
+  for (const std::string& file : files)
+  {
+    INFO("Processing " << file);
+    Mesh m {Utils::loadMesh(file)};
+    Mesh_ops m_ops {Utils::initMeshOps()};
+    Utils::initMeshInfo(m, m_ops);
+    std::vector<Vertex_handle> vertices;
+    std::vector<Vertex_handle*> bands;
+    REQUIRE(Classify::classify_max_levels(m, m_ops, 0, vertices, bands, true) == 0);
+  }
+}
+
+TEST_CASE("Counting sort of the band vertices is stable",
+          "[PTQ_classify_vertices]")
+{
+  std::mt19937 random {7};
+  for (int size : {0, 1, 1000, 200000})
+  {
+    for (int bound : {1, 13, 50000})
+    {
+      for (int num_threads : {1, 4})
+      {
+        INFO("size " << size << ", bound " << bound << ", threads " << num_threads);
+        std::vector<int> items(size);
+        std::vector<int> keys(size);
+        for (int i = 0; i < size; ++i)
+        {
+          items[i] = i;
+          keys[i] = random() % bound;
+        }
+        std::shuffle(items.begin(), items.end(), random);
+
+        std::vector<int> sorted(size);
+        wtlib::ptq_impl::counting_sort(items.data(),
+                                       items.data() + size,
+                                       bound,
+                                       [&keys](int i) { return keys[i]; },
+                                       sorted.data(),
+                                       num_threads);
+
+        std::stable_sort(items.begin(),
+                         items.end(),
+                         [&keys](int lhs, int rhs) { return keys[lhs] < keys[rhs]; });
+        REQUIRE(sorted == items);
+      }
+    }
+  }
+}
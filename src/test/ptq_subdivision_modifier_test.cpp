@@ -116,6 +116,26 @@ TEST_CASE("Check get_halfedges_to_old and get_halfedges_to_borders",
         REQUIRE(m_ops.get_vertex_border(hps.second->vertex()));
       }
     }
+
+    // The halfedges of a band match the ones found per vertex.
+    Vertex_handle* edge_start = bands[max_level];
+    Vertex_handle* edge_end = bands[max_level + 1];
+    for (int num_threads : {1, 4})
+    {
+      CAPTURE(num_threads);
+      std::vector<Modifier::Halfedge_pair> parents;
+      Modifier::get_halfedges_to_old_vertices(edge_start,
+                                              edge_end,
+                                              m_ops,
+                                              parents,
+                                              num_threads);
+      REQUIRE(parents.size() == static_cast<std::size_t>(edge_end - edge_start));
+      for (Vertex_handle* p = edge_start; p != edge_end; ++p)
+      {
+        REQUIRE(parents[p - edge_start] ==
+                Modifier::get_halfedges_to_old_vertices(*p, m_ops));
+      }
+    }
   }
   SUCCEED("[OK] Get vertex out halfedges");
 }
@@ -364,3 +384,96 @@ TEST_CASE("Check refine", "[PTQ subdivision modifier]")
     REQUIRE(origin == after);
   }
 }
+
+TEST_CASE("Check refine_levels", "[PTQ subdivision modifier]")
+{
+  std::vector<std::string> files;
+  Utils::loadFiles(files, std::string(TEST_DATA_DIR) + "unsubdivided_meshes/");
+  REQUIRE_FALSE(files.empty());
+
+  // The ids, levels, types, borders of the vertices and the facets.
+  auto get_topology = [](Mesh& m, const Mesh_ops& m_ops,
+                         const std::vector<Vertex_handle>& vertices)
+                      {
+                        std::vector<std::vector<int>> topology;
+                        for (const Vertex_handle& v : vertices)
+                        {
+                          topology.push_back({m_ops.get_vertex_id(v),
+                                              m_ops.get_vertex_level(v),
+                                              m_ops.get_vertex_type(v),
+                                              m_ops.get_vertex_border(v)});
+                        }
+                        for (auto f = m.facets_begin(); f != m.facets_end(); ++f)
+                        {
+                          std::vector<int> vids;
+                          Halfedge_handle h = f->halfedge();
+                          do
+                          {
+                            vids.push_back(m_ops.get_vertex_id(h->vertex()));
+                            h = h->next();
+                          }
+                          while (h != f->halfedge());
+                          std::sort(vids.begin(), vids.end());
+                          topology.push_back(vids);
+                        }
+                        std::sort(topology.begin() + vertices.size(), topology.end());
+                        return topology;
+                      };
+
+  for (const std::string& file : files)
+  {
+    INFO("Processing " << file);
+    int num_levels = 3;
+    for (int first = 0; first < num_levels; ++first)
+    {
+      CAPTURE(first);
+      std::vector<Mesh> meshes(2, Utils::loadMesh(file));
+      std::vector<Mesh_ops> m_ops {Utils::initMeshOps(), Utils::initMeshOps()};
+      std::vector<std::vector<Vertex_handle>> vertices(2);
+      std::vector<std::vector<Vertex_handle*>> bands(2);
+
+      for (int k = 0; k < 2; ++k)
+      {
+        Mesh& m = meshes[k];
+        Utils::initMeshInfo(m, m_ops[k]);
+        for (auto h = m.halfedges_begin(); h != m.halfedges_end(); ++h)
+        {
+          if (h->is_border_edge())
+          {
+            m_ops[k].set_vertex_border(h->vertex(), true);
+          }
+        }
+        vertices[k].reserve(Modifier::get_mesh_size(m, m_ops[k], num_levels));
+        for (auto v = m.vertices_begin(); v != m.vertices_end(); ++v)
+        {
+          vertices[k].push_back(v);
+        }
+        bands[k].push_back(&vertices[k].front());
+        bands[k].push_back(&vertices[k].back() + 1);
+        for (int level = 0; level < first; ++level)
+        {
+          Modifier::refine(m, m_ops[k], level, vertices[k], bands[k]);
+        }
+      }
+
+      // Refine the first mesh level by level, and the second one at once.
+      for (int level = first; level < num_levels; ++level)
+      {
+        Modifier::refine(meshes[0], m_ops[0], level, vertices[0], bands[0]);
+      }
+      Modifier::refine_levels(meshes[1], m_ops[1], first, num_levels - first,
+                              vertices[1], bands[1]);
+
+      REQUIRE(meshes[1].size_of_vertices() == meshes[0].size_of_vertices());
+      REQUIRE(meshes[1].size_of_halfedges() == meshes[0].size_of_halfedges());
+      REQUIRE(meshes[1].size_of_facets() == meshes[0].size_of_facets());
+      REQUIRE(bands[1].size() == bands[0].size());
+      for (int i = 0; i < bands[0].size(); ++i)
+      {
+        REQUIRE(bands[1][i] - bands[1][0] == bands[0][i] - bands[0][0]);
+      }
+      REQUIRE(get_topology(meshes[1], m_ops[1], vertices[1]) ==
+              get_topology(meshes[0], m_ops[0], vertices[0]));
+    }
+  }
+}
@@ -11,6 +11,10 @@
 #include <CGAL/IO/Polyhedron_iostream.h>
 #include <CGAL/Simple_cartesian.h>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+
 #ifndef TEST_DATA_DIR
 #define TEST_DATA_DIR "."
 #endif
@@ -212,6 +216,106 @@ TEST_CASE("Check loop synthesize interface",
 }
 
 
+TEST_CASE("Check multithreaded loop transforms",
+          "[PTQ wavelet transform]")
+
+{
+  std::vector<std::string> files;
+  Utils::loadFiles(files, std::string(TEST_DATA_DIR) + "subdivided_meshes/");
+  REQUIRE_FALSE(files.empty());
+
+  for (const std::string& file : files)
+  {
+    INFO("Processing " << file);
+    std::vector<int> vsize_levels {Utils::getSubdivisionLevels(file)};
+    int num_levels = vsize_levels.size() - 1;
+
+    Mesh m0 {Utils::loadMesh(file)};
+    Mesh m1 {m0};
+
+    std::vector<std::vector<Mesh::Traits::Vector_3>> coefs0;
+    std::vector<std::vector<Mesh::Traits::Vector_3>> coefs1;
+
+    // The parallel lifting steps give exactly the same result.
+    REQUIRE(wtlib::loop_analyze(m0, coefs0, num_levels, 1));
+    REQUIRE(wtlib::loop_analyze(m1, coefs1, num_levels, 4));
+
+    REQUIRE(m0.size_of_vertices() == m1.size_of_vertices());
+    REQUIRE(coefs0.size() == coefs1.size());
+    for (auto [v0, v1] = std::make_pair(m0.vertices_begin(), m1.vertices_begin());
+         v0 != m0.vertices_end(); ++v0, ++v1)
+    {
+      REQUIRE(v0->point() == v1->point());
+    }
+    for (int i = 0; i < coefs0.size(); ++i)
+    {
+      REQUIRE(coefs0[i] == coefs1[i]);
+    }
+
+    wtlib::loop_synthesize(m0, coefs0, num_levels, 1);
+    wtlib::loop_synthesize(m1, coefs1, num_levels, 4);
+
+    REQUIRE(m0.size_of_vertices() == m1.size_of_vertices());
+    for (auto [v0, v1] = std::make_pair(m0.vertices_begin(), m1.vertices_begin());
+         v0 != m0.vertices_end(); ++v0, ++v1)
+    {
+      REQUIRE(v0->point() == v1->point());
+    }
+  }
+}
+
+TEST_CASE("Check multithreaded butterfly transforms",
+          "[PTQ wavelet transform]")
+
+{
+  std::vector<std::string> files;
+  Utils::loadFiles(files, std::string(TEST_DATA_DIR) + "subdivided_meshes/");
+  REQUIRE_FALSE(files.empty());
+
+  for (const std::string& file : files)
+  {
+    INFO("Processing " << file);
+    std::vector<int> vsize_levels {Utils::getSubdivisionLevels(file)};
+    int num_levels = vsize_levels.size() - 1;
+
+    Mesh m0 {Utils::loadMesh(file)};
+    if (!m0.is_closed())
+    {
+      continue;
+    }
+    Mesh m1 {m0};
+
+    std::vector<std::vector<Mesh::Traits::Vector_3>> coefs0;
+    std::vector<std::vector<Mesh::Traits::Vector_3>> coefs1;
+
+    // The parallel lifting steps give exactly the same result.
+    REQUIRE(wtlib::butterfly_analyze(m0, coefs0, num_levels, 1));
+    REQUIRE(wtlib::butterfly_analyze(m1, coefs1, num_levels, 4));
+
+    REQUIRE(m0.size_of_vertices() == m1.size_of_vertices());
+    REQUIRE(coefs0.size() == coefs1.size());
+    for (auto [v0, v1] = std::make_pair(m0.vertices_begin(), m1.vertices_begin());
+         v0 != m0.vertices_end(); ++v0, ++v1)
+    {
+      REQUIRE(v0->point() == v1->point());
+    }
+    for (int i = 0; i < coefs0.size(); ++i)
+    {
+      REQUIRE(coefs0[i] == coefs1[i]);
+    }
+
+    wtlib::butterfly_synthesize(m0, coefs0, num_levels, 1);
+    wtlib::butterfly_synthesize(m1, coefs1, num_levels, 4);
+
+    REQUIRE(m0.size_of_vertices() == m1.size_of_vertices());
+    for (auto [v0, v1] = std::make_pair(m0.vertices_begin(), m1.vertices_begin());
+         v0 != m0.vertices_end(); ++v0, ++v1)
+    {
+      REQUIRE(v0->point() == v1->point());
+    }
+  }
+}
+
 TEST_CASE("Check butterfly analyze interface",
           "[PTQ wavelet transform]")
 
@@ -329,3 +433,168 @@ TEST_CASE("Check butterfly synthesize interface",
     }
   }
 }
+
+TEST_CASE("Check transforms of disconnected components",
+          "[PTQ wavelet transform]")
+
+{
+  using Vector = Mesh::Traits::Vector_3;
+  using Coefficients = wtlib::Wavelet_coefficients<Vector>;
+
+  // The points rounded to 1e-6, so points differing by round-off sort alike.
+  auto rounded_points = [](const Mesh& m)
+                        {
+                          std::vector<std::array<long long, 3>> points;
+                          for (auto v = m.vertices_begin(); v != m.vertices_end(); ++v)
+                          {
+                            points.push_back({std::llround(v->point().x() * 1e6),
+                                              std::llround(v->point().y() * 1e6),
+                                              std::llround(v->point().z() * 1e6)});
+                          }
+                          std::sort(points.begin(), points.end());
+                          return points;
+                        };
+  auto require_same_point_set = [&rounded_points](const Mesh& m0, const Mesh& m1)
+                                {
+                                  REQUIRE(rounded_points(m0) == rounded_points(m1));
+                                };
+  auto require_same_coefs = [](const Coefficients& coefs0, const Coefficients& coefs1)
+                            {
+                              REQUIRE(coefs0.num_bands() == coefs1.num_bands());
+                              for (int b = 0; b < coefs0.num_bands(); ++b)
+                              {
+                                REQUIRE(coefs0.band(b).size() == coefs1.band(b).size());
+                                for (int i = 0; i < coefs0.band(b).size(); ++i)
+                                {
+                                  REQUIRE(coefs0.band(b)[i] == coefs1.band(b)[i]);
+                                }
+                              }
+                            };
+
+  // The synthesized mesh recovers the input only if its edge vertices are in
+  // the order of refine, so the components are compared with the parts
+  // transformed on their own, merged in the same order.
+  auto transform_parts = [](std::vector<Mesh> parts, auto round_trip)
+                         {
+                           for (Mesh& part : parts)
+                           {
+                             round_trip(part);
+                           }
+                           Mesh merged;
+                           wtlib::merge_components(parts, merged);
+                           return merged;
+                         };
+  auto loop_round_trip = [](Mesh& part)
+                         {
+                           Coefficients part_coefs;
+                           int num_levels {wtlib::loop_analyze_max_levels(part, part_coefs)};
+                           if (num_levels > 0)
+                           {
+                             wtlib::loop_synthesize(part, part_coefs, num_levels);
+                           }
+                         };
+
+  // An assembly of components with two, one and no levels of subdivision
+  // connectivity, the hat is open.
+  std::vector<Mesh> parts {
+    Utils::loadMesh(std::string(TEST_DATA_DIR) + "subdivided_meshes/ico_12_42_162.off"),
+    Utils::loadMesh(std::string(TEST_DATA_DIR) + "subdivided_meshes/cube_8_26.off"),
+    Utils::loadMesh(std::string(TEST_DATA_DIR) + "subdivided_meshes/hat_13_37.off"),
+    Utils::loadMesh(std::string(TEST_DATA_DIR) + "unsubdivided_meshes/ico_12.off")};
+  std::vector<Mesh> parts_copy {parts};
+  Mesh assembly;
+  wtlib::merge_components(parts_copy, assembly);
+
+  SECTION("Split into components")
+  {
+    Mesh two_objects {Utils::loadMesh(std::string(TEST_DATA_DIR) + "disconnected_meshes/two_objects.off")};
+    std::vector<Mesh> components;
+    REQUIRE(wtlib::split_components(two_objects, components) == 2);
+    REQUIRE(components[0].size_of_vertices() == 9);
+    REQUIRE(components[1].size_of_vertices() == 9);
+
+    REQUIRE(wtlib::split_components(assembly, components, 0) == parts.size());
+    for (std::size_t i = 0; i < parts.size(); ++i)
+    {
+      REQUIRE(components[i].size_of_vertices() == parts[i].size_of_vertices());
+      REQUIRE(components[i].size_of_facets() == parts[i].size_of_facets());
+      for (auto [v0, v1] = std::make_pair(parts[i].vertices_begin(),
+                                          components[i].vertices_begin());
+           v0 != parts[i].vertices_end(); ++v0, ++v1)
+      {
+        REQUIRE(v0->point() == v1->point());
+      }
+    }
+  }
+
+  SECTION("Loop transforms")
+  {
+    Mesh two_objects {Utils::loadMesh(std::string(TEST_DATA_DIR) + "disconnected_meshes/two_objects.off")};
+    std::vector<Mesh> objects;
+    REQUIRE(wtlib::split_components(two_objects, objects) == 2);
+    std::vector<wtlib::Component_coefficients<Vector>> coefs;
+    REQUIRE(wtlib::loop_analyze_components(two_objects, coefs) == 1);
+    REQUIRE(coefs.size() == 2);
+    REQUIRE(two_objects.size_of_vertices() == 8);
+    wtlib::loop_synthesize_components(two_objects, coefs);
+    require_same_point_set(transform_parts(objects, loop_round_trip), two_objects);
+
+    Mesh recovered {transform_parts(parts, loop_round_trip)};
+
+    for (int num_threads : {1, 0})
+    {
+      Mesh m {assembly};
+      REQUIRE(wtlib::loop_analyze_components(m, coefs, 0, num_threads) == 2);
+      REQUIRE(coefs.size() == parts.size());
+      std::vector<int> expected_levels {2, 1, 1, 0};
+      for (std::size_t i = 0; i < parts.size(); ++i)
+      {
+        INFO("Component " << i);
+        REQUIRE(coefs[i].num_levels == expected_levels[i]);
+
+        // A component is transformed as the part on its own.
+        Mesh part {parts[i]};
+        Coefficients part_coefs;
+        REQUIRE(wtlib::loop_analyze_max_levels(part, part_coefs) == expected_levels[i]);
+        if (expected_levels[i] > 0)
+        {
+          require_same_coefs(part_coefs, coefs[i].coefs);
+        }
+      }
+
+      wtlib::loop_synthesize_components(m, coefs, num_threads);
+      require_same_point_set(recovered, m);
+      REQUIRE(m.size_of_facets() == assembly.size_of_facets());
+    }
+  }
+
+  SECTION("Butterfly transforms")
+  {
+    Mesh m {assembly};
+    std::vector<wtlib::Component_coefficients<Vector>> coefs;
+    REQUIRE(wtlib::butterfly_analyze_components(m, coefs, 0, 0) == 2);
+    REQUIRE(coefs.size() == parts.size());
+
+    // The open hat is left unchanged.
+    std::vector<int> expected_levels {2, 1, 0, 0};
+    for (std::size_t i = 0; i < parts.size(); ++i)
+    {
+      INFO("Component " << i);
+      REQUIRE(coefs[i].num_levels == expected_levels[i]);
+    }
+
+    auto butterfly_round_trip = [](Mesh& part)
+                                {
+                                  Coefficients part_coefs;
+                                  int num_levels {part.is_closed() ?
+                                    wtlib::butterfly_analyze_max_levels(part, part_coefs) : 0};
+                                  if (num_levels > 0)
+                                  {
+                                    wtlib::butterfly_synthesize(part, part_coefs, num_levels);
+                                  }
+                                };
+    wtlib::butterfly_synthesize_components(m, coefs, 0);
+    require_same_point_set(transform_parts(parts, butterfly_round_trip), m);
+    REQUIRE(m.size_of_facets() == assembly.size_of_facets());
+  }
+}
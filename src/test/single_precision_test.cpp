@@ -0,0 +1,172 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch.hpp>
+
+#include <test_utils.hpp>
+
+#include <wtlib/butterfly_wavelet_transform.hpp>
+#include <wtlib/loop_wavelet_transform.hpp>
+#include <wtlib/wavelet_coefficients.hpp>
+
+#include <CGAL/IO/Polyhedron_iostream.h>
+#include <CGAL/Simple_cartesian.h>
+
+#include <algorithm>
+#include <cmath>
+
+#ifndef TEST_DATA_DIR
+#define TEST_DATA_DIR "."
+#endif
+
+// The same vertex items as Mesh (see mesh_types.hpp), with float points.
+#if defined (WTLIB_USE_CUSTOM_MESH)
+using Float_mesh = CGAL::Polyhedron_3<CGAL::Simple_cartesian<float>, MeshItems>;
+#else
+using Float_mesh = CGAL::Polyhedron_3<CGAL::Simple_cartesian<float>>;
+#endif
+
+using Coefficients = wtlib::Wavelet_coefficients<Mesh::Traits::Vector_3>;
+using Float_coefficients = wtlib::Wavelet_coefficients<Float_mesh::Traits::Vector_3>;
+
+// The largest error of the single precision transforms on the test meshes,
+// relative to the bounding box diagonal of the mesh.
+const double max_relative_error = 1e-4;
+
+template <class M>
+M load_mesh(const std::string& file)
+{
+  std::ifstream in {file};
+  M m;
+  in >> m;
+  return m;
+}
+
+double bbox_diagonal(const Mesh& m)
+{
+  CGAL::Bbox_3 bbox {m.vertices_begin()->point().bbox()};
+  for (auto v = m.vertices_begin(); v != m.vertices_end(); ++v)
+  {
+    bbox = bbox + v->point().bbox();
+  }
+  return std::sqrt((bbox.xmax() - bbox.xmin()) * (bbox.xmax() - bbox.xmin()) +
+                   (bbox.ymax() - bbox.ymin()) * (bbox.ymax() - bbox.ymin()) +
+                   (bbox.zmax() - bbox.zmin()) * (bbox.zmax() - bbox.zmin()));
+}
+
+double max_error(const Coefficients& coefs0, const Float_coefficients& coefs1)
+{
+  REQUIRE(coefs0.get_band_sizes() == coefs1.get_band_sizes());
+  double error = 0.0;
+  for (int i = 0; i < coefs0.size(); ++i)
+  {
+    error = std::max({error,
+                      std::abs(coefs0.x()[i] - coefs1.x()[i]),
+                      std::abs(coefs0.y()[i] - coefs1.y()[i]),
+                      std::abs(coefs0.z()[i] - coefs1.z()[i])});
+  }
+  return error;
+}
+
+double max_error(const Mesh& m0, const Float_mesh& m1)
+{
+  REQUIRE(m0.size_of_vertices() == m1.size_of_vertices());
+  double error = 0.0;
+  for (auto [v0, v1] = std::make_pair(m0.vertices_begin(), m1.vertices_begin());
+       v0 != m0.vertices_end(); ++v0, ++v1)
+  {
+    error = std::max({error,
+                      std::abs(v0->point().x() - v1->point().x()),
+                      std::abs(v0->point().y() - v1->point().y()),
+                      std::abs(v0->point().z() - v1->point().z())});
+  }
+  return error;
+}
+
+/**
+ * @brief      Compare the single precision transform with the double
+ *             precision one on the subdivided test meshes, and report the
+ *             largest relative errors of the coefficients, the coarse meshes
+ *             and the recovered meshes. The synthesized meshes list their
+ *             vertices by resolution level, so the single precision recovery
+ *             is compared with the double precision one.
+ */
+template <class Analyze, class Synthesize>
+void check_single_precision(bool closed_only,
+                            Analyze analyze,
+                            Synthesize synthesize)
+{
+  using Utils = Wtlib_test_helper<Mesh, int>;
+
+  std::vector<std::string> files;
+  Utils::loadFiles(files, std::string(TEST_DATA_DIR) + "subdivided_meshes/");
+  REQUIRE_FALSE(files.empty());
+
+  double coefs_error = 0.0;
+  double coarse_error = 0.0;
+  double recover_error = 0.0;
+  for (const std::string& file : files)
+  {
+    INFO("Processing " << file);
+    std::vector<int> vsize_levels {Utils::getSubdivisionLevels(file)};
+    int num_levels = vsize_levels.size() - 1;
+
+    Mesh m0 {load_mesh<Mesh>(file)};
+    if (closed_only && !m0.is_closed())
+    {
+      continue;
+    }
+    Float_mesh m1 {load_mesh<Float_mesh>(file)};
+    double diagonal {bbox_diagonal(m0)};
+
+    Coefficients coefs0;
+    Float_coefficients coefs1;
+    REQUIRE(analyze(m0, coefs0, num_levels));
+    REQUIRE(analyze(m1, coefs1, num_levels));
+
+    double error {max_error(coefs0, coefs1) / diagonal};
+    REQUIRE(error < max_relative_error);
+    coefs_error = std::max(coefs_error, error);
+
+    error = max_error(m0, m1) / diagonal;
+    REQUIRE(error < max_relative_error);
+    coarse_error = std::max(coarse_error, error);
+
+    synthesize(m0, coefs0, num_levels);
+    synthesize(m1, coefs1, num_levels);
+    error = max_error(m0, m1) / diagonal;
+    REQUIRE(error < max_relative_error);
+    recover_error = std::max(recover_error, error);
+  }
+
+  WARN("Largest relative errors of single precision: coefficients "
+       << coefs_error << ", coarse meshes " << coarse_error
+       << ", recovered meshes " << recover_error);
+}
+
+TEST_CASE("Check loop transforms in single precision",
+          "[Single precision]")
+{
+  check_single_precision(false,
+                         [](auto& m, auto& coefs, int num_levels)
+                         {
+                           return wtlib::loop_analyze(m, coefs, num_levels);
+                         },
+                         [](auto& m, const auto& coefs, int num_levels)
+                         {
+                           wtlib::loop_synthesize(m, coefs, num_levels);
+                         });
+}
+
+TEST_CASE("Check butterfly transforms in single precision",
+          "[Single precision]")
+{
+  check_single_precision(true,
+                         [](auto& m, auto& coefs, int num_levels)
+                         {
+                           return wtlib::butterfly_analyze(m, coefs, num_levels);
+                         },
+                         [](auto& m, const auto& coefs, int num_levels)
+                         {
+                           wtlib::butterfly_synthesize(m, coefs, num_levels);
+                         });
+}
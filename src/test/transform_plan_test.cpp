@@ -0,0 +1,523 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch.hpp>
+
+#include <test_utils.hpp>
+
+#include <wtlib/butterfly_wavelet_transform.hpp>
+#include <wtlib/loop_wavelet_transform.hpp>
+#include <wtlib/transform_plan.hpp>
+
+#include <CGAL/IO/Polyhedron_iostream.h>
+#include <CGAL/Simple_cartesian.h>
+
+#ifndef TEST_DATA_DIR
+#define TEST_DATA_DIR "."
+#endif
+
+using Kernel = CGAL::Simple_cartesian<double>;
+using Point = typename Mesh::Traits::Point_3;
+using Vector = typename Mesh::Traits::Vector_3;
+
+using Vertex_const_handle = typename Mesh::Vertex_const_handle;
+using Vertex_handle = typename Mesh::Vertex_handle;
+
+using Get_vertex_id = std::function<int(Vertex_const_handle)>;
+using Set_vertex_id = std::function<void(Vertex_handle, int)>;
+using Get_vertex_level = std::function<int(Vertex_const_handle)>;
+using Set_vertex_level = std::function<void(Vertex_handle, int)>;
+using Get_vertex_type = std::function<int(Vertex_const_handle)>;
+using Set_vertex_type = std::function<void(Vertex_handle, int)>;
+using Get_vertex_border = std::function<bool(Vertex_const_handle)>;
+using Set_vertex_border = std::function<void(Vertex_handle, bool)>;
+
+using Mesh_ops = wtlib::Wavelet_mesh_operations<
+                                Mesh,
+                                Get_vertex_id,
+                                Set_vertex_id,
+                                Get_vertex_level,
+                                Set_vertex_level,
+                                Get_vertex_type,
+                                Set_vertex_type,
+                                Get_vertex_border,
+                                Set_vertex_border>;
+using Utils = Wtlib_test_helper<Mesh, Mesh_ops>;
+
+std::vector<Point> get_points(const Mesh& m)
+{
+  std::vector<Point> points;
+  for (auto v = m.vertices_begin(); v != m.vertices_end(); ++v)
+  {
+    points.push_back(v->point());
+  }
+  return points;
+}
+
+void require_same_points(const std::vector<Point>& points0,
+                         const std::vector<Point>& points1)
+{
+  REQUIRE(points0.size() == points1.size());
+  for (int i = 0; i < points0.size(); ++i)
+  {
+    REQUIRE(points0[i].x() == Approx(points1[i].x()).margin(1e-12));
+    REQUIRE(points0[i].y() == Approx(points1[i].y()).margin(1e-12));
+    REQUIRE(points0[i].z() == Approx(points1[i].z()).margin(1e-12));
+  }
+}
+
+void require_same_coefs(const std::vector<std::vector<Vector>>& coefs0,
+                        const std::vector<std::vector<Vector>>& coefs1)
+{
+  REQUIRE(coefs0.size() == coefs1.size());
+  for (int i = 0; i < coefs0.size(); ++i)
+  {
+    REQUIRE(coefs0[i].size() == coefs1[i].size());
+    for (int j = 0; j < coefs0[i].size(); ++j)
+    {
+      REQUIRE(coefs0[i][j].x() == Approx(coefs1[i][j].x()).margin(1e-12));
+      REQUIRE(coefs0[i][j].y() == Approx(coefs1[i][j].y()).margin(1e-12));
+      REQUIRE(coefs0[i][j].z() == Approx(coefs1[i][j].z()).margin(1e-12));
+    }
+  }
+}
+
+// Move every vertex, so that a frame differs from the mesh used to build the
+// plan but keeps its connectivity.
+void deform(Mesh& m)
+{
+  for (auto v = m.vertices_begin(); v != m.vertices_end(); ++v)
+  {
+    const Point& p = v->point();
+    v->point() = Point(2.0 * p.x() + p.y(), p.y() - 0.5 * p.z(), p.z() + 1.0);
+  }
+}
+
+// Run check(plan, mesh, num_levels, synthesize) on every mesh of a data
+// directory, with a Loop plan and, on the closed meshes, a Butterfly plan.
+// synthesize(mesh, coefs, num_levels) is the inverse transform of the plan.
+// The number of levels is the one of the file name, unless num_levels is
+// positive.
+template <class Check>
+void check_plans(const std::string& directory, int num_levels, Check check)
+{
+  std::vector<std::string> files;
+  Utils::loadFiles(files, std::string(TEST_DATA_DIR) + directory);
+  REQUIRE_FALSE(files.empty());
+
+  for (const std::string& file : files)
+  {
+    INFO("Processing " << file);
+    int levels = num_levels;
+    if (levels < 1)
+    {
+      std::vector<int> vsize_levels {Utils::getSubdivisionLevels(file)};
+      levels = vsize_levels.size() - 1;
+    }
+
+    Mesh m {Utils::loadMesh(file)};
+    wtlib::Loop_transform_plan<Kernel> loop_plan;
+    check(loop_plan,
+          m,
+          levels,
+          [](Mesh& mesh, std::vector<std::vector<Vector>>& coefs, int n)
+          {
+            wtlib::loop_synthesize(mesh, coefs, n);
+          });
+    if (m.is_closed())
+    {
+      wtlib::Butterfly_transform_plan<Kernel> butterfly_plan;
+      check(butterfly_plan,
+            m,
+            levels,
+            [](Mesh& mesh, std::vector<std::vector<Vector>>& coefs, int n)
+            {
+              wtlib::butterfly_synthesize(mesh, coefs, n);
+            });
+    }
+  }
+}
+
+template <class Plan, class Analyze>
+void check_plan(const Mesh& m, int num_levels, Analyze analyze)
+{
+  Plan plan;
+  Mesh m0 {m};
+  std::vector<std::vector<Vector>> coefs0;
+  bool success = analyze(m0, coefs0, num_levels);
+  REQUIRE(plan.build(m, num_levels) == success);
+  if (!success)
+  {
+    return;
+  }
+  REQUIRE(plan.num_levels() == num_levels);
+  REQUIRE(plan.size_of_vertices() == m.size_of_vertices());
+  REQUIRE(plan.size_of_vertices(0) == m0.size_of_vertices());
+
+  // Plan the first frame, and transform a second frame with the same plan.
+  for (int frame = 0; frame < 2; ++frame)
+  {
+    Mesh m1 {m};
+    if (frame > 0)
+    {
+      deform(m1);
+      m0 = m1;
+      REQUIRE(analyze(m0, coefs0, num_levels));
+    }
+
+    std::vector<Point> original {get_points(m1)};
+    std::vector<Point> points {original};
+    std::vector<std::vector<Vector>> coefs1;
+    REQUIRE(plan.analyze(points, coefs1));
+
+    require_same_coefs(coefs0, coefs1);
+    require_same_points(get_points(m0), points);
+
+    REQUIRE(plan.synthesize(points, coefs1));
+    require_same_points(original, points);
+  }
+
+  // Mismatched inputs are rejected.
+  std::vector<Point> points {get_points(m)};
+  points.pop_back();
+  REQUIRE_FALSE(plan.analyze(points, coefs0));
+}
+
+TEST_CASE("Check loop transform plan",
+          "[Transform plan]")
+{
+  std::vector<std::string> files;
+  Utils::loadFiles(files, std::string(TEST_DATA_DIR) + "subdivided_meshes/");
+  REQUIRE_FALSE(files.empty());
+
+  for (const std::string& file : files)
+  {
+    INFO("Processing " << file);
+    std::vector<int> vsize_levels {Utils::getSubdivisionLevels(file)};
+    int num_levels = vsize_levels.size() - 1;
+
+    Mesh m {Utils::loadMesh(file)};
+    check_plan<wtlib::Loop_transform_plan<Kernel>>(
+      m,
+      num_levels,
+      [](Mesh& mesh, std::vector<std::vector<Vector>>& coefs, int levels)
+      {
+        return wtlib::loop_analyze(mesh, coefs, levels);
+      });
+  }
+}
+
+TEST_CASE("Check butterfly transform plan",
+          "[Transform plan]")
+{
+  std::vector<std::string> files;
+  Utils::loadFiles(files, std::string(TEST_DATA_DIR) + "subdivided_meshes/");
+  REQUIRE_FALSE(files.empty());
+
+  for (const std::string& file : files)
+  {
+    INFO("Processing " << file);
+    std::vector<int> vsize_levels {Utils::getSubdivisionLevels(file)};
+    int num_levels = vsize_levels.size() - 1;
+
+    Mesh m {Utils::loadMesh(file)};
+    if (!m.is_closed())
+    {
+      wtlib::Butterfly_transform_plan<Kernel> plan;
+      REQUIRE_FALSE(plan.build(m, num_levels));
+      continue;
+    }
+    check_plan<wtlib::Butterfly_transform_plan<Kernel>>(
+      m,
+      num_levels,
+      [](Mesh& mesh, std::vector<std::vector<Vector>>& coefs, int levels)
+      {
+        return wtlib::butterfly_analyze(mesh, coefs, levels);
+      });
+  }
+}
+
+// Transform the mesh with every supported instruction set of the lifting
+// kernels, the results must be identical to the scalar kernels.
+template <class Plan>
+void check_plan_kernels(Plan& plan, const Mesh& m, int num_levels)
+{
+  using wtlib::ptq_impl::Simd_isa;
+
+  REQUIRE(plan.build(m, num_levels));
+  Simd_isa widest {wtlib::ptq_impl::supported_simd_isa()};
+
+  std::vector<Point> original {get_points(m)};
+  std::vector<Point> coarse0 {original};
+  std::vector<std::vector<Vector>> coefs0;
+  wtlib::ptq_impl::set_simd_isa(Simd_isa::scalar);
+  REQUIRE(plan.analyze(coarse0, coefs0));
+  std::vector<Point> recovered0 {coarse0};
+  REQUIRE(plan.synthesize(recovered0, coefs0));
+
+  for (int isa = static_cast<int>(Simd_isa::avx2);
+       isa <= static_cast<int>(widest); ++isa)
+  {
+    INFO("Instruction set " << isa);
+    REQUIRE(wtlib::ptq_impl::set_simd_isa(Simd_isa(isa)) == Simd_isa(isa));
+
+    std::vector<Point> coarse1 {original};
+    std::vector<std::vector<Vector>> coefs1;
+    REQUIRE(plan.analyze(coarse1, coefs1));
+    REQUIRE(coarse0 == coarse1);
+    REQUIRE(coefs0 == coefs1);
+
+    REQUIRE(plan.synthesize(coarse1, coefs1));
+    REQUIRE(recovered0 == coarse1);
+  }
+  wtlib::ptq_impl::set_simd_isa(widest);
+}
+
+TEST_CASE("Check transform plan lifting kernels",
+          "[Transform plan]")
+{
+  check_plans("subdivided_meshes/",
+              0,
+              [](auto& plan, const Mesh& m, int num_levels, auto)
+              {
+                check_plan_kernels(plan, m, num_levels);
+              });
+}
+
+TEST_CASE("Check transform plan lifting tiles",
+          "[Transform plan]")
+{
+  using Plan = wtlib::Loop_transform_plan<Kernel>;
+
+  std::vector<std::string> files;
+  Utils::loadFiles(files, std::string(TEST_DATA_DIR) + "subdivided_meshes/");
+  REQUIRE_FALSE(files.empty());
+
+  int default_size {wtlib::ptq_impl::lifting_tile_size()};
+  for (const std::string& file : files)
+  {
+    INFO("Processing " << file);
+    std::vector<int> vsize_levels {Utils::getSubdivisionLevels(file)};
+    int num_levels = vsize_levels.size() - 1;
+
+    Mesh m {Utils::loadMesh(file)};
+    Plan plan0;
+    REQUIRE(plan0.build(m, num_levels));
+    std::vector<Point> original {get_points(m)};
+    std::vector<Point> coarse0 {original};
+    std::vector<std::vector<Vector>> coefs0;
+    REQUIRE(plan0.analyze(coarse0, coefs0));
+
+    // Tiles of a few vertices split every level, the results must be
+    // identical to the ones of the default tiles.
+    for (int size : {1, 5, 64})
+    {
+      INFO("Tile size " << size);
+      wtlib::ptq_impl::set_lifting_tile_size(size);
+      Plan plan1;
+      REQUIRE(plan1.build(m, num_levels));
+
+      std::vector<Point> coarse1 {original};
+      std::vector<std::vector<Vector>> coefs1;
+      REQUIRE(plan1.analyze(coarse1, coefs1));
+      REQUIRE(coarse0 == coarse1);
+      REQUIRE(coefs0 == coefs1);
+
+      std::vector<Point> recovered0 {coarse0};
+      REQUIRE(plan0.synthesize(recovered0, coefs0));
+      REQUIRE(plan1.synthesize(coarse1, coefs1));
+      REQUIRE(recovered0 == coarse1);
+    }
+    wtlib::ptq_impl::set_lifting_tile_size(default_size);
+  }
+}
+
+// Transform per-vertex attributes with the plan: channels holding the vertex
+// coordinates get the same coefficients as the positions, and the other
+// channels are recovered by the synthesis.
+template <class Plan>
+void check_plan_channels(Plan& plan, const Mesh& m, int num_levels)
+{
+  using Channel_coefficients = typename Plan::Channel_coefficients;
+
+  REQUIRE(plan.build(m, num_levels));
+
+  const int num_channels = 5;
+  std::vector<Point> original {get_points(m)};
+  std::vector<double> values;
+  for (const Point& p : original)
+  {
+    values.insert(values.end(), {p.x(), p.y(), p.z(), p.x() * p.y(), 1.0});
+  }
+
+  std::vector<Point> points0 {original};
+  std::vector<std::vector<Vector>> coefs0;
+  REQUIRE(plan.analyze(points0, coefs0));
+
+  std::vector<double> values1 {values};
+  std::vector<Channel_coefficients> coefs1;
+  REQUIRE(plan.analyze(values1, num_channels, coefs1));
+  REQUIRE(coefs1.size() == num_channels);
+  REQUIRE(values1.size() == num_channels * points0.size());
+  for (int level = 0; level < num_levels; ++level)
+  {
+    for (int i = 0; i < coefs0[level].size(); ++i)
+    {
+      REQUIRE(coefs1[0][level][i] == coefs0[level][i].x());
+      REQUIRE(coefs1[1][level][i] == coefs0[level][i].y());
+      REQUIRE(coefs1[2][level][i] == coefs0[level][i].z());
+    }
+  }
+  for (int i = 0; i < points0.size(); ++i)
+  {
+    REQUIRE(values1[i * num_channels] == points0[i].x());
+    REQUIRE(values1[i * num_channels + 1] == points0[i].y());
+    REQUIRE(values1[i * num_channels + 2] == points0[i].z());
+  }
+
+  // Lifting the positions and the attributes in one pass gives the same
+  // results.
+  std::vector<Point> points2 {original};
+  std::vector<std::vector<Vector>> coefs2;
+  std::vector<double> values2 {values};
+  std::vector<Channel_coefficients> value_coefs2;
+  REQUIRE(plan.analyze(points2, coefs2, values2, num_channels, value_coefs2));
+  REQUIRE(points2 == points0);
+  REQUIRE(coefs2 == coefs0);
+  REQUIRE(values2 == values1);
+  REQUIRE(value_coefs2 == coefs1);
+
+  REQUIRE(plan.synthesize(values1, num_channels, coefs1));
+  REQUIRE(values1.size() == values.size());
+  for (int i = 0; i < values.size(); ++i)
+  {
+    REQUIRE(values1[i] == Approx(values[i]).margin(1e-12));
+  }
+
+  REQUIRE(plan.synthesize(points2, coefs2, values2, num_channels, value_coefs2));
+  REQUIRE(values2 == values1);
+  require_same_points(original, points2);
+
+  // Mismatched inputs are rejected.
+  values.pop_back();
+  REQUIRE_FALSE(plan.analyze(values, num_channels, coefs1));
+  REQUIRE_FALSE(plan.synthesize(values1, num_channels - 1, coefs1));
+}
+
+TEST_CASE("Check transform plan attribute channels",
+          "[Transform plan]")
+{
+  check_plans("subdivided_meshes/",
+              0,
+              [](auto& plan, const Mesh& m, int num_levels, auto)
+              {
+                check_plan_channels(plan, m, num_levels);
+              });
+}
+
+// Transform the geometry of a mesh in place, the connectivity of the mesh must
+// stay intact and the results must match the transform of the positions.
+template <class Plan>
+void check_plan_geometry(Plan& plan, const Mesh& m, int num_levels)
+{
+  REQUIRE(plan.build(m, num_levels));
+
+  Mesh m1 {m};
+  deform(m1);
+  std::vector<Point> original {get_points(m1)};
+  std::vector<Point> points0 {original};
+  std::vector<std::vector<Vector>> coefs0;
+  REQUIRE(plan.analyze(points0, coefs0));
+
+  std::vector<Point> points1;
+  wtlib::Wavelet_coefficients<Vector> coefs1;
+  REQUIRE(plan.analyze(m1, points1, coefs1));
+  REQUIRE(points1 == points0);
+  REQUIRE(coefs1.to_vectors() == coefs0);
+  REQUIRE(get_points(m1) == original);
+
+  // Drop the finest band, as a lowpass filter does.
+  for (int i = coefs1.band_offset(num_levels - 1); i < coefs1.size(); ++i)
+  {
+    coefs1.set(i, Vector(0.0, 0.0, 0.0));
+  }
+  coefs0 = coefs1.to_vectors();
+  REQUIRE(plan.synthesize(points0, coefs0));
+  REQUIRE(plan.synthesize(m1, points1, coefs1));
+  REQUIRE(get_points(m1) == points0);
+
+  // The connectivity is the one of the original mesh.
+  REQUIRE(m1.size_of_vertices() == m.size_of_vertices());
+  REQUIRE(m1.size_of_halfedges() == m.size_of_halfedges());
+  REQUIRE(m1.size_of_facets() == m.size_of_facets());
+  for (auto [v, v1] = std::make_pair(m.vertices_begin(), m1.vertices_begin());
+       v != m.vertices_end(); ++v, ++v1)
+  {
+    REQUIRE(v->degree() == v1->degree());
+  }
+
+  // Mismatched inputs are rejected.
+  points1.pop_back();
+  REQUIRE_FALSE(plan.synthesize(m1, points1, coefs1));
+}
+
+TEST_CASE("Check transform plan geometry of a mesh",
+          "[Transform plan]")
+{
+  check_plans("subdivided_meshes/",
+              0,
+              [](auto& plan, const Mesh& m, int num_levels, auto)
+              {
+                check_plan_geometry(plan, m, num_levels);
+              });
+}
+
+// Refine a coarse mesh with the plan, the inverse transform of the plan must
+// match the inverse transform refining the mesh level by level.
+template <class Plan, class Synthesize>
+void check_plan_refined(Plan& plan,
+                        const Mesh& m0,
+                        int num_levels,
+                        Synthesize synthesize)
+{
+  // Some coefficients for every edge vertex.
+  std::vector<std::vector<Vector>> coefs;
+  Mesh m {m0};
+  Mesh_ops m_ops {Utils::initMeshOps()};
+  int size = m0.size_of_vertices();
+  for (int level = 1; level <= num_levels; ++level)
+  {
+    int next_size = Utils::Modifier::get_mesh_size(m, m_ops, level);
+    coefs.emplace_back();
+    for (int i = size; i < next_size; ++i)
+    {
+      coefs.back().emplace_back(0.01 * (i % 7), -0.02 * (i % 5), 0.03 * (i % 3));
+    }
+    size = next_size;
+  }
+  std::vector<std::vector<Vector>> coefs0 {coefs};
+  synthesize(m, coefs0, num_levels);
+
+  Mesh m1 {m0};
+  REQUIRE(plan.build_refined(m1, num_levels));
+  REQUIRE(plan.num_levels() == num_levels);
+  REQUIRE(plan.size_of_vertices() == m.size_of_vertices());
+  REQUIRE(m1.size_of_vertices() == m.size_of_vertices());
+  REQUIRE(m1.size_of_halfedges() == m.size_of_halfedges());
+  REQUIRE(m1.size_of_facets() == m.size_of_facets());
+
+  REQUIRE(plan.synthesize(m1,
+                          get_points(m0),
+                          wtlib::Wavelet_coefficients<Vector>(coefs)));
+  require_same_points(get_points(m), get_points(m1));
+}
+
+TEST_CASE("Check transform plan refined from a coarse mesh",
+          "[Transform plan]")
+{
+  check_plans("unsubdivided_meshes/",
+              3,
+              [](auto& plan, const Mesh& m, int num_levels, auto synthesize)
+              {
+                check_plan_refined(plan, m, num_levels, synthesize);
+              });
+}
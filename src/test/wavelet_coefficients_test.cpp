@@ -0,0 +1,180 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch.hpp>
+
+#include <test_utils.hpp>
+
+#include <wtlib/butterfly_wavelet_transform.hpp>
+#include <wtlib/loop_wavelet_transform.hpp>
+#include <wtlib/wavelet_coefficients.hpp>
+
+#include <CGAL/IO/Polyhedron_iostream.h>
+#include <CGAL/Simple_cartesian.h>
+
+#ifndef TEST_DATA_DIR
+#define TEST_DATA_DIR "."
+#endif
+
+using Vector = typename Mesh::Traits::Vector_3;
+using Coefficients = wtlib::Wavelet_coefficients<Vector>;
+
+using Vertex_const_handle = typename Mesh::Vertex_const_handle;
+using Vertex_handle = typename Mesh::Vertex_handle;
+
+using Get_vertex_id = std::function<int(Vertex_const_handle)>;
+using Set_vertex_id = std::function<void(Vertex_handle, int)>;
+using Get_vertex_level = std::function<int(Vertex_const_handle)>;
+using Set_vertex_level = std::function<void(Vertex_handle, int)>;
+using Get_vertex_type = std::function<int(Vertex_const_handle)>;
+using Set_vertex_type = std::function<void(Vertex_handle, int)>;
+using Get_vertex_border = std::function<bool(Vertex_const_handle)>;
+using Set_vertex_border = std::function<void(Vertex_handle, bool)>;
+
+using Mesh_ops = wtlib::Wavelet_mesh_operations<
+                                Mesh,
+                                Get_vertex_id,
+                                Set_vertex_id,
+                                Get_vertex_level,
+                                Set_vertex_level,
+                                Get_vertex_type,
+                                Set_vertex_type,
+                                Get_vertex_border,
+                                Set_vertex_border>;
+using Utils = Wtlib_test_helper<Mesh, Mesh_ops>;
+
+void require_same_coefs(const std::vector<std::vector<Vector>>& coefs0,
+                        const Coefficients& coefs1)
+{
+  REQUIRE(coefs0.size() == coefs1.num_bands());
+  for (int b = 0; b < coefs0.size(); ++b)
+  {
+    Coefficients::Const_band band = coefs1.band(b);
+    REQUIRE(coefs0[b].size() == band.size());
+    for (int i = 0; i < band.size(); ++i)
+    {
+      REQUIRE(coefs0[b][i] == band[i]);
+    }
+  }
+}
+
+void require_same_points(const Mesh& m0, const Mesh& m1)
+{
+  REQUIRE(m0.size_of_vertices() == m1.size_of_vertices());
+  for (auto [v0, v1] = std::make_pair(m0.vertices_begin(), m1.vertices_begin());
+       v0 != m0.vertices_end(); ++v0, ++v1)
+  {
+    REQUIRE(v0->point() == v1->point());
+  }
+}
+
+TEST_CASE("Check wavelet coefficients layout",
+          "[Wavelet coefficients]")
+{
+  Coefficients coefs;
+  REQUIRE(coefs.empty());
+  REQUIRE(coefs.size() == 0);
+
+  coefs.add_band();
+  coefs.push_back(Vector {1.0, 2.0, 3.0});
+  coefs.add_band();
+  coefs.add_band();
+  coefs.push_back(Vector {4.0, 5.0, 6.0});
+  coefs.push_back(Vector {7.0, 8.0, 9.0});
+  coefs.add_band();
+  REQUIRE(coefs.num_bands() == 4);
+
+  coefs.pop_empty_bands();
+  REQUIRE(coefs.num_bands() == 3);
+  REQUIRE(coefs.get_band_sizes() == std::vector<int> {1, 0, 2});
+  REQUIRE(coefs.band_offset(2) == 1);
+  REQUIRE(coefs.band(2)[1] == Vector {7.0, 8.0, 9.0});
+  REQUIRE(coefs[2] == Vector {7.0, 8.0, 9.0});
+  REQUIRE(coefs.y()[1] == 5.0);
+
+  // Resizing keeps the leading coefficients of every band.
+  coefs.resize_bands({2, 1, 1, 1});
+  REQUIRE(coefs.size() == 5);
+  REQUIRE(coefs.band(0)[0] == Vector {1.0, 2.0, 3.0});
+  REQUIRE(coefs.band(0)[1] == Vector {0.0, 0.0, 0.0});
+  REQUIRE(coefs.band(1)[0] == Vector {0.0, 0.0, 0.0});
+  REQUIRE(coefs.band(2)[0] == Vector {4.0, 5.0, 6.0});
+  REQUIRE(coefs.band(3)[0] == Vector {0.0, 0.0, 0.0});
+
+  std::vector<std::vector<Vector>> vectors {coefs.to_vectors()};
+  require_same_coefs(vectors, Coefficients {vectors});
+
+  coefs.clear();
+  REQUIRE(coefs.empty());
+}
+
+TEST_CASE("Check loop transforms with wavelet coefficients",
+          "[Wavelet coefficients]")
+{
+  std::vector<std::string> files;
+  Utils::loadFiles(files, std::string(TEST_DATA_DIR) + "subdivided_meshes/");
+  REQUIRE_FALSE(files.empty());
+
+  Coefficients coefs1;
+  for (const std::string& file : files)
+  {
+    INFO("Processing " << file);
+    std::vector<int> vsize_levels {Utils::getSubdivisionLevels(file)};
+    int num_levels = vsize_levels.size() - 1;
+
+    Mesh m0 {Utils::loadMesh(file)};
+    Mesh m1 {m0};
+
+    std::vector<std::vector<Vector>> coefs0;
+    REQUIRE(wtlib::loop_analyze(m0, coefs0, num_levels));
+    REQUIRE(wtlib::loop_analyze(m1, coefs1, num_levels));
+
+    require_same_points(m0, m1);
+    require_same_coefs(coefs0, coefs1);
+
+    // The synthesis reads the buffer in place and leaves it unchanged.
+    wtlib::loop_synthesize(m0, coefs0, num_levels);
+    wtlib::loop_synthesize(m1, coefs1, num_levels);
+
+    require_same_points(m0, m1);
+    REQUIRE(coefs0.empty());
+    REQUIRE(coefs1.num_bands() == num_levels);
+  }
+}
+
+TEST_CASE("Check butterfly transforms with wavelet coefficients",
+          "[Wavelet coefficients]")
+{
+  std::vector<std::string> files;
+  Utils::loadFiles(files, std::string(TEST_DATA_DIR) + "subdivided_meshes/");
+  REQUIRE_FALSE(files.empty());
+
+  Coefficients coefs1;
+  for (const std::string& file : files)
+  {
+    INFO("Processing " << file);
+    std::vector<int> vsize_levels {Utils::getSubdivisionLevels(file)};
+    int num_levels = vsize_levels.size() - 1;
+
+    Mesh m0 {Utils::loadMesh(file)};
+    if (!m0.is_closed())
+    {
+      continue;
+    }
+    Mesh m1 {m0};
+
+    Mesh_ops m1_ops {Utils::initMeshOps()};
+    Utils::initMeshInfo(m1, m1_ops);
+
+    std::vector<std::vector<Vector>> coefs0;
+    REQUIRE(wtlib::butterfly_analyze(m0, coefs0, num_levels));
+    REQUIRE(wtlib::butterfly_analyze(m1, m1_ops, coefs1, num_levels));
+
+    require_same_points(m0, m1);
+    require_same_coefs(coefs0, coefs1);
+
+    wtlib::butterfly_synthesize(m0, coefs0, num_levels);
+    wtlib::butterfly_synthesize(m1, m1_ops, coefs1, num_levels);
+
+    require_same_points(m0, m1);
+  }
+}
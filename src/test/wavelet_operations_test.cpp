@@ -46,6 +46,16 @@ using Utils = Wtlib_test_helper<Mesh, Mesh_ops>;
 
 using PTQ_classify = wtlib::ptq_impl::PTQ_classify_vertices<Mesh, Mesh_ops>;
 using PTQ_modifier = wtlib::ptq_impl::PTQ_subdivision_modifier<Mesh, Mesh_ops>;
+// PTQ_classify::classify is overloaded on the certificate, bind the one
+// resetting the vertex ids.
+using Classify_reset_ids = bool (*)(Mesh&,
+                                    const Mesh_ops&,
+                                    int,
+                                    std::vector<Vertex_handle>&,
+                                    std::vector<Vertex_handle*>&,
+                                    bool,
+                                    int);
+const Classify_reset_ids ptq_classify_reset_ids = &PTQ_classify::classify;
 
 using Loop_analysis = wtlib::ptq_impl::Loop_analysis_operations<Mesh, Mesh_ops>;
 using Loop_synthesis = wtlib::ptq_impl::Loop_synthesis_operations<Mesh, Mesh_ops>;
@@ -104,10 +114,10 @@ TEST_CASE("Check loop analysis return false",
           "[Wavelet operations]")
 {
   Get_num_types get_num_types = &PTQ_classify::get_num_types;
-  Classify_vertices ptq_classify = std::bind(&PTQ_classify::classify, _1, _2, _3, _4, _5, true);
+  Classify_vertices ptq_classify = std::bind(ptq_classify_reset_ids, _1, _2, _3, _4, _5, true, 1);
   Coarsen ptq_coarsen = &PTQ_modifier::coarsen;
   Initialize analysis_init = &Loop_analysis::initialize;
-  Lift analysis_lift = &Loop_analysis::lift;
+  Lift analysis_lift = std::bind(&Loop_analysis::lift, _1, _2, _3, _4, 1);
   Cleanup cleanup = &Loop_analysis::clean_up;
   Analysis_ops analysis {get_num_types,
                          ptq_classify,
@@ -137,11 +147,11 @@ TEST_CASE("Check butterfly analysis return false",
           "[Wavelet operations]")
 {
   Get_num_types get_num_types = &PTQ_classify::get_num_types;
-  Classify_vertices ptq_classify = std::bind(&PTQ_classify::classify, _1, _2, _3, _4, _5, true);
+  Classify_vertices ptq_classify = std::bind(ptq_classify_reset_ids, _1, _2, _3, _4, _5, true, 1);
   Butterfly_analysis b_a;
   Coarsen ptq_coarsen = &PTQ_modifier::coarsen;
   Initialize analysis_init = std::bind(&Butterfly_analysis::initialize, &b_a, _1, _2);
-  Lift analysis_lift = std::bind(&Butterfly_analysis::lift, &b_a, _1, _2, _3, _4);
+  Lift analysis_lift = std::bind(&Butterfly_analysis::lift, &b_a, _1, _2, _3, _4, 1);
   Cleanup analysis_cleanup = std::bind(&Butterfly_analysis::cleanup, &b_a, _1, _2);
   Analysis_ops analysis {get_num_types,
                          ptq_classify,
@@ -180,13 +190,13 @@ TEST_CASE("loop synthesis analysis",
 {
   Get_num_types get_num_types = &PTQ_classify::get_num_types;
   Get_mesh_size get_mesh_size = &PTQ_modifier::get_mesh_size;
-  Classify_vertices ptq_classify = std::bind(&PTQ_classify::classify, _1, _2, _3, _4, _5, true);
+  Classify_vertices ptq_classify = std::bind(ptq_classify_reset_ids, _1, _2, _3, _4, _5, true, 1);
   Coarsen ptq_coarsen = &PTQ_modifier::coarsen;
   Refine ptq_refine = &PTQ_modifier::refine;
   Initialize analysis_init = &Loop_analysis::initialize;
   Syn_initialize synthesis_init = &Loop_synthesis::initialize;
-  Lift analysis_lift = &Loop_analysis::lift;
-  Lift synthesis_lift = &Loop_synthesis::lift;
+  Lift analysis_lift = std::bind(&Loop_analysis::lift, _1, _2, _3, _4, 1);
+  Lift synthesis_lift = std::bind(&Loop_synthesis::lift, _1, _2, _3, _4, 1);
   Cleanup cleanup = &Loop_analysis::clean_up;
 
   Analysis_ops analysis {get_num_types,
@@ -286,7 +296,7 @@ TEST_CASE("butterfly synthesis analysis",
 {
   Get_num_types get_num_types = &PTQ_classify::get_num_types;
   Get_mesh_size get_mesh_size = &PTQ_modifier::get_mesh_size;
-  Classify_vertices ptq_classify = std::bind(&PTQ_classify::classify, _1, _2, _3, _4, _5, true);
+  Classify_vertices ptq_classify = std::bind(ptq_classify_reset_ids, _1, _2, _3, _4, _5, true, 1);
   Coarsen ptq_coarsen = &PTQ_modifier::coarsen;
   Refine ptq_refine = &PTQ_modifier::refine;
 
@@ -296,8 +306,8 @@ TEST_CASE("butterfly synthesis analysis",
 
   Initialize analysis_init = std::bind(&Butterfly_analysis::initialize, &b_a, _1, _2);
   Syn_initialize synthesis_init = std::bind(&Butterfly_synthesis::initialize, &b_s, _1, _2, _3);
-  Lift analysis_lift = std::bind(&Butterfly_analysis::lift, &b_a, _1, _2, _3, _4);
-  Lift synthesis_lift = std::bind(&Butterfly_synthesis::lift, &b_s, _1, _2, _3, _4);
+  Lift analysis_lift = std::bind(&Butterfly_analysis::lift, &b_a, _1, _2, _3, _4, 1);
+  Lift synthesis_lift = std::bind(&Butterfly_synthesis::lift, &b_s, _1, _2, _3, _4, 1);
   Cleanup analysis_cleanup = std::bind(&Butterfly_analysis::cleanup, &b_a, _1, _2);
   Cleanup synthesis_cleanup = std::bind(&Butterfly_synthesis::cleanup, &b_s, _1, _2);
 
@@ -5,6 +5,8 @@
 #include "threaded_gl_buffer_uploader.hpp"
 #include "logger.hpp"
 
+#include <wtlib/wavelet_coefficients.hpp>
+
 #include <QThread>
 #include <QOpenGLFunctions>
 
@@ -23,6 +25,7 @@ public:
   using Vertex = typename Mesh::Vertex_const_handle;
   using Facet = typename Mesh::Facet_const_handle;
   using Vector3 = typename Mesh::Traits::Vector_3;
+  using Coefficients = wtlib::Wavelet_coefficients<Vector3>;
   using Vertex_handle = typename Mesh::Vertex_handle;
   using Vertex_const_handle = typename Mesh::Vertex_const_handle;
   explicit WTTManager();
@@ -60,7 +63,7 @@ protected:
   SceneObject* scene_ptr_;
   Mesh mesh_origin_;
   Mesh mesh_for_wt_;
-  std::vector<std::vector<Vector3>> coefs_;
+  Coefficients coefs_;
   DebugLogger debug;
   FatalLogger critical;
 };
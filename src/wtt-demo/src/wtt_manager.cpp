@@ -11,6 +11,7 @@
 #include <QDebug>
 #include <QFile>
 
+#include <numeric>
 #include <sstream>
 
 WTTManager::WTTManager():
@@ -266,18 +267,15 @@ void WTTManager::onDoFWT(int type, int level) {
 void WTTManager::onDoIWT(int type, int level) {
   using Modifier = wtlib::ptq_impl::PTQ_subdivision_modifier<Mesh, MeshOps>;
   MeshOps meshops;
-  bool padding = false;
-  if (coefs_.size() < level) {
-    padding = true;
-    coefs_.resize(level);
+  std::vector<int> band_sizes {coefs_.get_band_sizes()};
+  if (band_sizes.size() < level) {
+    band_sizes.resize(level);
   }
-  for (int i = 0; i < coefs_.size(); ++i) {
-    int expect_size = Modifier::get_mesh_size(mesh_for_wt_, MeshOps{}, i + 1) - Modifier::get_mesh_size(mesh_for_wt_, MeshOps{}, i);
-    if (coefs_[i].size() != expect_size) {
-      padding = true;
-      coefs_[i].resize(expect_size, Vector3 {0.0, 0.0, 0.0});
-    }
+  for (int i = 0; i < band_sizes.size(); ++i) {
+    band_sizes[i] = Modifier::get_mesh_size(mesh_for_wt_, MeshOps{}, i + 1) - Modifier::get_mesh_size(mesh_for_wt_, MeshOps{}, i);
   }
+  bool padding = band_sizes != coefs_.get_band_sizes();
+  coefs_.resize_bands(band_sizes);
 
   if (type == WTType::BUTTERFLY) {
     debug() << "Performing " << level << " Butterfly IWT";
@@ -290,6 +288,8 @@ void WTTManager::onDoIWT(int type, int level) {
     debug() << "Performing " << level << " Loop IWT";
     wtlib::loop_synthesize(mesh_for_wt_, meshops, coefs_, level);
   }
+  // The coefficients have been consumed by the inverse transform.
+  coefs_.clear();
 
   QString msg;
   if (padding) {
@@ -302,21 +302,13 @@ void WTTManager::onDoIWT(int type, int level) {
 
 void WTTManager::onCompress(double perc) {
   debug() << "Performing compressing with compression rate " << perc << "%";
-  int size = 0;
-  for (const auto& v : coefs_) {
-    size += v.size();
-  }
-  std::vector<std::pair<int, int>> idxmap;
-  idxmap.reserve(size);
-  for (int b = 0; b < coefs_.size(); ++b) {
-    for (int i = 0; i < coefs_[b].size(); ++i) {
-      idxmap.emplace_back(b, i);
-    }
-  }
+  int size = coefs_.size();
+  std::vector<int> idxmap(size);
+  std::iota(idxmap.begin(), idxmap.end(), 0);
 
-  auto compare = [this](const auto& l, const auto& r) {
-    const Vector3& lv = coefs_[l.first][l.second];
-    const Vector3& rv = coefs_[r.first][r.second];
+  auto compare = [this](int l, int r) {
+    const Vector3& lv = coefs_[l];
+    const Vector3& rv = coefs_[r];
     return lv.squared_length() > rv.squared_length();
   };
 
@@ -324,8 +316,7 @@ void WTTManager::onCompress(double perc) {
   
   if (desired_length < size) {
     for (int i = desired_length; i < idxmap.size(); ++i) {
-      std::pair<int, int> idx = idxmap[i];
-      coefs_[idx.first][idx.second] = Vector3{0.0, 0.0, 0.0};
+      coefs_.set(idxmap[i], Vector3{0.0, 0.0, 0.0});
     }
   }
   QString msg = "Set " + QString::number(size > desired_length ? size - desired_length : 0) + " out of " + QString::number(size) + " wavelet coefficients to 0";
@@ -335,13 +326,13 @@ void WTTManager::onCompress(double perc) {
 
 void WTTManager::onDenoise(int level) {
   debug() << "Performing " << level << " levels denosing";
-  for (int l = 0; l < coefs_.size(); ++l) {
+  for (int l = 0; l < coefs_.num_bands(); ++l) {
     if (l + 1 <= level) {
       continue;
     }
-    std::vector<Vector3>& band_coefs = coefs_[l];
-    for (Vector3& v : band_coefs) {
-      v = Vector3{0.0, 0.0, 0.0};
+    Coefficients::Band band_coefs = coefs_.band(l);
+    for (int i = 0; i < band_coefs.size(); ++i) {
+      band_coefs.set(i, Vector3{0.0, 0.0, 0.0});
     }
   }
   emit denoiseDone("Set wavelet coefficients in level " + QString::number(level) + " and above to 0");